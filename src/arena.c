@@ -0,0 +1,88 @@
+#include "arena.h"
+#include "shard.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Size classes: 64, 128, ..., 4096 bytes. */
+#define ARENA_MIN_SHIFT 6
+#define ARENA_CLASSES 7
+#define ARENA_MAX_SIZE (1u << (ARENA_MIN_SHIFT + ARENA_CLASSES - 1))
+#define ARENA_BLOCK_SIZE (64u * 1024u)
+
+typedef struct free_node {
+  struct free_node *next;
+} free_node_t;
+
+static pthread_mutex_t g_arena_mutex = PTHREAD_MUTEX_INITIALIZER;
+static free_node_t *g_free[ARENA_CLASSES];
+static char *g_bump = NULL; /* next unused byte of the current block */
+static char *g_bump_end = NULL;
+
+static unsigned class_of(size_t size) {
+  unsigned c = 0;
+  while (((size_t)1 << (ARENA_MIN_SHIFT + c)) < size)
+    ++c;
+  return c;
+}
+
+void *logger_arena_alloc(size_t size) {
+  if (size == 0)
+    size = 1;
+
+  if (size > ARENA_MAX_SIZE) {
+    size_t rounded =
+        (size + LOGGER_CACHE_LINE - 1) & ~(size_t)(LOGGER_CACHE_LINE - 1);
+    void *p = aligned_alloc(LOGGER_CACHE_LINE, rounded);
+    if (p)
+      memset(p, 0, rounded);
+    return p;
+  }
+
+  unsigned c = class_of(size);
+  size_t csize = (size_t)1 << (ARENA_MIN_SHIFT + c);
+  void *p = NULL;
+
+  pthread_mutex_lock(&g_arena_mutex);
+  if (g_free[c]) {
+    p = g_free[c];
+    g_free[c] = g_free[c]->next;
+  } else {
+    if ((size_t)(g_bump_end - g_bump) < csize) {
+      /* The tail of the old block is lost; at most ARENA_MAX_SIZE bytes. */
+      char *block = (char *)aligned_alloc(LOGGER_CACHE_LINE, ARENA_BLOCK_SIZE);
+      if (!block) {
+        pthread_mutex_unlock(&g_arena_mutex);
+        return NULL;
+      }
+      g_bump = block;
+      g_bump_end = block + ARENA_BLOCK_SIZE;
+    }
+    p = g_bump;
+    g_bump += csize;
+  }
+  pthread_mutex_unlock(&g_arena_mutex);
+
+  memset(p, 0, csize);
+  return p;
+}
+
+void logger_arena_free(void *p, size_t size) {
+  if (!p)
+    return;
+  if (size == 0)
+    size = 1;
+
+  if (size > ARENA_MAX_SIZE) {
+    free(p);
+    return;
+  }
+
+  unsigned c = class_of(size);
+  free_node_t *n = (free_node_t *)p;
+
+  pthread_mutex_lock(&g_arena_mutex);
+  n->next = g_free[c];
+  g_free[c] = n;
+  pthread_mutex_unlock(&g_arena_mutex);
+}
@@ -0,0 +1,41 @@
+/**
+ * @file arena.h
+ * @brief Internal size-class arena for long-lived logger objects.
+ *
+ * Backends, their contexts, composite snapshots and logger handles are
+ * carved from 64 KiB blocks owned by the logger instead of separate
+ * calloc() calls. Freed objects go to a per-size-class free list and are
+ * reused by the next allocation of the same class, so reconfiguring the
+ * pipeline at steady state does not reach malloc(). Blocks are never
+ * returned to the system.
+ *
+ * Every allocation is zeroed and LOGGER_CACHE_LINE aligned. Requests larger
+ * than the largest class fall through to aligned_alloc()/free().
+ */
+#ifndef LOGGER_ARENA_H
+#define LOGGER_ARENA_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Allocates @p size zeroed bytes, cache-line aligned.
+ * @return NULL on out-of-memory.
+ */
+void *logger_arena_alloc(size_t size);
+
+/**
+ * @brief Returns @p p, obtained with logger_arena_alloc(@p size).
+ *
+ * @p size must be the value passed at allocation. NULL is ignored.
+ */
+void logger_arena_free(void *p, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
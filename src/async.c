@@ -0,0 +1,476 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
+#include "async.h"
+#include "arena.h"
+#include "context.h"
+#include "format.h"
+#include "record.h"
+#include "shard.h"
+#include "srcloc.h"
+#include "threads.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#if (LOGGER_RT_SLOTS & (LOGGER_RT_SLOTS - 1)) != 0
+#error "LOGGER_RT_SLOTS must be a power of two"
+#endif
+#if (LOGGER_ASYNC_SLOTS & (LOGGER_ASYNC_SLOTS - 1)) != 0
+#error "LOGGER_ASYNC_SLOTS must be a power of two"
+#endif
+
+/* Consumer poll period when all queues are empty. */
+#define CONSUMER_IDLE_NS 1000000L
+
+typedef struct rt_slot {
+  logger_handle_t *h;
+  logger_level_t level;
+  const char *file; /* interned name, or file_buf */
+  int line;
+  unsigned long long seq;
+  logger_ctx_t *ctx; /* referenced */
+  char file_buf[LOGGER_RT_FILE_MAX];
+  char msg[LOGGER_RT_MSG_MAX];
+} rt_slot_t;
+
+typedef struct rt_ring {
+  /* producer line */
+  _Alignas(LOGGER_CACHE_LINE) atomic_size_t head;
+  size_t tail_cache; /* producer's last view of tail */
+
+  /* consumer line */
+  _Alignas(LOGGER_CACHE_LINE) atomic_size_t tail;
+  atomic_int closed; /* owner exited or left real-time mode */
+  struct rt_ring *next;
+
+  rt_slot_t slots[LOGGER_RT_SLOTS];
+} rt_ring_t;
+
+typedef struct async_queue {
+  /* producer line */
+  _Alignas(LOGGER_CACHE_LINE) atomic_size_t head;
+  size_t tail_cache;
+
+  /* consumer line */
+  _Alignas(LOGGER_CACHE_LINE) atomic_size_t tail; /* published to producer */
+  size_t c_tail;     /* consumer's read position */
+  size_t c_head;     /* consumer's last view of head */
+  atomic_int closed; /* owner exited */
+  struct async_queue *next;
+
+  logger_record_t *slots[LOGGER_ASYNC_SLOTS];
+} async_queue_t;
+
+_Thread_local rt_ring_t *logger_tls_rt = NULL;
+static _Thread_local async_queue_t *tls_queue = NULL;
+static _Thread_local int tls_queue_closed = 0; /* thread is exiting */
+
+/* Consumer state; producers only take the mutex to register a queue. */
+static pthread_mutex_t g_consumer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static rt_ring_t *g_rings = NULL;
+static async_queue_t *g_queues = NULL;
+static int g_consumer_running = 0;
+
+static atomic_ullong g_window_ns = LOGGER_ASYNC_WINDOW_US * 1000ull;
+
+/* Idle consumer sleep; async producers with a full queue cut it short. */
+static pthread_mutex_t g_wake_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_wake_cond = PTHREAD_COND_INITIALIZER;
+static atomic_int g_consumer_idle = 0;
+
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_rt_key;
+static pthread_key_t g_queue_key;
+
+static unsigned long long now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ull +
+         (unsigned long long)ts.tv_nsec;
+}
+
+/* ---- producers ---- */
+
+int logger_async_rt_push(logger_handle_t *h, logger_level_t level,
+                         const char *file, int line, unsigned long long seq,
+                         logger_ctx_t *ctx, const char *fmt, va_list args) {
+  rt_ring_t *r = logger_tls_rt;
+  if (!r)
+    return 0;
+
+  size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+  if (head - r->tail_cache >= LOGGER_RT_SLOTS) {
+    r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (head - r->tail_cache >= LOGGER_RT_SLOTS)
+      return 0;
+  }
+
+  rt_slot_t *s = &r->slots[head & (LOGGER_RT_SLOTS - 1)];
+  s->h = h;
+  s->level = level;
+  s->file = logger_srcloc_find(file);
+  if (!s->file && file) {
+    /* not interned yet (that takes a lock): copy the tail of the path */
+    size_t n = strlen(file);
+    if (n >= sizeof(s->file_buf)) {
+      file += n - (sizeof(s->file_buf) - 1);
+      n = sizeof(s->file_buf) - 1;
+    }
+    memcpy(s->file_buf, file, n + 1);
+    s->file = s->file_buf;
+  }
+  s->line = line;
+  s->seq = seq;
+  s->ctx = logger_ctx_retain(ctx);
+  logger_vformat(s->msg, sizeof(s->msg), fmt, args);
+
+  atomic_store_explicit(&r->head, head + 1, memory_order_release);
+  return 1;
+}
+
+static async_queue_t *queue_create(void);
+
+int logger_async_push(logger_handle_t *h, logger_level_t level,
+                      const char *file, int line, unsigned long long seq,
+                      logger_ctx_t *ctx, const char *fmt, va_list args) {
+  if (!tls_queue && tls_queue_closed)
+    return -1;
+  async_queue_t *q = tls_queue ? tls_queue : queue_create();
+  if (!q)
+    return 0;
+
+  logger_record_t *r = logger_record_acquire();
+  if (!r)
+    return 0;
+
+  r->h = h;
+  r->level = level;
+  r->file_id = logger_srcloc_intern(file);
+  r->line = line;
+  r->seq = seq;
+  r->ctx = logger_ctx_retain(ctx);
+  int n = logger_vformat(r->msg, sizeof(r->msg), fmt, args);
+  r->len = n < 0 ? 0 : (size_t)n < sizeof(r->msg) ? (size_t)n
+                                                   : sizeof(r->msg) - 1;
+  r->ts_ns = now_ns();
+
+  size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+  while (head - q->tail_cache >= LOGGER_ASYNC_SLOTS) {
+    q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);
+    if (head - q->tail_cache < LOGGER_ASYNC_SLOTS)
+      break;
+    /* back-pressure: wake the consumer if it is sleeping, then wait */
+    if (atomic_load_explicit(&g_consumer_idle, memory_order_relaxed)) {
+      pthread_mutex_lock(&g_wake_mutex);
+      pthread_cond_signal(&g_wake_cond);
+      pthread_mutex_unlock(&g_wake_mutex);
+    }
+    sched_yield();
+  }
+
+  q->slots[head & (LOGGER_ASYNC_SLOTS - 1)] = r;
+  atomic_store_explicit(&q->head, head + 1, memory_order_release);
+  return 1;
+}
+
+/* ---- consumer ---- */
+
+/* Emits what @p r holds; returns the number of records. */
+static size_t drain_ring_locked(rt_ring_t *r) {
+  size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+  size_t n = head - tail;
+
+  for (; tail != head; ++tail) {
+    rt_slot_t *s = &r->slots[tail & (LOGGER_RT_SLOTS - 1)];
+    logger_emit_h(s->h, s->level, s->file, s->line, s->msg, s->seq, 0,
+                  s->ctx);
+    logger_ctx_release(s->ctx);
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+  }
+  return n;
+}
+
+static size_t drain_rings_locked(void) {
+  size_t total = 0;
+  for (rt_ring_t **pp = &g_rings; *pp;) {
+    rt_ring_t *r = *pp;
+    /* closed first: nothing is pushed after it is observed */
+    int closed = atomic_load_explicit(&r->closed, memory_order_acquire);
+    total += drain_ring_locked(r);
+    if (closed) {
+      *pp = r->next;
+      logger_arena_free(r, sizeof(*r));
+    } else {
+      pp = &r->next;
+    }
+  }
+  return total;
+}
+
+static void emit_record(logger_record_t *r) {
+  const char *file = logger_srcloc_name(r->file_id);
+  logger_emit_h(r->h, r->level, file ? file : "?", r->line, r->msg, r->seq,
+                r->ts_ns, r->ctx);
+  logger_ctx_release(r->ctx);
+  logger_record_release(r);
+}
+
+/* Publish the read position every this many records within a pass. */
+#define TAIL_PUBLISH_EVERY 32
+
+/*
+ * Emits async records in timestamp order. The oldest pending head is safe
+ * once every live queue has a pending record (nothing older can still
+ * arrive) or once it is older than the merge window. With @p flush set,
+ * everything pending is emitted. *pending reports records held back.
+ *
+ * Queue positions are cached on the consumer's own line; a producer's head
+ * is only re-read when its cached view runs empty.
+ */
+static size_t merge_queues_locked(int flush, int *pending) {
+  const unsigned long long window =
+      atomic_load_explicit(&g_window_ns, memory_order_relaxed);
+  unsigned long long now = now_ns();
+  size_t n = 0;
+
+  *pending = 0;
+  for (;;) {
+    async_queue_t *best_q = NULL;
+    logger_record_t *best = NULL;
+    int complete = 1;
+
+    for (async_queue_t *q = g_queues; q; q = q->next) {
+      if (q->c_tail == q->c_head) {
+        int closed = atomic_load_explicit(&q->closed, memory_order_acquire);
+        q->c_head = atomic_load_explicit(&q->head, memory_order_acquire);
+        if (q->c_tail == q->c_head) {
+          if (!closed)
+            complete = 0;
+          continue;
+        }
+      }
+      logger_record_t *r = q->slots[q->c_tail & (LOGGER_ASYNC_SLOTS - 1)];
+      if (!best || r->ts_ns < best->ts_ns) {
+        best = r;
+        best_q = q;
+      }
+    }
+
+    if (!best)
+      break;
+    if (!flush && !complete && best->ts_ns + window > now) {
+      now = now_ns();
+      if (best->ts_ns + window > now) {
+        *pending = 1;
+        break;
+      }
+    }
+
+    if (++best_q->c_tail % TAIL_PUBLISH_EVERY == 0)
+      atomic_store_explicit(&best_q->tail, best_q->c_tail,
+                            memory_order_release);
+    emit_record(best);
+    ++n;
+  }
+
+  for (async_queue_t *q = g_queues; q; q = q->next)
+    atomic_store_explicit(&q->tail, q->c_tail, memory_order_release);
+
+  /* reap queues of exited threads once empty */
+  for (async_queue_t **pp = &g_queues; *pp;) {
+    async_queue_t *q = *pp;
+    if (atomic_load_explicit(&q->closed, memory_order_acquire) &&
+        q->c_tail == atomic_load_explicit(&q->head, memory_order_acquire)) {
+      *pp = q->next;
+      logger_arena_free(q, sizeof(*q));
+    } else {
+      pp = &q->next;
+    }
+  }
+  return n;
+}
+
+static void consumer_sleep(long ns) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_nsec += ns;
+  if (ts.tv_nsec >= 1000000000L) {
+    ts.tv_sec += 1;
+    ts.tv_nsec -= 1000000000L;
+  }
+
+  pthread_mutex_lock(&g_wake_mutex);
+  atomic_store_explicit(&g_consumer_idle, 1, memory_order_relaxed);
+  pthread_cond_timedwait(&g_wake_cond, &g_wake_mutex, &ts);
+  atomic_store_explicit(&g_consumer_idle, 0, memory_order_relaxed);
+  pthread_mutex_unlock(&g_wake_mutex);
+}
+
+static void *consumer_main(void *arg) {
+  (void)arg;
+  logger_thread_started("log-async");
+
+  for (;;) {
+    pthread_mutex_lock(&g_consumer_mutex);
+    if (!g_rings && !g_queues) {
+      g_consumer_running = 0;
+      pthread_mutex_unlock(&g_consumer_mutex);
+      break;
+    }
+    int pending;
+    size_t n = drain_rings_locked() + merge_queues_locked(0, &pending);
+    pthread_mutex_unlock(&g_consumer_mutex);
+
+    if (!n) {
+      unsigned idle_us;
+      logger_wait_t how = logger_thread_wait(&idle_us);
+      if (how == LOGGER_WAIT_SPIN) {
+        logger_cpu_relax();
+        continue;
+      }
+      if (how == LOGGER_WAIT_YIELD) {
+        sched_yield();
+        continue;
+      }
+      /* held-back records become due within the window */
+      long wait = idle_us ? (long)idle_us * 1000L : CONSUMER_IDLE_NS;
+      if (pending) {
+        unsigned long long w =
+            atomic_load_explicit(&g_window_ns, memory_order_relaxed) / 2;
+        wait = w < (unsigned long long)wait ? (long)w : wait;
+      }
+      consumer_sleep(wait > 0 ? wait : 1);
+    }
+  }
+  return NULL;
+}
+
+/* Starts the consumer if needed; g_consumer_mutex held. */
+static int consumer_start_locked(void) {
+  if (g_consumer_running)
+    return 1;
+
+  pthread_attr_t attr;
+  pthread_t tid;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  int rc = pthread_create(&tid, &attr, consumer_main, NULL);
+  pthread_attr_destroy(&attr);
+  if (rc != 0)
+    return 0;
+  g_consumer_running = 1;
+  return 1;
+}
+
+void logger_async_drain(void) {
+  int pending;
+  pthread_mutex_lock(&g_consumer_mutex);
+  drain_rings_locked();
+  merge_queues_locked(1, &pending);
+  pthread_mutex_unlock(&g_consumer_mutex);
+}
+
+/* ---- per-thread queues ---- */
+
+/*
+ * The consumer frees a closed ring once drained, so the thread must not
+ * reach it again: later calls (e.g. from other key destructors) take the
+ * synchronous path, and logger_log_rt() ones are dropped.
+ */
+static void ring_close(void *arg) {
+  rt_ring_t *r = (rt_ring_t *)arg;
+  if (logger_tls_rt == r)
+    logger_tls_rt = NULL;
+  if (r)
+    atomic_store_explicit(&r->closed, 1, memory_order_release);
+}
+
+/*
+ * Runs at thread exit. The consumer reaps the queue once drained, so later
+ * pushes of this thread (other key destructors) must not reach it, nor
+ * register a queue nobody would close.
+ */
+static void queue_close(void *arg) {
+  async_queue_t *q = (async_queue_t *)arg;
+  if (tls_queue == q) {
+    tls_queue = NULL;
+    tls_queue_closed = 1;
+  }
+  if (q)
+    atomic_store_explicit(&q->closed, 1, memory_order_release);
+}
+
+static void make_keys(void) {
+  pthread_key_create(&g_rt_key, ring_close);
+  pthread_key_create(&g_queue_key, queue_close);
+}
+
+static async_queue_t *queue_create(void) {
+  pthread_once(&g_key_once, make_keys);
+
+  async_queue_t *q = (async_queue_t *)logger_arena_alloc(sizeof(*q));
+  if (!q)
+    return NULL;
+  atomic_init(&q->head, 0);
+  atomic_init(&q->tail, 0);
+  atomic_init(&q->closed, 0);
+
+  pthread_mutex_lock(&g_consumer_mutex);
+  if (!consumer_start_locked()) {
+    pthread_mutex_unlock(&g_consumer_mutex);
+    logger_arena_free(q, sizeof(*q));
+    return NULL;
+  }
+  q->next = g_queues;
+  g_queues = q;
+  pthread_mutex_unlock(&g_consumer_mutex);
+
+  pthread_setspecific(g_queue_key, q);
+  tls_queue = q;
+  return q;
+}
+
+logger_status_t logger_set_thread_rt(int enabled) {
+  pthread_once(&g_key_once, make_keys);
+
+  if (!enabled) {
+    pthread_setspecific(g_rt_key, NULL);
+    ring_close(logger_tls_rt);
+    return LOGGER_OK;
+  }
+
+  if (logger_tls_rt)
+    return LOGGER_OK;
+  logger_ctx_current(1); /* thread id/name, looked up outside the ring */
+
+  rt_ring_t *r = (rt_ring_t *)logger_arena_alloc(sizeof(*r));
+  if (!r)
+    return LOGGER_OUT_OF_MEMORY;
+  atomic_init(&r->head, 0);
+  atomic_init(&r->tail, 0);
+  atomic_init(&r->closed, 0);
+
+  pthread_mutex_lock(&g_consumer_mutex);
+  if (!consumer_start_locked()) {
+    pthread_mutex_unlock(&g_consumer_mutex);
+    logger_arena_free(r, sizeof(*r));
+    return LOGGER_UNKOWN_ERROR;
+  }
+  r->next = g_rings;
+  g_rings = r;
+  pthread_mutex_unlock(&g_consumer_mutex);
+
+  pthread_setspecific(g_rt_key, r);
+  logger_tls_rt = r;
+  return LOGGER_OK;
+}
+
+logger_status_t logger_set_async_window(unsigned window_us) {
+  atomic_store_explicit(&g_window_ns, (unsigned long long)window_us * 1000ull,
+                        memory_order_relaxed);
+  return LOGGER_OK;
+}
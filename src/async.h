@@ -0,0 +1,98 @@
+/**
+ * @file async.h
+ * @brief Internal deferred-emission paths: real-time rings and async queues.
+ *
+ * Two kinds of per-thread single-producer/single-consumer queues feed one
+ * consumer thread:
+ * - real-time rings (logger_set_thread_rt()): preallocated slots the
+ *   producer formats into, or drops when full. No lock, allocation or
+ *   syscall on the producer side.
+ * - async queues (logger_set_async()): rings of pooled logger_record_t
+ *   pointers, stamped with CLOCK_MONOTONIC. A full queue makes the producer
+ *   yield instead of dropping.
+ *
+ * There is no shared producer-side cache line: each thread only writes its
+ * own queue head. The consumer merges the async queues by timestamp, holding
+ * a record back until it is older than the merge window unless every queue
+ * has something pending, so output is globally ordered within the window.
+ * It emits through logger_emit_h() on the record's handle, so records reach
+ * the backend children in that order.
+ *
+ * The consumer starts with the first queue and exits with the last one.
+ */
+#ifndef LOGGER_ASYNC_H
+#define LOGGER_ASYNC_H
+
+#include "backend.h"
+#include <stdarg.h>
+
+/** Slots per real-time ring (power of two). */
+#ifndef LOGGER_RT_SLOTS
+#define LOGGER_RT_SLOTS 256
+#endif
+
+/** Message capacity of a real-time slot; longer messages are truncated. */
+#ifndef LOGGER_RT_MSG_MAX
+#define LOGGER_RT_MSG_MAX 512
+#endif
+
+/** File name capacity of a real-time slot, for names not yet interned. */
+#ifndef LOGGER_RT_FILE_MAX
+#define LOGGER_RT_FILE_MAX 128
+#endif
+
+/** Record pointers per async queue (power of two). */
+#ifndef LOGGER_ASYNC_SLOTS
+#define LOGGER_ASYNC_SLOTS 256
+#endif
+
+/** Default merge window of the consumer, in microseconds. */
+#define LOGGER_ASYNC_WINDOW_US 200
+
+struct rt_ring;
+
+/** Calling thread's ring, or NULL when it is not in real-time mode. */
+extern _Thread_local struct rt_ring *logger_tls_rt;
+
+/**
+ * @brief Formats a record into the calling thread's ring.
+ *
+ * Wait-free. Never blocks, allocates or enters the kernel. Takes a
+ * reference on @p ctx (logger_ctx_current()), dropped once emitted.
+ * @return 1 if queued, 0 if dropped (no ring, or ring full).
+ */
+int logger_async_rt_push(logger_handle_t *h, logger_level_t level,
+                         const char *file, int line, unsigned long long seq,
+                         logger_ctx_t *ctx, const char *fmt, va_list args);
+
+/**
+ * @brief Formats a record into the calling thread's async queue.
+ *
+ * Creates the queue on the thread's first call. Waits (yielding) while the
+ * queue is full. Takes a reference on @p ctx, dropped once emitted.
+ * @return 1 if queued, 0 if no record or queue could be allocated, -1 if
+ *         the thread's queue was already released at thread exit: the
+ *         caller logs synchronously instead.
+ */
+int logger_async_push(logger_handle_t *h, logger_level_t level,
+                      const char *file, int line, unsigned long long seq,
+                      logger_ctx_t *ctx, const char *fmt, va_list args);
+
+/**
+ * @brief Emits every record queued so far, from the calling thread.
+ */
+void logger_async_drain(void);
+
+/**
+ * @brief Delivers an already formatted record to @p h's backend.
+ *
+ * Defined in logger.c. Applies the handle's level and started state and
+ * updates its counters like a synchronous logger_log_h() call. @p seq,
+ * @p ts_ns and @p ctx are what logger_backend_current_record() reports
+ * (0/NULL = unknown).
+ */
+void logger_emit_h(logger_handle_t *h, logger_level_t level, const char *file,
+                   int line, const char *msg, unsigned long long seq,
+                   unsigned long long ts_ns, const logger_ctx_t *ctx);
+
+#endif
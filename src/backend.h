@@ -1,6 +1,6 @@
 /**
  * @file backend.h
- * @brief Internal backend interface used by the logger.
+ * @brief Backend interface, for built-in outputs and user backends.
  *
  * A backend is a pluggable sink that receives already-formatted log messages.
  * Implementations must provide a vtable with:
@@ -8,16 +8,34 @@
  * - stop(): flush/close resources (idempotent)
  * - log(): emit a message (msg is already formatted)
  * - destroy(): free resources and the backend object
+ * - flush(): optional, make everything logged so far durable
+ * - prewarm(): optional, acquire resources ahead of the first record
+ * - log_batch(): optional, emit several records in one call
+ * - log_raw(): optional, emit a record from its format string and arguments
+ *
+ * Applications add their own backends next to the built-in outputs with
+ * logger_register_backend(); capability flags tell the logger how each one
+ * may be called (see logger_backend_caps_t).
  *
  * Ownership:
  * - The creator returns a heap-allocated logger_backend_t*.
  * - Whoever owns the backend must call vtbl->destroy().
+ *
+ * Ordering metadata and the logging thread's context of the record being
+ * logged are available from inside log() through
+ * logger_backend_current_record().
  */
 #ifndef LOGGER_BACKEND_H
 #define LOGGER_BACKEND_H
 
 #include "logger.h"
 
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * @brief Backend instance (opaque context + vtable).
  *
@@ -38,7 +56,15 @@ typedef struct logger_backend logger_backend_t;
  * - stop(): flush/close resources; should be safe to call multiple times
  * - log(): emit a single already-formatted message
  * - destroy(): free all resources (must tolerate partially-started objects)
+ * - flush(): optional (may be NULL); blocks until every message passed to
+ *   log() before the call is persisted as far as the backend can tell
+ * - prewarm(): optional (may be NULL); open/allocate/fault in what the first
+ *   log() would otherwise pay for
+ * - log_batch(): optional (may be NULL); used for LOGGER_BACKEND_BATCH
+ * - log_raw(): optional (may be NULL); used for LOGGER_BACKEND_RAW_ARGS
  */
+typedef struct logger_backend_record logger_backend_record_t;
+
 typedef struct logger_backend_vtbl {
   /**
    * @brief Starts the backend.
@@ -75,6 +101,60 @@ typedef struct logger_backend_vtbl {
    * @param backend Backend instance.
    */
   void (*destroy)(logger_backend_t *backend);
+
+  /**
+   * @brief Persists every message logged before the call (optional).
+   *
+   * Unlike stop(), the backend stays usable. May block; called from the
+   * flushing thread, concurrently with log().
+   *
+   * @param backend Backend instance.
+   * @return LOGGER_OK on success, or a logger_status_t error code on failure.
+   */
+  logger_status_t (*flush)(logger_backend_t *backend);
+
+  /**
+   * @brief Acquires resources ahead of the first record (optional).
+   *
+   * Called once from the logger's prewarm thread after start(),
+   * concurrently with log(). Failures are not reported; log() handles
+   * them as it would without prewarming.
+   *
+   * @param backend Backend instance.
+   */
+  void (*prewarm)(logger_backend_t *backend);
+
+  /**
+   * @brief Emits several records in capture order (optional).
+   *
+   * Called from a single delivery thread. Neither @p records nor the
+   * strings they point to outlive the call.
+   *
+   * @param backend Backend instance.
+   * @param records Records to emit.
+   * @param count   Number of records (> 0).
+   */
+  void (*log_batch)(logger_backend_t *backend,
+                    const logger_backend_record_t *records, size_t count);
+
+  /**
+   * @brief Emits a record before it is formatted (optional).
+   *
+   * Called instead of log() on the synchronous path, so the backend can
+   * keep the arguments in binary form or format them itself. Records that
+   * were queued (async, real-time) or collapsed by dedup are already text
+   * and still arrive through log().
+   *
+   * @param backend Backend instance.
+   * @param level Log level of the message.
+   * @param file Source file where the log was emitted.
+   * @param line Source line where the log was emitted.
+   * @param fmt  printf-style format string.
+   * @param args Arguments of @p fmt; the backend must va_copy() them to
+   *             read them more than once.
+   */
+  void (*log_raw)(logger_backend_t *backend, logger_level_t level,
+                  const char *file, int line, const char *fmt, va_list args);
 } logger_backend_vtbl_t;
 
 /**
@@ -90,4 +170,152 @@ typedef struct logger_backend {
   void *ctx;                         /**< Implementation-defined context. */
 } logger_backend_t;
 
+/**
+ * @brief Context of the logging thread (logger_ctx_push()), opaque.
+ *
+ * An immutable chain: each node adds one key/value to its parent, and the
+ * last node holds the thread's id and name. Read it with the
+ * logger_ctx_*() accessors below; it stays valid during the log() call.
+ */
+typedef struct logger_ctx logger_ctx_t;
+
+/**
+ * @brief Ordering metadata and context of a record.
+ */
+typedef struct logger_record_meta {
+  unsigned long long seq;   /**< Per-logger capture order, 0 if disabled. */
+  unsigned long long ts_ns; /**< CLOCK_MONOTONIC at capture, 0 if unknown. */
+  const logger_ctx_t *ctx;  /**< Thread's context, NULL if it has none. */
+  int thread;               /**< Show thread id/name (thread info on). */
+} logger_record_meta_t;
+
+/**
+ * @brief Metadata of the record the calling thread is delivering.
+ *
+ * Only meaningful inside log(). With logger_set_sequence() on, @c seq gives
+ * the order in which records were captured even when the express lane or
+ * the async merge window wrote them out of order.
+ *
+ * @return Never NULL. Unspecified outside a log() call.
+ */
+const logger_record_meta_t *logger_backend_current_record(void);
+
+/**
+ * @brief Rendered context fields, "tid=.. thread=.. key=value ...".
+ *
+ * Rendered once when the context is pushed, so this is a lookup.
+ *
+ * @param ctx         Context (NULL gives "").
+ * @param with_thread Non-zero to include the thread fields (pass
+ *                    logger_record_meta_t.thread).
+ * @param len         Receives the length.
+ * @return NUL-terminated text, valid as long as @p ctx.
+ */
+const char *logger_ctx_text(const logger_ctx_t *ctx, int with_thread,
+                            size_t *len);
+
+/** @brief Next node toward the thread node, NULL past it. */
+const logger_ctx_t *logger_ctx_parent(const logger_ctx_t *ctx);
+
+/** @brief Key pushed by this node, NULL for the thread node. */
+const char *logger_ctx_key(const logger_ctx_t *ctx);
+
+/** @brief Value pushed by this node, NULL for the thread node. */
+const char *logger_ctx_value(const logger_ctx_t *ctx);
+
+/** @brief Logging thread's kernel id (0 for NULL). */
+unsigned long logger_ctx_thread_id(const logger_ctx_t *ctx);
+
+/** @brief Logging thread's name, "" if it has none. */
+const char *logger_ctx_thread_name(const logger_ctx_t *ctx);
+
+/**
+ * @brief One record handed to log_batch().
+ */
+struct logger_backend_record {
+  logger_level_t level;
+  const char *file;         /**< Interned source file name. */
+  int line;
+  const char *msg;          /**< Formatted message. */
+  unsigned long long seq;   /**< Capture order, 0 if disabled. */
+  unsigned long long ts_ns; /**< CLOCK_MONOTONIC at capture. */
+  const logger_ctx_t *ctx;  /**< Thread's context, NULL if none. */
+  int thread;               /**< Show thread id/name. */
+};
+
+/**
+ * @brief Capability flags of a registered backend.
+ *
+ * They select how records reach the backend:
+ * - THREAD_SAFE alone: log() is called directly by the logging threads.
+ * - BATCH: records are queued and a delivery thread hands them over with
+ *   log_batch(), a batch every few milliseconds (ERROR+ at once).
+ * - neither: records are queued and a delivery thread calls log(), one
+ *   record at a time, so the backend needs no locking of its own.
+ * - RAW_ARGS (with THREAD_SAFE, without BATCH): log_raw() replaces log()
+ *   on the synchronous path.
+ *
+ * Queued delivery is lossless: a producer waits while both batches of a
+ * slow backend are full.
+ */
+typedef enum logger_backend_caps {
+  LOGGER_BACKEND_THREAD_SAFE = 1u << 0, /**< log() is reentrant */
+  LOGGER_BACKEND_BATCH = 1u << 1,       /**< implements log_batch() */
+  LOGGER_BACKEND_RAW_ARGS = 1u << 2     /**< implements log_raw() */
+} logger_backend_caps_t;
+
+/**
+ * @brief Registration of a user backend.
+ *
+ * The logger calls @c create each time it builds its outputs (at start,
+ * and at registration if already started) and owns the backends it gets.
+ */
+typedef struct logger_backend_desc {
+  const char *name;         /**< Unique per logger; copied. */
+  unsigned caps;            /**< logger_backend_caps_t flags. */
+  logger_level_t min_level; /**< Records below are not delivered. */
+  /** Builds a backend instance; returns NULL on failure. */
+  logger_backend_t *(*create)(void *arg);
+  void *arg; /**< Passed to create(). */
+  /** Releases arg on unregister and destroy (may be NULL). */
+  void (*free_arg)(void *arg);
+} logger_backend_desc_t;
+
+/**
+ * @brief Adds a user backend to the default logger.
+ *
+ * If the logger is started, the backend is built and starts receiving
+ * records immediately, like any reconfigured output.
+ *
+ * @param desc Backend description (copied).
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if logger is NULL,
+ *         LOGGER_INVALID_PATH if the name is NULL or empty,
+ *         LOGGER_OUT_OF_MEMORY, or LOGGER_UNKOWN_ERROR if @c create is NULL,
+ *         the name is taken or the backend could not be built.
+ */
+logger_status_t logger_register_backend(const logger_backend_desc_t *desc);
+
+/** @brief logger_register_backend() for a specific handle. */
+logger_status_t logger_register_backend_h(logger_handle_t *h,
+                                          const logger_backend_desc_t *desc);
+
+/**
+ * @brief Removes a user backend from the default logger.
+ *
+ * Returns once no record can still reach it; the backend is stopped and
+ * destroyed and @c free_arg releases its argument.
+ *
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if the logger is NULL or no
+ *         backend has that name.
+ */
+logger_status_t logger_unregister_backend(const char *name);
+
+/** @brief logger_unregister_backend() for a specific handle. */
+logger_status_t logger_unregister_backend_h(logger_handle_t *h,
+                                            const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
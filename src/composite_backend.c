@@ -1,16 +1,154 @@
 #include "composite_backend.h"
+#include "arena.h"
+#include "format.h"
+#include "record.h"
+#include "shard.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdlib.h>
+#include <string.h>
 
 /*
- * Composite backend context:
- * holds a dynamic list of child backends
+ * Composite backend context.
+ *
+ * The child list is an immutable snapshot (composite_set_t) published through
+ * an atomic pointer. log() never takes a lock: it registers itself in one of
+ * two reader counters of its thread's shard, walks the current snapshot and
+ * leaves. Writers (add/put/remove) build a new snapshot, publish it, and wait
+ * for a grace period (both reader counters of every shard drained once)
+ * before stopping/freeing what they replaced. Producers are never paused and
+ * no in-flight record is lost.
  */
-typedef struct composite_ctx {
-  logger_backend_t **items;
+typedef struct composite_child {
+  logger_backend_t *backend;
+  int tag;              /* caller-defined key, 0 = untagged */
+  atomic_int min_level; /* per-child filter */
+  atomic_int raw;       /* log_raw() on the synchronous path */
+} composite_child_t;
+
+typedef struct composite_set {
   size_t count;
-  size_t capacity;
+  composite_child_t *items[];
+} composite_set_t;
+
+/* Reader counters, one cache line per shard so producers do not contend. */
+typedef struct reader_shard {
+  _Alignas(LOGGER_CACHE_LINE) atomic_ulong readers[2];
+} reader_shard_t;
+
+typedef struct composite_ctx {
+  /* read-mostly: loaded by every log() call */
+  _Alignas(LOGGER_CACHE_LINE) _Atomic(composite_set_t *) set;
+  atomic_uint epoch;
+
+  reader_shard_t shards[LOGGER_SHARDS];
+
+  /* writer side */
+  _Alignas(LOGGER_CACHE_LINE) pthread_mutex_t writer; /* add/put/remove/... */
+  int started;
 } composite_ctx_t;
 
+static size_t set_size(size_t count) {
+  return sizeof(composite_set_t) + count * sizeof(composite_child_t *);
+}
+
+static composite_set_t *set_alloc(size_t count) {
+  composite_set_t *s = (composite_set_t *)logger_arena_alloc(set_size(count));
+  if (s)
+    s->count = count;
+  return s;
+}
+
+static void set_free(composite_set_t *s) {
+  if (s)
+    logger_arena_free(s, set_size(s->count));
+}
+
+/* Waits until no log() call can still be using a previously published set. */
+static void wait_for_readers(composite_ctx_t *ctx) {
+  for (int pass = 0; pass < 2; ++pass) {
+    unsigned old = atomic_fetch_add(&ctx->epoch, 1) & 1u;
+    for (int s = 0; s < LOGGER_SHARDS; ++s) {
+      while (atomic_load(&ctx->shards[s].readers[old]) != 0)
+        sched_yield();
+    }
+  }
+}
+
+/* Publishes @p next, retires the old snapshot and optionally one child. */
+static void publish(composite_ctx_t *ctx, composite_set_t *next,
+                    composite_child_t *retired) {
+  composite_set_t *prev = atomic_exchange(&ctx->set, next);
+  wait_for_readers(ctx);
+  set_free(prev);
+
+  if (retired) {
+    if (ctx->started)
+      retired->backend->vtbl->stop(retired->backend);
+    retired->backend->vtbl->destroy(retired->backend);
+    logger_arena_free(retired, sizeof(*retired));
+  }
+}
+
+static logger_status_t insert(composite_ctx_t *ctx, int tag,
+                              logger_backend_t *child) {
+  composite_child_t *item =
+      (composite_child_t *)logger_arena_alloc(sizeof(*item));
+  if (!item)
+    return LOGGER_OUT_OF_MEMORY;
+  item->backend = child;
+  item->tag = tag;
+  atomic_init(&item->min_level, LOGGER_LEVEL_TRACE);
+  atomic_init(&item->raw, 0);
+
+  pthread_mutex_lock(&ctx->writer);
+
+  composite_set_t *cur = atomic_load(&ctx->set);
+  size_t count = cur ? cur->count : 0;
+
+  size_t slot = count;
+  for (size_t i = 0; tag != 0 && i < count; ++i) {
+    if (cur->items[i]->tag == tag) {
+      slot = i;
+      break;
+    }
+  }
+
+  composite_set_t *next = set_alloc(slot == count ? count + 1 : count);
+  if (!next) {
+    pthread_mutex_unlock(&ctx->writer);
+    logger_arena_free(item, sizeof(*item));
+    return LOGGER_OUT_OF_MEMORY;
+  }
+
+  if (ctx->started) {
+    logger_status_t st = child->vtbl->start(child);
+    if (st != LOGGER_OK) {
+      pthread_mutex_unlock(&ctx->writer);
+      set_free(next);
+      logger_arena_free(item, sizeof(*item));
+      return st;
+    }
+  }
+
+  composite_child_t *retired = NULL;
+  for (size_t i = 0; i < count; ++i)
+    next->items[i] = cur->items[i];
+  if (slot < count) {
+    retired = cur->items[slot];
+    atomic_store(&item->min_level, atomic_load(&retired->min_level));
+    atomic_store(&item->raw,
+                 atomic_load(&retired->raw) && child->vtbl->log_raw);
+  }
+  next->items[slot] = item;
+
+  publish(ctx, next, retired);
+
+  pthread_mutex_unlock(&ctx->writer);
+  return LOGGER_OK;
+}
+
 /* ---- vtable methods ---- */
 
 static logger_status_t composite_start(logger_backend_t *self) {
@@ -18,11 +156,18 @@ static logger_status_t composite_start(logger_backend_t *self) {
   if (!ctx)
     return LOGGER_UNKOWN_ERROR;
 
-  for (size_t i = 0; i < ctx->count; ++i) {
-    logger_status_t st = ctx->items[i]->vtbl->start(ctx->items[i]);
-    if (st != LOGGER_OK)
+  pthread_mutex_lock(&ctx->writer);
+  composite_set_t *cur = atomic_load(&ctx->set);
+  for (size_t i = 0; cur && i < cur->count; ++i) {
+    logger_backend_t *b = cur->items[i]->backend;
+    logger_status_t st = b->vtbl->start(b);
+    if (st != LOGGER_OK) {
+      pthread_mutex_unlock(&ctx->writer);
       return st;
+    }
   }
+  ctx->started = 1;
+  pthread_mutex_unlock(&ctx->writer);
   return LOGGER_OK;
 }
 
@@ -31,11 +176,18 @@ static logger_status_t composite_stop(logger_backend_t *self) {
   if (!ctx)
     return LOGGER_UNKOWN_ERROR;
 
-  for (size_t i = 0; i < ctx->count; ++i) {
-    logger_status_t st = ctx->items[i]->vtbl->stop(ctx->items[i]);
-    if (st != LOGGER_OK)
+  pthread_mutex_lock(&ctx->writer);
+  ctx->started = 0;
+  composite_set_t *cur = atomic_load(&ctx->set);
+  for (size_t i = 0; cur && i < cur->count; ++i) {
+    logger_backend_t *b = cur->items[i]->backend;
+    logger_status_t st = b->vtbl->stop(b);
+    if (st != LOGGER_OK) {
+      pthread_mutex_unlock(&ctx->writer);
       return st;
+    }
   }
+  pthread_mutex_unlock(&ctx->writer);
   return LOGGER_OK;
 }
 
@@ -45,9 +197,99 @@ static void composite_log(logger_backend_t *self, logger_level_t level,
   if (!ctx)
     return;
 
-  for (size_t i = 0; i < ctx->count; ++i) {
-    ctx->items[i]->vtbl->log(ctx->items[i], level, file, line, msg);
+  atomic_ulong *readers = ctx->shards[logger_shard_index()].readers;
+  unsigned e = atomic_load(&ctx->epoch) & 1u;
+  atomic_fetch_add(&readers[e], 1);
+
+  composite_set_t *cur = atomic_load(&ctx->set);
+  for (size_t i = 0; cur && i < cur->count; ++i) {
+    composite_child_t *c = cur->items[i];
+    if ((int)level < atomic_load_explicit(&c->min_level, memory_order_relaxed))
+      continue;
+    c->backend->vtbl->log(c->backend, level, file, line, msg);
+  }
+
+  atomic_fetch_sub(&readers[e], 1);
+}
+
+/* Raw children get the arguments; the rest share one lazily formatted copy. */
+static void composite_log_raw(logger_backend_t *self, logger_level_t level,
+                              const char *file, int line, const char *fmt,
+                              va_list args) {
+  composite_ctx_t *ctx = (composite_ctx_t *)self->ctx;
+  if (!ctx)
+    return;
+
+  atomic_ulong *readers = ctx->shards[logger_shard_index()].readers;
+  unsigned e = atomic_load(&ctx->epoch) & 1u;
+  atomic_fetch_add(&readers[e], 1);
+
+  char msg[LOGGER_RECORD_MSG_MAX];
+  int formatted = 0;
+  composite_set_t *cur = atomic_load(&ctx->set);
+  for (size_t i = 0; cur && i < cur->count; ++i) {
+    composite_child_t *c = cur->items[i];
+    if ((int)level < atomic_load_explicit(&c->min_level, memory_order_relaxed))
+      continue;
+    va_list ap;
+    va_copy(ap, args);
+    if (atomic_load_explicit(&c->raw, memory_order_relaxed)) {
+      c->backend->vtbl->log_raw(c->backend, level, file, line, fmt, ap);
+    } else {
+      if (!formatted) {
+        logger_vformat(msg, sizeof(msg), fmt, ap);
+        formatted = 1;
+      }
+      c->backend->vtbl->log(c->backend, level, file, line, msg);
+    }
+    va_end(ap);
   }
+
+  atomic_fetch_sub(&readers[e], 1);
+}
+
+static logger_status_t composite_flush(logger_backend_t *self) {
+  composite_ctx_t *ctx = (composite_ctx_t *)self->ctx;
+  if (!ctx)
+    return LOGGER_UNKOWN_ERROR;
+
+  /* a read section, like log(): children stay alive while flushed */
+  atomic_ulong *readers = ctx->shards[logger_shard_index()].readers;
+  unsigned e = atomic_load(&ctx->epoch) & 1u;
+  atomic_fetch_add(&readers[e], 1);
+
+  logger_status_t st = LOGGER_OK;
+  composite_set_t *cur = atomic_load(&ctx->set);
+  for (size_t i = 0; cur && i < cur->count; ++i) {
+    logger_backend_t *b = cur->items[i]->backend;
+    if (!b->vtbl->flush)
+      continue;
+    logger_status_t r = b->vtbl->flush(b);
+    if (r != LOGGER_OK && st == LOGGER_OK)
+      st = r;
+  }
+
+  atomic_fetch_sub(&readers[e], 1);
+  return st;
+}
+
+static void composite_prewarm(logger_backend_t *self) {
+  composite_ctx_t *ctx = (composite_ctx_t *)self->ctx;
+  if (!ctx)
+    return;
+
+  atomic_ulong *readers = ctx->shards[logger_shard_index()].readers;
+  unsigned e = atomic_load(&ctx->epoch) & 1u;
+  atomic_fetch_add(&readers[e], 1);
+
+  composite_set_t *cur = atomic_load(&ctx->set);
+  for (size_t i = 0; cur && i < cur->count; ++i) {
+    logger_backend_t *b = cur->items[i]->backend;
+    if (b->vtbl->prewarm)
+      b->vtbl->prewarm(b);
+  }
+
+  atomic_fetch_sub(&readers[e], 1);
 }
 
 static void composite_destroy(logger_backend_t *self) {
@@ -56,34 +298,49 @@ static void composite_destroy(logger_backend_t *self) {
 
   composite_ctx_t *ctx = (composite_ctx_t *)self->ctx;
   if (ctx) {
-    for (size_t i = 0; i < ctx->count; ++i) {
-      ctx->items[i]->vtbl->destroy(ctx->items[i]);
+    composite_set_t *cur = atomic_load(&ctx->set);
+    for (size_t i = 0; cur && i < cur->count; ++i) {
+      cur->items[i]->backend->vtbl->destroy(cur->items[i]->backend);
+      logger_arena_free(cur->items[i], sizeof(composite_child_t));
     }
-    free(ctx->items);
-    free(ctx);
+    set_free(cur);
+    pthread_mutex_destroy(&ctx->writer);
+    logger_arena_free(ctx, sizeof(*ctx));
   }
-  free(self);
+  logger_arena_free(self, sizeof(*self));
 }
 
 /* ---- vtable instance ---- */
 
-static const logger_backend_vtbl_t COMPOSITE_VTBL = {.start = composite_start,
-                                                     .stop = composite_stop,
-                                                     .log = composite_log,
-                                                     .destroy =
-                                                         composite_destroy};
+static const logger_backend_vtbl_t COMPOSITE_VTBL = {
+    .start = composite_start,
+    .stop = composite_stop,
+    .log = composite_log,
+    .destroy = composite_destroy,
+    .flush = composite_flush,
+    .prewarm = composite_prewarm,
+    .log_raw = composite_log_raw};
 
 logger_backend_t *logger_backend_composite_create(void) {
-  logger_backend_t *backend = (logger_backend_t *)calloc(1, sizeof(*backend));
+  logger_backend_t *backend =
+      (logger_backend_t *)logger_arena_alloc(sizeof(*backend));
   if (!backend)
     return NULL;
 
-  composite_ctx_t *ctx = (composite_ctx_t *)calloc(1, sizeof(*ctx));
+  composite_ctx_t *ctx = (composite_ctx_t *)logger_arena_alloc(sizeof(*ctx));
   if (!ctx) {
-    free(backend);
+    logger_arena_free(backend, sizeof(*backend));
     return NULL;
   }
 
+  atomic_init(&ctx->set, NULL);
+  atomic_init(&ctx->epoch, 0);
+  for (int s = 0; s < LOGGER_SHARDS; ++s) {
+    atomic_init(&ctx->shards[s].readers[0], 0);
+    atomic_init(&ctx->shards[s].readers[1], 0);
+  }
+  pthread_mutex_init(&ctx->writer, NULL);
+
   backend->vtbl = &COMPOSITE_VTBL;
   backend->ctx = ctx;
 
@@ -92,6 +349,12 @@ logger_backend_t *logger_backend_composite_create(void) {
 
 logger_status_t logger_backend_composite_add(logger_backend_t *composite,
                                              logger_backend_t *child) {
+  return logger_backend_composite_put(composite, 0, child);
+}
+
+logger_status_t logger_backend_composite_put(logger_backend_t *composite,
+                                             int tag,
+                                             logger_backend_t *child) {
   if (!composite || !child)
     return LOGGER_NO_EXIST;
 
@@ -99,17 +362,96 @@ logger_status_t logger_backend_composite_add(logger_backend_t *composite,
   if (!ctx)
     return LOGGER_UNKOWN_ERROR;
 
-  if (ctx->count == ctx->capacity) {
-    size_t new_capacity = (ctx->capacity == 0) ? 4 : ctx->capacity * 2;
-    logger_backend_t **new_items = (logger_backend_t **)realloc(
-        ctx->items, new_capacity * sizeof(*new_items));
-    if (!new_items)
-      return LOGGER_OUT_OF_MEMORY;
+  return insert(ctx, tag, child);
+}
+
+logger_status_t logger_backend_composite_remove(logger_backend_t *composite,
+                                                int tag) {
+  if (!composite || tag == 0)
+    return LOGGER_NO_EXIST;
+
+  composite_ctx_t *ctx = (composite_ctx_t *)composite->ctx;
+  if (!ctx)
+    return LOGGER_UNKOWN_ERROR;
+
+  pthread_mutex_lock(&ctx->writer);
 
-    ctx->items = new_items;
-    ctx->capacity = new_capacity;
+  composite_set_t *cur = atomic_load(&ctx->set);
+  size_t count = cur ? cur->count : 0;
+  size_t slot = count;
+  for (size_t i = 0; i < count; ++i) {
+    if (cur->items[i]->tag == tag) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot == count) {
+    pthread_mutex_unlock(&ctx->writer);
+    return LOGGER_NO_EXIST;
   }
 
-  ctx->items[ctx->count++] = child;
+  composite_set_t *next = set_alloc(count - 1);
+  if (!next) {
+    pthread_mutex_unlock(&ctx->writer);
+    return LOGGER_OUT_OF_MEMORY;
+  }
+  for (size_t i = 0, j = 0; i < count; ++i) {
+    if (i != slot)
+      next->items[j++] = cur->items[i];
+  }
+
+  publish(ctx, next, cur->items[slot]);
+
+  pthread_mutex_unlock(&ctx->writer);
   return LOGGER_OK;
 }
+
+logger_status_t logger_backend_composite_set_level(logger_backend_t *composite,
+                                                   int tag,
+                                                   logger_level_t level) {
+  if (!composite)
+    return LOGGER_NO_EXIST;
+
+  composite_ctx_t *ctx = (composite_ctx_t *)composite->ctx;
+  if (!ctx)
+    return LOGGER_UNKOWN_ERROR;
+
+  logger_status_t st = LOGGER_NO_EXIST;
+  pthread_mutex_lock(&ctx->writer);
+  composite_set_t *cur = atomic_load(&ctx->set);
+  for (size_t i = 0; cur && i < cur->count; ++i) {
+    if (cur->items[i]->tag == tag) {
+      atomic_store(&cur->items[i]->min_level, (int)level);
+      st = LOGGER_OK;
+    }
+  }
+  pthread_mutex_unlock(&ctx->writer);
+  return st;
+}
+
+logger_status_t logger_backend_composite_set_raw(logger_backend_t *composite,
+                                                 int tag, int enabled) {
+  if (!composite)
+    return LOGGER_NO_EXIST;
+
+  composite_ctx_t *ctx = (composite_ctx_t *)composite->ctx;
+  if (!ctx)
+    return LOGGER_UNKOWN_ERROR;
+
+  logger_status_t st = LOGGER_NO_EXIST;
+  pthread_mutex_lock(&ctx->writer);
+  composite_set_t *cur = atomic_load(&ctx->set);
+  for (size_t i = 0; cur && i < cur->count; ++i) {
+    composite_child_t *c = cur->items[i];
+    if (c->tag != tag)
+      continue;
+    if (enabled && !c->backend->vtbl->log_raw) {
+      st = LOGGER_UNKOWN_ERROR;
+      continue;
+    }
+    atomic_store(&c->raw, enabled != 0);
+    st = LOGGER_OK;
+  }
+  pthread_mutex_unlock(&ctx->writer);
+  return st;
+}
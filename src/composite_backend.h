@@ -6,6 +6,19 @@
  * - Console + File
  * - Quill + Tracy
  *
+ * Live reconfiguration:
+ * - Children can be added, replaced or removed while other threads are
+ *   logging through the composite. log() takes no lock; replaced/removed
+ *   children are stopped and destroyed only after every in-flight log()
+ *   call has left them, so no record is dropped.
+ * - Children may carry a non-zero tag (e.g. a logger_output_t) used to
+ *   replace, remove or re-level them individually.
+ *
+ * Raw arguments:
+ * - vtbl->log_raw() formats the record at most once, and only if a child
+ *   that passes the level filter wants text; children marked raw receive
+ *   the format string and arguments instead.
+ *
  * Ownership:
  * - After calling logger_backend_composite_add(composite, child),
  *   the composite takes ownership of `child` and will destroy it.
@@ -39,4 +52,66 @@ logger_backend_t *logger_backend_composite_create(void);
 logger_status_t logger_backend_composite_add(logger_backend_t *composite,
                                              logger_backend_t *child);
 
+/**
+ * @brief Adds a tagged child, or replaces the child with the same tag.
+ *
+ * If the composite is started, @p child is started before it becomes
+ * visible to log(). A replaced child keeps its level, and is stopped and
+ * destroyed once no log() call can still reach it.
+ *
+ * Ownership:
+ * - On success, the composite takes ownership of @p child.
+ * - On failure, the caller keeps ownership of @p child.
+ *
+ * @param composite Composite backend instance.
+ * @param tag Child key; 0 behaves like logger_backend_composite_add().
+ * @param child Child backend instance.
+ *
+ * @return LOGGER_OK on success, or a logger_status_t error code.
+ */
+logger_status_t logger_backend_composite_put(logger_backend_t *composite,
+                                             int tag,
+                                             logger_backend_t *child);
+
+/**
+ * @brief Removes (stops and destroys) the child with the given tag.
+ *
+ * Returns once no log() call can still reach the removed child.
+ *
+ * @param composite Composite backend instance.
+ * @param tag Non-zero child key.
+ *
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if no child has @p tag.
+ */
+logger_status_t logger_backend_composite_remove(logger_backend_t *composite,
+                                                int tag);
+
+/**
+ * @brief Sets the minimum level forwarded to the child with the given tag.
+ *
+ * Takes effect immediately for subsequent log() calls.
+ *
+ * @param composite Composite backend instance.
+ * @param tag Child key.
+ * @param level Minimum severity forwarded to that child.
+ *
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if no child has @p tag.
+ */
+logger_status_t logger_backend_composite_set_level(logger_backend_t *composite,
+                                                   int tag,
+                                                   logger_level_t level);
+
+/**
+ * @brief Hands records to the child's log_raw() on the synchronous path.
+ *
+ * @param composite Composite backend instance.
+ * @param tag Child key.
+ * @param enabled Non-zero to call log_raw(), zero for log().
+ *
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if no child has @p tag,
+ *         LOGGER_UNKOWN_ERROR if the child has no log_raw().
+ */
+logger_status_t logger_backend_composite_set_raw(logger_backend_t *composite,
+                                                 int tag, int enabled);
+
 #endif
@@ -0,0 +1,414 @@
+#define _GNU_SOURCE /* strcasecmp, pipe2 */
+
+#include "logger.h"
+#include "threads.h"
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/* ---- parsing ---- */
+
+static char *trim(char *s) {
+  while (isspace((unsigned char)*s))
+    ++s;
+  char *end = s + strlen(s);
+  while (end > s && isspace((unsigned char)end[-1]))
+    *--end = '\0';
+  return s;
+}
+
+static int parse_level(const char *v, logger_level_t *out) {
+  static const char *names[] = {"trace", "debug", "info",
+                                "warn",  "error", "fatal"};
+  for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); ++i) {
+    if (strcasecmp(v, names[i]) == 0) {
+      *out = (logger_level_t)i;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int parse_switch(const char *v, int *out) {
+  if (strcasecmp(v, "on") == 0 || strcasecmp(v, "true") == 0 ||
+      strcmp(v, "1") == 0) {
+    *out = 1;
+    return 1;
+  }
+  if (strcasecmp(v, "off") == 0 || strcasecmp(v, "false") == 0 ||
+      strcmp(v, "0") == 0) {
+    *out = 0;
+    return 1;
+  }
+  return 0;
+}
+
+static int parse_output(const char *v, logger_output_t *out) {
+  static const struct {
+    const char *name;
+    logger_output_t out;
+  } outputs[] = {{"console", LOGGER_OUTPUT_CONSOLE},
+                 {"file", LOGGER_OUTPUT_FILE},
+                 {"jsonl", LOGGER_OUTPUT_JSONL},
+                 {"tracy", LOGGER_OUTPUT_TRACY},
+                 {"quill", LOGGER_OUTPUT_QUILL},
+                 {"journald", LOGGER_OUTPUT_JOURNALD}};
+  for (size_t i = 0; i < sizeof(outputs) / sizeof(outputs[0]); ++i) {
+    if (strcasecmp(v, outputs[i].name) == 0) {
+      *out = outputs[i].out;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int parse_compression(const char *v, logger_compression_t *out) {
+  static const char *names[] = {"none", "lz4", "zstd"};
+  for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); ++i) {
+    if (strcasecmp(v, names[i]) == 0) {
+      *out = (logger_compression_t)i;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int parse_sched(const char *v, logger_sched_t *out) {
+  static const char *names[] = {"inherit", "other", "batch",
+                                "idle",    "fifo",  "rr"};
+  for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); ++i) {
+    if (strcasecmp(v, names[i]) == 0) {
+      *out = (logger_sched_t)i;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int parse_wait(const char *v, logger_wait_t *out) {
+  static const char *names[] = {"sleep", "yield", "spin"};
+  for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); ++i) {
+    if (strcasecmp(v, names[i]) == 0) {
+      *out = (logger_wait_t)i;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* threads.* keys: process-wide, changed one field at a time. */
+static logger_status_t apply_threads(const char *key, const char *val) {
+  logger_thread_options_t o;
+  logger_get_thread_options(&o);
+  char cpus[256];
+  snprintf(cpus, sizeof(cpus), "%s", o.cpus);
+  o.cpus = cpus;
+
+  char *end;
+  if (strcasecmp(key, "cpus") == 0) {
+    o.cpus = strcasecmp(val, "all") == 0 ? "" : val;
+  } else if (strcasecmp(key, "sched") == 0) {
+    if (!parse_sched(val, &o.sched))
+      return LOGGER_OK;
+  } else if (strcasecmp(key, "priority") == 0) {
+    long p = strtol(val, &end, 10);
+    if (end == val || *end)
+      return LOGGER_OK;
+    o.priority = (int)p;
+  } else if (strcasecmp(key, "wait") == 0) {
+    if (!parse_wait(val, &o.wait))
+      return LOGGER_OK;
+  } else if (strcasecmp(key, "idle_us") == 0) {
+    unsigned long us = strtoul(val, &end, 10);
+    if (end == val || *end)
+      return LOGGER_OK;
+    o.idle_us = (unsigned)us;
+  } else {
+    return LOGGER_OK;
+  }
+  return logger_set_thread_options(&o);
+}
+
+static logger_status_t apply_entry(logger_handle_t *h, const char *key,
+                                   const char *val) {
+  logger_level_t lvl;
+  int on;
+
+  if (strcasecmp(key, "level") == 0) {
+    if (parse_level(val, &lvl))
+      return logger_set_level_h(h, lvl);
+  } else if (strncasecmp(key, "level.", 6) == 0) {
+    logger_output_t out;
+    if (parse_output(key + 6, &out) && parse_level(val, &lvl))
+      return logger_set_output_level_h(h, out, lvl);
+  } else if (strcasecmp(key, "console") == 0) {
+    if (parse_switch(val, &on))
+      return on ? logger_enable_console_h(h) : logger_disable_console_h(h);
+  } else if (strcasecmp(key, "tracy") == 0) {
+    if (parse_switch(val, &on))
+      return on ? logger_enable_tracy_h(h) : logger_disable_tracy_h(h);
+  } else if (strcasecmp(key, "file") == 0) {
+    if (parse_switch(val, &on) && !on)
+      return logger_disable_file_output_h(h);
+    return logger_enable_file_output_h(h, val);
+  } else if (strcasecmp(key, "file.compression") == 0) {
+    logger_compression_t codec;
+    if (parse_compression(val, &codec))
+      return logger_set_file_compression_h(h, codec, 0);
+  } else if (strcasecmp(key, "file.durable") == 0) {
+    if (parse_switch(val, &on))
+      return logger_set_file_durable_h(h, on, 0);
+  } else if (strcasecmp(key, "file.index") == 0) {
+    if (parse_switch(val, &on))
+      return logger_set_file_index_h(h, on);
+  } else if (strcasecmp(key, "file.latency_us") == 0) {
+    char *end;
+    unsigned long us = strtoul(val, &end, 10);
+    if (end != val && !*end)
+      return logger_set_file_latency_target_h(h, (unsigned)us);
+  } else if (strcasecmp(key, "dedup") == 0) {
+    if (parse_switch(val, &on))
+      return logger_set_dedup_h(h, on, on ? 1000 : 0);
+  } else if (strcasecmp(key, "express") == 0) {
+    if (parse_level(val, &lvl))
+      return logger_set_express_lane_h(h, 1, lvl);
+    if (parse_switch(val, &on) && !on)
+      return logger_set_express_lane_h(h, 0, LOGGER_LEVEL_ERROR);
+  } else if (strcasecmp(key, "sequence") == 0) {
+    if (parse_switch(val, &on))
+      return logger_set_sequence_h(h, on);
+  } else if (strcasecmp(key, "thread") == 0) {
+    if (parse_switch(val, &on))
+      return logger_set_thread_info_h(h, on);
+  } else if (strcasecmp(key, "journald") == 0) {
+    if (parse_switch(val, &on))
+      return on ? logger_enable_journald_h(h, NULL)
+                : logger_disable_journald_h(h);
+    return logger_enable_journald_h(h, val);
+  } else if (strncasecmp(key, "threads.", 8) == 0) {
+    return apply_threads(key + 8, val);
+  } else if (strcasecmp(key, "jsonl") == 0) {
+    if (parse_switch(val, &on) && !on)
+      return logger_disable_jsonl_output_h(h);
+    return logger_enable_jsonl_output_h(h, val);
+  }
+  return LOGGER_OK; /* unknown key or value: ignored */
+}
+
+logger_status_t logger_load_config_h(logger_handle_t *h, const char *path) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  if (!path || !path[0])
+    return LOGGER_INVALID_PATH;
+
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return LOGGER_UNABLE_TO_OPEN_FILE;
+
+  logger_status_t first_err = LOGGER_OK;
+  char line[1024];
+  while (fgets(line, sizeof(line), f)) {
+    char *hash = strchr(line, '#');
+    if (hash)
+      *hash = '\0';
+    char *eq = strchr(line, '=');
+    if (!eq)
+      continue;
+    *eq = '\0';
+
+    char *key = trim(line);
+    char *val = trim(eq + 1);
+    if (!key[0] || !val[0])
+      continue;
+
+    logger_status_t st = apply_entry(h, key, val);
+    if (st != LOGGER_OK && first_err == LOGGER_OK)
+      first_err = st;
+  }
+
+  fclose(f);
+  return first_err;
+}
+
+/* ---- watching ---- */
+
+#ifdef __linux__
+typedef struct config_watch {
+  logger_handle_t *h;
+  char *path;
+  const char *base; /* points into path */
+  int ifd;
+  int wake[2];
+  pthread_t thread;
+  struct config_watch *next;
+} config_watch_t;
+
+static pthread_mutex_t g_watch_mutex = PTHREAD_MUTEX_INITIALIZER;
+static config_watch_t *g_watches = NULL;
+
+static void *watch_main(void *arg) {
+  config_watch_t *w = (config_watch_t *)arg;
+  char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  logger_thread_started("log-config");
+
+  for (;;) {
+    struct pollfd fds[2] = {{w->ifd, POLLIN, 0}, {w->wake[0], POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0)
+      continue;
+    if (fds[1].revents)
+      break;
+    if (!(fds[0].revents & POLLIN))
+      continue;
+
+    ssize_t n = read(w->ifd, buf, sizeof(buf));
+    int changed = 0;
+    for (ssize_t off = 0; off < n;) {
+      const struct inotify_event *ev = (const struct inotify_event *)(buf + off);
+      if (ev->len && strcmp(ev->name, w->base) == 0)
+        changed = 1;
+      off += (ssize_t)(sizeof(*ev) + ev->len);
+    }
+
+    if (changed)
+      logger_load_config_h(w->h, w->path);
+  }
+  return NULL;
+}
+
+static void watch_free(config_watch_t *w) {
+  if (w->ifd >= 0)
+    close(w->ifd);
+  if (w->wake[0] >= 0)
+    close(w->wake[0]);
+  if (w->wake[1] >= 0)
+    close(w->wake[1]);
+  free(w->path);
+  free(w);
+}
+#endif
+
+logger_status_t logger_watch_config_h(logger_handle_t *h, const char *path) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  if (!path || !path[0])
+    return LOGGER_INVALID_PATH;
+
+#ifdef __linux__
+  config_watch_t *w = (config_watch_t *)calloc(1, sizeof(*w));
+  if (!w)
+    return LOGGER_OUT_OF_MEMORY;
+  w->h = h;
+  w->ifd = w->wake[0] = w->wake[1] = -1;
+
+  w->path = strdup(path);
+  if (!w->path) {
+    watch_free(w);
+    return LOGGER_OUT_OF_MEMORY;
+  }
+
+  /* Watch the directory: editors often replace the file via rename(). */
+  char *dir = strdup(path);
+  if (!dir) {
+    watch_free(w);
+    return LOGGER_OUT_OF_MEMORY;
+  }
+  char *slash = strrchr(dir, '/');
+  const char *dir_path = ".";
+  if (slash) {
+    *slash = '\0';
+    dir_path = (slash == dir) ? "/" : dir;
+  }
+  const char *base = strrchr(w->path, '/');
+  w->base = base ? base + 1 : w->path;
+
+  w->ifd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+  int wd = w->ifd >= 0 ? inotify_add_watch(w->ifd, dir_path,
+                                           IN_CLOSE_WRITE | IN_MOVED_TO)
+                       : -1;
+  free(dir);
+  if (wd < 0 || pipe2(w->wake, O_CLOEXEC) != 0) {
+    watch_free(w);
+    return LOGGER_UNABLE_TO_OPEN_FILE;
+  }
+
+  logger_status_t st = logger_load_config_h(h, w->path);
+  if (st != LOGGER_OK) {
+    watch_free(w);
+    return st;
+  }
+
+  pthread_mutex_lock(&g_watch_mutex);
+  for (config_watch_t *it = g_watches; it; it = it->next) {
+    if (it->h == h) {
+      pthread_mutex_unlock(&g_watch_mutex);
+      watch_free(w);
+      return LOGGER_UNKOWN_ERROR;
+    }
+  }
+  if (pthread_create(&w->thread, NULL, watch_main, w) != 0) {
+    pthread_mutex_unlock(&g_watch_mutex);
+    watch_free(w);
+    return LOGGER_UNKOWN_ERROR;
+  }
+  w->next = g_watches;
+  g_watches = w;
+  pthread_mutex_unlock(&g_watch_mutex);
+
+  return LOGGER_OK;
+#else
+  return LOGGER_UNKOWN_ERROR;
+#endif
+}
+
+logger_status_t logger_unwatch_config_h(logger_handle_t *h) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+
+#ifdef __linux__
+  config_watch_t *w = NULL;
+  pthread_mutex_lock(&g_watch_mutex);
+  for (config_watch_t **pp = &g_watches; *pp; pp = &(*pp)->next) {
+    if ((*pp)->h == h) {
+      w = *pp;
+      *pp = w->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&g_watch_mutex);
+
+  if (w) {
+    char c = 0;
+    while (write(w->wake[1], &c, 1) < 0)
+      ;
+    pthread_join(w->thread, NULL);
+    watch_free(w);
+  }
+#endif
+
+  return LOGGER_OK;
+}
+
+/* ---- default-handle API ---- */
+
+logger_status_t logger_load_config(const char *path) {
+  return logger_load_config_h(logger_default(), path);
+}
+
+logger_status_t logger_watch_config(const char *path) {
+  return logger_watch_config_h(logger_default(), path);
+}
+
+logger_status_t logger_unwatch_config() {
+  return logger_unwatch_config_h(logger_default());
+}
@@ -1,6 +1,11 @@
+#define _POSIX_C_SOURCE 200809L /* flockfile, putc_unlocked */
+
 #include "console_backend.h"
+#include "arena.h"
+#include "srcloc.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 static const char *lvl_to_str(logger_level_t lvl) {
   switch (lvl) {
@@ -30,20 +35,53 @@ static logger_status_t c_stop(logger_backend_t *self) {
   return LOGGER_OK;
 }
 
+static logger_status_t c_flush(logger_backend_t *self) {
+  (void)self;
+  int ok = fflush(stdout) == 0;
+  ok = fflush(stderr) == 0 && ok;
+  return ok ? LOGGER_OK : LOGGER_UNKOWN_ERROR;
+}
+
 static void c_log(logger_backend_t *self, logger_level_t lvl, const char *file,
                   int line, const char *msg) {
   (void)self;
   FILE *out = (lvl >= LOGGER_LEVEL_ERROR) ? stderr : stdout;
-  fprintf(out, "[%s] %s:%d | %s\n", lvl_to_str(lvl), file, line, msg);
+
+  const logger_record_meta_t *meta = logger_backend_current_record();
+  size_t flen;
+  const char *fields = logger_ctx_text(meta->ctx, meta->thread, &flen);
+
+  size_t plen;
+  const char *prefix = logger_srcloc_prefix(lvl, file, line, &plen);
+  if (!prefix) {
+    fprintf(out, "[%s] %s:%d | %s%s%s\n", lvl_to_str(lvl), file, line, fields,
+            flen ? " | " : "", msg);
+    return;
+  }
+
+  flockfile(out);
+  fwrite(prefix, 1, plen, out);
+  if (flen) {
+    fwrite(fields, 1, flen, out);
+    fwrite(" | ", 1, 3, out);
+  }
+  fwrite(msg, 1, strlen(msg), out);
+  putc_unlocked('\n', out);
+  funlockfile(out);
 }
 
-static void c_destroy(logger_backend_t *self) { free(self); }
+static void c_destroy(logger_backend_t *self) {
+  logger_arena_free(self, sizeof(*self));
+}
 
-static const logger_backend_vtbl_t V = {
-    .start = c_start, .stop = c_stop, .log = c_log, .destroy = c_destroy};
+static const logger_backend_vtbl_t V = {.start = c_start,
+                                        .stop = c_stop,
+                                        .log = c_log,
+                                        .destroy = c_destroy,
+                                        .flush = c_flush};
 
 logger_backend_t *logger_backend_console_create(void) {
-  logger_backend_t *b = (logger_backend_t *)calloc(1, sizeof(*b));
+  logger_backend_t *b = (logger_backend_t *)logger_arena_alloc(sizeof(*b));
   if (!b)
     return NULL;
   b->vtbl = &V;
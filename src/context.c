@@ -0,0 +1,245 @@
+#define _GNU_SOURCE /* pthread_getname_np, syscall */
+
+#include "context.h"
+#include "arena.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* Top of this thread's stack; owns one reference. */
+static _Thread_local logger_ctx_t *tls_top = NULL;
+
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_top_key;
+
+static void top_release(void *arg) {
+  if (tls_top == arg)
+    tls_top = NULL;
+  logger_ctx_release((logger_ctx_t *)arg);
+}
+
+static void make_key(void) { pthread_key_create(&g_top_key, top_release); }
+
+/* Installs @p c as the top, taking over its reference. */
+static void set_top(logger_ctx_t *c) {
+  logger_ctx_t *old = tls_top;
+  tls_top = c;
+  pthread_once(&g_key_once, make_key);
+  pthread_setspecific(g_top_key, c);
+  logger_ctx_release(old);
+}
+
+static logger_ctx_t *node_alloc(size_t text_len, size_t extra) {
+  size_t size = sizeof(logger_ctx_t) + text_len + 1 + extra;
+  logger_ctx_t *c = (logger_ctx_t *)logger_arena_alloc(size);
+  if (!c)
+    return NULL;
+  atomic_init(&c->refs, 1);
+  c->size = size;
+  return c;
+}
+
+static logger_ctx_t *thread_node(const char *name) {
+  char buf[LOGGER_THREAD_NAME_MAX] = "";
+  if (name) {
+    snprintf(buf, sizeof(buf), "%s", name);
+  } else {
+#if defined(__linux__) && defined(__GLIBC__)
+    if (pthread_getname_np(pthread_self(), buf, sizeof(buf)) != 0)
+      buf[0] = '\0';
+#endif
+  }
+
+  unsigned long tid;
+#ifdef __linux__
+  tid = (unsigned long)syscall(SYS_gettid);
+#else
+  tid = (unsigned long)pthread_self();
+#endif
+
+  char text[32 + LOGGER_THREAD_NAME_MAX];
+  int n = buf[0] ? snprintf(text, sizeof(text), "tid=%lu thread=%s", tid, buf)
+                 : snprintf(text, sizeof(text), "tid=%lu", tid);
+  size_t tlen = n < 0 ? 0 : (size_t)n;
+  size_t nlen = strlen(buf);
+
+  logger_ctx_t *c = node_alloc(tlen, nlen + 1);
+  if (!c)
+    return NULL;
+  memcpy(c->text, text, tlen);
+  char *nm = c->text + tlen + 1;
+  memcpy(nm, buf, nlen + 1);
+  c->tid = tid;
+  c->name = nm;
+  c->thread_len = tlen;
+  c->len = tlen;
+  return c;
+}
+
+/* New node for key=value on top of @p parent, taking over its reference. */
+static logger_ctx_t *field_node(logger_ctx_t *parent, const char *key,
+                                const char *value) {
+  size_t klen = strnlen(key, LOGGER_CTX_KEY_MAX - 1);
+  size_t vlen = strnlen(value, LOGGER_CTX_VALUE_MAX - 1);
+  size_t plen = parent->len;
+  size_t len = plen + 1 + klen + 1 + vlen;
+
+  logger_ctx_t *c = node_alloc(len, klen + 1 + vlen + 1);
+  if (!c) {
+    logger_ctx_release(parent);
+    return NULL;
+  }
+  char *p = c->text;
+  memcpy(p, parent->text, plen);
+  p += plen;
+  if (plen)
+    *p++ = ' ';
+  memcpy(p, key, klen);
+  p[klen] = '=';
+  memcpy(p + klen + 1, value, vlen);
+  c->len = (size_t)(p + klen + 1 + vlen - c->text);
+
+  char *k = c->text + len + 1;
+  memcpy(k, key, klen);
+  memcpy(k + klen + 1, value, vlen);
+  c->key = k;
+  c->value = k + klen + 1;
+
+  c->parent = parent;
+  c->depth = parent->depth + 1;
+  c->tid = parent->tid;
+  c->name = parent->name;
+  c->thread_len = parent->thread_len;
+  return c;
+}
+
+/* Rebuilds @p c's fields on top of @p root; consumes the root reference. */
+static logger_ctx_t *rebase(const logger_ctx_t *c, logger_ctx_t *root) {
+  if (!c || !c->parent)
+    return root;
+  logger_ctx_t *below = rebase(c->parent, root);
+  return below ? field_node(below, c->key, c->value) : NULL;
+}
+
+logger_ctx_t *logger_ctx_current(int need_thread) {
+  if (!tls_top && need_thread)
+    set_top(thread_node(NULL));
+  return tls_top;
+}
+
+void logger_ctx_release(logger_ctx_t *c) {
+  while (c &&
+         atomic_fetch_sub_explicit(&c->refs, 1, memory_order_acq_rel) == 1) {
+    logger_ctx_t *parent = c->parent;
+    logger_arena_free(c, c->size);
+    c = parent;
+  }
+}
+
+unsigned logger_ctx_fields(const logger_ctx_t *ctx,
+                           const logger_ctx_t *out[LOGGER_CTX_DEPTH]) {
+  unsigned n = 0;
+  for (const logger_ctx_t *c = ctx; c && c->parent; c = c->parent) {
+    int hidden = 0;
+    for (unsigned i = 0; i < n && !hidden; ++i)
+      hidden = strcmp(out[i]->key, c->key) == 0;
+    if (!hidden)
+      out[n++] = c;
+  }
+  for (unsigned i = 0; i < n / 2; ++i) { /* newest first -> push order */
+    const logger_ctx_t *t = out[i];
+    out[i] = out[n - 1 - i];
+    out[n - 1 - i] = t;
+  }
+  return n;
+}
+
+/* ---- public API ---- */
+
+logger_status_t logger_ctx_push(const char *key, const char *value) {
+  if (!key || !key[0])
+    return LOGGER_UNKOWN_ERROR;
+  logger_ctx_t *top = logger_ctx_current(1);
+  if (!top)
+    return LOGGER_OUT_OF_MEMORY;
+  if (top->depth == LOGGER_CTX_DEPTH)
+    return LOGGER_UNKOWN_ERROR;
+
+  logger_ctx_t *c =
+      field_node(logger_ctx_retain(top), key, value ? value : "");
+  if (!c)
+    return LOGGER_OUT_OF_MEMORY;
+  set_top(c);
+  return LOGGER_OK;
+}
+
+logger_status_t logger_ctx_pushf(const char *key, const char *fmt, ...) {
+  char value[LOGGER_CTX_VALUE_MAX];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(value, sizeof(value), fmt ? fmt : "", args);
+  va_end(args);
+  return logger_ctx_push(key, value);
+}
+
+logger_status_t logger_ctx_pop(void) {
+  logger_ctx_t *top = tls_top;
+  if (!top || !top->parent)
+    return LOGGER_UNKOWN_ERROR;
+  set_top(logger_ctx_retain(top->parent));
+  return LOGGER_OK;
+}
+
+logger_status_t logger_set_thread_name(const char *name) {
+  logger_ctx_t *root = thread_node(name);
+  if (!root)
+    return LOGGER_OUT_OF_MEMORY;
+  logger_ctx_t *c = rebase(tls_top, root);
+  if (!c)
+    return LOGGER_OUT_OF_MEMORY;
+  set_top(c);
+  return LOGGER_OK;
+}
+
+/* ---- backend accessors ---- */
+
+const char *logger_ctx_text(const logger_ctx_t *ctx, int with_thread,
+                            size_t *len) {
+  if (!ctx) {
+    *len = 0;
+    return "";
+  }
+  if (with_thread) {
+    *len = ctx->len;
+    return ctx->text;
+  }
+  size_t skip = ctx->thread_len + (ctx->len > ctx->thread_len);
+  *len = ctx->len - skip;
+  return ctx->text + skip;
+}
+
+const logger_ctx_t *logger_ctx_parent(const logger_ctx_t *ctx) {
+  return ctx && ctx->parent ? ctx->parent : NULL;
+}
+
+const char *logger_ctx_key(const logger_ctx_t *ctx) {
+  return ctx ? ctx->key : NULL;
+}
+
+const char *logger_ctx_value(const logger_ctx_t *ctx) {
+  return ctx ? ctx->value : NULL;
+}
+
+unsigned long logger_ctx_thread_id(const logger_ctx_t *ctx) {
+  return ctx ? ctx->tid : 0;
+}
+
+const char *logger_ctx_thread_name(const logger_ctx_t *ctx) {
+  return ctx ? ctx->name : "";
+}
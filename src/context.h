@@ -0,0 +1,74 @@
+/**
+ * @file context.h
+ * @brief Internal per-thread context stack and cached thread identity.
+ *
+ * Each thread owns a stack of immutable, reference-counted nodes:
+ * - the bottom node holds the thread's id and name, looked up once;
+ * - every logger_ctx_push() adds a node pointing at the one below it and
+ *   renders "key=value", appended to its parent's text, once.
+ *
+ * A record carries the top node by reference. Synchronous logging hands it
+ * to the backends in logger_tls_record; queued records (async, real-time,
+ * queue adapter) take a reference, so the chain outlives later pops and
+ * the thread itself until they are emitted.
+ *
+ * Nothing is allocated until a thread pushes or a logger shows thread info.
+ */
+#ifndef LOGGER_CONTEXT_H
+#define LOGGER_CONTEXT_H
+
+#include "backend.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+/** Maximum number of pushed fields per thread. */
+#define LOGGER_CTX_DEPTH 16
+
+/** Longer keys/values/thread names are truncated. */
+#define LOGGER_CTX_KEY_MAX 64
+#define LOGGER_CTX_VALUE_MAX 256
+#define LOGGER_THREAD_NAME_MAX 32
+
+struct logger_ctx {
+  atomic_uint refs;
+  size_t size;                     /* allocation size */
+  struct logger_ctx *parent;       /* NULL for the thread node */
+  unsigned depth;                  /* pushed fields up to this node */
+  unsigned long tid;
+  const char *name;                /* thread name, in the thread node */
+  const char *key, *value;         /* NULL for the thread node */
+  size_t thread_len;               /* "tid=... thread=..." prefix of text */
+  size_t len;                      /* strlen(text) */
+  char text[];                     /* text, then key and value */
+};
+
+/**
+ * @brief Top of the calling thread's stack, without taking a reference.
+ *
+ * With @p need_thread set, creates the thread node if the thread has none
+ * yet. Valid until the thread's next push/pop.
+ * @return NULL if the thread has no context (or it could not be created).
+ */
+logger_ctx_t *logger_ctx_current(int need_thread);
+
+/** Takes a reference on @p c (NULL is ignored). */
+static inline logger_ctx_t *logger_ctx_retain(logger_ctx_t *c) {
+  if (c)
+    atomic_fetch_add_explicit(&c->refs, 1, memory_order_relaxed);
+  return c;
+}
+
+/** Drops a reference on @p c, freeing the nodes no one uses any more. */
+void logger_ctx_release(logger_ctx_t *c);
+
+/**
+ * @brief Pushed fields of @p ctx in push order, for structured outputs.
+ *
+ * A key pushed again hides its older value.
+ * @param out Receives up to LOGGER_CTX_DEPTH nodes.
+ * @return Number of nodes stored.
+ */
+unsigned logger_ctx_fields(const logger_ctx_t *ctx,
+                           const logger_ctx_t *out[LOGGER_CTX_DEPTH]);
+
+#endif
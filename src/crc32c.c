@@ -0,0 +1,85 @@
+#include "crc32c.h"
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CRC32C_USE_SSE42 1
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define CRC32C_USE_ARM 1
+#include <arm_acle.h>
+#endif
+
+#define CRC32C_POLY 0x82F63B78u /* reflected Castagnoli polynomial */
+
+static uint32_t TABLE[256];
+static pthread_once_t g_once = PTHREAD_ONCE_INIT;
+
+#if defined(CRC32C_USE_SSE42)
+static int g_hw;
+#endif
+
+static void init(void) {
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; ++k)
+      c = (c >> 1) ^ (CRC32C_POLY & (0u - (c & 1u)));
+    TABLE[i] = c;
+  }
+#if defined(CRC32C_USE_SSE42)
+  __builtin_cpu_init();
+  g_hw = __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+static uint32_t crc_table(uint32_t c, const unsigned char *p, size_t len) {
+  while (len--)
+    c = (c >> 8) ^ TABLE[(c ^ *p++) & 0xFFu];
+  return c;
+}
+
+#if defined(CRC32C_USE_SSE42)
+__attribute__((target("sse4.2"))) static uint32_t
+crc_hw(uint32_t c, const unsigned char *p, size_t len) {
+  uint64_t c64 = c;
+  for (; len >= 8; p += 8, len -= 8) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    c64 = _mm_crc32_u64(c64, v);
+  }
+  c = (uint32_t)c64;
+  while (len--)
+    c = _mm_crc32_u8(c, *p++);
+  return c;
+}
+#elif defined(CRC32C_USE_ARM)
+static uint32_t crc_hw(uint32_t c, const unsigned char *p, size_t len) {
+  for (; len >= 8; p += 8, len -= 8) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    c = __crc32cd(c, v);
+  }
+  while (len--)
+    c = __crc32cb(c, *p++);
+  return c;
+}
+#endif
+
+uint32_t logger_crc32c(uint32_t crc, const void *data, size_t len) {
+  pthread_once(&g_once, init);
+  const unsigned char *p = (const unsigned char *)data;
+  uint32_t c = ~crc;
+
+#if defined(CRC32C_USE_SSE42)
+  if (g_hw)
+    return ~crc_hw(c, p, len);
+#elif defined(CRC32C_USE_ARM)
+  return ~crc_hw(c, p, len);
+#endif
+  return ~crc_table(c, p, len);
+}
+
+uint32_t logger_crc32c_sw(uint32_t crc, const void *data, size_t len) {
+  pthread_once(&g_once, init);
+  return ~crc_table(~crc, (const unsigned char *)data, len);
+}
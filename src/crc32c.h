@@ -0,0 +1,34 @@
+/**
+ * @file crc32c.h
+ * @brief CRC-32C (Castagnoli) used to checksum durable file blocks.
+ *
+ * Uses the SSE4.2 crc32 instruction on x86_64 (selected at run time) and
+ * the ARMv8 CRC32 extension on aarch64 when the compiler targets it
+ * (-march=armv8-a+crc or later); other targets use a lookup table.
+ */
+#ifndef LOGGER_CRC32C_H
+#define LOGGER_CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Extends a CRC-32C over @p len bytes.
+ *
+ * @param crc  0 to start, or the result of a previous call to continue.
+ * @param data Bytes to checksum.
+ * @param len  Number of bytes.
+ *
+ * @return The CRC-32C of all bytes fed so far (same as crc32c(1) / iSCSI).
+ */
+uint32_t logger_crc32c(uint32_t crc, const void *data, size_t len);
+
+/**
+ * @brief logger_crc32c() on the lookup table, whatever the CPU offers.
+ *
+ * The fallback path, callable directly so that it is built and can be
+ * checked against the instruction path on every target.
+ */
+uint32_t logger_crc32c_sw(uint32_t crc, const void *data, size_t len);
+
+#endif
@@ -0,0 +1,400 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
+#include "dedup_backend.h"
+#include "arena.h"
+#include "context.h"
+#include "format.h"
+#include "queue_backend.h"
+#include "record.h"
+#include "srcloc.h"
+#include "threads.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct dedup_ctx {
+  logger_backend_t *inner;
+  atomic_int enabled; /* read without the lock by the pass-through path */
+
+  /*
+   * Under lock. Counting a repeat and replacing the last record happen
+   * under it; forwarding does not. Each forward takes a ticket under the
+   * lock and waits for its turn, so records and summaries still reach the
+   * outputs in the order they were decided: the summary of a run always
+   * lands between the run's record and the next one.
+   */
+  pthread_mutex_t lock;
+  pthread_cond_t turn;
+  unsigned long long ticket, serving;
+  unsigned window_ms;
+  uint64_t last; /* hash, 0 = none */
+  unsigned long repeats;
+  unsigned long long run_start_ns; /* first repeat of the pending run */
+
+  /* last forwarded record, for the summary line */
+  logger_level_t level;
+  const char *file; /* interned name, or file_buf */
+  int line;
+  logger_ctx_t *ctx; /* referenced */
+  int thread;
+  char file_buf[256];
+
+  /* window timer ("log-dedup"); started, stopped and joined under the
+   * logger's configuration lock */
+  pthread_cond_t cond;
+  pthread_t timer;
+  int timer_running; /* cleared to make it exit */
+  int timer_joinable;
+} dedup_ctx_t;
+
+/* ---- hashing (wyhash-style multiply-mix) ---- */
+
+static const uint64_t P0 = 0xa0761d6478bd642fULL;
+static const uint64_t P1 = 0xe7037ed1a0b428dbULL;
+static const uint64_t P2 = 0x8ebc6af09c88c6e3ULL;
+
+static inline uint64_t mix(uint64_t a, uint64_t b) {
+  __uint128_t r = (__uint128_t)a * b;
+  return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+static inline uint64_t rd64(const unsigned char *p) {
+  uint64_t v;
+  memcpy(&v, p, 8);
+  return v;
+}
+
+static uint64_t hash_bytes(uint64_t seed, const char *s, size_t n) {
+  const unsigned char *p = (const unsigned char *)s;
+  size_t left = n;
+
+  for (; left > 16; left -= 16, p += 16)
+    seed = mix(rd64(p) ^ P1, rd64(p + 8) ^ seed);
+
+  unsigned char tail[16] = {0};
+  memcpy(tail, p, left);
+  return mix(P1 ^ n, mix(rd64(tail) ^ P1, rd64(tail + 8) ^ seed));
+}
+
+/* Over what the outputs show: location, message and context fields. */
+static uint64_t hash_record(logger_level_t level, const char *file, int line,
+                            const char *msg, const char *fields,
+                            size_t fields_len) {
+  /* file is interned, so its address identifies it */
+  uint64_t seed = mix((uint64_t)(uintptr_t)file ^ P0,
+                      ((uint64_t)(unsigned)line << 8 | (unsigned)level) ^ P1);
+  uint64_t h = hash_bytes(seed, msg, strlen(msg));
+  if (fields_len)
+    h = hash_bytes(h, fields, fields_len);
+  h ^= P2;
+  return h ? h : 1;
+}
+
+/* The timer's condition variable waits on this clock too. */
+static unsigned long long now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ull +
+         (unsigned long long)ts.tv_nsec;
+}
+
+/* A repeat summary taken out of the stage, forwarded without the lock. */
+typedef struct summary {
+  unsigned long n; /* 0 = none */
+  logger_level_t level;
+  const char *file;
+  int line;
+  logger_ctx_t *ctx; /* referenced */
+  int thread;
+  char file_buf[256];
+} summary_t;
+
+/* Takes the pending repeat summary, if any. Caller holds c->lock. */
+static void take_summary_locked(dedup_ctx_t *c, summary_t *sum) {
+  sum->n = c->file ? c->repeats : 0;
+  c->repeats = 0;
+  if (!sum->n)
+    return;
+  sum->level = c->level;
+  sum->file = c->file;
+  if (c->file == c->file_buf) { /* replaced by the next record */
+    memcpy(sum->file_buf, c->file_buf, sizeof(sum->file_buf));
+    sum->file = sum->file_buf;
+  }
+  sum->line = c->line;
+  sum->ctx = logger_ctx_retain(c->ctx);
+  sum->thread = c->thread;
+}
+
+/* Forwards @p sum with the context of the repeated record. */
+static void forward_summary(dedup_ctx_t *c, summary_t *sum) {
+  if (!sum->n)
+    return;
+  char msg[64];
+  snprintf(msg, sizeof(msg), "last message repeated %lu time%s", sum->n,
+           sum->n == 1 ? "" : "s");
+
+  logger_record_meta_t saved = logger_tls_record;
+  logger_tls_record.seq = 0;
+  logger_tls_record.ts_ns = 0;
+  logger_tls_record.ctx = sum->ctx;
+  logger_tls_record.thread = sum->thread;
+  c->inner->vtbl->log(c->inner, sum->level, sum->file, sum->line, msg);
+  logger_tls_record = saved;
+  logger_ctx_release(sum->ctx);
+}
+
+/*
+ * Forwards @p sum, then the record if @p msg is set, once every forward
+ * decided before it is done. Caller holds c->lock, which is released
+ * meanwhile and held again on return.
+ */
+static void forward_locked(dedup_ctx_t *c, summary_t *sum,
+                           logger_level_t level, const char *file, int line,
+                           const char *msg) {
+  if (!sum->n && !msg)
+    return;
+  unsigned long long my = c->ticket++;
+  while (c->serving != my)
+    pthread_cond_wait(&c->turn, &c->lock);
+  pthread_mutex_unlock(&c->lock);
+
+  forward_summary(c, sum);
+  if (msg)
+    c->inner->vtbl->log(c->inner, level, file, line, msg);
+
+  pthread_mutex_lock(&c->lock);
+  c->serving++;
+  pthread_cond_broadcast(&c->turn);
+}
+
+/* Forwards the pending summary. Caller holds c->lock. */
+static void flush_locked(dedup_ctx_t *c) {
+  summary_t sum;
+  take_summary_locked(c, &sum);
+  forward_locked(c, &sum, LOGGER_LEVEL_INFO, NULL, 0, NULL);
+}
+
+/* Ends the run: the next record is forwarded even if it repeats. */
+static void reset_locked(dedup_ctx_t *c) {
+  flush_locked(c);
+  c->last = 0;
+  c->file = NULL;
+  logger_ctx_release(c->ctx);
+  c->ctx = NULL;
+}
+
+/* ---- window timer ---- */
+
+static void *timer_main(void *arg) {
+  dedup_ctx_t *c = (dedup_ctx_t *)arg;
+  logger_thread_started("log-dedup");
+
+  pthread_mutex_lock(&c->lock);
+  while (c->timer_running) {
+    if (!c->repeats || !c->window_ms) {
+      pthread_cond_wait(&c->cond, &c->lock);
+      continue;
+    }
+    unsigned long long start = c->run_start_ns;
+    unsigned long long due =
+        start + (unsigned long long)c->window_ms * 1000000ull;
+    struct timespec ts = {(time_t)(due / 1000000000ull),
+                          (long)(due % 1000000000ull)};
+    if (pthread_cond_timedwait(&c->cond, &c->lock, &ts) == ETIMEDOUT &&
+        c->timer_running && c->repeats && c->run_start_ns == start)
+      flush_locked(c);
+  }
+  pthread_mutex_unlock(&c->lock);
+  return NULL;
+}
+
+/* Caller holds c->lock. */
+static void timer_start_locked(dedup_ctx_t *c) {
+  if (c->timer_running || c->timer_joinable || !c->window_ms ||
+      !atomic_load(&c->enabled))
+    return;
+  c->timer_running = 1;
+  if (pthread_create(&c->timer, NULL, timer_main, c) != 0) {
+    c->timer_running = 0; /* summaries then wait for the next record */
+    return;
+  }
+  c->timer_joinable = 1;
+}
+
+static void timer_stop(dedup_ctx_t *c) {
+  pthread_mutex_lock(&c->lock);
+  int joinable = c->timer_joinable;
+  c->timer_running = 0;
+  c->timer_joinable = 0;
+  pthread_cond_signal(&c->cond);
+  pthread_mutex_unlock(&c->lock);
+  if (joinable)
+    pthread_join(c->timer, NULL);
+}
+
+/* ---- vtable methods ---- */
+
+static logger_status_t d_start(logger_backend_t *self) {
+  dedup_ctx_t *c = (dedup_ctx_t *)self->ctx;
+  logger_status_t st = c->inner->vtbl->start(c->inner);
+  pthread_mutex_lock(&c->lock);
+  timer_start_locked(c);
+  pthread_mutex_unlock(&c->lock);
+  return st;
+}
+
+static logger_status_t d_stop(logger_backend_t *self) {
+  dedup_ctx_t *c = (dedup_ctx_t *)self->ctx;
+  timer_stop(c);
+  pthread_mutex_lock(&c->lock);
+  reset_locked(c);
+  pthread_mutex_unlock(&c->lock);
+  return c->inner->vtbl->stop(c->inner);
+}
+
+static void d_log(logger_backend_t *self, logger_level_t level,
+                  const char *file, int line, const char *msg) {
+  dedup_ctx_t *c = (dedup_ctx_t *)self->ctx;
+
+  if (!atomic_load_explicit(&c->enabled, memory_order_relaxed)) {
+    c->inner->vtbl->log(c->inner, level, file, line, msg);
+    return;
+  }
+
+  const logger_record_meta_t *meta = &logger_tls_record;
+  size_t flen;
+  const char *fields = logger_ctx_text(meta->ctx, meta->thread, &flen);
+  uint64_t h = hash_record(level, file, line, msg, fields, flen);
+
+  pthread_mutex_lock(&c->lock);
+  if (h == c->last) {
+    if (c->repeats++ == 0) {
+      c->run_start_ns = now_ns();
+      if (c->window_ms)
+        pthread_cond_signal(&c->cond); /* arm the timer */
+    }
+    pthread_mutex_unlock(&c->lock);
+    return;
+  }
+
+  summary_t sum;
+  take_summary_locked(c, &sum);
+  c->last = h;
+  c->level = level;
+  c->line = line;
+  c->file = logger_srcloc_find(file);
+  if (!c->file) { /* not interned: may not outlive this call */
+    snprintf(c->file_buf, sizeof(c->file_buf), "%s", file ? file : "");
+    c->file = c->file_buf;
+  }
+  logger_ctx_release(c->ctx);
+  c->ctx = logger_ctx_retain((logger_ctx_t *)meta->ctx);
+  c->thread = meta->thread;
+  forward_locked(c, &sum, level, file, line, msg);
+  pthread_mutex_unlock(&c->lock);
+}
+
+/* Repeats are detected on text, so only a disabled stage passes args on. */
+static void d_log_raw(logger_backend_t *self, logger_level_t level,
+                      const char *file, int line, const char *fmt,
+                      va_list args) {
+  dedup_ctx_t *c = (dedup_ctx_t *)self->ctx;
+
+  if (!atomic_load_explicit(&c->enabled, memory_order_relaxed) &&
+      c->inner->vtbl->log_raw) {
+    c->inner->vtbl->log_raw(c->inner, level, file, line, fmt, args);
+    return;
+  }
+
+  char msg[LOGGER_RECORD_MSG_MAX];
+  logger_vformat(msg, sizeof(msg), fmt, args);
+  d_log(self, level, file, line, msg);
+}
+
+static logger_status_t d_flush(logger_backend_t *self) {
+  dedup_ctx_t *c = (dedup_ctx_t *)self->ctx;
+  return c->inner->vtbl->flush ? c->inner->vtbl->flush(c->inner) : LOGGER_OK;
+}
+
+static void d_prewarm(logger_backend_t *self) {
+  dedup_ctx_t *c = (dedup_ctx_t *)self->ctx;
+  if (c->inner->vtbl->prewarm)
+    c->inner->vtbl->prewarm(c->inner);
+}
+
+static void d_destroy(logger_backend_t *self) {
+  dedup_ctx_t *c = (dedup_ctx_t *)self->ctx;
+  if (c) {
+    timer_stop(c);
+    logger_ctx_release(c->ctx);
+    c->inner->vtbl->destroy(c->inner);
+    pthread_cond_destroy(&c->turn);
+    pthread_cond_destroy(&c->cond);
+    pthread_mutex_destroy(&c->lock);
+    logger_arena_free(c, sizeof(*c));
+  }
+  logger_arena_free(self, sizeof(*self));
+}
+
+static const logger_backend_vtbl_t V = {.start = d_start,
+                                        .stop = d_stop,
+                                        .log = d_log,
+                                        .destroy = d_destroy,
+                                        .flush = d_flush,
+                                        .prewarm = d_prewarm,
+                                        .log_raw = d_log_raw};
+
+logger_backend_t *logger_backend_dedup_create(logger_backend_t *inner) {
+  if (!inner)
+    return NULL;
+
+  logger_backend_t *b = (logger_backend_t *)logger_arena_alloc(sizeof(*b));
+  if (!b)
+    return NULL;
+
+  dedup_ctx_t *c = (dedup_ctx_t *)logger_arena_alloc(sizeof(*c));
+  if (!c) {
+    logger_arena_free(b, sizeof(*b));
+    return NULL;
+  }
+
+  memset(c, 0, sizeof(*c));
+  c->inner = inner;
+  atomic_init(&c->enabled, 0);
+  pthread_mutex_init(&c->lock, NULL);
+  pthread_cond_init(&c->turn, NULL);
+  pthread_condattr_t ca;
+  pthread_condattr_init(&ca);
+  pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+  pthread_cond_init(&c->cond, &ca);
+  pthread_condattr_destroy(&ca);
+
+  b->vtbl = &V;
+  b->ctx = c;
+  return b;
+}
+
+logger_status_t logger_backend_dedup_configure(logger_backend_t *dedup,
+                                               int enabled,
+                                               unsigned window_ms) {
+  if (!dedup)
+    return LOGGER_NO_EXIST;
+
+  dedup_ctx_t *c = (dedup_ctx_t *)dedup->ctx;
+  if (!enabled || !window_ms)
+    timer_stop(c);
+  pthread_mutex_lock(&c->lock);
+  c->window_ms = window_ms;
+  atomic_store(&c->enabled, enabled != 0);
+  if (!enabled)
+    reset_locked(c);
+  pthread_cond_signal(&c->cond); /* new window */
+  timer_start_locked(c);
+  pthread_mutex_unlock(&c->lock);
+  return LOGGER_OK;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file dedup_backend.h
+ * @brief Stage that collapses consecutive repeated records.
+ *
+ * Wraps another backend (the logger's composite). Each record is hashed
+ * over (level, file, line, message, context fields as the outputs show
+ * them); a record equal to the previous one is only counted. When a
+ * different record arrives, the window expires or the stage is
+ * stopped/disabled, a single
+ *
+ *   last message repeated N times
+ *
+ * is forwarded with the level, source location and context of the
+ * repeated record. Counting and replacing the last record share one
+ * lock; records and summaries are forwarded after it is released, in the
+ * order they were decided, so a summary always lands right after its run
+ * and a slow output does not hold up the counting of repeats.
+ *
+ * With a window, a "log-dedup" thread forwards the summary once the window
+ * has passed since the run's first repeat, even if no record follows.
+ * Memory use is constant: only the hash, location and context of the last
+ * record are kept. While disabled, log() is a plain pass-through.
+ *
+ * Ownership:
+ * - The stage owns @p inner and stops/destroys it with itself.
+ */
+#ifndef DEDUP_BACKEND_H
+#define DEDUP_BACKEND_H
+
+#include "backend.h"
+
+/**
+ * @brief Creates a dedup stage in front of @p inner.
+ *
+ * The stage starts disabled.
+ *
+ * @param inner Backend receiving the records (owned on success).
+ *
+ * @return Pointer to a logger_backend_t instance on success, NULL on failure
+ *         (the caller keeps @p inner).
+ */
+logger_backend_t *logger_backend_dedup_create(logger_backend_t *inner);
+
+/**
+ * @brief Enables/disables the stage; safe while other threads log.
+ *
+ * Disabling forwards the pending repeat summary, if any.
+ *
+ * @param dedup     Stage created by logger_backend_dedup_create().
+ * @param enabled   Non-zero to collapse repeats.
+ * @param window_ms A summary is forwarded this long after the run's first
+ *                  repeat, by the stage's timer thread (0 = only on
+ *                  change).
+ *
+ * @return LOGGER_OK, or LOGGER_NO_EXIST if @p dedup is NULL.
+ */
+logger_status_t logger_backend_dedup_configure(logger_backend_t *dedup,
+                                               int enabled,
+                                               unsigned window_ms);
+
+#endif
@@ -1,24 +1,101 @@
+#define _GNU_SOURCE /* flockfile, putc_unlocked, fallocate */
+
 #include "file_backend.h"
+#include "arena.h"
+#include "crc32c.h"
+#include "file_index.h"
+#include "srcloc.h"
+#include "threads.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef LOGGER_USE_LZ4
+#include <lz4frame.h>
+#endif
+#ifdef LOGGER_USE_ZSTD
+#include <zstd.h>
+#endif
+
+#define FILE_BLOCK_DEFAULT (64u * 1024u)
+#define FILE_BLOCK_MIN 4096u
+#define FILE_LINE_MAX 4096u /* longest line appended to a block */
+#define FILE_BLOCKS 4u      /* filling + queued blocks */
+#define FILE_FLUSH_MS 1000  /* a partial block is written after this */
+#define FILE_SYNC_MS 100    /* durable mode default group-commit interval */
+
+/*
+ * Durable frame: "LGB1", codec byte, 3 zero bytes, payload length (LE32),
+ * CRC-32C (LE32) of header bytes 4..11 followed by the payload.
+ */
+#define FILE_FRAME_HDR 16u
+#define FILE_FRAME_MAX (64u * 1024u * 1024u) /* sanity bound on recovery */
+static const char FRAME_MAGIC[4] = {'L', 'G', 'B', '1'};
+
+typedef struct file_block {
+  size_t len;
+  char *data; /* block_size + FILE_LINE_MAX bytes */
+
+  unsigned lines;
+  uint64_t born_ns; /* CLOCK_MONOTONIC of the first line */
+
+  /* index mode: what the block holds */
+  uint64_t first_ns, last_ns;
+  unsigned levels;
+} file_block_t;
 
 typedef struct file_ctx {
-  FILE *f;
+  FILE *f;    /* plain mode */
   char *path; /* owned */
-} file_ctx_t;
 
-static logger_status_t f_start(logger_backend_t *self) {
-  (void)self;
-  return LOGGER_OK;
-}
+  /*
+   * Block mode: lines are appended to blocks[head % FILE_BLOCKS]; sealed
+   * blocks [tail, head) are encoded and written by the writer thread.
+   */
+  int fd;
+  logger_compression_t codec;
+  int level;
+  size_t block_size;
 
-static logger_status_t f_stop(logger_backend_t *self) {
-  file_ctx_t *c = (file_ctx_t *)self->ctx;
-  if (c && c->f)
-    fflush(c->f);
-  return LOGGER_OK;
-}
+  pthread_mutex_t lock;
+  pthread_cond_t filled;  /* writer: a block was sealed */
+  pthread_cond_t drained; /* producers/flush: a block was written */
+  file_block_t blocks[FILE_BLOCKS];
+  unsigned head, tail;
+  int flush_req, stop;
+  pthread_t writer;
+
+  /* durable mode: blocks [0, synced) have reached the disk */
+  int durable;
+  unsigned sync_ms;
+  unsigned synced;
+  int sync_req; /* ERROR+ seen: commit now */
+
+  int index_fd; /* "<path>.idx", -1 if indexing is off */
+
+  /* latency mode: adaptive sealing; EWMAs of arrival gap and write cost */
+  uint64_t latency_ns;
+  uint64_t last_ns, gap_ns; /* producers, under lock */
+  uint64_t cost_ns;         /* writer, under lock */
+  uint64_t avg_lines, avg_bytes; /* writer only, x16 */
+  logger_file_batch_counters_t own; /* when the caller passes none */
+  logger_file_batch_counters_t *stats;
+
+  size_t prealloc; /* prewarm: reserve this many bytes ahead */
+
+  char *out; /* writer-owned encode buffer */
+  size_t out_cap;
+#ifdef LOGGER_USE_ZSTD
+  ZSTD_CCtx *zctx;
+#endif
+} file_ctx_t;
 
 static const char *lvl_to_str(logger_level_t lvl) {
   switch (lvl) {
@@ -39,60 +116,815 @@ static const char *lvl_to_str(logger_level_t lvl) {
   }
 }
 
+/* ---- codecs ---- */
+
+int logger_file_compression_supported(logger_compression_t codec) {
+  switch (codec) {
+  case LOGGER_COMPRESSION_NONE:
+    return 1;
+#ifdef LOGGER_USE_LZ4
+  case LOGGER_COMPRESSION_LZ4:
+    return 1;
+#endif
+#ifdef LOGGER_USE_ZSTD
+  case LOGGER_COMPRESSION_ZSTD:
+    return 1;
+#endif
+  default:
+    return 0;
+  }
+}
+
+static size_t codec_bound(const file_ctx_t *c, size_t n) {
+  switch (c->codec) {
+#ifdef LOGGER_USE_LZ4
+  case LOGGER_COMPRESSION_LZ4: {
+    LZ4F_preferences_t prefs;
+    memset(&prefs, 0, sizeof(prefs));
+    prefs.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+    return LZ4F_compressFrameBound(n, &prefs);
+  }
+#endif
+#ifdef LOGGER_USE_ZSTD
+  case LOGGER_COMPRESSION_ZSTD:
+    return ZSTD_compressBound(n);
+#endif
+  default:
+    return n;
+  }
+}
+
+/*
+ * Encodes one block as a self-contained frame. Returns the encoded bytes in
+ * *dst (either c->out or @p src itself), or 0 on codec failure.
+ */
+static size_t codec_encode(file_ctx_t *c, const char *src, size_t n,
+                           const char **dst) {
+  switch (c->codec) {
+#ifdef LOGGER_USE_LZ4
+  case LOGGER_COMPRESSION_LZ4: {
+    LZ4F_preferences_t prefs;
+    memset(&prefs, 0, sizeof(prefs));
+    prefs.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+    prefs.frameInfo.contentSize = n;
+    prefs.compressionLevel = c->level;
+    size_t r = LZ4F_compressFrame(c->out, c->out_cap, src, n, &prefs);
+    if (LZ4F_isError(r))
+      return 0;
+    *dst = c->out;
+    return r;
+  }
+#endif
+#ifdef LOGGER_USE_ZSTD
+  case LOGGER_COMPRESSION_ZSTD: {
+    size_t r = ZSTD_compressCCtx(c->zctx, c->out, c->out_cap, src, n,
+                                 c->level ? c->level : ZSTD_CLEVEL_DEFAULT);
+    if (ZSTD_isError(r))
+      return 0;
+    *dst = c->out;
+    return r;
+  }
+#endif
+  default:
+    *dst = src;
+    return n;
+  }
+}
+
+/* ---- block writer ---- */
+
+static void put_le32(unsigned char *p, uint32_t v) {
+  p[0] = (unsigned char)v;
+  p[1] = (unsigned char)(v >> 8);
+  p[2] = (unsigned char)(v >> 16);
+  p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t get_le32(const unsigned char *p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+         (uint32_t)p[3] << 24;
+}
+
+static void frame_header(unsigned char *hdr, logger_compression_t codec,
+                         const char *payload, size_t n) {
+  memcpy(hdr, FRAME_MAGIC, 4);
+  hdr[4] = (unsigned char)codec;
+  hdr[5] = hdr[6] = hdr[7] = 0;
+  put_le32(hdr + 8, (uint32_t)n);
+  put_le32(hdr + 12, logger_crc32c(logger_crc32c(0, hdr + 4, 8), payload, n));
+}
+
+static int write_all(int fd, const char *p, size_t n) {
+  while (n) {
+    ssize_t w = write(fd, p, n);
+    if (w < 0) {
+      if (errno == EINTR)
+        continue;
+      return 0; /* disk full / I/O error: the block is lost */
+    }
+    p += w;
+    n -= (size_t)w;
+  }
+  return 1;
+}
+
+/* Records a block written at @p at; a failed write only loses the entry. */
+static void index_append(file_ctx_t *c, const file_block_t *blk, off_t at,
+                         size_t stored, int framed) {
+  logger_index_entry_t e;
+  e.offset = (uint64_t)at;
+  e.stored = (uint32_t)stored;
+  e.lines = blk->lines;
+  e.first_ns = blk->first_ns;
+  e.last_ns = blk->last_ns;
+  e.levels = (uint8_t)blk->levels;
+  e.codec = (uint8_t)c->codec;
+  e.flags = framed ? LOGGER_INDEX_FRAMED : 0;
+  e.raw = (uint32_t)blk->len;
+
+  unsigned char buf[LOGGER_INDEX_ENTRY];
+  logger_index_encode(buf, &e);
+  write_all(c->index_fd, (const char *)buf, sizeof(buf));
+}
+
+/* Seals the filling block if it holds data. Caller holds c->lock. */
+static void seal_locked(file_ctx_t *c) {
+  if (c->head - c->tail < FILE_BLOCKS &&
+      c->blocks[c->head % FILE_BLOCKS].len) {
+    c->head++;
+    pthread_cond_signal(&c->filled);
+  }
+}
+
+/* Index the filling block will have once sealed, if it holds data. */
+static unsigned end_locked(const file_ctx_t *c) {
+  return c->head + (c->head - c->tail < FILE_BLOCKS &&
+                    c->blocks[c->head % FILE_BLOCKS].len);
+}
+
+static uint64_t mono_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* x += (v - x) / 8 */
+static uint64_t ewma(uint64_t x, uint64_t v) { return x - x / 8 + v / 8; }
+
+/* Four buckets per power of two: ~19% wide, enough for a p99. */
+static unsigned lat_bucket(uint64_t us) {
+  if (us < 4)
+    return (unsigned)us;
+  unsigned msb = 63u - (unsigned)__builtin_clzll(us);
+  unsigned b = msb * 4 + (unsigned)((us >> (msb - 2)) & 3);
+  return b < LOGGER_FILE_LAT_BUCKETS ? b : LOGGER_FILE_LAT_BUCKETS - 1;
+}
+
+/* Upper bound of a bucket. */
+static uint64_t lat_bucket_top(unsigned b) {
+  if (b < 4)
+    return b;
+  unsigned msb = b / 4;
+  return ((uint64_t)(4 + b % 4 + 1) << (msb - 2)) - 1;
+}
+
+/* Accounts one block write; @p t0 is when the write started. */
+static void batch_done(file_ctx_t *c, const file_block_t *blk, uint64_t t0) {
+  logger_file_batch_counters_t *s = c->stats;
+  uint64_t now = mono_ns();
+  uint64_t us = (now - blk->born_ns) / 1000u;
+
+  atomic_fetch_add_explicit(&s->batches, 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&s->records, blk->lines, memory_order_relaxed);
+  atomic_fetch_add_explicit(&s->bytes, blk->len, memory_order_relaxed);
+  atomic_fetch_sub_explicit(&s->queued, (long long)blk->lines,
+                            memory_order_relaxed);
+  c->avg_lines = ewma(c->avg_lines, (uint64_t)blk->lines << 4);
+  c->avg_bytes = ewma(c->avg_bytes, (uint64_t)blk->len << 4);
+  atomic_store_explicit(&s->batch_records, (unsigned)(c->avg_lines >> 4),
+                        memory_order_relaxed);
+  atomic_store_explicit(&s->batch_bytes, (unsigned)(c->avg_bytes >> 4),
+                        memory_order_relaxed);
+  atomic_fetch_add_explicit(&s->latency[lat_bucket(us)], 1,
+                            memory_order_relaxed);
+  if (us > atomic_load_explicit(&s->latency_max_us, memory_order_relaxed))
+    atomic_store_explicit(&s->latency_max_us, us, memory_order_relaxed);
+
+  pthread_mutex_lock(&c->lock);
+  c->cost_ns = ewma(c->cost_ns, now - t0);
+  pthread_mutex_unlock(&c->lock);
+}
+
+/*
+ * Latency mode: when the filling block must be sealed. Returns 0 if now
+ * (no time left, or lines arrive too rarely to join it in time), else
+ * sets @p ts. The block is sealed early enough to write it (recent cost)
+ * and to absorb the writer's wake-up delay (an eighth of the target).
+ * Caller holds c->lock and the block holds data.
+ */
+static int latency_deadline(const file_ctx_t *c, struct timespec *ts) {
+  uint64_t margin = c->cost_ns + c->latency_ns / 8;
+  uint64_t budget = c->latency_ns > margin ? c->latency_ns - margin : 0;
+  if (budget < c->latency_ns / 8)
+    budget = c->latency_ns / 8;
+
+  const file_block_t *blk = &c->blocks[c->head % FILE_BLOCKS];
+  uint64_t now = mono_ns();
+  uint64_t due = blk->born_ns + budget;
+  if (now >= due || (c->gap_ns && c->gap_ns >= budget))
+    return 0;
+
+  clock_gettime(CLOCK_REALTIME, ts);
+  uint64_t wait = due - now;
+  ts->tv_sec += (time_t)(wait / 1000000000u);
+  ts->tv_nsec += (long)(wait % 1000000000u);
+  if (ts->tv_nsec >= 1000000000L) {
+    ts->tv_sec++;
+    ts->tv_nsec -= 1000000000L;
+  }
+  return 1;
+}
+
+static void deadline(struct timespec *ts, unsigned ms) {
+  clock_gettime(CLOCK_REALTIME, ts);
+  ts->tv_sec += ms / 1000;
+  ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+  if (ts->tv_nsec >= 1000000000L) {
+    ts->tv_sec++;
+    ts->tv_nsec -= 1000000000L;
+  }
+}
+
+/*
+ * Writer thread. Sealed blocks are encoded and written as they come; a
+ * partial block is sealed when the interval (sync_ms in durable mode,
+ * FILE_FLUSH_MS otherwise) expires. In durable mode one fdatasync() then
+ * commits everything written so far (group commit): at every interval, on
+ * ERROR+ records, on flush and on stop. In latency mode the partial block
+ * is sealed at latency_deadline() instead, and durable mode commits every
+ * block as it is written.
+ */
+static void *writer_main(void *arg) {
+  file_ctx_t *c = (file_ctx_t *)arg;
+  unsigned interval = c->durable ? c->sync_ms : FILE_FLUSH_MS;
+  logger_thread_started("log-file");
+  int want_sync = 0;
+
+  pthread_mutex_lock(&c->lock);
+  for (;;) {
+    while (c->tail == c->head && !c->stop && !c->flush_req &&
+           !c->sync_req && !want_sync) {
+      if (!c->blocks[c->head % FILE_BLOCKS].len &&
+          c->synced == c->tail) {
+        pthread_cond_wait(&c->filled, &c->lock); /* idle */
+        continue;
+      }
+      struct timespec ts;
+      if (!c->blocks[c->head % FILE_BLOCKS].len) {
+        deadline(&ts, interval); /* only a commit is pending */
+      } else if (c->latency_ns && !latency_deadline(c, &ts)) {
+        seal_locked(c);
+        want_sync = 1;
+        continue;
+      } else if (!c->latency_ns) {
+        deadline(&ts, interval);
+      }
+      if (pthread_cond_timedwait(&c->filled, &c->lock, &ts) == ETIMEDOUT &&
+          !c->latency_ns) {
+        seal_locked(c);
+        want_sync = 1;
+      }
+    }
+    if (c->flush_req || c->stop || c->sync_req) {
+      c->flush_req = 0;
+      c->sync_req = 0;
+      want_sync = 1;
+      seal_locked(c);
+    }
+
+    if (c->tail != c->head) {
+      file_block_t *blk = &c->blocks[c->tail % FILE_BLOCKS];
+      pthread_mutex_unlock(&c->lock);
+
+      uint64_t t0 = mono_ns();
+      const char *enc = NULL;
+      size_t n = codec_encode(c, blk->data, blk->len, &enc);
+      off_t at = c->index_fd >= 0 ? lseek(c->fd, 0, SEEK_END) : -1;
+      int ok = n != 0;
+      if (ok && c->durable) {
+        unsigned char hdr[FILE_FRAME_HDR];
+        frame_header(hdr, c->codec, enc, n);
+        ok = write_all(c->fd, (const char *)hdr, sizeof(hdr));
+      }
+      ok = ok && write_all(c->fd, enc, n);
+      if (ok && at >= 0)
+        index_append(c, blk, at, n + (c->durable ? FILE_FRAME_HDR : 0),
+                     c->durable);
+      if (ok && c->durable && c->latency_ns)
+        fdatasync(c->fd); /* the target is to disk */
+      batch_done(c, blk, t0);
+
+      pthread_mutex_lock(&c->lock);
+      blk->len = 0;
+      blk->lines = 0;
+      blk->levels = 0;
+      c->tail++;
+      if (!c->durable || c->latency_ns)
+        c->synced = c->tail;
+      pthread_cond_broadcast(&c->drained);
+      continue;
+    }
+
+    /* queue empty: commit what was written */
+    if (want_sync && c->synced != c->tail) {
+      unsigned target = c->tail;
+      pthread_mutex_unlock(&c->lock);
+      fdatasync(c->fd);
+      pthread_mutex_lock(&c->lock);
+      c->synced = target;
+    }
+    want_sync = 0;
+    pthread_cond_broadcast(&c->drained);
+    if (c->stop)
+      break;
+  }
+  pthread_mutex_unlock(&c->lock);
+  return NULL;
+}
+
+/* Waits until blocks [0, target) are written (durable mode: synced). */
+static void wait_synced_locked(file_ctx_t *c, unsigned target) {
+  while ((int)(c->synced - target) < 0 && !c->stop)
+    pthread_cond_wait(&c->drained, &c->lock);
+}
+
+/* Waits until everything logged so far has been written. */
+static void block_flush(file_ctx_t *c) {
+  pthread_mutex_lock(&c->lock);
+  unsigned target = end_locked(c);
+  c->flush_req = 1;
+  pthread_cond_signal(&c->filled);
+  wait_synced_locked(c, target);
+  pthread_mutex_unlock(&c->lock);
+}
+
+static void block_append(file_ctx_t *c, logger_level_t lvl,
+                         const char *prefix, size_t plen, const char *msg) {
+  size_t mlen = strlen(msg);
+  if (plen > FILE_LINE_MAX - 1)
+    plen = FILE_LINE_MAX - 1;
+  if (mlen > FILE_LINE_MAX - 1 - plen)
+    mlen = FILE_LINE_MAX - 1 - plen;
+
+  pthread_mutex_lock(&c->lock);
+  while (c->head - c->tail >= FILE_BLOCKS) /* all blocks queued */
+    pthread_cond_wait(&c->drained, &c->lock);
+
+  file_block_t *blk = &c->blocks[c->head % FILE_BLOCKS];
+  int was_empty = blk->len == 0;
+  char *p = blk->data + blk->len;
+  memcpy(p, prefix, plen);
+  memcpy(p + plen, msg, mlen);
+  p[plen + mlen] = '\n';
+  blk->len += plen + mlen + 1;
+
+  if (c->latency_ns) {
+    uint64_t now = mono_ns();
+    if (c->last_ns)
+      c->gap_ns = ewma(c->gap_ns, now - c->last_ns);
+    c->last_ns = now;
+    if (was_empty)
+      blk->born_ns = now;
+  } else if (was_empty) {
+    blk->born_ns = mono_ns();
+  }
+  blk->lines++;
+  atomic_fetch_add_explicit(&c->stats->queued, 1, memory_order_relaxed);
+
+  if (c->index_fd >= 0) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t now = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+    if (blk->lines == 1)
+      blk->first_ns = now;
+    blk->last_ns = now;
+    blk->levels |= 1u << (lvl & 7);
+  }
+
+  if (c->durable && lvl >= LOGGER_LEVEL_ERROR) {
+    /* commit now; a FATAL record is usually followed by abort() */
+    unsigned target = c->head + 1;
+    c->head++;
+    c->sync_req = 1;
+    pthread_cond_signal(&c->filled);
+    if (lvl >= LOGGER_LEVEL_FATAL)
+      wait_synced_locked(c, target);
+  } else if (blk->len >= c->block_size) {
+    c->head++;
+    pthread_cond_signal(&c->filled);
+  } else if (was_empty) {
+    pthread_cond_signal(&c->filled); /* arm the writer's interval */
+  }
+  pthread_mutex_unlock(&c->lock);
+}
+
+/*
+ * Scans the frames of an existing durable file and truncates it after the
+ * last valid one (torn or garbage tail after a power cut). A non-empty file
+ * that does not start with a frame is not ours: it is left alone and the
+ * open fails.
+ */
+static int recover(int fd) {
+  unsigned char hdr[FILE_FRAME_HDR];
+  char *buf = NULL;
+  size_t cap = 0;
+  off_t off = 0;
+  int ok = 1;
+
+  for (;;) {
+    ssize_t r = pread(fd, hdr, sizeof(hdr), off);
+    if (r == 0)
+      break; /* clean end */
+    if (r < 0) {
+      ok = 0;
+      break;
+    }
+    if (r != (ssize_t)sizeof(hdr) || memcmp(hdr, FRAME_MAGIC, 4) != 0) {
+      /* a torn tail is cut; foreign content at offset 0 is refused */
+      ok = off != 0 || memcmp(hdr, FRAME_MAGIC, r < 4 ? (size_t)r : 4) == 0;
+      break;
+    }
+    uint32_t n = get_le32(hdr + 8);
+    if (n > FILE_FRAME_MAX)
+      break;
+    if (n > cap) {
+      char *nb = (char *)realloc(buf, n);
+      if (!nb) {
+        ok = 0;
+        break;
+      }
+      buf = nb;
+      cap = n;
+    }
+    if (pread(fd, buf, n, off + (off_t)sizeof(hdr)) != (ssize_t)n)
+      break;
+    if (logger_crc32c(logger_crc32c(0, hdr + 4, 8), buf, n) !=
+        get_le32(hdr + 12))
+      break;
+    off += (off_t)(sizeof(hdr) + n);
+  }
+  free(buf);
+
+  if (ok && lseek(fd, 0, SEEK_END) != off) {
+    if (ftruncate(fd, off) != 0)
+      return 0;
+    fdatasync(fd);
+  }
+  return ok;
+}
+
+/*
+ * Opens "<path>.idx" for appending. A missing or foreign index starts over;
+ * trailing entries past the end of the log (cut by recovery) are dropped.
+ */
+static int index_open(file_ctx_t *c) {
+  size_t n = strlen(c->path);
+  char *ipath = (char *)malloc(n + sizeof(".idx"));
+  if (!ipath)
+    return 0;
+  memcpy(ipath, c->path, n);
+  memcpy(ipath + n, ".idx", sizeof(".idx"));
+  c->index_fd = open(ipath, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+  free(ipath);
+  if (c->index_fd < 0)
+    return 0;
+
+  unsigned char hdr[LOGGER_INDEX_HDR], cur[LOGGER_INDEX_HDR];
+  logger_index_header(hdr);
+  struct stat st;
+  if (fstat(c->index_fd, &st) != 0)
+    return 0;
+
+  off_t keep = 0;
+  if (st.st_size >= (off_t)LOGGER_INDEX_HDR &&
+      pread(c->index_fd, cur, sizeof(cur), 0) == (ssize_t)sizeof(cur) &&
+      memcmp(cur, hdr, sizeof(hdr)) == 0) {
+    off_t end = lseek(c->fd, 0, SEEK_END);
+    off_t off = st.st_size - (st.st_size - (off_t)LOGGER_INDEX_HDR) %
+                                 (off_t)LOGGER_INDEX_ENTRY;
+    unsigned char buf[LOGGER_INDEX_ENTRY];
+    while (off > (off_t)LOGGER_INDEX_HDR) {
+      logger_index_entry_t e;
+      if (pread(c->index_fd, buf, sizeof(buf),
+                off - (off_t)LOGGER_INDEX_ENTRY) != (ssize_t)sizeof(buf))
+        return 0;
+      logger_index_decode(buf, &e);
+      if (e.offset + e.stored <= (uint64_t)end)
+        break;
+      off -= (off_t)LOGGER_INDEX_ENTRY;
+    }
+    keep = off;
+  }
+
+  if (keep != st.st_size && ftruncate(c->index_fd, keep) != 0)
+    return 0;
+  return keep || write_all(c->index_fd, (const char *)hdr, sizeof(hdr));
+}
+
+/* ---- vtable methods ---- */
+
+static logger_status_t f_start(logger_backend_t *self) {
+  (void)self;
+  return LOGGER_OK;
+}
+
+static logger_status_t f_stop(logger_backend_t *self) {
+  file_ctx_t *c = (file_ctx_t *)self->ctx;
+  if (c && c->f)
+    fflush(c->f);
+  else if (c && c->fd >= 0)
+    block_flush(c);
+  return LOGGER_OK;
+}
+
+static logger_status_t f_flush(logger_backend_t *self) {
+  file_ctx_t *c = (file_ctx_t *)self->ctx;
+  if (!c)
+    return LOGGER_UNKOWN_ERROR;
+  if (c->f) {
+    if (fflush(c->f) != 0 || fdatasync(fileno(c->f)) != 0)
+      return LOGGER_UNKOWN_ERROR;
+  } else if (c->fd >= 0) {
+    block_flush(c);
+    if (!c->durable && fdatasync(c->fd) != 0) /* durable: already synced */
+      return LOGGER_UNKOWN_ERROR;
+  }
+  return LOGGER_OK;
+}
+
+/*
+ * Reserves disk space past the end of the file without changing its size,
+ * and faults in the block buffers not queued for the writer.
+ */
+static void f_prewarm(logger_backend_t *self) {
+  file_ctx_t *c = (file_ctx_t *)self->ctx;
+  if (!c)
+    return;
+
+  int fd = c->f ? fileno(c->f) : c->fd;
+#ifdef __linux__
+  off_t end = fd >= 0 ? lseek(fd, 0, SEEK_END) : -1;
+  if (c->prealloc && end >= 0)
+    fallocate(fd, FALLOC_FL_KEEP_SIZE, end, (off_t)c->prealloc);
+#else
+  (void)fd;
+#endif
+
+  if (c->fd < 0)
+    return;
+  long page = sysconf(_SC_PAGESIZE);
+  size_t step = page > 0 ? (size_t)page : 4096u;
+  size_t cap = c->block_size + FILE_LINE_MAX;
+  pthread_mutex_lock(&c->lock);
+  unsigned unqueued = FILE_BLOCKS - (c->head - c->tail);
+  for (unsigned i = 0; i < unqueued; ++i) {
+    file_block_t *blk = &c->blocks[(c->head + i) % FILE_BLOCKS];
+    for (size_t off = blk->len; off < cap; off += step)
+      blk->data[off] = 0;
+  }
+  pthread_mutex_unlock(&c->lock);
+}
+
 static void f_log(logger_backend_t *self, logger_level_t lvl, const char *file,
                   int line, const char *msg) {
   file_ctx_t *c = (file_ctx_t *)self->ctx;
-  if (!c || !c->f)
+  if (!c)
     return;
-  fprintf(c->f, "[%s] %s:%d | %s\n", lvl_to_str(lvl), file, line, msg);
+
+  size_t plen;
+  const char *prefix = logger_srcloc_prefix(lvl, file, line, &plen);
+  const logger_record_meta_t *meta = logger_backend_current_record();
+  unsigned long long seq = meta->seq;
+  size_t flen;
+  const char *fields = logger_ctx_text(meta->ctx, meta->thread, &flen);
+
+  char tmp[1024];
+  if (!prefix || seq || flen) {
+    int n = seq ? snprintf(tmp, sizeof(tmp), "#%llu ", seq) : 0;
+    if (prefix)
+      n += snprintf(tmp + n, sizeof(tmp) - (size_t)n, "%.*s", (int)plen,
+                    prefix);
+    else
+      n += snprintf(tmp + n, sizeof(tmp) - (size_t)n, "[%s] %s:%d | ",
+                    lvl_to_str(lvl), file, line);
+    if (flen && (size_t)n < sizeof(tmp))
+      n += snprintf(tmp + n, sizeof(tmp) - (size_t)n, "%.*s | ", (int)flen,
+                    fields);
+    plen = n < 0 ? 0 : (size_t)n < sizeof(tmp) ? (size_t)n : sizeof(tmp) - 1;
+    prefix = tmp;
+  }
+
+  if (c->fd >= 0) {
+    block_append(c, lvl, prefix, plen, msg);
+    return;
+  }
+
+  if (!c->f)
+    return;
+  flockfile(c->f);
+  fwrite(prefix, 1, plen, c->f);
+  fwrite(msg, 1, strlen(msg), c->f);
+  putc_unlocked('\n', c->f);
+  funlockfile(c->f);
   fflush(c->f); /* luego optimizas */
 }
 
+static void block_release(file_ctx_t *c) {
+  for (unsigned i = 0; i < FILE_BLOCKS; ++i)
+    free(c->blocks[i].data);
+  free(c->out);
+#ifdef LOGGER_USE_ZSTD
+  ZSTD_freeCCtx(c->zctx);
+#endif
+  pthread_cond_destroy(&c->drained);
+  pthread_cond_destroy(&c->filled);
+  pthread_mutex_destroy(&c->lock);
+  if (c->index_fd >= 0)
+    close(c->index_fd);
+  close(c->fd);
+}
+
 static void f_destroy(logger_backend_t *self) {
   file_ctx_t *c = (file_ctx_t *)self->ctx;
   if (c) {
     if (c->f)
       fclose(c->f);
+    if (c->fd >= 0) {
+      pthread_mutex_lock(&c->lock);
+      c->stop = 1;
+      pthread_cond_signal(&c->filled);
+      pthread_mutex_unlock(&c->lock);
+      pthread_join(c->writer, NULL);
+      block_release(c);
+    }
     free(c->path);
-    free(c);
+    logger_arena_free(c, sizeof(*c));
   }
-  free(self);
+  logger_arena_free(self, sizeof(*self));
 }
 
-static const logger_backend_vtbl_t V = {
-    .start = f_start, .stop = f_stop, .log = f_log, .destroy = f_destroy};
+static const logger_backend_vtbl_t V = {.start = f_start,
+                                        .stop = f_stop,
+                                        .log = f_log,
+                                        .destroy = f_destroy,
+                                        .flush = f_flush,
+                                        .prewarm = f_prewarm};
+
+/* Sets up block mode; on failure everything it allocated is released. */
+static int block_init(file_ctx_t *c, const logger_file_options_t *opt) {
+  c->codec = opt->compression;
+  c->level = opt->level;
+  c->block_size = opt->block_size ? opt->block_size : FILE_BLOCK_DEFAULT;
+  if (c->block_size < FILE_BLOCK_MIN)
+    c->block_size = FILE_BLOCK_MIN;
+
+  c->durable = opt->durable;
+  c->sync_ms = opt->sync_interval_ms ? opt->sync_interval_ms : FILE_SYNC_MS;
+  c->latency_ns = (uint64_t)opt->latency_us * 1000u;
+
+  int flags = O_CREAT | O_APPEND | O_CLOEXEC;
+  c->fd = open(c->path, flags | (c->durable ? O_RDWR : O_WRONLY), 0666);
+  if (c->fd < 0)
+    return 0;
+  if ((c->durable && !recover(c->fd)) || (opt->index && !index_open(c))) {
+    if (c->index_fd >= 0)
+      close(c->index_fd);
+    close(c->fd);
+    c->fd = -1;
+    c->index_fd = -1;
+    return 0;
+  }
+
+  pthread_mutex_init(&c->lock, NULL);
+  pthread_cond_init(&c->filled, NULL);
+  pthread_cond_init(&c->drained, NULL);
+
+  int ok = 1;
+  size_t cap = c->block_size + FILE_LINE_MAX;
+  for (unsigned i = 0; i < FILE_BLOCKS; ++i) {
+    c->blocks[i].data = (char *)malloc(cap);
+    ok = ok && c->blocks[i].data;
+  }
+  if (c->codec != LOGGER_COMPRESSION_NONE) {
+    c->out_cap = codec_bound(c, cap);
+    c->out = (char *)malloc(c->out_cap);
+    ok = ok && c->out;
+  }
+#ifdef LOGGER_USE_ZSTD
+  if (c->codec == LOGGER_COMPRESSION_ZSTD) {
+    c->zctx = ZSTD_createCCtx();
+    ok = ok && c->zctx;
+  }
+#endif
+  if (ok && pthread_create(&c->writer, NULL, writer_main, c) == 0)
+    return 1;
+
+  block_release(c);
+  c->fd = -1;
+  return 0;
+}
 
 logger_backend_t *logger_backend_file_create(const char *path) {
+  return logger_backend_file_create_ex(path, NULL);
+}
+
+logger_backend_t *
+logger_backend_file_create_ex(const char *path,
+                              const logger_file_options_t *opt) {
   if (!path || !path[0])
     return NULL;
+  if (opt && !logger_file_compression_supported(opt->compression))
+    return NULL;
 
-  logger_backend_t *b = (logger_backend_t *)calloc(1, sizeof(*b));
+  logger_backend_t *b = (logger_backend_t *)logger_arena_alloc(sizeof(*b));
   if (!b)
     return NULL;
 
-  file_ctx_t *c = (file_ctx_t *)calloc(1, sizeof(*c));
+  file_ctx_t *c = (file_ctx_t *)logger_arena_alloc(sizeof(*c));
   if (!c) {
-    free(b);
+    logger_arena_free(b, sizeof(*b));
     return NULL;
   }
+  c->fd = -1;
+  c->index_fd = -1;
+  c->stats = opt && opt->stats ? opt->stats : &c->own;
 
   c->path = (char *)malloc(strlen(path) + 1);
   if (!c->path) {
-    free(c);
-    free(b);
+    logger_arena_free(c, sizeof(*c));
+    logger_arena_free(b, sizeof(*b));
     return NULL;
   }
   strcpy(c->path, path);
+  c->prealloc = opt ? opt->prealloc : 0;
 
-  c->f = fopen(c->path, "a");
-  if (!c->f) {
-    free(c->path);
-    free(c);
-    free(b);
-    return NULL;
+  if (opt && (opt->compression != LOGGER_COMPRESSION_NONE || opt->durable ||
+              opt->index || opt->latency_us)) {
+    if (!block_init(c, opt)) {
+      free(c->path);
+      logger_arena_free(c, sizeof(*c));
+      logger_arena_free(b, sizeof(*b));
+      return NULL;
+    }
+  } else {
+    c->f = fopen(c->path, "a");
+    if (!c->f) {
+      free(c->path);
+      logger_arena_free(c, sizeof(*c));
+      logger_arena_free(b, sizeof(*b));
+      return NULL;
+    }
   }
 
   b->vtbl = &V;
   b->ctx = c;
   return b;
 }
+
+void logger_file_batch_stats(const logger_file_batch_counters_t *c,
+                             unsigned target_us, logger_batch_stats_t *out) {
+  memset(out, 0, sizeof(*out));
+  out->batches = atomic_load_explicit(&c->batches, memory_order_relaxed);
+  out->records = atomic_load_explicit(&c->records, memory_order_relaxed);
+  out->bytes = atomic_load_explicit(&c->bytes, memory_order_relaxed);
+  long long q = atomic_load_explicit(&c->queued, memory_order_relaxed);
+  out->queued = q > 0 ? (unsigned long long)q : 0;
+  out->batch_records =
+      atomic_load_explicit(&c->batch_records, memory_order_relaxed);
+  out->batch_bytes =
+      atomic_load_explicit(&c->batch_bytes, memory_order_relaxed);
+  out->latency_max_us =
+      (unsigned)atomic_load_explicit(&c->latency_max_us, memory_order_relaxed);
+  out->target_us = target_us;
+
+  unsigned long long hist[LOGGER_FILE_LAT_BUCKETS], total = 0;
+  for (unsigned b = 0; b < LOGGER_FILE_LAT_BUCKETS; ++b) {
+    hist[b] = atomic_load_explicit(&c->latency[b], memory_order_relaxed);
+    total += hist[b];
+  }
+  unsigned long long seen = 0;
+  for (unsigned b = 0; b < LOGGER_FILE_LAT_BUCKETS && total; ++b) {
+    if (!hist[b])
+      continue;
+    seen += hist[b];
+    uint64_t top = lat_bucket_top(b);
+    if (top > out->latency_max_us)
+      top = out->latency_max_us; /* the last bucket is open-ended */
+    if (!out->latency_p50_us && seen * 2 >= total)
+      out->latency_p50_us = (unsigned)top;
+    if (seen * 100 >= total * 99) {
+      out->latency_p99_us = (unsigned)top;
+      break;
+    }
+  }
+}
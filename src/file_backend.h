@@ -5,6 +5,15 @@
  * Notes:
  * - The backend opens the file in append mode ("a") during create().
  * - Messages are formatted like: [LEVEL] file:line | message
+ * - With compression enabled (logger_backend_file_create_ex()), lines are
+ *   collected into blocks that a per-backend writer thread compresses and
+ *   appends as independent LZ4/zstd frames.
+ * - In durable mode every block is framed with its length and a CRC-32C,
+ *   fdatasync() is batched (group commit) and a torn tail is cut on open.
+ * - In index mode every block gets an entry in a "<path>.idx" sidecar
+ *   (file_index.h) that tools/logq uses to skip blocks.
+ * - With a latency target, block writes are sized and timed from the
+ *   observed arrival rate and write cost instead of fixed intervals.
  *
  * Ownership:
  * - Returned backend must be destroyed via vtbl->destroy().
@@ -13,6 +22,27 @@
 #define FILE_BACKEND_H
 
 #include "backend.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+/** Latency histogram buckets: four per power of two microseconds. */
+#define LOGGER_FILE_LAT_BUCKETS 128
+
+/**
+ * @brief Block write counters, owned by the caller so they outlive rebuilds.
+ *
+ * Updated by the writer thread of block mode (queued also by producers).
+ */
+typedef struct logger_file_batch_counters {
+  atomic_ullong batches;        /**< Block writes. */
+  atomic_ullong records;        /**< Records written. */
+  atomic_ullong bytes;          /**< Uncompressed bytes written. */
+  atomic_llong queued;          /**< Records accepted, not yet written. */
+  atomic_uint batch_records;    /**< Moving average per write. */
+  atomic_uint batch_bytes;      /**< Moving average per write. */
+  atomic_ullong latency_max_us; /**< Worst first-record-to-disk time. */
+  atomic_ullong latency[LOGGER_FILE_LAT_BUCKETS]; /**< Per-block histogram. */
+} logger_file_batch_counters_t;
 
 /**
  * @brief Creates a file backend.
@@ -29,4 +59,86 @@
  */
 logger_backend_t *logger_backend_file_create(const char *path);
 
+/**
+ * @brief File backend options.
+ *
+ * A zero-initialized struct selects the plain (uncompressed) backend.
+ */
+typedef struct logger_file_options {
+  logger_compression_t compression; /**< block codec */
+  int level;         /**< codec level, 0 = codec default */
+  size_t block_size; /**< uncompressed bytes per block, 0 = 64 KiB */
+  int durable;       /**< checksummed frames + group-commit fdatasync */
+  unsigned sync_interval_ms; /**< durable commit interval, 0 = 100 ms */
+  size_t prealloc; /**< prewarm() reserves this many bytes (Linux) */
+  int index;       /**< write the "<path>.idx" block index */
+  unsigned latency_us; /**< adaptive block writes, max latency; 0 = off */
+  logger_file_batch_counters_t *stats; /**< block write counters, or NULL */
+} logger_file_options_t;
+
+/**
+ * @brief Creates a file backend with options.
+ *
+ * With a codec selected, log() appends the formatted line to an in-memory
+ * block and returns; full blocks (and partial ones after one second, on
+ * stop() and on destroy()) are compressed on the backend's writer thread
+ * and appended to the file as one self-contained frame each. The file is a
+ * plain concatenation of frames, readable with `lz4 -dc` / `zstd -dc`; after
+ * a crash everything up to the last complete frame decodes.
+ *
+ * With @c durable set, each block (compressed or not) is written as a frame:
+ *
+ *   "LGB1" | codec (1 byte) | 3 zero bytes | length (LE32) | CRC-32C (LE32)
+ *   | payload
+ *
+ * where the CRC covers the codec byte through the length, then the
+ * payload. The writer thread seals the current block and calls
+ * fdatasync() once every @c sync_interval_ms, so all records of an interval
+ * share one commit. An ERROR or FATAL record seals and commits at once;
+ * FATAL also waits for the commit before log() returns. On open the
+ * existing file is scanned and truncated after its last valid frame. A
+ * non-empty file that does not start with a frame makes create fail.
+ *
+ * With @c index set, lines are collected into blocks as above (even with
+ * no codec, in which case the log stays plain text) and, for each block
+ * written, an entry with its offset, size, wall-clock time range and the
+ * levels it holds is appended to "<path>.idx" (see file_index.h). Entries
+ * past the end of the log are dropped on open.
+ *
+ * With @c latency_us set, lines are collected into blocks as well, and a
+ * partial block is written when its first line has waited the target minus the
+ * recent cost of a write (in durable mode, write plus fdatasync(), which then
+ * happens for every block) and an eighth of the target for the writer's
+ * wake-up, or at once when the recent arrival rate says no further line would
+ * make it into the block in time. Under load blocks fill up before their
+ * deadline, so writes grow with the rate; at low rates each record is written
+ * within the target.
+ *
+ * @param path Output file path. Must be non-NULL and non-empty.
+ * @param opt  Options, or NULL for the plain backend.
+ *
+ * @return Pointer to a logger_backend_t instance on success.
+ *         Returns NULL if @p path is invalid, the codec is not compiled in
+ *         (see logger_file_compression_supported()) or allocation/open fails.
+ */
+logger_backend_t *
+logger_backend_file_create_ex(const char *path,
+                              const logger_file_options_t *opt);
+
+/**
+ * @brief Tells whether @p codec was compiled in.
+ *
+ * LOGGER_COMPRESSION_NONE is always supported; LZ4 needs LOGGER_USE_LZ4
+ * (link -llz4) and zstd needs LOGGER_USE_ZSTD (link -lzstd).
+ *
+ * @return 1 if supported, 0 otherwise.
+ */
+int logger_file_compression_supported(logger_compression_t codec);
+
+/**
+ * @brief Summarizes @p c into @p out (percentiles from the histogram).
+ */
+void logger_file_batch_stats(const logger_file_batch_counters_t *c,
+                             unsigned target_us, logger_batch_stats_t *out);
+
 #endif
@@ -0,0 +1,95 @@
+/**
+ * @file file_index.h
+ * @brief On-disk layout of the file output's sidecar block index.
+ *
+ * With indexing on, the file backend appends one entry to "<path>.idx" for
+ * every block it writes to "<path>". The index is an accelerator: it may
+ * lag the log after a crash, and readers scan whatever follows the last
+ * indexed block.
+ *
+ * Layout (all integers little-endian):
+ *
+ *   header: "LGI1" | entry size (LE32)
+ *   entry:  offset (LE64)       where the block starts in the log
+ *           stored (LE32)       bytes in the log, frame header included
+ *           lines (LE32)        records in the block
+ *           first_ns (LE64)     CLOCK_REALTIME of the first record
+ *           last_ns (LE64)      CLOCK_REALTIME of the last record
+ *           levels (1 byte)     bit (1 << level) per level present
+ *           codec (1 byte)      logger_compression_t of the payload
+ *           flags (1 byte)      LOGGER_INDEX_FRAMED
+ *           0 (1 byte)
+ *           raw (LE32)          uncompressed payload bytes
+ *
+ * Shared by the backend and tools/logq.c.
+ */
+#ifndef LOGGER_FILE_INDEX_H
+#define LOGGER_FILE_INDEX_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define LOGGER_INDEX_MAGIC "LGI1"
+#define LOGGER_INDEX_HDR 8u
+#define LOGGER_INDEX_ENTRY 40u
+
+/** The block is a durable frame (16-byte header before the payload). */
+#define LOGGER_INDEX_FRAMED 0x01u
+
+typedef struct logger_index_entry {
+  uint64_t offset;
+  uint32_t stored;
+  uint32_t lines;
+  uint64_t first_ns;
+  uint64_t last_ns;
+  uint8_t levels;
+  uint8_t codec;
+  uint8_t flags;
+  uint32_t raw;
+} logger_index_entry_t;
+
+static inline void logger_index_put(unsigned char *p, uint64_t v, int n) {
+  for (int i = 0; i < n; ++i)
+    p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static inline uint64_t logger_index_get(const unsigned char *p, int n) {
+  uint64_t v = 0;
+  for (int i = n - 1; i >= 0; --i)
+    v = v << 8 | p[i];
+  return v;
+}
+
+static inline void logger_index_encode(unsigned char *p,
+                                       const logger_index_entry_t *e) {
+  logger_index_put(p, e->offset, 8);
+  logger_index_put(p + 8, e->stored, 4);
+  logger_index_put(p + 12, e->lines, 4);
+  logger_index_put(p + 16, e->first_ns, 8);
+  logger_index_put(p + 24, e->last_ns, 8);
+  p[32] = e->levels;
+  p[33] = e->codec;
+  p[34] = e->flags;
+  p[35] = 0;
+  logger_index_put(p + 36, e->raw, 4);
+}
+
+static inline void logger_index_decode(const unsigned char *p,
+                                       logger_index_entry_t *e) {
+  e->offset = logger_index_get(p, 8);
+  e->stored = (uint32_t)logger_index_get(p + 8, 4);
+  e->lines = (uint32_t)logger_index_get(p + 12, 4);
+  e->first_ns = logger_index_get(p + 16, 8);
+  e->last_ns = logger_index_get(p + 24, 8);
+  e->levels = p[32];
+  e->codec = p[33];
+  e->flags = p[34];
+  e->raw = (uint32_t)logger_index_get(p + 36, 4);
+}
+
+static inline void logger_index_header(unsigned char *p) {
+  memcpy(p, LOGGER_INDEX_MAGIC, 4);
+  logger_index_put(p + 4, LOGGER_INDEX_ENTRY, 4);
+}
+
+#endif
@@ -0,0 +1,148 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
+#include "flush.h"
+#include "threads.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define FLUSH_IDLE_MS 1000 /* the thread exits after this long idle */
+
+typedef struct flush_req {
+  logger_handle_t *h;
+  logger_flush_cb cb;
+  void *user;
+  logger_status_t st;
+  struct flush_req *next;
+} flush_req_t;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_done = PTHREAD_COND_INITIALIZER;
+static flush_req_t *g_pending = NULL; /* newest first */
+static flush_req_t *g_inflight = NULL;
+static int g_running = 0;
+
+static void complete(flush_req_t *list) {
+  while (list) {
+    flush_req_t *next = list->next;
+    list->cb(list->st, list->user);
+    free(list);
+    list = next;
+  }
+}
+
+static void *flusher_main(void *arg) {
+  (void)arg;
+  logger_thread_started("log-flush");
+  pthread_mutex_lock(&g_lock);
+  for (;;) {
+    while (!g_pending) {
+      struct timespec ts;
+      clock_gettime(CLOCK_REALTIME, &ts);
+      ts.tv_sec += FLUSH_IDLE_MS / 1000;
+      if (pthread_cond_timedwait(&g_wake, &g_lock, &ts) == ETIMEDOUT &&
+          !g_pending) {
+        g_running = 0;
+        pthread_mutex_unlock(&g_lock);
+        return NULL;
+      }
+    }
+
+    /* oldest first, so completions run in request order */
+    while (g_pending) {
+      flush_req_t *r = g_pending;
+      g_pending = r->next;
+      r->next = g_inflight;
+      g_inflight = r;
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    /* one flush per distinct handle in the batch */
+    for (flush_req_t *r = g_inflight; r; r = r->next) {
+      flush_req_t *seen = g_inflight;
+      while (seen != r && seen->h != r->h)
+        seen = seen->next;
+      r->st = seen != r ? seen->st : logger_flush_h(r->h);
+    }
+
+    pthread_mutex_lock(&g_lock);
+    flush_req_t *batch = g_inflight;
+    g_inflight = NULL;
+    pthread_cond_broadcast(&g_done);
+    pthread_mutex_unlock(&g_lock);
+
+    complete(batch);
+    pthread_mutex_lock(&g_lock);
+  }
+}
+
+logger_status_t logger_flush_async_h(logger_handle_t *h, logger_flush_cb cb,
+                                     void *user) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  if (!cb)
+    return LOGGER_UNKOWN_ERROR;
+
+  flush_req_t *r = (flush_req_t *)malloc(sizeof(*r));
+  if (!r)
+    return LOGGER_OUT_OF_MEMORY;
+  r->h = h;
+  r->cb = cb;
+  r->user = user;
+  r->st = LOGGER_OK;
+
+  pthread_mutex_lock(&g_lock);
+  if (!g_running) {
+    pthread_t t;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int err = pthread_create(&t, &attr, flusher_main, NULL);
+    pthread_attr_destroy(&attr);
+    if (err) {
+      pthread_mutex_unlock(&g_lock);
+      free(r);
+      return LOGGER_UNKOWN_ERROR;
+    }
+    g_running = 1;
+  }
+  r->next = g_pending;
+  g_pending = r;
+  pthread_cond_signal(&g_wake);
+  pthread_mutex_unlock(&g_lock);
+  return LOGGER_OK;
+}
+
+logger_status_t logger_flush_async(logger_flush_cb cb, void *user) {
+  return logger_flush_async_h(logger_default(), cb, user);
+}
+
+void logger_flush_forget(logger_handle_t *h) {
+  flush_req_t *dropped = NULL;
+
+  pthread_mutex_lock(&g_lock);
+  for (flush_req_t **pp = &g_pending; *pp;) {
+    flush_req_t *r = *pp;
+    if (r->h == h) {
+      *pp = r->next;
+      r->st = LOGGER_NO_EXIST;
+      r->next = dropped;
+      dropped = r;
+    } else {
+      pp = &r->next;
+    }
+  }
+  for (;;) {
+    int busy = 0;
+    for (flush_req_t *r = g_inflight; r && !busy; r = r->next)
+      busy = r->h == h;
+    if (!busy)
+      break;
+    pthread_cond_wait(&g_done, &g_lock);
+  }
+  pthread_mutex_unlock(&g_lock);
+
+  complete(dropped);
+}
@@ -0,0 +1,24 @@
+/**
+ * @file flush.h
+ * @brief Internal: completion-callback flush requests (logger_flush_async()).
+ *
+ * Requests are queued for a lazily started flusher thread. Each pass takes
+ * every pending request, flushes each distinct handle once with
+ * logger_flush_h() and then completes them all, so a burst of requests
+ * costs one flush (group commit). A request is only served by a pass that
+ * started after it was queued, hence covers every record logged before it.
+ */
+#ifndef LOGGER_FLUSH_H
+#define LOGGER_FLUSH_H
+
+#include "logger.h"
+
+/**
+ * @brief Fails pending requests of @p h and waits out a pass flushing it.
+ *
+ * Called by logger_destroy_h() before the handle is freed. Dropped
+ * requests complete with LOGGER_NO_EXIST.
+ */
+void logger_flush_forget(logger_handle_t *h);
+
+#endif
@@ -0,0 +1,274 @@
+#define _POSIX_C_SOURCE 200809L /* strnlen */
+
+#include "format.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Two ASCII digits per entry: "00", "01", ..., "99". */
+static const char DIGITS2[201] = "00010203040506070809"
+                                 "10111213141516171819"
+                                 "20212223242526272829"
+                                 "30313233343536373839"
+                                 "40414243444546474849"
+                                 "50515253545556575859"
+                                 "60616263646566676869"
+                                 "70717273747576777879"
+                                 "80818283848586878889"
+                                 "90919293949596979899";
+
+static const char HEX_LOWER[] = "0123456789abcdef";
+static const char HEX_UPPER[] = "0123456789ABCDEF";
+
+static const double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4,
+                               1e5, 1e6, 1e7, 1e8, 1e9};
+
+/* Largest precision handled without falling back to vsnprintf(). */
+#define FMT_MAX_PREC 40
+
+/* Fast %f path bound: |v| * 10^prec below 2^40 keeps the product error far
+ * below the half-way tie margin checked in fmt_double(). */
+#define FMT_FAST_FLOAT_MAX 1099511627776.0
+
+typedef struct fmt_out {
+  char *buf;
+  size_t cap; /* usable bytes (size - 1) */
+  size_t len; /* logical length, may exceed cap */
+} fmt_out_t;
+
+static inline void put_mem(fmt_out_t *o, const char *s, size_t n) {
+  if (o->len < o->cap) {
+    size_t room = o->cap - o->len;
+    memcpy(o->buf + o->len, s, n < room ? n : room);
+  }
+  o->len += n;
+}
+
+static inline void put_char(fmt_out_t *o, char c) {
+  if (o->len < o->cap)
+    o->buf[o->len] = c;
+  o->len++;
+}
+
+/* Writes v in decimal right-aligned at end; returns pointer to first digit. */
+static char *u64_to_dec(char *end, uint64_t v) {
+  char *p = end;
+  while (v >= 100) {
+    unsigned idx = (unsigned)(v % 100) * 2;
+    v /= 100;
+    p -= 2;
+    p[0] = DIGITS2[idx];
+    p[1] = DIGITS2[idx + 1];
+  }
+  if (v >= 10) {
+    p -= 2;
+    p[0] = DIGITS2[v * 2];
+    p[1] = DIGITS2[v * 2 + 1];
+  } else {
+    *--p = (char)('0' + v);
+  }
+  return p;
+}
+
+static char *u64_to_hex(char *end, uint64_t v, const char *digits) {
+  char *p = end;
+  do {
+    *--p = digits[v & 0xF];
+    v >>= 4;
+  } while (v);
+  return p;
+}
+
+static void fmt_unsigned(fmt_out_t *o, uint64_t v) {
+  char tmp[24];
+  char *end = tmp + sizeof(tmp);
+  char *p = u64_to_dec(end, v);
+  put_mem(o, p, (size_t)(end - p));
+}
+
+static void fmt_signed(fmt_out_t *o, int64_t v) {
+  if (v < 0) {
+    put_char(o, '-');
+    fmt_unsigned(o, (uint64_t)0 - (uint64_t)v);
+  } else {
+    fmt_unsigned(o, (uint64_t)v);
+  }
+}
+
+static void fmt_hex(fmt_out_t *o, uint64_t v, const char *digits) {
+  char tmp[20];
+  char *end = tmp + sizeof(tmp);
+  char *p = u64_to_hex(end, v, digits);
+  put_mem(o, p, (size_t)(end - p));
+}
+
+static void fmt_double(fmt_out_t *o, double v, int prec) {
+  if (isfinite(v) && prec <= 9) {
+    double scaled = fabs(v) * POW10[prec];
+    if (scaled < FMT_FAST_FLOAT_MAX) {
+      uint64_t whole = (uint64_t)scaled;
+      double frac = scaled - (double)whole;
+      /* Too close to a tie to trust the rounded product: use libc. */
+      if (fabs(frac - 0.5) > 1e-3) {
+        uint64_t r = whole + (frac > 0.5 ? 1 : 0);
+        uint64_t ip = r, fp = 0;
+        if (prec > 0) {
+          uint64_t p10 = (uint64_t)POW10[prec];
+          ip = r / p10;
+          fp = r % p10;
+        }
+
+        if (signbit(v))
+          put_char(o, '-');
+        fmt_unsigned(o, ip);
+        if (prec > 0) {
+          char tmp[16];
+          char *end = tmp + sizeof(tmp);
+          char *p = u64_to_dec(end, fp);
+          while (end - p < prec)
+            *--p = '0';
+          put_char(o, '.');
+          put_mem(o, p, (size_t)prec);
+        }
+        return;
+      }
+    }
+  }
+
+  /* inf/nan, huge magnitudes, ties and long precisions */
+  char tmp[384];
+  int n = snprintf(tmp, sizeof(tmp), "%.*f", prec, v);
+  if (n > 0)
+    put_mem(o, tmp, (size_t)n < sizeof(tmp) ? (size_t)n : sizeof(tmp) - 1);
+}
+
+int logger_vformat(char *buf, size_t size, const char *fmt, va_list ap) {
+  fmt_out_t o = {buf, size ? size - 1 : 0, 0};
+  va_list orig;
+  va_copy(orig, ap);
+
+  const char *f = fmt;
+  while (*f) {
+    const char *lit = f;
+    f += strcspn(f, "%");
+    if (f != lit)
+      put_mem(&o, lit, (size_t)(f - lit));
+    if (!*f)
+      break;
+
+    ++f; /* '%' */
+
+    int prec = -1;
+    if (*f == '.') {
+      ++f;
+      if (*f < '0' || *f > '9')
+        goto fallback;
+      prec = 0;
+      while (*f >= '0' && *f <= '9') {
+        prec = prec * 10 + (*f - '0');
+        if (prec > FMT_MAX_PREC)
+          goto fallback;
+        ++f;
+      }
+    }
+
+    int lng = 0; /* 0 = int, 1 = long, 2 = long long, 3 = size_t */
+    if (*f == 'l') {
+      ++f;
+      lng = 1;
+      if (*f == 'l') {
+        ++f;
+        lng = 2;
+      }
+    } else if (*f == 'z') {
+      ++f;
+      lng = 3;
+    }
+
+    char conv = *f;
+    if (!conv) /* trailing '%' */
+      goto fallback;
+    ++f;
+    if (prec >= 0 && conv != 'f' && conv != 's')
+      goto fallback;
+    if (lng && (conv == 'c' || conv == 's' || conv == 'p' || conv == 'f' ||
+                conv == '%'))
+      goto fallback;
+
+    switch (conv) {
+    case '%':
+      put_char(&o, '%');
+      break;
+    case 'd':
+    case 'i': {
+      int64_t v;
+      if (lng == 0)
+        v = va_arg(ap, int);
+      else if (lng == 1)
+        v = va_arg(ap, long);
+      else if (lng == 2)
+        v = va_arg(ap, long long);
+      else
+        v = (int64_t)va_arg(ap, size_t);
+      fmt_signed(&o, v);
+      break;
+    }
+    case 'u':
+    case 'x':
+    case 'X': {
+      uint64_t v;
+      if (lng == 0)
+        v = va_arg(ap, unsigned int);
+      else if (lng == 1)
+        v = va_arg(ap, unsigned long);
+      else if (lng == 2)
+        v = va_arg(ap, unsigned long long);
+      else
+        v = va_arg(ap, size_t);
+      if (conv == 'u')
+        fmt_unsigned(&o, v);
+      else
+        fmt_hex(&o, v, conv == 'x' ? HEX_LOWER : HEX_UPPER);
+      break;
+    }
+    case 'c':
+      put_char(&o, (char)(unsigned char)va_arg(ap, int));
+      break;
+    case 's': {
+      const char *s = va_arg(ap, const char *);
+      if (!s) /* glibc prints "(null)" only if it fits the precision */
+        s = (prec < 0 || prec >= 6) ? "(null)" : "";
+      size_t n = prec < 0 ? strlen(s) : strnlen(s, (size_t)prec);
+      put_mem(&o, s, n);
+      break;
+    }
+    case 'p': {
+      const void *p = va_arg(ap, const void *);
+      if (!p) {
+        put_mem(&o, "(nil)", 5);
+      } else {
+        put_mem(&o, "0x", 2);
+        fmt_hex(&o, (uint64_t)(uintptr_t)p, HEX_LOWER);
+      }
+      break;
+    }
+    case 'f':
+      fmt_double(&o, va_arg(ap, double), prec < 0 ? 6 : prec);
+      break;
+    default:
+      goto fallback;
+    }
+  }
+
+  va_end(orig);
+  if (size)
+    buf[o.len < o.cap ? o.len : o.cap] = '\0';
+  return (int)o.len;
+
+fallback : {
+  int n = vsnprintf(buf, size, fmt, orig);
+  va_end(orig);
+  return n;
+}
+}
@@ -0,0 +1,37 @@
+/**
+ * @file format.h
+ * @brief Internal printf-compatible formatter used on the logging hot path.
+ *
+ * Handles the subset of conversions that log call sites actually use,
+ * without locale lookups, wide characters or the generic printf state
+ * machine:
+ * - %d %i %u %x %X with no modifier, l, ll or z
+ * - %p %s %c %%
+ * - %f and %.Nf (N <= 40), %.Ns
+ *
+ * Anything else (flags, field widths, '*', %e, %g, %n, ...) makes the whole
+ * call fall back to vsnprintf(), so output is always byte-identical to
+ * glibc's vsnprintf().
+ */
+#ifndef LOGGER_FORMAT_H
+#define LOGGER_FORMAT_H
+
+#include <stdarg.h>
+#include <stddef.h>
+
+/**
+ * @brief vsnprintf()-compatible formatting.
+ *
+ * @param buf  Destination buffer (may be NULL if @p size is 0).
+ * @param size Size of @p buf in bytes. Output is truncated to size - 1
+ *             characters and always NUL-terminated when size > 0.
+ * @param fmt  printf-style format string.
+ * @param ap   Format arguments.
+ *
+ * @return Number of characters that would have been written had @p size
+ *         been large enough (excluding the NUL), or a negative value on
+ *         error, exactly like vsnprintf().
+ */
+int logger_vformat(char *buf, size_t size, const char *fmt, va_list ap);
+
+#endif
@@ -0,0 +1,414 @@
+#define _GNU_SOURCE /* sendmmsg, program_invocation_short_name */
+
+#include "journald_backend.h"
+#include "arena.h"
+#include "context.h"
+#include "threads.h"
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define JD_BATCH 32          /* datagrams per sendmmsg() */
+#define JD_BUF (64u * 1024u) /* bytes per batch */
+#define JD_FLUSH_MS 20       /* a partial batch is sent after this */
+#define JD_FIELDS_MAX 192u   /* field names, framing and numbers */
+#define JD_NAME_MAX 64u      /* journal field name limit */
+
+typedef struct jd_batch {
+  char *buf;
+  size_t len;
+  unsigned n;
+  size_t off[JD_BATCH + 1]; /* datagram i is buf[off[i], off[i + 1]) */
+} jd_batch_t;
+
+typedef struct journald_ctx {
+  int fd;
+  struct sockaddr_un addr;
+  socklen_t addr_len;
+  const char *ident;
+
+  /*
+   * Producers fill batches[fill]; batches[fill ^ 1] is being sent while
+   * sealed is set. Batch counters let flush() wait for its records.
+   */
+  pthread_mutex_t lock;
+  pthread_cond_t filled;  /* sender: a batch was sealed */
+  pthread_cond_t drained; /* flush: a batch was sent */
+  jd_batch_t batches[2];
+  unsigned fill;
+  int sealed;
+  unsigned sealed_count, sent_count;
+  int flush_req, stop;
+  pthread_t sender;
+
+  logger_journald_counters_t own; /* when the caller passes none */
+  logger_journald_counters_t *cnt;
+} journald_ctx_t;
+
+static int priority(logger_level_t lvl) {
+  switch (lvl) {
+  case LOGGER_LEVEL_TRACE:
+  case LOGGER_LEVEL_DEBUG:
+    return 7; /* LOG_DEBUG */
+  case LOGGER_LEVEL_INFO:
+    return 6; /* LOG_INFO */
+  case LOGGER_LEVEL_WARN:
+    return 4; /* LOG_WARNING */
+  case LOGGER_LEVEL_ERROR:
+    return 3; /* LOG_ERR */
+  default:
+    return 2; /* LOG_CRIT */
+  }
+}
+
+/* ---- sender ---- */
+
+static void send_batch(journald_ctx_t *c, const jd_batch_t *b) {
+  struct iovec iov[JD_BATCH];
+  struct mmsghdr msgs[JD_BATCH];
+  memset(msgs, 0, sizeof(msgs));
+  for (unsigned i = 0; i < b->n; ++i) {
+    iov[i].iov_base = b->buf + b->off[i];
+    iov[i].iov_len = b->off[i + 1] - b->off[i];
+    msgs[i].msg_hdr.msg_name = &c->addr;
+    msgs[i].msg_hdr.msg_namelen = c->addr_len;
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  unsigned done = 0;
+  while (done < b->n) {
+    int r = sendmmsg(c->fd, msgs + done, b->n - done, MSG_DONTWAIT);
+    if (r > 0) {
+      done += (unsigned)r;
+      atomic_fetch_add_explicit(&c->cnt->sent, (unsigned)r,
+                                memory_order_relaxed);
+    } else if (r < 0 && errno == EINTR) {
+      continue;
+    } else if (r < 0 && errno == EMSGSIZE) {
+      done++; /* this datagram only */
+      atomic_fetch_add_explicit(&c->cnt->dropped, 1, memory_order_relaxed);
+    } else {
+      /* EAGAIN (socket buffer full), no listener, ...: never wait */
+      atomic_fetch_add_explicit(&c->cnt->dropped, b->n - done,
+                                memory_order_relaxed);
+      break;
+    }
+  }
+}
+
+/* Hands the filling batch to the sender if it is free. Caller holds lock. */
+static int seal_locked(journald_ctx_t *c) {
+  if (c->sealed)
+    return 0;
+  if (c->batches[c->fill].n) {
+    c->fill ^= 1;
+    c->sealed = 1;
+    c->sealed_count++;
+    pthread_cond_signal(&c->filled);
+  }
+  return 1;
+}
+
+static void deadline(struct timespec *ts, unsigned ms) {
+  clock_gettime(CLOCK_REALTIME, ts);
+  ts->tv_nsec += (long)ms * 1000000L;
+  if (ts->tv_nsec >= 1000000000L) {
+    ts->tv_sec++;
+    ts->tv_nsec -= 1000000000L;
+  }
+}
+
+static void *sender_main(void *arg) {
+  journald_ctx_t *c = (journald_ctx_t *)arg;
+  logger_thread_started("log-journald");
+
+  pthread_mutex_lock(&c->lock);
+  for (;;) {
+    while (!c->sealed && !c->stop && !c->flush_req) {
+      if (!c->batches[c->fill].n) {
+        pthread_cond_wait(&c->filled, &c->lock); /* idle */
+        continue;
+      }
+      struct timespec ts;
+      deadline(&ts, JD_FLUSH_MS);
+      if (pthread_cond_timedwait(&c->filled, &c->lock, &ts) == ETIMEDOUT)
+        seal_locked(c);
+    }
+    if (!c->sealed && (c->stop || c->flush_req))
+      seal_locked(c);
+
+    if (c->sealed) {
+      jd_batch_t *b = &c->batches[c->fill ^ 1];
+      pthread_mutex_unlock(&c->lock);
+      send_batch(c, b);
+      pthread_mutex_lock(&c->lock);
+      b->n = 0;
+      b->len = 0;
+      c->sealed = 0;
+      c->sent_count++;
+      pthread_cond_broadcast(&c->drained);
+      continue;
+    }
+
+    c->flush_req = 0;
+    pthread_cond_broadcast(&c->drained);
+    if (c->stop)
+      break;
+  }
+  pthread_mutex_unlock(&c->lock);
+  return NULL;
+}
+
+/* ---- encoding ---- */
+
+static size_t put_field(char *p, const char *name, const char *v, size_t n) {
+  size_t k = strlen(name);
+  memcpy(p, name, k);
+  if (!memchr(v, '\n', n)) {
+    p[k] = '=';
+    memcpy(p + k + 1, v, n);
+    p[k + 1 + n] = '\n';
+    return k + n + 2;
+  }
+  /* binary form: NAME\n, length as LE64, data, \n */
+  p[k] = '\n';
+  for (int i = 0; i < 8; ++i)
+    p[k + 1 + i] = (char)((uint64_t)n >> (8 * i));
+  memcpy(p + k + 9, v, n);
+  p[k + 9 + n] = '\n';
+  return k + n + 10;
+}
+
+/* Fields this backend or the journal give a meaning to. */
+static const char *const RESERVED[] = {
+    "PRIORITY", "SYSLOG_IDENTIFIER", "SYSLOG_FACILITY", "SYSLOG_PID",
+    "SYSLOG_TIMESTAMP", "SYSLOG_RAW", "CODE_FILE", "CODE_LINE", "CODE_FUNC",
+    "LOGGER_SEQ", "TID", "THREAD_NAME", "MESSAGE", "MESSAGE_ID", "ERRNO",
+    "INVOCATION_ID", "USER_INVOCATION_ID", "DOCUMENTATION"};
+
+static int reserved(const char *name) {
+  for (size_t i = 0; i < sizeof(RESERVED) / sizeof(RESERVED[0]); ++i)
+    if (strcmp(name, RESERVED[i]) == 0)
+      return 1;
+  return 0;
+}
+
+/*
+ * Context key as a journal field name: [A-Z0-9_], starting with a letter.
+ * Keys that would not start with a letter, or would land on a reserved
+ * field ("priority", "message"), get a CTX_ prefix.
+ */
+static size_t field_name(char *out, const char *key) {
+  char up[JD_NAME_MAX + 1];
+  size_t n = 0;
+  for (; *key && n < JD_NAME_MAX; ++key) {
+    unsigned char ch = (unsigned char)*key;
+    up[n++] = isalnum(ch) ? (char)toupper(ch) : '_';
+  }
+  up[n] = '\0';
+
+  size_t at = 0;
+  if (!isalpha((unsigned char)up[0]) || reserved(up)) {
+    memcpy(out, "CTX_", 4);
+    at = 4;
+  }
+  if (n > JD_NAME_MAX - at)
+    n = JD_NAME_MAX - at;
+  memcpy(out + at, up, n);
+  out[at + n] = '\0';
+  return at + n;
+}
+
+/* ---- vtable methods ---- */
+
+static logger_status_t jd_start(logger_backend_t *self) {
+  (void)self;
+  return LOGGER_OK;
+}
+
+static logger_status_t jd_flush(logger_backend_t *self) {
+  journald_ctx_t *c = (journald_ctx_t *)self->ctx;
+  if (!c)
+    return LOGGER_UNKOWN_ERROR;
+  pthread_mutex_lock(&c->lock);
+  unsigned target = c->sealed_count + (c->batches[c->fill].n != 0);
+  c->flush_req = 1;
+  pthread_cond_signal(&c->filled);
+  while ((int)(c->sent_count - target) < 0 && !c->stop)
+    pthread_cond_wait(&c->drained, &c->lock);
+  pthread_mutex_unlock(&c->lock);
+  return LOGGER_OK;
+}
+
+static logger_status_t jd_stop(logger_backend_t *self) {
+  return jd_flush(self);
+}
+
+static void jd_log(logger_backend_t *self, logger_level_t lvl,
+                   const char *file, int line, const char *msg) {
+  journald_ctx_t *c = (journald_ctx_t *)self->ctx;
+  if (!c)
+    return;
+  if (!file)
+    file = "";
+  if (!msg)
+    msg = "";
+
+  size_t flen = strlen(file), mlen = strlen(msg);
+  size_t ilen = strlen(c->ident);
+  const logger_record_meta_t *meta = logger_backend_current_record();
+  unsigned long long seq = meta->seq;
+  const logger_ctx_t *fields[LOGGER_CTX_DEPTH];
+  unsigned nf = logger_ctx_fields(meta->ctx, fields);
+  size_t clen = 0;
+  if (meta->thread || nf)
+    logger_ctx_text(meta->ctx, 1, &clen);
+  size_t need = JD_FIELDS_MAX + ilen + flen + mlen + clen +
+                (nf + 1) * (JD_NAME_MAX + 16);
+
+  pthread_mutex_lock(&c->lock);
+  jd_batch_t *b = &c->batches[c->fill];
+  if ((b->n == JD_BATCH || b->len + need > JD_BUF) &&
+      (!seal_locked(c) || need > JD_BUF)) {
+    pthread_mutex_unlock(&c->lock);
+    atomic_fetch_add_explicit(&c->cnt->dropped, 1, memory_order_relaxed);
+    return;
+  }
+  b = &c->batches[c->fill];
+  int was_empty = b->n == 0;
+
+  char num[32];
+  char *p = b->buf + b->len;
+  p += put_field(p, "PRIORITY", num,
+                 (size_t)snprintf(num, sizeof(num), "%d", priority(lvl)));
+  p += put_field(p, "SYSLOG_IDENTIFIER", c->ident, ilen);
+  p += put_field(p, "CODE_FILE", file, flen);
+  p += put_field(p, "CODE_LINE", num,
+                 (size_t)snprintf(num, sizeof(num), "%d", line));
+  if (seq)
+    p += put_field(p, "LOGGER_SEQ", num,
+                   (size_t)snprintf(num, sizeof(num), "%llu", seq));
+  if (meta->thread && meta->ctx) {
+    const char *name = logger_ctx_thread_name(meta->ctx);
+    p += put_field(p, "TID", num,
+                   (size_t)snprintf(num, sizeof(num), "%lu",
+                                    logger_ctx_thread_id(meta->ctx)));
+    if (name[0])
+      p += put_field(p, "THREAD_NAME", name, strlen(name));
+  }
+  for (unsigned i = 0; i < nf; ++i) {
+    char key[JD_NAME_MAX + 1];
+    const char *v = logger_ctx_value(fields[i]);
+    field_name(key, logger_ctx_key(fields[i]));
+    p += put_field(p, key, v, strlen(v));
+  }
+  p += put_field(p, "MESSAGE", msg, mlen);
+  b->len = (size_t)(p - b->buf);
+  b->off[++b->n] = b->len;
+
+  if (b->n == JD_BATCH || lvl >= LOGGER_LEVEL_ERROR) {
+    if (!seal_locked(c))
+      c->flush_req = 1; /* sender busy: seal right after this send */
+  } else if (was_empty)
+    pthread_cond_signal(&c->filled); /* arm the sender's interval */
+  pthread_mutex_unlock(&c->lock);
+}
+
+static void jd_destroy(logger_backend_t *self) {
+  journald_ctx_t *c = (journald_ctx_t *)self->ctx;
+  if (c) {
+    pthread_mutex_lock(&c->lock);
+    c->stop = 1;
+    pthread_cond_signal(&c->filled);
+    pthread_mutex_unlock(&c->lock);
+    pthread_join(c->sender, NULL);
+
+    pthread_cond_destroy(&c->drained);
+    pthread_cond_destroy(&c->filled);
+    pthread_mutex_destroy(&c->lock);
+    free(c->batches[0].buf);
+    free(c->batches[1].buf);
+    close(c->fd);
+    logger_arena_free(c, sizeof(*c));
+  }
+  logger_arena_free(self, sizeof(*self));
+}
+
+static const logger_backend_vtbl_t V = {.start = jd_start,
+                                        .stop = jd_stop,
+                                        .log = jd_log,
+                                        .destroy = jd_destroy,
+                                        .flush = jd_flush};
+
+logger_backend_t *
+logger_backend_journald_create(const char *socket_path,
+                               logger_journald_counters_t *counters) {
+  if (!socket_path || !socket_path[0])
+    socket_path = LOGGER_JOURNALD_SOCKET;
+
+  struct stat st;
+  if (strlen(socket_path) >= sizeof(((struct sockaddr_un *)0)->sun_path) ||
+      stat(socket_path, &st) != 0 || !S_ISSOCK(st.st_mode))
+    return NULL;
+
+  logger_backend_t *b = (logger_backend_t *)logger_arena_alloc(sizeof(*b));
+  if (!b)
+    return NULL;
+
+  journald_ctx_t *c = (journald_ctx_t *)logger_arena_alloc(sizeof(*c));
+  if (!c) {
+    logger_arena_free(b, sizeof(*b));
+    return NULL;
+  }
+
+  c->addr.sun_family = AF_UNIX;
+  strcpy(c->addr.sun_path, socket_path);
+  c->addr_len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) +
+                            strlen(socket_path) + 1);
+#ifdef __GLIBC__
+  c->ident = program_invocation_short_name;
+#else
+  c->ident = "logger";
+#endif
+  c->cnt = counters ? counters : &c->own;
+
+  c->fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  c->batches[0].buf = (char *)malloc(JD_BUF);
+  c->batches[1].buf = (char *)malloc(JD_BUF);
+  if (c->fd < 0 || !c->batches[0].buf || !c->batches[1].buf)
+    goto fail;
+
+  pthread_mutex_init(&c->lock, NULL);
+  pthread_cond_init(&c->filled, NULL);
+  pthread_cond_init(&c->drained, NULL);
+  if (pthread_create(&c->sender, NULL, sender_main, c) != 0) {
+    pthread_cond_destroy(&c->drained);
+    pthread_cond_destroy(&c->filled);
+    pthread_mutex_destroy(&c->lock);
+    goto fail;
+  }
+
+  b->vtbl = &V;
+  b->ctx = c;
+  return b;
+
+fail:
+  if (c->fd >= 0)
+    close(c->fd);
+  free(c->batches[0].buf);
+  free(c->batches[1].buf);
+  logger_arena_free(c, sizeof(*c));
+  logger_arena_free(b, sizeof(*b));
+  return NULL;
+}
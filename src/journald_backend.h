@@ -0,0 +1,58 @@
+/**
+ * @file journald_backend.h
+ * @brief Backend that sends records to systemd-journald (native protocol).
+ *
+ * Notes:
+ * - Each record is one datagram on the journal's AF_UNIX socket, made of
+ *   the fields PRIORITY (from logger_level_t), SYSLOG_IDENTIFIER,
+ *   CODE_FILE, CODE_LINE, LOGGER_SEQ (with logger_set_sequence()) and
+ *   MESSAGE. A multi-line message uses the protocol's length-prefixed form.
+ * - With thread info on, TID and THREAD_NAME are added. Each context field
+ *   becomes a field named after its key, upper-cased, with [^A-Z0-9]
+ *   mapped to '_'; a CTX_ prefix is added when the key does not start with
+ *   a letter or names one of the fields above (or another one the journal
+ *   reserves), so a context key never overrides them.
+ * - log() only copies the record into the filling batch. A sender thread
+ *   hands each batch to the kernel with one sendmmsg() call; a partial
+ *   batch is sent after 20 ms, at once for ERROR+ records, on flush() and
+ *   on stop().
+ * - Nothing blocks: a record that finds both batches busy, a full socket
+ *   buffer (EAGAIN) and a missing listener all count as drops.
+ *
+ * Ownership:
+ * - Returned backend must be destroyed via vtbl->destroy().
+ */
+#ifndef JOURNALD_BACKEND_H
+#define JOURNALD_BACKEND_H
+
+#include "backend.h"
+
+#include <stdatomic.h>
+
+/** Default journal socket. */
+#define LOGGER_JOURNALD_SOCKET "/run/systemd/journal/socket"
+
+/**
+ * @brief Delivery counters, owned by the caller so they outlive rebuilds.
+ */
+typedef struct logger_journald_counters {
+  atomic_ullong sent;    /**< Datagrams the socket accepted. */
+  atomic_ullong dropped; /**< Records lost (busy, EAGAIN, no listener). */
+} logger_journald_counters_t;
+
+/**
+ * @brief Creates a journald backend.
+ *
+ * @param socket_path Datagram socket to send to, NULL for
+ *                    LOGGER_JOURNALD_SOCKET.
+ * @param counters    Counters to update (may be NULL).
+ *
+ * @return Pointer to a logger_backend_t instance on success.
+ *         Returns NULL if @p socket_path is not a socket or if
+ *         allocation/socket creation fails.
+ */
+logger_backend_t *
+logger_backend_journald_create(const char *socket_path,
+                               logger_journald_counters_t *counters);
+
+#endif
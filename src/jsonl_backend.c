@@ -0,0 +1,337 @@
+#define _POSIX_C_SOURCE 200809L /* fileno, fdatasync */
+
+#include "jsonl_backend.h"
+#include "arena.h"
+#include "context.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define JSONL_USE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define JSONL_USE_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef struct jsonl_ctx {
+  FILE *f;
+  char *path; /* owned */
+  char *buf;  /* escape scratch buffer, owned */
+  size_t cap;
+  pthread_mutex_t lock; /* guards buf across concurrent log() calls */
+} jsonl_ctx_t;
+
+static const char *lvl_to_str(logger_level_t lvl) {
+  switch (lvl) {
+  case LOGGER_LEVEL_TRACE:
+    return "TRACE";
+  case LOGGER_LEVEL_DEBUG:
+    return "DEBUG";
+  case LOGGER_LEVEL_INFO:
+    return "INFO";
+  case LOGGER_LEVEL_WARN:
+    return "WARN";
+  case LOGGER_LEVEL_ERROR:
+    return "ERROR";
+  case LOGGER_LEVEL_FATAL:
+    return "FATAL";
+  default:
+    return "UNKNOWN";
+  }
+}
+
+/* ---- escaping ---- */
+
+static const char HEX[] = "0123456789abcdef";
+
+static size_t escape_byte(char *dst, unsigned char ch) {
+  switch (ch) {
+  case '"':
+    dst[0] = '\\';
+    dst[1] = '"';
+    return 2;
+  case '\\':
+    dst[0] = '\\';
+    dst[1] = '\\';
+    return 2;
+  case '\n':
+    dst[0] = '\\';
+    dst[1] = 'n';
+    return 2;
+  case '\r':
+    dst[0] = '\\';
+    dst[1] = 'r';
+    return 2;
+  case '\t':
+    dst[0] = '\\';
+    dst[1] = 't';
+    return 2;
+  case '\b':
+    dst[0] = '\\';
+    dst[1] = 'b';
+    return 2;
+  case '\f':
+    dst[0] = '\\';
+    dst[1] = 'f';
+    return 2;
+  default:
+    dst[0] = '\\';
+    dst[1] = 'u';
+    dst[2] = '0';
+    dst[3] = '0';
+    dst[4] = HEX[ch >> 4];
+    dst[5] = HEX[ch & 0xF];
+    return 6;
+  }
+}
+
+static inline int needs_escape(unsigned char ch) {
+  return ch < 0x20 || ch == '"' || ch == '\\';
+}
+
+/*
+ * Returns a bitmask (bit i = byte i) of the bytes in src[0..15] that need
+ * escaping, or 0 when the whole chunk can be copied as-is.
+ */
+#if defined(JSONL_USE_SSE2)
+static inline unsigned special_mask16(const char *src) {
+  const __m128i v = _mm_loadu_si128((const __m128i *)src);
+  const __m128i quote = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+  const __m128i bslash = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+  /* unsigned v <= 0x1F  <=>  min(v, 0x1F) == v */
+  const __m128i ctrl =
+      _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1F)), v);
+  const __m128i any = _mm_or_si128(_mm_or_si128(quote, bslash), ctrl);
+  return (unsigned)_mm_movemask_epi8(any);
+}
+#elif defined(JSONL_USE_NEON)
+static inline uint64_t special_mask16(const char *src) {
+  const uint8x16_t v = vld1q_u8((const uint8_t *)src);
+  const uint8x16_t quote = vceqq_u8(v, vdupq_n_u8('"'));
+  const uint8x16_t bslash = vceqq_u8(v, vdupq_n_u8('\\'));
+  const uint8x16_t ctrl = vcltq_u8(v, vdupq_n_u8(0x20));
+  const uint8x16_t any = vorrq_u8(vorrq_u8(quote, bslash), ctrl);
+  /* Narrow to 4 bits per byte: bit (4 * i) is set for a special byte i. */
+  const uint8x8_t nib = vshrn_n_u16(vreinterpretq_u16_u8(any), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(nib), 0) & 0x1111111111111111ULL;
+}
+#endif
+
+size_t logger_jsonl_escape(char *dst, const char *src, size_t len) {
+  char *out = dst;
+  size_t i = 0;
+
+#if defined(JSONL_USE_SSE2) || defined(JSONL_USE_NEON)
+  while (i + 16 <= len) {
+#if defined(JSONL_USE_SSE2)
+    unsigned mask = special_mask16(src + i);
+    const unsigned shift = 1;
+#else
+    uint64_t mask = special_mask16(src + i);
+    const unsigned shift = 4;
+#endif
+    if (!mask) {
+      memcpy(out, src + i, 16);
+      out += 16;
+      i += 16;
+      continue;
+    }
+
+    /* Copy the clean run before each special byte, then escape it. */
+    size_t done = 0;
+    while (mask) {
+      size_t pos = (size_t)__builtin_ctzll(mask) / shift;
+      memcpy(out, src + i + done, pos - done);
+      out += pos - done;
+      out += escape_byte(out, (unsigned char)src[i + pos]);
+      done = pos + 1;
+      mask &= mask - 1;
+    }
+    memcpy(out, src + i + done, 16 - done);
+    out += 16 - done;
+    i += 16;
+  }
+#endif
+
+  for (; i < len; ++i) {
+    unsigned char ch = (unsigned char)src[i];
+    if (needs_escape(ch))
+      out += escape_byte(out, ch);
+    else
+      *out++ = (char)ch;
+  }
+
+  return (size_t)(out - dst);
+}
+
+/* ---- vtable methods ---- */
+
+static logger_status_t j_start(logger_backend_t *self) {
+  (void)self;
+  return LOGGER_OK;
+}
+
+static logger_status_t j_stop(logger_backend_t *self) {
+  jsonl_ctx_t *c = (jsonl_ctx_t *)self->ctx;
+  if (c && c->f)
+    fflush(c->f);
+  return LOGGER_OK;
+}
+
+static logger_status_t j_flush(logger_backend_t *self) {
+  jsonl_ctx_t *c = (jsonl_ctx_t *)self->ctx;
+  if (!c || !c->f)
+    return LOGGER_UNKOWN_ERROR;
+  pthread_mutex_lock(&c->lock);
+  int ok = fflush(c->f) == 0;
+  pthread_mutex_unlock(&c->lock);
+  return ok && fdatasync(fileno(c->f)) == 0 ? LOGGER_OK : LOGGER_UNKOWN_ERROR;
+}
+
+static int reserve(jsonl_ctx_t *c, size_t need) {
+  if (need <= c->cap)
+    return 1;
+  size_t cap = c->cap ? c->cap : 4096;
+  while (cap < need)
+    cap *= 2;
+  char *nb = (char *)realloc(c->buf, cap);
+  if (!nb)
+    return 0;
+  c->buf = nb;
+  c->cap = cap;
+  return 1;
+}
+
+static void j_log(logger_backend_t *self, logger_level_t lvl, const char *file,
+                  int line, const char *msg) {
+  jsonl_ctx_t *c = (jsonl_ctx_t *)self->ctx;
+  if (!c || !c->f)
+    return;
+
+  if (!file)
+    file = "";
+  if (!msg)
+    msg = "";
+
+  size_t flen = strlen(file);
+  size_t mlen = strlen(msg);
+  const logger_record_meta_t *meta = logger_backend_current_record();
+  unsigned long long seq = meta->seq;
+  const logger_ctx_t *fields[LOGGER_CTX_DEPTH];
+  unsigned nf = logger_ctx_fields(meta->ctx, fields);
+  size_t clen = 0;
+  if (meta->thread || nf)
+    logger_ctx_text(meta->ctx, 1, &clen);
+
+  pthread_mutex_lock(&c->lock);
+
+  /* fixed keys + seq + level + line number + context + worst-case escaping */
+  if (!reserve(c, 160 + 6 * (flen + mlen + clen) + 6 * nf)) {
+    pthread_mutex_unlock(&c->lock);
+    return;
+  }
+
+  char *p = c->buf;
+  *p++ = '{';
+  if (seq)
+    p += sprintf(p, "\"seq\":%llu,", seq);
+  p += sprintf(p, "\"level\":\"%s\",\"file\":\"", lvl_to_str(lvl));
+  p += logger_jsonl_escape(p, file, flen);
+  p += sprintf(p, "\",\"line\":%d,", line);
+  if (meta->thread && meta->ctx) {
+    const char *name = logger_ctx_thread_name(meta->ctx);
+    p += sprintf(p, "\"tid\":%lu,\"thread\":\"",
+                 logger_ctx_thread_id(meta->ctx));
+    p += logger_jsonl_escape(p, name, strlen(name));
+    *p++ = '"';
+    *p++ = ',';
+  }
+  if (nf) {
+    memcpy(p, "\"ctx\":{", 7);
+    p += 7;
+    for (unsigned i = 0; i < nf; ++i) {
+      const char *k = logger_ctx_key(fields[i]);
+      const char *v = logger_ctx_value(fields[i]);
+      if (i)
+        *p++ = ',';
+      *p++ = '"';
+      p += logger_jsonl_escape(p, k, strlen(k));
+      memcpy(p, "\":\"", 3);
+      p += 3;
+      p += logger_jsonl_escape(p, v, strlen(v));
+      *p++ = '"';
+    }
+    *p++ = '}';
+    *p++ = ',';
+  }
+  p += sprintf(p, "\"msg\":\"");
+  p += logger_jsonl_escape(p, msg, mlen);
+  *p++ = '"';
+  *p++ = '}';
+  *p++ = '\n';
+
+  fwrite(c->buf, 1, (size_t)(p - c->buf), c->f);
+  fflush(c->f);
+  pthread_mutex_unlock(&c->lock);
+}
+
+static void j_destroy(logger_backend_t *self) {
+  jsonl_ctx_t *c = (jsonl_ctx_t *)self->ctx;
+  if (c) {
+    if (c->f)
+      fclose(c->f);
+    free(c->buf);
+    free(c->path);
+    pthread_mutex_destroy(&c->lock);
+    logger_arena_free(c, sizeof(*c));
+  }
+  logger_arena_free(self, sizeof(*self));
+}
+
+static const logger_backend_vtbl_t V = {.start = j_start,
+                                        .stop = j_stop,
+                                        .log = j_log,
+                                        .destroy = j_destroy,
+                                        .flush = j_flush};
+
+logger_backend_t *logger_backend_jsonl_create(const char *path) {
+  if (!path || !path[0])
+    return NULL;
+
+  logger_backend_t *b = (logger_backend_t *)logger_arena_alloc(sizeof(*b));
+  if (!b)
+    return NULL;
+
+  jsonl_ctx_t *c = (jsonl_ctx_t *)logger_arena_alloc(sizeof(*c));
+  if (!c) {
+    logger_arena_free(b, sizeof(*b));
+    return NULL;
+  }
+
+  c->path = (char *)malloc(strlen(path) + 1);
+  if (!c->path) {
+    logger_arena_free(c, sizeof(*c));
+    logger_arena_free(b, sizeof(*b));
+    return NULL;
+  }
+  strcpy(c->path, path);
+
+  c->f = fopen(c->path, "a");
+  if (!c->f) {
+    free(c->path);
+    logger_arena_free(c, sizeof(*c));
+    logger_arena_free(b, sizeof(*b));
+    return NULL;
+  }
+
+  pthread_mutex_init(&c->lock, NULL);
+
+  b->vtbl = &V;
+  b->ctx = c;
+  return b;
+}
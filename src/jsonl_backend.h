@@ -0,0 +1,48 @@
+/**
+ * @file jsonl_backend.h
+ * @brief JSON Lines backend that appends one JSON object per log record.
+ *
+ * Notes:
+ * - The backend opens the file in append mode ("a") during create().
+ * - Records are written like:
+ *   {"level":"INFO","file":"main.c","line":12,"msg":"..."}
+ * - String fields are escaped per RFC 8259. The escaper scans 16 bytes at a
+ *   time with SSE2 (x86/x86_64) or NEON (aarch64) and falls back to a scalar
+ *   loop elsewhere.
+ *
+ * Ownership:
+ * - Returned backend must be destroyed via vtbl->destroy().
+ */
+#ifndef JSONL_BACKEND_H
+#define JSONL_BACKEND_H
+
+#include "backend.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Creates a JSON Lines backend.
+ *
+ * @param path Output file path. Must be non-NULL and non-empty.
+ *
+ * @return Pointer to a logger_backend_t instance on success.
+ *         Returns NULL if @p path is invalid or if allocation/open fails.
+ */
+logger_backend_t *logger_backend_jsonl_create(const char *path);
+
+/**
+ * @brief Escapes @p len bytes of @p src as the body of a JSON string.
+ *
+ * Quotes, backslashes and control characters (< 0x20) are escaped; every
+ * other byte is copied verbatim (UTF-8 passes through untouched). No
+ * surrounding quotes and no NUL terminator are written.
+ *
+ * @param dst Output buffer, at least (6 * len) bytes.
+ * @param src Input bytes.
+ * @param len Number of input bytes.
+ *
+ * @return Number of bytes written to @p dst.
+ */
+size_t logger_jsonl_escape(char *dst, const char *src, size_t len);
+
+#endif
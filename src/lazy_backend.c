@@ -0,0 +1,129 @@
+#include "lazy_backend.h"
+#include "arena.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+typedef struct lazy_ctx {
+  _Atomic(logger_backend_t *) inner; /* NULL until built */
+  pthread_mutex_t lock;              /* build / start / stop */
+  int started;
+  int failed;
+  logger_backend_factory_t make;
+  void *arg;
+  void (*free_arg)(void *);
+} lazy_ctx_t;
+
+/* Builds (and starts, if the proxy is started) the real backend once. */
+static logger_backend_t *materialize(lazy_ctx_t *c) {
+  pthread_mutex_lock(&c->lock);
+  logger_backend_t *b = atomic_load_explicit(&c->inner, memory_order_relaxed);
+  if (!b && !c->failed) {
+    b = c->make(c->arg);
+    if (b && c->started && b->vtbl->start(b) != LOGGER_OK) {
+      b->vtbl->destroy(b);
+      b = NULL;
+    }
+    if (b)
+      atomic_store_explicit(&c->inner, b, memory_order_release);
+    else
+      c->failed = 1;
+  }
+  pthread_mutex_unlock(&c->lock);
+  return b;
+}
+
+/* ---- vtable methods ---- */
+
+static logger_status_t z_start(logger_backend_t *self) {
+  lazy_ctx_t *c = (lazy_ctx_t *)self->ctx;
+  logger_status_t st = LOGGER_OK;
+  pthread_mutex_lock(&c->lock);
+  logger_backend_t *b = atomic_load_explicit(&c->inner, memory_order_relaxed);
+  if (b)
+    st = b->vtbl->start(b);
+  c->started = st == LOGGER_OK;
+  pthread_mutex_unlock(&c->lock);
+  return st;
+}
+
+static logger_status_t z_stop(logger_backend_t *self) {
+  lazy_ctx_t *c = (lazy_ctx_t *)self->ctx;
+  logger_status_t st = LOGGER_OK;
+  pthread_mutex_lock(&c->lock);
+  logger_backend_t *b = atomic_load_explicit(&c->inner, memory_order_relaxed);
+  if (b)
+    st = b->vtbl->stop(b);
+  c->started = 0;
+  pthread_mutex_unlock(&c->lock);
+  return st;
+}
+
+static void z_log(logger_backend_t *self, logger_level_t level,
+                  const char *file, int line, const char *msg) {
+  lazy_ctx_t *c = (lazy_ctx_t *)self->ctx;
+  logger_backend_t *b = atomic_load_explicit(&c->inner, memory_order_acquire);
+  if (!b && !(b = materialize(c)))
+    return;
+  b->vtbl->log(b, level, file, line, msg);
+}
+
+static logger_status_t z_flush(logger_backend_t *self) {
+  lazy_ctx_t *c = (lazy_ctx_t *)self->ctx;
+  logger_backend_t *b = atomic_load_explicit(&c->inner, memory_order_acquire);
+  return b && b->vtbl->flush ? b->vtbl->flush(b) : LOGGER_OK;
+}
+
+static void z_prewarm(logger_backend_t *self) {
+  lazy_ctx_t *c = (lazy_ctx_t *)self->ctx;
+  logger_backend_t *b = materialize(c);
+  if (b && b->vtbl->prewarm)
+    b->vtbl->prewarm(b);
+}
+
+static void z_destroy(logger_backend_t *self) {
+  lazy_ctx_t *c = (lazy_ctx_t *)self->ctx;
+  if (c) {
+    logger_backend_t *b = atomic_load(&c->inner);
+    if (b)
+      b->vtbl->destroy(b);
+    if (c->free_arg)
+      c->free_arg(c->arg);
+    pthread_mutex_destroy(&c->lock);
+    logger_arena_free(c, sizeof(*c));
+  }
+  logger_arena_free(self, sizeof(*self));
+}
+
+static const logger_backend_vtbl_t V = {.start = z_start,
+                                        .stop = z_stop,
+                                        .log = z_log,
+                                        .destroy = z_destroy,
+                                        .flush = z_flush,
+                                        .prewarm = z_prewarm};
+
+logger_backend_t *logger_backend_lazy_create(logger_backend_factory_t make,
+                                             void *arg,
+                                             void (*free_arg)(void *)) {
+  if (!make)
+    return NULL;
+
+  logger_backend_t *b = (logger_backend_t *)logger_arena_alloc(sizeof(*b));
+  if (!b)
+    return NULL;
+
+  lazy_ctx_t *c = (lazy_ctx_t *)logger_arena_alloc(sizeof(*c));
+  if (!c) {
+    logger_arena_free(b, sizeof(*b));
+    return NULL;
+  }
+
+  atomic_init(&c->inner, NULL);
+  pthread_mutex_init(&c->lock, NULL);
+  c->make = make;
+  c->arg = arg;
+  c->free_arg = free_arg;
+
+  b->vtbl = &V;
+  b->ctx = c;
+  return b;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file lazy_backend.h
+ * @brief Proxy that builds its backend on the first record (or prewarm).
+ *
+ * Keeps logger_start() cheap: files are not opened and client threads are
+ * not started until a record actually reaches the output, or until the
+ * prewarm thread calls vtbl->prewarm(). If building fails, records sent
+ * to the proxy are dropped and no further attempt is made.
+ *
+ * Ownership:
+ * - The proxy owns @p arg (released with @p free_arg) and the backend it
+ *   builds.
+ */
+#ifndef LAZY_BACKEND_H
+#define LAZY_BACKEND_H
+
+#include "backend.h"
+
+/** @brief Builds the real backend from the captured configuration. */
+typedef logger_backend_t *(*logger_backend_factory_t)(void *arg);
+
+/**
+ * @brief Creates a lazy proxy.
+ *
+ * @param make     Factory called at most once, from the first log() or
+ *                 prewarm() (serialized by the proxy).
+ * @param arg      Factory argument, owned by the proxy.
+ * @param free_arg Releases @p arg (may be NULL).
+ *
+ * @return Pointer to a logger_backend_t instance on success, NULL on failure
+ *         (the caller keeps @p arg).
+ */
+logger_backend_t *logger_backend_lazy_create(logger_backend_factory_t make,
+                                             void *arg,
+                                             void (*free_arg)(void *));
+
+#endif
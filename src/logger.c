@@ -1,9 +1,23 @@
 #include "logger.h"
 
+#include "arena.h"
+#include "async.h"
 #include "backend.h"
 #include "composite_backend.h"
 #include "console_backend.h"
+#include "context.h"
+#include "dedup_backend.h"
 #include "file_backend.h"
+#include "flush.h"
+#include "format.h"
+#include "journald_backend.h"
+#include "jsonl_backend.h"
+#include "lazy_backend.h"
+#include "logger_timer.h"
+#include "queue_backend.h"
+#include "shard.h"
+#include "srcloc.h"
+#include "threads.h"
 #include "tracy_backend.h"
 
 // #define USE_QUILL
@@ -12,15 +26,18 @@
 #include "quill_backend.h"
 #endif
 
+#ifdef TRACY_ENABLE
+#include "tracy/TracyC.h"
+#endif
+
+#include <pthread.h>
+#include <sched.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-/* Todo, implement mutex
-#include <pthread.h>
-*/
-
 /**
  * @internal
  * @brief String lookup table for logger_status_t values.
@@ -42,81 +59,354 @@ static const char *logger_status_str[LOGGER_STATUS_COUNT] = {
     [LOGGER_INVALID_PATH] = "LOGGER_INVALID_PATH",
     [LOGGER_OUT_OF_MEMORY] = "LOGGER_OUT_OF_MEMORY",
     [LOGGER_UNABLE_TO_OPEN_FILE] = "LOGGER_UNABLE_TO_OPEN_FILE",
-    [LOGGER_UNKOWN_ERROR] = "LOGGER_UNKOWN_ERROR"};
+    [LOGGER_UNKOWN_ERROR] = "LOGGER_UNKOWN_ERROR",
+    [LOGGER_ALREADY_INITIALIZED] = "LOGGER_ALREADY_INITIALIZED"};
+
+/* Default handle used by the global (non-_h) API; NULL once destroyed. */
+_Atomic(logger_handle_t *) base_logger = NULL;
+
+/*
+ * Per-thread-shard counters (see shard.h). readers[] are two-epoch read
+ * sections: a logging thread is registered in one of them while it uses
+ * the handle's backend, so stop/destroy/restart can wait it out.
+ */
+typedef struct logger_counters {
+  _Alignas(LOGGER_CACHE_LINE) atomic_ullong logged;
+  atomic_ullong filtered;
+  atomic_ullong dropped;
+  atomic_ulong readers[2];
+} logger_counters_t;
 
-logger_handle_t *base_logger = {0};
+/* Read sections of the default-handle logging calls, for logger_destroy(). */
+typedef struct default_readers {
+  _Alignas(LOGGER_CACHE_LINE) atomic_ulong readers[2];
+} default_readers_t;
+
+static default_readers_t g_default_readers[LOGGER_SHARDS];
+static atomic_uint g_default_epoch = 0;
 
 struct logger_handle {
-  logger_level_t level;
-  int started;
+  /*
+   * Hot, read-mostly state touched by every logger_log() call. It sits alone
+   * on its own cache line so configuration writes (below) and counter
+   * updates (sharded) never invalidate it on other cores.
+   */
+  _Alignas(LOGGER_CACHE_LINE) _Atomic logger_level_t level;
+  atomic_int started;
+  atomic_int async; /* hand records to the consumer thread */
+  atomic_int express; /* async: levels >= this are written inline */
+  atomic_int sequence; /* stamp records from seq */
+  atomic_int thread_info; /* records show thread id/name */
+  atomic_int raw_backends; /* children that take log_raw() */
+  _Atomic(logger_backend_t *) backend; /* dedup stage -> composite */
+  atomic_uint epoch; /* selects the readers[] slot new sections use */
+
+  /* Shared by every producer when sequence numbers are on. */
+  _Alignas(LOGGER_CACHE_LINE) atomic_ullong seq;
+
+  /* Cold configuration, written under mutex. */
+  _Alignas(LOGGER_CACHE_LINE) char *name; /* owned */
 
   int console_enabled;
 
   int file_enabled;
   char *file_path;
+  logger_file_options_t file_opts;
+  logger_file_batch_counters_t file_batch; /* survives output rebuilds */
+
+  int jsonl_enabled;
+  char *jsonl_path;
 
   int tracy_enabled;
 
-  logger_backend_t *backend;
+  int journald_enabled;
+  char *journald_path;
+  logger_journald_counters_t journald; /* outlives journald outputs */
+
+  logger_level_t output_level[LOGGER_OUTPUT_COUNT]; /* per-output filter */
+
+  struct user_backend *user_backends; /* registration order */
+  int user_tag;                       /* next composite tag */
+
+  logger_backend_t *composite; /* owned by backend, for reconfiguration */
+  int dedup_enabled;
+  unsigned dedup_window_ms;
+
+  int lazy_outputs;     /* build outputs on their first record */
+  int prewarm;          /* build/warm outputs on a thread at start */
+  size_t prewarm_bytes; /* file space reserved by prewarm */
+  pthread_t prewarm_thread;
+  int prewarm_running;
+  unsigned quill_gen;
+
+  pthread_mutex_t mutex; /* guards configuration and lifecycle */
 
-  /* pthread_mutex_t mutex; */
+  logger_handle_t *next; /* registry link */
+
+  logger_counters_t counters[LOGGER_SHARDS];
 };
 
-static logger_backend_t *make_backend() {
-  logger_backend_t *composite = logger_backend_composite_create();
-  if (!composite)
-    return NULL;
+/* A registered user backend; tags follow the logger_output_t range. */
+typedef struct user_backend {
+  char *name; /* owned */
+  unsigned caps;
+  logger_level_t min_level;
+  logger_backend_t *(*create)(void *arg);
+  void *arg;
+  void (*free_arg)(void *arg);
+  int tag;
+  int raw; /* current child takes log_raw() */
+  struct user_backend *next;
+} user_backend_t;
+
+/* Registry of live handles, so subsystems can look each other up by name. */
+static pthread_mutex_t g_registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static logger_handle_t *g_registry = NULL;
+
+static logger_handle_t *registry_find_locked(const char *name) {
+  for (logger_handle_t *it = g_registry; it; it = it->next) {
+    if (strcmp(it->name, name) == 0)
+      return it;
+  }
+  return NULL;
+}
 
-  int added = 0;
+static void registry_remove_locked(logger_handle_t *h) {
+  for (logger_handle_t **pp = &g_registry; *pp; pp = &(*pp)->next) {
+    if (*pp == h) {
+      *pp = h->next;
+      h->next = NULL;
+      return;
+    }
+  }
+}
 
+/*
+ * In Quill builds console and file output are sinks of a single Quill child,
+ * so they are addressed as LOGGER_OUTPUT_QUILL inside the composite.
+ */
+static logger_output_t child_tag(logger_output_t out) {
 #ifdef USE_QUILL
-  // If QUILL selected will be the only backend
-  logger_backend_t *q = logger_backend_quill_create(
-      base_logger->file_enabled ? base_logger->file_path : NULL,
-      base_logger->console_enabled);
+  if (out == LOGGER_OUTPUT_CONSOLE || out == LOGGER_OUTPUT_FILE)
+    return LOGGER_OUTPUT_QUILL;
+#else
+  if (out == LOGGER_OUTPUT_QUILL)
+    return (logger_output_t)0;
+#endif
+  return out;
+}
 
-  if (!q)
-    goto fail;
+static int output_wanted(const logger_handle_t *h, logger_output_t out) {
+  switch (out) {
+  case LOGGER_OUTPUT_CONSOLE:
+    return h->console_enabled;
+  case LOGGER_OUTPUT_FILE:
+    return h->file_enabled && h->file_path && h->file_path[0] != '\0';
+  case LOGGER_OUTPUT_JSONL:
+    return h->jsonl_enabled && h->jsonl_path && h->jsonl_path[0] != '\0';
+  case LOGGER_OUTPUT_TRACY:
+    return h->tracy_enabled;
+  case LOGGER_OUTPUT_JOURNALD:
+    return h->journald_enabled && h->journald_path;
+  case LOGGER_OUTPUT_QUILL:
+#ifdef USE_QUILL
+    /* Quill is the log backend even with no sink: create() then fails */
+    return 1;
+#else
+    return 0;
+#endif
+  default:
+    return 0;
+  }
+}
 
-  logger_backend_composite_add(composite, q);
-  added = 1;
+static char *dup_str(const char *s) {
+  char *copy = (char *)malloc(strlen(s) + 1);
+  if (copy)
+    strcpy(copy, s);
+  return copy;
+}
 
-  // Tracy can go also
-  if (base_logger->tracy_enabled) {
-    logger_backend_t *t = logger_backend_tracy_create();
-    if (!t)
-      goto fail;
-    logger_backend_composite_add(composite, t);
+/*
+ * Copy of the configuration one output is built from, so a lazy output can
+ * be built later without touching the (mutable) handle configuration.
+ */
+typedef struct output_spec {
+  logger_handle_t *h; /* Tracy plots the owner's counters */
+  logger_output_t out;
+  char *path; /* file, jsonl, journald socket or Quill file path; owned */
+  logger_file_options_t file_opts;
+  int console;
+  char qname[128];
+} output_spec_t;
+
+static void spec_free(void *arg) {
+  output_spec_t *s = (output_spec_t *)arg;
+  free(s->path);
+  free(s);
+}
+
+static output_spec_t *spec_capture(logger_handle_t *h, logger_output_t out) {
+  output_spec_t *s = (output_spec_t *)calloc(1, sizeof(*s));
+  if (!s)
+    return NULL;
+  s->h = h;
+  s->out = out;
+
+  const char *path = NULL;
+  if (out == LOGGER_OUTPUT_FILE)
+    path = h->file_path;
+  else if (out == LOGGER_OUTPUT_JSONL)
+    path = h->jsonl_path;
+  else if (out == LOGGER_OUTPUT_JOURNALD)
+    path = h->journald_path;
+#ifdef USE_QUILL
+  if (out == LOGGER_OUTPUT_QUILL) {
+    /* Quill loggers are looked up by name: give each rebuild its own. */
+    snprintf(s->qname, sizeof(s->qname), "%s.%u", h->name, h->quill_gen++);
+    path = h->file_enabled ? h->file_path : NULL;
+    s->console = h->console_enabled;
+  }
+#endif
+  if (path && !(s->path = dup_str(path))) {
+    free(s);
+    return NULL;
   }
+  s->file_opts = h->file_opts;
+  if (h->prewarm)
+    s->file_opts.prealloc = h->prewarm_bytes;
+  return s;
+}
 
-  return composite;
+static logger_backend_t *spec_build(void *arg) {
+  output_spec_t *s = (output_spec_t *)arg;
+  switch (s->out) {
+  case LOGGER_OUTPUT_CONSOLE:
+    return logger_backend_console_create();
+  case LOGGER_OUTPUT_FILE:
+    return logger_backend_file_create_ex(s->path, &s->file_opts);
+  case LOGGER_OUTPUT_JSONL:
+    return logger_backend_jsonl_create(s->path);
+  case LOGGER_OUTPUT_TRACY:
+    return logger_backend_tracy_create(s->h);
+  case LOGGER_OUTPUT_JOURNALD:
+    return logger_backend_journald_create(s->path, &s->h->journald);
+#ifdef USE_QUILL
+  case LOGGER_OUTPUT_QUILL:
+    return logger_backend_quill_create(s->qname, s->path, s->console);
 #endif
+  default:
+    return NULL;
+  }
+}
 
-  /* ---- Fallback default logs: backends C ---- */
-  if (base_logger->console_enabled) {
-    logger_backend_t *c = logger_backend_console_create();
-    if (!c)
-      goto fail;
-    logger_backend_composite_add(composite, c);
-    added = 1;
+/*
+ * Builds the child backend for one output from the handle configuration,
+ * or a proxy that builds it on the first record when outputs are lazy.
+ */
+static logger_backend_t *make_output(logger_handle_t *h, logger_output_t out) {
+  output_spec_t *s = spec_capture(h, out);
+  if (!s)
+    return NULL;
+
+  logger_backend_t *b;
+  if (h->lazy_outputs) {
+    b = logger_backend_lazy_create(spec_build, s, spec_free);
+    if (!b)
+      spec_free(s);
+  } else {
+    b = spec_build(s);
+    spec_free(s);
   }
+  return b;
+}
 
-  /* file */
-  if (base_logger->file_enabled && base_logger->file_path &&
-      base_logger->file_path[0] != '\0') {
-    logger_backend_t *f = logger_backend_file_create(base_logger->file_path);
-    if (!f)
+/*
+ * Builds a user backend with the fastest delivery its capabilities allow:
+ * thread-safe ones are called directly (raw if they ask for it), the rest
+ * sit behind a queue with its own delivery thread.
+ */
+static logger_backend_t *make_user_output(const user_backend_t *u, int *raw) {
+  logger_backend_t *b = u->create(u->arg);
+  *raw = 0;
+  if (!b)
+    return NULL;
+
+  int batch = (u->caps & LOGGER_BACKEND_BATCH) && b->vtbl->log_batch;
+  if ((u->caps & LOGGER_BACKEND_THREAD_SAFE) && !batch) {
+    *raw = (u->caps & LOGGER_BACKEND_RAW_ARGS) && b->vtbl->log_raw;
+    return b;
+  }
+
+  logger_backend_t *q = logger_backend_queue_create(b, batch);
+  if (!q)
+    b->vtbl->destroy(b);
+  return q;
+}
+
+static logger_status_t put_user(logger_backend_t *composite,
+                                user_backend_t *u) {
+  int raw;
+  logger_backend_t *child = make_user_output(u, &raw);
+  if (!child)
+    return LOGGER_UNKOWN_ERROR;
+
+  logger_status_t st = logger_backend_composite_put(composite, u->tag, child);
+  if (st != LOGGER_OK) {
+    child->vtbl->destroy(child);
+    return st;
+  }
+  logger_backend_composite_set_level(composite, u->tag, u->min_level);
+  logger_backend_composite_set_raw(composite, u->tag, raw);
+  u->raw = raw;
+  return LOGGER_OK;
+}
+
+/* vlog() passes arguments down unformatted only while someone wants them. */
+static void refresh_raw_locked(logger_handle_t *h) {
+  int n = 0;
+  for (const user_backend_t *u = h->user_backends; u; u = u->next)
+    n += u->raw;
+  atomic_store(&h->raw_backends, n);
+}
+
+static logger_backend_t *make_backend(logger_handle_t *h) {
+  logger_backend_t *composite = logger_backend_composite_create();
+  if (!composite)
+    return NULL;
+
+  int added = 0;
+
+#ifdef USE_QUILL
+  // If QUILL selected will be the only log backend (console + file sinks)
+  static const logger_output_t order[] = {
+      LOGGER_OUTPUT_QUILL, LOGGER_OUTPUT_JSONL, LOGGER_OUTPUT_TRACY,
+      LOGGER_OUTPUT_JOURNALD};
+#else
+  static const logger_output_t order[] = {
+      LOGGER_OUTPUT_CONSOLE, LOGGER_OUTPUT_FILE, LOGGER_OUTPUT_JSONL,
+      LOGGER_OUTPUT_TRACY, LOGGER_OUTPUT_JOURNALD};
+#endif
+
+  for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); ++i) {
+    logger_output_t out = order[i];
+    if (!output_wanted(h, out))
+      continue;
+
+    logger_backend_t *child = make_output(h, out);
+    if (!child)
+      goto fail;
+    if (logger_backend_composite_put(composite, out, child) != LOGGER_OK) {
+      child->vtbl->destroy(child);
       goto fail;
-    logger_backend_composite_add(composite, f);
+    }
+    logger_backend_composite_set_level(composite, out, h->output_level[out]);
     added = 1;
   }
 
-  /* tracy */
-  if (base_logger->tracy_enabled) {
-    logger_backend_t *t = logger_backend_tracy_create();
-    if (!t)
+  for (user_backend_t *u = h->user_backends; u; u = u->next) {
+    if (put_user(composite, u) != LOGGER_OK)
       goto fail;
-    logger_backend_composite_add(composite, t);
     added = 1;
   }
 
@@ -125,209 +415,1080 @@ static logger_backend_t *make_backend() {
     return NULL;
   }
 
-  return composite;
+  /* the dedup stage always sits in front, so it can be toggled live */
+  logger_backend_t *front = logger_backend_dedup_create(composite);
+  if (!front)
+    goto fail;
+  logger_backend_dedup_configure(front, h->dedup_enabled, h->dedup_window_ms);
+  h->composite = composite;
+  return front;
 
 fail:
   composite->vtbl->destroy(composite);
   return NULL;
 }
 
-logger_status_t logger_init(void) {
-  logger_handle_t *h = (logger_handle_t *)calloc(1, sizeof(*h));
+/*
+ * Applies the current configuration of one output to a running pipeline:
+ * the child is built and swapped in (or removed) without stopping the
+ * composite, so other outputs and in-flight records are unaffected.
+ * Caller holds h->mutex. A stopped logger picks changes up at start.
+ */
+static logger_status_t apply_output_locked(logger_handle_t *h,
+                                           logger_output_t out) {
+  if (!h->composite)
+    return LOGGER_OK;
+
+  logger_output_t tag = child_tag(out);
+  if (!tag)
+    return LOGGER_OK;
+
+  if (!output_wanted(h, tag)) {
+    logger_status_t st = logger_backend_composite_remove(h->composite, tag);
+    return st == LOGGER_NO_EXIST ? LOGGER_OK : st;
+  }
+
+  logger_backend_t *child = make_output(h, tag);
+  if (!child)
+    return (tag == LOGGER_OUTPUT_FILE || tag == LOGGER_OUTPUT_JSONL ||
+            tag == LOGGER_OUTPUT_JOURNALD)
+               ? LOGGER_UNABLE_TO_OPEN_FILE
+               : LOGGER_UNKOWN_ERROR;
+
+  logger_status_t st = logger_backend_composite_put(h->composite, tag, child);
+  if (st != LOGGER_OK) {
+    child->vtbl->destroy(child);
+    return st;
+  }
+  return logger_backend_composite_set_level(h->composite, tag,
+                                            h->output_level[tag]);
+}
+
+static logger_handle_t *handle_alloc(const char *name) {
+  logger_handle_t *h = (logger_handle_t *)logger_arena_alloc(sizeof(*h));
   if (!h)
-    return LOGGER_OUT_OF_MEMORY;
+    return NULL;
+
+  h->name = dup_str(name);
+  if (!h->name) {
+    logger_arena_free(h, sizeof(*h));
+    return NULL;
+  }
 
   h->level = LOGGER_LEVEL_INFO;
   h->started = 0;
+  h->async = 0;
+  h->express = LOGGER_LEVEL_ERROR;
+  h->sequence = 0;
+  h->thread_info = 0;
+  h->seq = 0;
+  h->raw_backends = 0;
+  h->epoch = 0;
 
   h->console_enabled = 1; /* default console on */
 
   h->file_enabled = 0;
   h->file_path = NULL;
+  memset(&h->file_opts, 0, sizeof(h->file_opts));
+  h->file_opts.stats = &h->file_batch;
+
+  h->jsonl_enabled = 0;
+  h->jsonl_path = NULL;
 
   h->tracy_enabled = 0;
 
+  h->journald_enabled = 0;
+  h->journald_path = NULL;
+  h->journald.sent = 0;
+  h->journald.dropped = 0;
+
+  for (int i = 0; i < LOGGER_OUTPUT_COUNT; ++i)
+    h->output_level[i] = LOGGER_LEVEL_TRACE;
+
+  h->user_backends = NULL;
+  h->user_tag = LOGGER_OUTPUT_COUNT;
+
   h->backend = NULL;
+  h->composite = NULL;
+  h->dedup_enabled = 0;
+  h->dedup_window_ms = 0;
 
-  /* pthread_mutex_init(&h->mutex, NULL); */
-  base_logger = h;
+  h->lazy_outputs = 0;
+  h->prewarm = 0;
+  h->prewarm_bytes = 0;
+  h->prewarm_running = 0;
 
-  return LOGGER_OK;
+  pthread_mutex_init(&h->mutex, NULL);
+  return h;
 }
 
-logger_status_t logger_set_level(logger_level_t level) {
-  if (!base_logger)
+/* ---- Handle API ---- */
+
+logger_handle_t *logger_create(const char *name) {
+  if (!name || !name[0])
+    return NULL;
+
+  logger_handle_t *h = handle_alloc(name);
+  if (!h)
+    return NULL;
+
+  pthread_mutex_lock(&g_registry_mutex);
+  if (registry_find_locked(name)) {
+    pthread_mutex_unlock(&g_registry_mutex);
+    pthread_mutex_destroy(&h->mutex);
+    free(h->name);
+    logger_arena_free(h, sizeof(*h));
+    return NULL;
+  }
+  h->next = g_registry;
+  g_registry = h;
+  pthread_mutex_unlock(&g_registry_mutex);
+
+  return h;
+}
+
+logger_handle_t *logger_get(const char *name) {
+  if (!name)
+    return NULL;
+
+  pthread_mutex_lock(&g_registry_mutex);
+  logger_handle_t *h = registry_find_locked(name);
+  pthread_mutex_unlock(&g_registry_mutex);
+  return h;
+}
+
+logger_handle_t *logger_default(void) { return atomic_load(&base_logger); }
+
+const char *logger_name(const logger_handle_t *h) {
+  return h ? h->name : NULL;
+}
+
+logger_status_t logger_set_level_h(logger_handle_t *h, logger_level_t level) {
+  if (!h)
     return LOGGER_NO_EXIST;
 
-  /* pthread_mutex_lock(&logger->mutex); */
-  base_logger->level = level;
-  /* pthread_mutex_unlock(&logger->mutex); */
+  pthread_mutex_lock(&h->mutex);
+  h->level = level;
+  pthread_mutex_unlock(&h->mutex);
 
   return LOGGER_OK;
 }
 
-logger_status_t logger_start(logger_level_t level) {
-  if (!base_logger)
+static void *prewarm_main(void *arg) {
+  logger_backend_t *b = (logger_backend_t *)arg;
+  logger_thread_started("log-prewarm");
+  b->vtbl->prewarm(b);
+  return NULL;
+}
+
+/* Opens a read section in the caller's shard; returns its slot. */
+static inline unsigned read_enter(atomic_uint *epoch, atomic_ulong *readers) {
+  unsigned e = atomic_load(epoch) & 1u;
+  atomic_fetch_add(&readers[e], 1);
+  return e;
+}
+
+static inline void read_exit(atomic_ulong *readers, unsigned e) {
+  atomic_fetch_sub(&readers[e], 1);
+}
+
+/*
+ * Waits until every read section open on @p epoch's previous slot has
+ * closed; twice, so sections that started on either slot are covered.
+ * @p first is shard 0's readers[], @p stride the distance between shards.
+ */
+static void wait_for_readers(atomic_uint *epoch, atomic_ulong *first,
+                             size_t stride) {
+  for (int pass = 0; pass < 2; ++pass) {
+    unsigned old = atomic_fetch_add(epoch, 1) & 1u;
+    for (int s = 0; s < LOGGER_SHARDS; ++s) {
+      atomic_ulong *r = (atomic_ulong *)((char *)first + s * stride) + old;
+      while (atomic_load(r) != 0)
+        sched_yield();
+    }
+  }
+}
+
+/*
+ * Unpublishes the backend and returns it once no logging thread can still
+ * be inside it, so the caller can stop and destroy it. Caller holds mutex.
+ */
+static logger_backend_t *retire_backend_locked(logger_handle_t *h) {
+  logger_backend_t *b = atomic_exchange(&h->backend, NULL);
+  h->composite = NULL;
+  if (b)
+    wait_for_readers(&h->epoch, h->counters[0].readers,
+                     sizeof(logger_counters_t));
+  return b;
+}
+
+/* The prewarm thread uses h->backend: joined before it is torn down. */
+static void join_prewarm_locked(logger_handle_t *h) {
+  if (h->prewarm_running) {
+    pthread_join(h->prewarm_thread, NULL);
+    h->prewarm_running = 0;
+  }
+}
+
+logger_status_t logger_start_h(logger_handle_t *h, logger_level_t level) {
+  if (!h)
     return LOGGER_NO_EXIST;
 
-  /* pthread_mutex_lock(&logger->mutex); */
+  pthread_mutex_lock(&h->mutex);
 
-  base_logger->level = level;
+  h->level = level;
 
   /* rebuild backend on start */
-  if (base_logger->backend) {
-    base_logger->backend->vtbl->stop(base_logger->backend);
-    base_logger->backend->vtbl->destroy(base_logger->backend);
-    base_logger->backend = NULL;
+  join_prewarm_locked(h);
+  logger_backend_t *old = retire_backend_locked(h);
+  if (old) {
+    old->vtbl->stop(old);
+    old->vtbl->destroy(old);
   }
 
-  base_logger->backend = make_backend();
-  if (!base_logger->backend) {
-    /* pthread_mutex_unlock(&logger->mutex); */
+  /* published only once started, so no record reaches it half-built */
+  logger_backend_t *b = make_backend(h);
+  if (!b) {
+    h->composite = NULL;
+    pthread_mutex_unlock(&h->mutex);
     return LOGGER_UNKOWN_ERROR;
   }
+  refresh_raw_locked(h);
 
-  logger_status_t st = base_logger->backend->vtbl->start(base_logger->backend);
+  logger_status_t st = b->vtbl->start(b);
   if (st != LOGGER_OK) {
-    base_logger->backend->vtbl->destroy(base_logger->backend);
-    base_logger->backend = NULL;
-    /* pthread_mutex_unlock(&logger->mutex); */
+    b->vtbl->destroy(b);
+    h->composite = NULL;
+    pthread_mutex_unlock(&h->mutex);
     return st;
   }
 
-  base_logger->started = 1;
+  atomic_store(&h->backend, b);
+  h->started = 1;
+
+  if (h->prewarm && b->vtbl->prewarm)
+    h->prewarm_running = pthread_create(&h->prewarm_thread, NULL,
+                                        prewarm_main, b) == 0;
 
-  /* pthread_mutex_unlock(&logger->mutex); */
+  pthread_mutex_unlock(&h->mutex);
   return LOGGER_OK;
 }
 
-logger_status_t logger_stop(void) {
-  if (!base_logger)
+logger_status_t logger_stop_h(logger_handle_t *h) {
+  if (!h)
     return LOGGER_NO_EXIST;
 
-  /* pthread_mutex_lock(&logger->mutex); */
+  /* scope timer summaries go to the default logger: report open intervals */
+  if (h == atomic_load(&base_logger))
+    logger_timer_flush_all();
+
+  /* emit what real-time threads queued while the backend still exists */
+  logger_async_drain();
+
+  pthread_mutex_lock(&h->mutex);
 
-  base_logger->started = 0;
+  h->started = 0;
+  join_prewarm_locked(h);
 
-  if (base_logger->backend) {
-    logger_status_t st = base_logger->backend->vtbl->stop(base_logger->backend);
+  logger_backend_t *b = retire_backend_locked(h);
+  if (b) {
+    logger_status_t st = b->vtbl->stop(b);
 
     /* IMPORTANTE: destruir aquí para no dejar file/socket abierto si hacen stop
      * sin destroy */
-    base_logger->backend->vtbl->destroy(base_logger->backend);
-    base_logger->backend = NULL;
+    b->vtbl->destroy(b);
 
-    /* pthread_mutex_unlock(&logger->mutex); */
+    pthread_mutex_unlock(&h->mutex);
     return st;
   }
 
-  /* pthread_mutex_unlock(&logger->mutex); */
+  pthread_mutex_unlock(&h->mutex);
   return LOGGER_OK;
 }
 
-logger_status_t logger_destroy(void) {
-  if (!base_logger)
+logger_status_t logger_flush_h(logger_handle_t *h) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+
+  logger_async_drain();
+
+  pthread_mutex_lock(&h->mutex);
+  logger_status_t st = LOGGER_OK;
+  logger_backend_t *b = h->backend;
+  if (b && b->vtbl->flush)
+    st = b->vtbl->flush(b);
+  pthread_mutex_unlock(&h->mutex);
+
+  return st;
+}
+
+static void user_free(user_backend_t *u) {
+  if (u->free_arg)
+    u->free_arg(u->arg);
+  free(u->name);
+  free(u);
+}
+
+logger_status_t logger_destroy_h(logger_handle_t *h) {
+  if (!h)
     return LOGGER_NO_EXIST;
 
-  /* pthread_mutex_lock(&logger->mutex); */
+  if (h == atomic_load(&base_logger))
+    logger_timer_flush_all();
+
+  /* default-API callers may hold h: unpublish it and let them leave */
+  logger_handle_t *expected = h;
+  if (atomic_compare_exchange_strong(&base_logger, &expected, NULL))
+    wait_for_readers(&g_default_epoch, g_default_readers[0].readers,
+                     sizeof(default_readers_t));
+
+  logger_unwatch_config_h(h);
+  logger_flush_forget(h);
+  logger_async_drain();
+
+  pthread_mutex_lock(&g_registry_mutex);
+  registry_remove_locked(h);
+  pthread_mutex_unlock(&g_registry_mutex);
 
-  if (base_logger->backend) {
-    base_logger->backend->vtbl->stop(base_logger->backend);
-    base_logger->backend->vtbl->destroy(base_logger->backend);
-    base_logger->backend = NULL;
+  pthread_mutex_lock(&h->mutex);
+
+  h->started = 0;
+  join_prewarm_locked(h);
+
+  logger_backend_t *b = retire_backend_locked(h);
+  if (b) {
+    b->vtbl->stop(b);
+    b->vtbl->destroy(b);
   }
 
-  free(base_logger->file_path);
-  base_logger->file_path = NULL;
+  /* records queued by threads that raced with us: dropped, not leaked */
+  logger_async_drain();
 
-  /* pthread_mutex_unlock(&logger->mutex); */
-  /* pthread_mutex_destroy(&logger->mutex); */
+  free(h->file_path);
+  h->file_path = NULL;
 
-  free(base_logger);
+  free(h->jsonl_path);
+  h->jsonl_path = NULL;
+
+  free(h->journald_path);
+  h->journald_path = NULL;
+
+  while (h->user_backends) {
+    user_backend_t *u = h->user_backends;
+    h->user_backends = u->next;
+    user_free(u);
+  }
+
+  pthread_mutex_unlock(&h->mutex);
+  pthread_mutex_destroy(&h->mutex);
+
+  free(h->name);
+  logger_arena_free(h, sizeof(*h));
   return LOGGER_OK;
 }
 
 /* config */
-logger_status_t logger_enable_file_output(const char *path) {
-  if (!base_logger)
-    return LOGGER_NO_EXIST;
+static logger_status_t set_path(logger_handle_t *h, logger_output_t out,
+                                const char *path, char **slot, int *enabled) {
   if (!path || !path[0])
     return LOGGER_INVALID_PATH;
 
-  /* pthread_mutex_lock(&logger->mutex); */
+  char *copy = dup_str(path);
+  if (!copy)
+    return LOGGER_OUT_OF_MEMORY;
+
+  pthread_mutex_lock(&h->mutex);
+  char *old_path = *slot;
+  int old_enabled = *enabled;
+  *slot = copy;
+  *enabled = 1;
+
+  logger_status_t st = apply_output_locked(h, out);
+  if (st != LOGGER_OK) {
+    /* keep the previous (still running) configuration */
+    *slot = old_path;
+    *enabled = old_enabled;
+    old_path = copy;
+  }
+  pthread_mutex_unlock(&h->mutex);
+
+  free(old_path);
+  return st;
+}
+
+static logger_status_t set_flag(logger_handle_t *h, logger_output_t out,
+                                int *flag, int value) {
+  pthread_mutex_lock(&h->mutex);
+  int old = *flag;
+  *flag = value;
+  logger_status_t st = apply_output_locked(h, out);
+  if (st != LOGGER_OK)
+    *flag = old;
+  pthread_mutex_unlock(&h->mutex);
+
+  return st;
+}
+
+logger_status_t logger_enable_console_h(logger_handle_t *h) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  return set_flag(h, LOGGER_OUTPUT_CONSOLE, &h->console_enabled, 1);
+}
+
+logger_status_t logger_disable_console_h(logger_handle_t *h) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  return set_flag(h, LOGGER_OUTPUT_CONSOLE, &h->console_enabled, 0);
+}
+
+logger_status_t logger_enable_file_output_h(logger_handle_t *h,
+                                            const char *path) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  return set_path(h, LOGGER_OUTPUT_FILE, path, &h->file_path,
+                  &h->file_enabled);
+}
+
+logger_status_t logger_disable_file_output_h(logger_handle_t *h) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  return set_flag(h, LOGGER_OUTPUT_FILE, &h->file_enabled, 0);
+}
+
+logger_status_t logger_set_file_compression_h(logger_handle_t *h,
+                                              logger_compression_t codec,
+                                              int level) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  if (!logger_file_compression_supported(codec))
+    return LOGGER_UNKOWN_ERROR;
+
+  pthread_mutex_lock(&h->mutex);
+  logger_file_options_t old = h->file_opts;
+  h->file_opts.compression = codec;
+  h->file_opts.level = level;
+  logger_status_t st = apply_output_locked(h, LOGGER_OUTPUT_FILE);
+  if (st != LOGGER_OK)
+    h->file_opts = old;
+  pthread_mutex_unlock(&h->mutex);
+
+  return st;
+}
+
+logger_status_t logger_set_file_durable_h(logger_handle_t *h, int enabled,
+                                          unsigned sync_interval_ms) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+
+  pthread_mutex_lock(&h->mutex);
+  logger_file_options_t old = h->file_opts;
+  h->file_opts.durable = enabled != 0;
+  h->file_opts.sync_interval_ms = sync_interval_ms;
+  logger_status_t st = apply_output_locked(h, LOGGER_OUTPUT_FILE);
+  if (st != LOGGER_OK)
+    h->file_opts = old;
+  pthread_mutex_unlock(&h->mutex);
+
+  return st;
+}
+
+logger_status_t logger_set_file_index_h(logger_handle_t *h, int enabled) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+
+  pthread_mutex_lock(&h->mutex);
+  logger_file_options_t old = h->file_opts;
+  h->file_opts.index = enabled != 0;
+  logger_status_t st = apply_output_locked(h, LOGGER_OUTPUT_FILE);
+  if (st != LOGGER_OK)
+    h->file_opts = old;
+  pthread_mutex_unlock(&h->mutex);
+
+  return st;
+}
+
+logger_status_t logger_set_file_latency_target_h(logger_handle_t *h,
+                                                 unsigned max_latency_us) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+
+  pthread_mutex_lock(&h->mutex);
+  logger_file_options_t old = h->file_opts;
+  h->file_opts.latency_us = max_latency_us;
+  logger_status_t st = apply_output_locked(h, LOGGER_OUTPUT_FILE);
+  if (st != LOGGER_OK)
+    h->file_opts = old;
+  pthread_mutex_unlock(&h->mutex);
+
+  return st;
+}
+
+logger_status_t logger_enable_jsonl_output_h(logger_handle_t *h,
+                                             const char *path) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  return set_path(h, LOGGER_OUTPUT_JSONL, path, &h->jsonl_path,
+                  &h->jsonl_enabled);
+}
+
+logger_status_t logger_disable_jsonl_output_h(logger_handle_t *h) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  return set_flag(h, LOGGER_OUTPUT_JSONL, &h->jsonl_enabled, 0);
+}
 
-  char *copy = (char *)malloc(strlen(path) + 1);
-  if (!copy) {
-    /* pthread_mutex_unlock(&logger->mutex); */
+logger_status_t logger_enable_tracy_h(logger_handle_t *h) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  return set_flag(h, LOGGER_OUTPUT_TRACY, &h->tracy_enabled, 1);
+}
+
+logger_status_t logger_disable_tracy_h(logger_handle_t *h) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  return set_flag(h, LOGGER_OUTPUT_TRACY, &h->tracy_enabled, 0);
+}
+
+logger_status_t logger_enable_journald_h(logger_handle_t *h,
+                                         const char *socket_path) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  if (!socket_path || !socket_path[0])
+    socket_path = LOGGER_JOURNALD_SOCKET;
+  return set_path(h, LOGGER_OUTPUT_JOURNALD, socket_path, &h->journald_path,
+                  &h->journald_enabled);
+}
+
+logger_status_t logger_disable_journald_h(logger_handle_t *h) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  return set_flag(h, LOGGER_OUTPUT_JOURNALD, &h->journald_enabled, 0);
+}
+
+logger_status_t logger_register_backend_h(logger_handle_t *h,
+                                          const logger_backend_desc_t *desc) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  if (!desc || !desc->create)
+    return LOGGER_UNKOWN_ERROR;
+  if (!desc->name || !desc->name[0])
+    return LOGGER_INVALID_PATH;
+
+  user_backend_t *u = (user_backend_t *)calloc(1, sizeof(*u));
+  if (!u)
+    return LOGGER_OUT_OF_MEMORY;
+  u->name = dup_str(desc->name);
+  if (!u->name) {
+    free(u);
     return LOGGER_OUT_OF_MEMORY;
   }
+  u->caps = desc->caps;
+  u->min_level = desc->min_level;
+  u->create = desc->create;
+  u->arg = desc->arg;
+
+  pthread_mutex_lock(&h->mutex);
+  user_backend_t **tail = &h->user_backends;
+  for (; *tail; tail = &(*tail)->next) {
+    if (strcmp((*tail)->name, u->name) == 0) {
+      pthread_mutex_unlock(&h->mutex);
+      user_free(u); /* free_arg not set yet: the caller keeps arg */
+      return LOGGER_UNKOWN_ERROR;
+    }
+  }
+  u->tag = h->user_tag++;
+
+  logger_status_t st = LOGGER_OK;
+  if (h->composite)
+    st = put_user(h->composite, u);
+  if (st == LOGGER_OK) {
+    u->free_arg = desc->free_arg;
+    *tail = u;
+    refresh_raw_locked(h);
+  }
+  pthread_mutex_unlock(&h->mutex);
 
-  strcpy(copy, path);
-  free(base_logger->file_path);
+  if (st != LOGGER_OK)
+    user_free(u);
+  return st;
+}
 
-  base_logger->file_path = copy;
-  base_logger->file_enabled = 1;
+logger_status_t logger_unregister_backend_h(logger_handle_t *h,
+                                            const char *name) {
+  if (!h || !name)
+    return LOGGER_NO_EXIST;
 
-  /* pthread_mutex_unlock(&logger->mutex); */
+  pthread_mutex_lock(&h->mutex);
+  user_backend_t *u = NULL;
+  for (user_backend_t **pp = &h->user_backends; *pp; pp = &(*pp)->next) {
+    if (strcmp((*pp)->name, name) == 0) {
+      u = *pp;
+      *pp = u->next;
+      break;
+    }
+  }
+  if (u) {
+    refresh_raw_locked(h);
+    if (h->composite)
+      logger_backend_composite_remove(h->composite, u->tag);
+  }
+  pthread_mutex_unlock(&h->mutex);
+
+  if (!u)
+    return LOGGER_NO_EXIST;
+  user_free(u);
   return LOGGER_OK;
 }
 
-logger_status_t logger_disable_file_output() {
-  if (!base_logger)
+logger_status_t logger_set_output_level_h(logger_handle_t *h,
+                                          logger_output_t out,
+                                          logger_level_t level) {
+  if (!h)
     return LOGGER_NO_EXIST;
+  if (out <= 0 || out >= LOGGER_OUTPUT_COUNT)
+    return LOGGER_UNKOWN_ERROR;
 
-  /* pthread_mutex_lock(&logger->mutex); */
-  base_logger->file_enabled = 0;
-  /* pthread_mutex_unlock(&logger->mutex); */
+  pthread_mutex_lock(&h->mutex);
+  h->output_level[out] = level;
+  logger_output_t tag = child_tag(out);
+  if (tag && tag != out)
+    h->output_level[tag] = level;
+  /* the output may simply not be enabled yet */
+  if (h->composite && tag)
+    logger_backend_composite_set_level(h->composite, tag, level);
+  pthread_mutex_unlock(&h->mutex);
 
   return LOGGER_OK;
 }
 
-logger_status_t logger_enable_tracy() {
-  if (!base_logger)
+logger_status_t logger_set_lazy_outputs_h(logger_handle_t *h, int enabled) {
+  if (!h)
     return LOGGER_NO_EXIST;
 
-  /* pthread_mutex_lock(&logger->mutex); */
-  base_logger->tracy_enabled = 1;
-  /* pthread_mutex_unlock(&logger->mutex); */
+  pthread_mutex_lock(&h->mutex);
+  h->lazy_outputs = enabled != 0;
+  pthread_mutex_unlock(&h->mutex);
 
   return LOGGER_OK;
 }
 
-logger_status_t logger_disable_tracy() {
-  if (!base_logger)
+logger_status_t logger_set_prewarm_h(logger_handle_t *h, int enabled,
+                                     size_t file_prealloc) {
+  if (!h)
     return LOGGER_NO_EXIST;
 
-  /* pthread_mutex_lock(&logger->mutex); */
-  base_logger->tracy_enabled = 0;
-  /* pthread_mutex_unlock(&logger->mutex); */
+  pthread_mutex_lock(&h->mutex);
+  h->prewarm = enabled != 0;
+  h->prewarm_bytes = file_prealloc;
+  pthread_mutex_unlock(&h->mutex);
 
   return LOGGER_OK;
 }
 
-void logger_log(logger_level_t level, const char *file, int line,
-                const char *fmt, ...) {
-  if (!base_logger)
+logger_status_t logger_set_dedup_h(logger_handle_t *h, int enabled,
+                                   unsigned window_ms) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+
+  pthread_mutex_lock(&h->mutex);
+  h->dedup_enabled = enabled != 0;
+  h->dedup_window_ms = window_ms;
+  if (h->backend)
+    logger_backend_dedup_configure(h->backend, enabled, window_ms);
+  pthread_mutex_unlock(&h->mutex);
+
+  return LOGGER_OK;
+}
+
+/* Record this thread is handing to a backend. */
+_Thread_local logger_record_meta_t logger_tls_record;
+
+const logger_record_meta_t *logger_backend_current_record(void) {
+  return &logger_tls_record;
+}
+
+static inline unsigned long long next_seq(logger_handle_t *h) {
+  if (!atomic_load_explicit(&h->sequence, memory_order_relaxed))
+    return 0;
+  return atomic_fetch_add_explicit(&h->seq, 1, memory_order_relaxed) + 1;
+}
+
+static void vlog(logger_handle_t *h, logger_level_t level, const char *file,
+                 int line, const char *fmt, va_list args, int rt) {
+  if (!h)
     return;
-  if (!base_logger->started)
+
+  logger_counters_t *cnt = &h->counters[logger_shard_index()];
+
+  if (level < atomic_load_explicit(&h->level, memory_order_relaxed)) {
+    atomic_fetch_add_explicit(&cnt->filtered, 1, memory_order_relaxed);
     return;
-  if (!base_logger->backend)
+  }
+
+  /* the backend stays alive until read_exit() */
+  unsigned e = read_enter(&h->epoch, cnt->readers);
+  logger_backend_t *backend = atomic_load(&h->backend);
+  if (!atomic_load_explicit(&h->started, memory_order_relaxed) || !backend) {
+    atomic_fetch_add_explicit(&cnt->dropped, 1, memory_order_relaxed);
+    goto done;
+  }
+
+  unsigned long long seq = next_seq(h);
+  int thread = atomic_load_explicit(&h->thread_info, memory_order_relaxed);
+  logger_ctx_t *ctx = logger_ctx_current(thread && !logger_tls_rt);
+
+  /* real-time: queue or drop, never block; the consumer counts it */
+  if (rt || logger_tls_rt) {
+    if (!logger_async_rt_push(h, level, file, line, seq, ctx, fmt, args))
+      atomic_fetch_add_explicit(&cnt->dropped, 1, memory_order_relaxed);
+    goto done;
+  }
+
+  /* express lane: severe records skip the queue and are written below */
+  if (atomic_load_explicit(&h->async, memory_order_relaxed) &&
+      (int)level < atomic_load_explicit(&h->express, memory_order_relaxed)) {
+    int queued = logger_async_push(h, level, file, line, seq, ctx, fmt, args);
+    if (queued == 0)
+      atomic_fetch_add_explicit(&cnt->dropped, 1, memory_order_relaxed);
+    if (queued >= 0)
+      goto done;
+    /* exiting thread, queue released: emit what it queued, then this */
+    logger_async_drain();
+  }
+
+#ifdef TRACY_ENABLE
+  /* make the logger's own cost visible in the profiler */
+  TracyCZoneN(log_zone, "logger_log", 1);
+#endif
+
+  /* interned (and, with LOGGER_STRIP_PATH, stripped) name */
+  file = logger_srcloc_canonical(file);
+
+  logger_tls_record.seq = seq;
+  logger_tls_record.ts_ns = 0;
+  logger_tls_record.ctx = ctx;
+  logger_tls_record.thread = thread;
+  if (atomic_load_explicit(&h->raw_backends, memory_order_relaxed) &&
+      backend->vtbl->log_raw) {
+    /* formatted further down, only for the outputs that want text */
+    backend->vtbl->log_raw(backend, level, file, line, fmt, args);
+  } else {
+    char msg[2048];
+    logger_vformat(msg, sizeof(msg), fmt, args);
+    backend->vtbl->log(backend, level, file, line, msg);
+  }
+  logger_tls_record.ctx = NULL; /* may be popped once we return */
+  atomic_fetch_add_explicit(&cnt->logged, 1, memory_order_relaxed);
+
+#ifdef TRACY_ENABLE
+  TracyCZoneEnd(log_zone);
+#endif
+
+done:
+  read_exit(cnt->readers, e);
+}
+
+void logger_vlog_h(logger_handle_t *h, logger_level_t level, const char *file,
+                   int line, const char *fmt, va_list args) {
+  vlog(h, level, file, line, fmt, args, 0);
+}
+
+void logger_emit_h(logger_handle_t *h, logger_level_t level, const char *file,
+                   int line, const char *msg, unsigned long long seq,
+                   unsigned long long ts_ns, const logger_ctx_t *ctx) {
+  if (!h)
     return;
-  if (level < base_logger->level)
+
+  logger_counters_t *cnt = &h->counters[logger_shard_index()];
+
+  if (level < atomic_load_explicit(&h->level, memory_order_relaxed)) {
+    atomic_fetch_add_explicit(&cnt->filtered, 1, memory_order_relaxed);
     return;
+  }
+
+  unsigned e = read_enter(&h->epoch, cnt->readers);
+  logger_backend_t *backend = atomic_load(&h->backend);
+  if (!atomic_load_explicit(&h->started, memory_order_relaxed) || !backend) {
+    atomic_fetch_add_explicit(&cnt->dropped, 1, memory_order_relaxed);
+  } else {
+    logger_tls_record.seq = seq;
+    logger_tls_record.ts_ns = ts_ns;
+    logger_tls_record.ctx = ctx;
+    logger_tls_record.thread =
+        atomic_load_explicit(&h->thread_info, memory_order_relaxed);
+    backend->vtbl->log(backend, level, logger_srcloc_canonical(file), line,
+                       msg);
+    logger_tls_record.ctx = NULL;
+    atomic_fetch_add_explicit(&cnt->logged, 1, memory_order_relaxed);
+  }
+  read_exit(cnt->readers, e);
+}
+
+logger_status_t logger_set_async_h(logger_handle_t *h, int enabled) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+
+  atomic_store(&h->async, enabled ? 1 : 0);
+  /* keep order with what follows on the synchronous path */
+  if (!enabled)
+    logger_async_drain();
+  return LOGGER_OK;
+}
+
+logger_status_t logger_set_express_lane_h(logger_handle_t *h, int enabled,
+                                          logger_level_t min_level) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+
+  atomic_store(&h->express,
+               enabled ? (int)min_level : (int)LOGGER_LEVEL_FATAL + 1);
+  return LOGGER_OK;
+}
+
+logger_status_t logger_set_thread_info_h(logger_handle_t *h, int enabled) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+
+  atomic_store(&h->thread_info, enabled ? 1 : 0);
+  return LOGGER_OK;
+}
+
+logger_status_t logger_set_sequence_h(logger_handle_t *h, int enabled) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+
+  atomic_store(&h->sequence, enabled ? 1 : 0);
+  return LOGGER_OK;
+}
+
+void logger_log_rt_h(logger_handle_t *h, logger_level_t level,
+                     const char *file, int line, const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  vlog(h, level, file, line, fmt, args, 1);
+  va_end(args);
+}
+
+logger_status_t logger_get_stats_h(logger_handle_t *h, logger_stats_t *out) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  if (!out)
+    return LOGGER_UNKOWN_ERROR;
 
-  char msg[2048];
+  logger_stats_t st = {0, 0, 0};
+  for (int i = 0; i < LOGGER_SHARDS; ++i) {
+    const logger_counters_t *c = &h->counters[i];
+    st.logged += atomic_load_explicit(&c->logged, memory_order_relaxed);
+    st.filtered += atomic_load_explicit(&c->filtered, memory_order_relaxed);
+    st.dropped += atomic_load_explicit(&c->dropped, memory_order_relaxed);
+  }
+  *out = st;
+  return LOGGER_OK;
+}
+
+logger_status_t logger_get_journald_stats_h(logger_handle_t *h,
+                                            logger_journald_stats_t *out) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  if (!out)
+    return LOGGER_UNKOWN_ERROR;
+
+  out->sent = atomic_load_explicit(&h->journald.sent, memory_order_relaxed);
+  out->dropped =
+      atomic_load_explicit(&h->journald.dropped, memory_order_relaxed);
+  return LOGGER_OK;
+}
+
+logger_status_t logger_get_batch_stats_h(logger_handle_t *h,
+                                         logger_batch_stats_t *out) {
+  if (!h)
+    return LOGGER_NO_EXIST;
+  if (!out)
+    return LOGGER_UNKOWN_ERROR;
+
+  pthread_mutex_lock(&h->mutex);
+  unsigned target = h->file_opts.latency_us;
+  pthread_mutex_unlock(&h->mutex);
+  logger_file_batch_stats(&h->file_batch, target, out);
+  return LOGGER_OK;
+}
+
+void logger_log_h(logger_handle_t *h, logger_level_t level, const char *file,
+                  int line, const char *fmt, ...) {
   va_list args;
   va_start(args, fmt);
-  vsnprintf(msg, sizeof(msg), fmt, args);
+  logger_vlog_h(h, level, file, line, fmt, args);
   va_end(args);
+}
+
+/* ---- Default-handle API ---- */
 
-  /* pthread_mutex_lock(&logger->mutex); */
-  if (base_logger->backend) {
-    base_logger->backend->vtbl->log(base_logger->backend, level, file, line,
-                                    msg);
+logger_status_t logger_init(void) {
+  logger_handle_t *h = handle_alloc("default");
+  if (!h)
+    return LOGGER_OUT_OF_MEMORY;
+
+  pthread_mutex_lock(&g_registry_mutex);
+  if (registry_find_locked("default")) {
+    pthread_mutex_unlock(&g_registry_mutex);
+    pthread_mutex_destroy(&h->mutex);
+    free(h->name);
+    logger_arena_free(h, sizeof(*h));
+    return LOGGER_ALREADY_INITIALIZED;
   }
-  /* pthread_mutex_unlock(&logger->mutex); */
+  h->next = g_registry;
+  g_registry = h;
+  base_logger = h;
+  pthread_mutex_unlock(&g_registry_mutex);
+
+  return LOGGER_OK;
+}
+
+logger_status_t logger_set_level(logger_level_t level) {
+  return logger_set_level_h(base_logger, level);
+}
+
+logger_status_t logger_start(logger_level_t level) {
+  return logger_start_h(base_logger, level);
+}
+
+logger_status_t logger_stop(void) { return logger_stop_h(base_logger); }
+
+logger_status_t logger_flush(void) { return logger_flush_h(base_logger); }
+
+logger_status_t logger_destroy(void) { return logger_destroy_h(base_logger); }
+
+logger_status_t logger_enable_console() {
+  return logger_enable_console_h(base_logger);
+}
+
+logger_status_t logger_disable_console() {
+  return logger_disable_console_h(base_logger);
+}
+
+logger_status_t logger_enable_file_output(const char *path) {
+  return logger_enable_file_output_h(base_logger, path);
+}
+
+logger_status_t logger_disable_file_output() {
+  return logger_disable_file_output_h(base_logger);
+}
+
+logger_status_t logger_set_file_compression(logger_compression_t codec,
+                                            int level) {
+  return logger_set_file_compression_h(base_logger, codec, level);
+}
+
+logger_status_t logger_set_file_durable(int enabled,
+                                        unsigned sync_interval_ms) {
+  return logger_set_file_durable_h(base_logger, enabled, sync_interval_ms);
+}
+
+logger_status_t logger_set_file_index(int enabled) {
+  return logger_set_file_index_h(base_logger, enabled);
+}
+
+logger_status_t logger_set_file_latency_target(unsigned max_latency_us) {
+  return logger_set_file_latency_target_h(base_logger, max_latency_us);
+}
+
+logger_status_t logger_enable_jsonl_output(const char *path) {
+  return logger_enable_jsonl_output_h(base_logger, path);
+}
+
+logger_status_t logger_disable_jsonl_output() {
+  return logger_disable_jsonl_output_h(base_logger);
+}
+
+logger_status_t logger_enable_tracy() {
+  return logger_enable_tracy_h(base_logger);
+}
+
+logger_status_t logger_disable_tracy() {
+  return logger_disable_tracy_h(base_logger);
+}
+
+logger_status_t logger_enable_journald(const char *socket_path) {
+  return logger_enable_journald_h(base_logger, socket_path);
+}
+
+logger_status_t logger_disable_journald(void) {
+  return logger_disable_journald_h(base_logger);
+}
+
+logger_status_t logger_register_backend(const logger_backend_desc_t *desc) {
+  return logger_register_backend_h(base_logger, desc);
+}
+
+logger_status_t logger_unregister_backend(const char *name) {
+  return logger_unregister_backend_h(base_logger, name);
+}
+
+logger_status_t logger_set_output_level(logger_output_t out,
+                                        logger_level_t level) {
+  return logger_set_output_level_h(base_logger, out, level);
+}
+
+logger_status_t logger_get_stats(logger_stats_t *out) {
+  return logger_get_stats_h(base_logger, out);
+}
+
+logger_status_t logger_get_journald_stats(logger_journald_stats_t *out) {
+  return logger_get_journald_stats_h(base_logger, out);
+}
+
+logger_status_t logger_get_batch_stats(logger_batch_stats_t *out) {
+  return logger_get_batch_stats_h(base_logger, out);
+}
+
+void logger_log(logger_level_t level, const char *file, int line,
+                const char *fmt, ...) {
+  atomic_ulong *readers = g_default_readers[logger_shard_index()].readers;
+  unsigned e = read_enter(&g_default_epoch, readers);
+  va_list args;
+  va_start(args, fmt);
+  vlog(atomic_load(&base_logger), level, file, line, fmt, args, 0);
+  va_end(args);
+  read_exit(readers, e);
+}
+
+logger_status_t logger_set_lazy_outputs(int enabled) {
+  return logger_set_lazy_outputs_h(base_logger, enabled);
+}
+
+logger_status_t logger_set_prewarm(int enabled, size_t file_prealloc) {
+  return logger_set_prewarm_h(base_logger, enabled, file_prealloc);
+}
+
+logger_status_t logger_set_dedup(int enabled, unsigned window_ms) {
+  return logger_set_dedup_h(base_logger, enabled, window_ms);
+}
+
+logger_status_t logger_set_async(int enabled) {
+  return logger_set_async_h(base_logger, enabled);
+}
+
+logger_status_t logger_set_express_lane(int enabled, logger_level_t min_level) {
+  return logger_set_express_lane_h(base_logger, enabled, min_level);
+}
+
+logger_status_t logger_set_thread_info(int enabled) {
+  return logger_set_thread_info_h(base_logger, enabled);
+}
+
+logger_status_t logger_set_sequence(int enabled) {
+  return logger_set_sequence_h(base_logger, enabled);
+}
+
+void logger_log_rt(logger_level_t level, const char *file, int line,
+                   const char *fmt, ...) {
+  atomic_ulong *readers = g_default_readers[logger_shard_index()].readers;
+  unsigned e = read_enter(&g_default_epoch, readers);
+  va_list args;
+  va_start(args, fmt);
+  vlog(atomic_load(&base_logger), level, file, line, fmt, args, 1);
+  va_end(args);
+  read_exit(readers, e);
 }
 
 const char *logger_status_to_string(logger_status_t status) {
@@ -335,4 +1496,4 @@ const char *logger_status_to_string(logger_status_t status) {
     return logger_status_str[status];
 
   return "LOGGER_STATUS_INVALID";
-}
\ No newline at end of file
+}
@@ -12,13 +12,50 @@
  *
  * Notes:
  * - The logger drops messages if it is not started.
+ * - Output configuration (console/file/JSON Lines/Tracy, per-output levels)
+ *   may be changed while the logger is started: only the affected output is
+ *   rebuilt, without pausing producers or dropping in-flight records.
  * - Filtering rule: a message is emitted if (message_level >=
  * configured_level).
+ * - The functions above operate on the default logger created by
+ *   logger_init(). Subsystems that need their own level and backends can
+ *   create independent named loggers with logger_create() and use the
+ *   *_h() variants / LOGH_* macros.
  */
 
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <stdarg.h>
+#include <stddef.h>
+
+/**
+ * @brief printf-style format checking for the logging entry points.
+ *
+ * Lets GCC/Clang check the format string against its arguments at every
+ * call site (-Wformat). Expands to nothing on other compilers.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define LOGGER_PRINTF_FMT(fmt_idx, first_arg)                                 \
+  __attribute__((format(printf, fmt_idx, first_arg)))
+#else
+#define LOGGER_PRINTF_FMT(fmt_idx, first_arg)
+#endif
+
+/**
+ * @brief File name captured by the LOG_* macros.
+ *
+ * With LOGGER_STRIP_PATH defined, call sites record only the basename
+ * (__FILE_NAME__ on GCC >= 12 / Clang), which keeps build paths out of the
+ * binary and the output. On other compilers the full __FILE__ is passed and
+ * a library built with LOGGER_STRIP_PATH strips it once, when interned.
+ */
+#if defined(LOGGER_STRIP_PATH) && defined(__FILE_NAME__)
+#define LOGGER_FILE __FILE_NAME__
+#else
+#define LOGGER_FILE __FILE__
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -42,7 +79,8 @@ typedef enum logger_status {
   LOGGER_OUT_OF_MEMORY,        /**< Memory allocation failed. */
   LOGGER_UNABLE_TO_OPEN_FILE,  /**< fopen() failed for the provided path. */
   LOGGER_UNKOWN_ERROR, /**< Unknown/unclassified error (avoid if possible). */
-  LOGGER_STATUS_COUNT  /**< status counter */
+  LOGGER_ALREADY_INITIALIZED, /**< Default logger exists (logger_init()). */
+  LOGGER_STATUS_COUNT         /**< status counter */
 } logger_status_t;
 
 /**
@@ -66,11 +104,113 @@ typedef enum logger_level {
   LOGGER_LEVEL_FATAL      /**< Fatal errors. */
 } logger_level_t;
 
+/**
+ * @brief Logger counters, summed over all threads.
+ *
+ * Counters are kept per thread shard, so updating them from many threads
+ * does not contend; reading them is a (cheap, unsynchronized) sum and may
+ * be slightly behind concurrent logging.
+ */
+typedef struct logger_stats {
+  unsigned long long logged;   /**< Records forwarded to the backends. */
+  unsigned long long filtered; /**< Records below the configured level. */
+  unsigned long long dropped;  /**< Records discarded: logger not started. */
+} logger_stats_t;
+
+/**
+ * @brief Delivery counters of the journald output.
+ */
+typedef struct logger_journald_stats {
+  unsigned long long sent;    /**< Records the journal socket accepted. */
+  unsigned long long dropped; /**< Records lost instead of blocking. */
+} logger_journald_stats_t;
+
+/**
+ * @brief Write batching of the file output (block mode).
+ *
+ * Latencies run from the first record of a block until its write (durable
+ * mode: its fdatasync()) returned, so they bound every record's latency.
+ */
+typedef struct logger_batch_stats {
+  unsigned long long batches; /**< Writes issued. */
+  unsigned long long records; /**< Records written. */
+  unsigned long long bytes;   /**< Uncompressed bytes written. */
+  unsigned long long queued;  /**< Records waiting to be written. */
+  unsigned batch_records;     /**< Recent records per write. */
+  unsigned batch_bytes;       /**< Recent bytes per write. */
+  unsigned latency_p50_us;    /**< Median block latency. */
+  unsigned latency_p99_us;    /**< 99th percentile block latency. */
+  unsigned latency_max_us;    /**< Worst block latency. */
+  unsigned target_us;         /**< Configured target, 0 if none. */
+} logger_batch_stats_t;
+
+/**
+ * @brief Output (backend) kinds of a logger pipeline.
+ *
+ * Used to address a single output for live reconfiguration, e.g. per-output
+ * levels. In Quill builds, console and file output are Quill sinks and share
+ * the LOGGER_OUTPUT_QUILL child.
+ */
+typedef enum logger_output {
+  LOGGER_OUTPUT_CONSOLE = 1, /**< stdout/stderr */
+  LOGGER_OUTPUT_FILE,        /**< plain text file */
+  LOGGER_OUTPUT_JSONL,       /**< JSON Lines file */
+  LOGGER_OUTPUT_TRACY,       /**< Tracy profiler */
+  LOGGER_OUTPUT_QUILL,       /**< Quill (USE_QUILL builds only) */
+  LOGGER_OUTPUT_JOURNALD,    /**< systemd-journald socket */
+  LOGGER_OUTPUT_COUNT        /**< output counter */
+} logger_output_t;
+
+/**
+ * @brief Compression codecs of the file output.
+ */
+typedef enum logger_compression {
+  LOGGER_COMPRESSION_NONE = 0, /**< plain text (default) */
+  LOGGER_COMPRESSION_LZ4,      /**< LZ4 frames (LOGGER_USE_LZ4 builds) */
+  LOGGER_COMPRESSION_ZSTD      /**< zstd frames (LOGGER_USE_ZSTD builds) */
+} logger_compression_t;
+
+/**
+ * @brief Scheduling policy of the logger's background threads.
+ */
+typedef enum logger_sched {
+  LOGGER_SCHED_INHERIT = 0, /**< leave as created (default) */
+  LOGGER_SCHED_OTHER,       /**< SCHED_OTHER; priority = nice value */
+  LOGGER_SCHED_BATCH,       /**< SCHED_BATCH; priority = nice value */
+  LOGGER_SCHED_IDLE,        /**< SCHED_IDLE */
+  LOGGER_SCHED_FIFO,        /**< SCHED_FIFO; priority 1..99 */
+  LOGGER_SCHED_RR           /**< SCHED_RR; priority 1..99 */
+} logger_sched_t;
+
+/**
+ * @brief What polling background threads do when idle.
+ */
+typedef enum logger_wait {
+  LOGGER_WAIT_SLEEP = 0, /**< sleep between polls (default) */
+  LOGGER_WAIT_YIELD,     /**< poll, yielding the CPU between polls */
+  LOGGER_WAIT_SPIN       /**< poll without yielding: one busy core */
+} logger_wait_t;
+
+/**
+ * @brief Placement and idle behaviour of the logger's background threads.
+ */
+typedef struct logger_thread_options {
+  const char *cpus;     /**< CPU list ("4-7", "0,2"); NULL/"" = inherit. */
+  logger_sched_t sched; /**< Policy; INHERIT ignores @c priority. */
+  int priority;         /**< Real-time priority or nice value. */
+  logger_wait_t wait;   /**< Idle strategy of polling threads. */
+  unsigned idle_us;     /**< SLEEP poll period; 0 = thread default. */
+} logger_thread_options_t;
+
 /**
  * @brief Opaque logger handle.
  *
  * The internal structure is private to the library.
- * Consumers must create/destroy it via the provided API.
+ * Consumers must create/destroy it via the provided API:
+ * - the default handle via logger_init()/logger_destroy()
+ * - named handles via logger_create()/logger_destroy_h()
+ *
+ * Each handle owns its level, configuration and backend pipeline.
  */
 typedef struct logger_handle logger_handle_t;
 
@@ -82,10 +222,15 @@ typedef struct logger_handle logger_handle_t;
  * - level: LOGGER_LEVEL_INFO
  * - started: false
  * - file output: disabled
+ * - JSON Lines output: disabled
  * - tracy: disabled
  *
+ * The default logger exists until logger_destroy(); calling logger_init()
+ * again before that leaves it as it is.
+ *
  * @return LOGGER_OK on success, LOGGER_OUT_OF_MEMORY if unable to allocate
- * memory.
+ * memory, LOGGER_ALREADY_INITIALIZED if the default logger (a handle named
+ * "default") already exists.
  */
 logger_status_t logger_init(void);
 
@@ -113,22 +258,81 @@ logger_status_t logger_start(logger_level_t level);
  *
  * Behavior:
  * - Disables emission of new log messages (started = false).
- * - Flushes outputs (stdout/stderr and file if enabled).
+ * - Waits for logging calls already inside the outputs to return, then
+ *   flushes and closes them (stdout/stderr and file if enabled). Records
+ *   logged concurrently are either written or counted as dropped.
  *
  * @return LOGGER_OK on success, LOGGER_NO_EXIST if logger is NULL.
  */
 logger_status_t logger_stop(void);
 
+/**
+ * @brief Persist everything logged so far, without stopping.
+ *
+ * Emits records still queued by async/real-time threads, then flushes each
+ * output: console streams are flushed, files are flushed and
+ * fdatasync()ed (durable file mode waits for its group commit), Quill
+ * waits for its backend thread. Blocks the calling thread.
+ *
+ * @return LOGGER_OK, LOGGER_NO_EXIST if logger is NULL, or the first error
+ *         reported by an output.
+ */
+logger_status_t logger_flush(void);
+
+/**
+ * @brief Completion callback of logger_flush_async().
+ *
+ * @param status Result of the flush (see logger_flush()), or
+ *               LOGGER_NO_EXIST if the logger was destroyed first.
+ * @param user   Pointer given to logger_flush_async().
+ */
+typedef void (*logger_flush_cb)(logger_status_t status, void *user);
+
+/**
+ * @brief logger_flush() without blocking the caller.
+ *
+ * The flush runs on a background flusher thread, which then calls @p cb.
+ * The flush covers every record logged before this call. Concurrent
+ * requests share one flush per logger.
+ *
+ * @p cb runs on the flusher thread and must not call logger_destroy() of
+ * the same logger; it may log and request further flushes.
+ *
+ * @return LOGGER_OK if queued (cb will be called exactly once),
+ *         LOGGER_NO_EXIST if logger is NULL, LOGGER_UNKOWN_ERROR if @p cb
+ *         is NULL or the flusher thread cannot start, LOGGER_OUT_OF_MEMORY.
+ */
+logger_status_t logger_flush_async(logger_flush_cb cb, void *user);
+
 /**
  * @brief Destroy a logger instance and release all associated resources.
  *
  * This closes the log file (if enabled), releases allocated memory, and frees
- * the logger handle itself.
+ * the logger handle itself. The default logger is reset to NULL first, and
+ * logging calls already running on it are waited for, so logger_log() from
+ * other threads (during or after this call) is dropped instead of touching
+ * freed memory. logger_init() creates a new default logger.
  *
  * @return LOGGER_OK on success, LOGGER_NO_EXIST if logger is NULL.
  */
 logger_status_t logger_destroy(void);
 
+// --- Logger API console config --- //
+
+/**
+ * @brief Enable console output (enabled by default).
+ *
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if logger is NULL.
+ */
+logger_status_t logger_enable_console();
+
+/**
+ * @brief Disable console output.
+ *
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if logger is NULL.
+ */
+logger_status_t logger_disable_console();
+
 // --- Logger API file config --- //
 
 /**
@@ -137,7 +341,9 @@ logger_status_t logger_destroy(void);
  * Notes:
  * - The library copies the provided path internally (caller can free/modify
  * theirs).
- * - If file output is already enabled, returns LOGGER_FILE_IS_ALREADY_OPEN.
+ * - If the logger is started, the file is opened immediately and swapped in
+ *   for the current one (live path switch); otherwise it is opened on
+ *   logger_start().
  * - On success, subsequent logs are also written to the file.
  *
  * @param path   Path to log file (must be non-NULL and non-empty).
@@ -146,7 +352,8 @@ logger_status_t logger_destroy(void);
  *         - LOGGER_FILE_IS_ALREADY_OPEN
  *         - LOGGER_INVALID_PATH
  *         - LOGGER_OUT_OF_MEMORY
- *         - LOGGER_UNABLE_TO_OPEN_FILE
+ *         - LOGGER_UNABLE_TO_OPEN_FILE (started logger only; the previous
+ *           configuration stays active)
  */
 logger_status_t logger_enable_file_output(const char *path);
 
@@ -159,6 +366,138 @@ logger_status_t logger_enable_file_output(const char *path);
  */
 logger_status_t logger_disable_file_output();
 
+/**
+ * @brief Compresses the file output in blocks.
+ *
+ * Lines are collected into 64 KiB blocks that a background thread
+ * compresses and appends as independent frames, so the file stays readable
+ * (`lz4 -dc` / `zstd -dc`) up to the last complete block after a crash.
+ * Partial blocks are written after one second and on logger_stop(). If the
+ * file output is live it is reopened with the new codec.
+ *
+ * Quill builds ignore this setting (file output is a Quill sink).
+ *
+ * @param codec LOGGER_COMPRESSION_NONE turns compression off.
+ * @param level Codec level, 0 for the codec default.
+ * @return LOGGER_OK, LOGGER_NO_EXIST if logger is NULL,
+ *         LOGGER_UNKOWN_ERROR if @p codec is not compiled in, or
+ *         LOGGER_UNABLE_TO_OPEN_FILE if reopening a live file fails (the
+ *         previous codec stays active).
+ */
+logger_status_t logger_set_file_compression(logger_compression_t codec,
+                                            int level);
+
+/**
+ * @brief Makes the file output power-loss safe.
+ *
+ * The file is written as checksummed blocks (length + CRC-32C) and
+ * fdatasync() is issued once per interval for everything written in it
+ * (group commit), and immediately on ERROR/FATAL records; FATAL waits for
+ * the commit. On open, a torn or corrupt tail left by a power cut is
+ * truncated at the last valid block. Combines with
+ * logger_set_file_compression(). The file is no longer plain text; see
+ * docs/backends.md for the block layout.
+ *
+ * Quill builds ignore this setting (file output is a Quill sink).
+ *
+ * @param enabled          Non-zero to enable, 0 to disable.
+ * @param sync_interval_ms Group-commit interval, 0 for 100 ms.
+ * @return LOGGER_OK, LOGGER_NO_EXIST if logger is NULL, or
+ *         LOGGER_UNABLE_TO_OPEN_FILE if reopening a live file fails (e.g.
+ *         the existing file is not a durable log); the previous mode stays
+ *         active.
+ */
+logger_status_t logger_set_file_durable(int enabled,
+                                        unsigned sync_interval_ms);
+
+/**
+ * @brief Indexes the file output for tools/logq.
+ *
+ * The file is written in blocks (plain text unless compressed) and every
+ * block gets an entry in "<path>.idx": its offset and size, the wall-clock
+ * time of its first and last record and a bitmap of the levels it holds.
+ * logq reads both files via mmap and only decodes blocks that can match a
+ * query, e.g. ERRORs from motor.c between two times. Lines are written
+ * like without indexing; time ranges resolve to whole blocks, and records
+ * are up to one second late on disk unless flushed (logger_flush()).
+ * Combines with logger_set_file_compression() and
+ * logger_set_file_durable().
+ *
+ * Quill builds ignore this setting (file output is a Quill sink).
+ *
+ * @param enabled Non-zero to enable, 0 to disable.
+ * @return LOGGER_OK, LOGGER_NO_EXIST if logger is NULL, or
+ *         LOGGER_UNABLE_TO_OPEN_FILE if reopening a live file fails; the
+ *         previous mode stays active.
+ */
+logger_status_t logger_set_file_index(int enabled);
+
+/**
+ * @brief Adapts file writes to a maximum latency.
+ *
+ * The file output collects lines into blocks that its writer thread writes once
+ * the oldest line has waited @p max_latency_us minus the recent cost of a write
+ * and a wake-up margin (an eighth of the target), or as soon as the block is
+ * full. The arrival rate and write cost are measured continuously: at high
+ * rates writes grow up to the block size (64 KiB), at low rates a lone record
+ * is written at once instead of waiting for company that will not come. In
+ * durable mode the target covers the fdatasync() too, and every block is
+ * committed. Without a target the file output keeps its fixed intervals (plain
+ * mode: one write per line).
+ *
+ * Achieved latencies and batch sizes: logger_get_batch_stats().
+ * Quill builds ignore this setting (file output is a Quill sink).
+ *
+ * @param max_latency_us Target, e.g. 2000 for 2 ms; 0 to disable.
+ * @return LOGGER_OK, LOGGER_NO_EXIST if logger is NULL, or
+ *         LOGGER_UNABLE_TO_OPEN_FILE if reopening a live file fails; the
+ *         previous mode stays active.
+ */
+logger_status_t logger_set_file_latency_target(unsigned max_latency_us);
+
+/**
+ * @brief Read the default logger's file write batching statistics.
+ *
+ * Counters and the latency histogram accumulate over the logger's
+ * lifetime; batch sizes are moving averages of recent writes.
+ *
+ * @param out Destination (must be non-NULL).
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if logger is NULL,
+ *         LOGGER_UNKOWN_ERROR if @p out is NULL.
+ */
+logger_status_t logger_get_batch_stats(logger_batch_stats_t *out);
+
+// --- Logger API JSON Lines config --- //
+
+/**
+ * @brief Enable JSON Lines output to the given path.
+ *
+ * Each record is appended as one JSON object per line:
+ * {"level":"INFO","file":"main.c","line":12,"msg":"..."}
+ *
+ * Notes:
+ * - The library copies the provided path internally.
+ * - Takes effect immediately if the logger is started, otherwise on
+ *   logger_start().
+ *
+ * @param path   Path to the JSON Lines file (must be non-NULL and non-empty).
+ * @return LOGGER_OK on success, or an error status on failure:
+ *         - LOGGER_NO_EXIST
+ *         - LOGGER_INVALID_PATH
+ *         - LOGGER_OUT_OF_MEMORY
+ *         - LOGGER_UNABLE_TO_OPEN_FILE (started logger only)
+ */
+logger_status_t logger_enable_jsonl_output(const char *path);
+
+/**
+ * @brief Disable JSON Lines output.
+ *
+ * Safe to call even if JSON Lines output is not enabled.
+ *
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if logger is NULL.
+ */
+logger_status_t logger_disable_jsonl_output();
+
 // --- Logger tracy config --- //
 /**
  * @brief Enable Tracy integration.
@@ -175,6 +514,89 @@ logger_status_t logger_enable_tracy();
  */
 logger_status_t logger_disable_tracy();
 
+// --- Logger journald config --- //
+/**
+ * @brief Send records to systemd-journald.
+ *
+ * Uses the journal's native datagram protocol with structured fields:
+ * PRIORITY (TRACE/DEBUG 7, INFO 6, WARN 4, ERROR 3, FATAL 2),
+ * SYSLOG_IDENTIFIER (program name), CODE_FILE, CODE_LINE, MESSAGE and,
+ * with logger_set_sequence(), LOGGER_SEQ. Records are batched and sent
+ * with one sendmmsg() per batch from a background thread, at the latest
+ * 20 ms later (ERROR+ at once). The output never blocks the logging
+ * thread: when the journal falls behind, records are dropped and counted
+ * (logger_get_journald_stats()).
+ *
+ * @param socket_path Journal socket, NULL for /run/systemd/journal/socket.
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if logger is NULL,
+ *         LOGGER_OUT_OF_MEMORY, or LOGGER_UNABLE_TO_OPEN_FILE (started
+ *         logger only) if @p socket_path is not a socket.
+ */
+logger_status_t logger_enable_journald(const char *socket_path);
+
+/**
+ * @brief Stop sending records to journald.
+ *
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if logger is NULL.
+ */
+logger_status_t logger_disable_journald(void);
+
+// --- Logger per-output config --- //
+/**
+ * @brief Set the minimum level forwarded to one output.
+ *
+ * Applied after the logger-wide level set by logger_start()/
+ * logger_set_level(), e.g. INFO overall but only ERROR+ to the console.
+ * Takes effect immediately, including on a started logger.
+ *
+ * @param out    Output to configure.
+ * @param level  Minimum severity forwarded to @p out.
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if logger is NULL,
+ *         LOGGER_UNKOWN_ERROR if @p out is out of range.
+ */
+logger_status_t logger_set_output_level(logger_output_t out,
+                                        logger_level_t level);
+
+// --- Logger config file --- //
+/**
+ * @brief Apply a configuration file once.
+ *
+ * The file holds `key = value` lines (`#` starts a comment):
+ * - `level = trace|debug|info|warn|error|fatal`
+ * - `console = on|off`, `tracy = on|off`
+ * - `file = <path>|off`, `jsonl = <path>|off`
+ * - `level.<console|file|jsonl|tracy|quill> = <level>`
+ *
+ * Keys that are absent keep their current value. Unknown keys are ignored.
+ *
+ * @param path Configuration file path.
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if logger is NULL,
+ *         LOGGER_INVALID_PATH if @p path is NULL/empty,
+ *         LOGGER_UNABLE_TO_OPEN_FILE if it cannot be read, or the first
+ *         error returned while applying a setting.
+ */
+logger_status_t logger_load_config(const char *path);
+
+/**
+ * @brief Apply a configuration file and re-apply it whenever it changes.
+ *
+ * Uses inotify on the containing directory (so editors that replace the
+ * file are handled) from a background thread. Changes are applied live,
+ * like the corresponding API calls. Linux only.
+ *
+ * @param path Configuration file path (see logger_load_config()).
+ * @return LOGGER_OK on success, or an error status; LOGGER_UNKOWN_ERROR if
+ *         watching is unsupported or a watch is already active.
+ */
+logger_status_t logger_watch_config(const char *path);
+
+/**
+ * @brief Stop watching the configuration file. Safe if none is watched.
+ *
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if logger is NULL.
+ */
+logger_status_t logger_unwatch_config();
+
 // --- Logger --- //
 /**
  * @brief Core logging function (printf-style).
@@ -195,7 +617,465 @@ logger_status_t logger_disable_tracy();
  * @param ...    Format arguments.
  */
 void logger_log(logger_level_t level, const char *file, int line,
-                const char *fmt, ...);
+                const char *fmt, ...) LOGGER_PRINTF_FMT(4, 5);
+
+// --- Logger handle API --- //
+/**
+ * @brief Create an independent named logger.
+ *
+ * The new logger has the same defaults as logger_init() (level INFO,
+ * console on, file/JSON Lines/Tracy off, not started) and its own backend
+ * pipeline. Configure it with the *_h() functions and start it with
+ * logger_start_h().
+ *
+ * @param name Unique, non-empty name. Copied internally.
+ * @return The new handle, or NULL if @p name is invalid, already in use, or
+ *         allocation fails.
+ */
+logger_handle_t *logger_create(const char *name);
+
+/**
+ * @brief Look up a live logger by name.
+ *
+ * The default logger created by logger_init() is registered as "default".
+ *
+ * @param name Logger name.
+ * @return The handle, or NULL if no logger with that name exists.
+ */
+logger_handle_t *logger_get(const char *name);
+
+/**
+ * @brief Return the default logger created by logger_init().
+ *
+ * @return The default handle, or NULL if logger_init() was not called.
+ */
+logger_handle_t *logger_default(void);
+
+/**
+ * @brief Return the name of a logger.
+ *
+ * @param h Logger handle.
+ * @return The name (owned by the handle), or NULL if @p h is NULL.
+ */
+const char *logger_name(const logger_handle_t *h);
+
+/** @brief logger_set_level() for a specific handle. */
+logger_status_t logger_set_level_h(logger_handle_t *h, logger_level_t level);
+
+/** @brief logger_start() for a specific handle. */
+logger_status_t logger_start_h(logger_handle_t *h, logger_level_t level);
+
+/** @brief logger_stop() for a specific handle. */
+logger_status_t logger_stop_h(logger_handle_t *h);
+
+/** @brief logger_flush() for a specific handle. */
+logger_status_t logger_flush_h(logger_handle_t *h);
+
+/** @brief logger_flush_async() for a specific handle. */
+logger_status_t logger_flush_async_h(logger_handle_t *h, logger_flush_cb cb,
+                                     void *user);
+
+/**
+ * @brief Destroy a logger handle and release all associated resources.
+ *
+ * Stops the handle if needed and removes it from the name registry.
+ * The handle must not be used afterwards: unlike the default logger,
+ * callers still holding a named handle are not tracked.
+ *
+ * @param h Logger handle.
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if @p h is NULL.
+ */
+logger_status_t logger_destroy_h(logger_handle_t *h);
+
+/** @brief logger_enable_console() for a specific handle. */
+logger_status_t logger_enable_console_h(logger_handle_t *h);
+
+/** @brief logger_disable_console() for a specific handle. */
+logger_status_t logger_disable_console_h(logger_handle_t *h);
+
+/** @brief logger_enable_file_output() for a specific handle. */
+logger_status_t logger_enable_file_output_h(logger_handle_t *h,
+                                            const char *path);
+
+/** @brief logger_disable_file_output() for a specific handle. */
+logger_status_t logger_disable_file_output_h(logger_handle_t *h);
+
+/** @brief logger_set_file_compression() for a specific handle. */
+logger_status_t logger_set_file_compression_h(logger_handle_t *h,
+                                              logger_compression_t codec,
+                                              int level);
+
+/** @brief logger_set_file_index() for a specific handle. */
+logger_status_t logger_set_file_index_h(logger_handle_t *h, int enabled);
+
+/** @brief logger_set_file_latency_target() for a specific handle. */
+logger_status_t logger_set_file_latency_target_h(logger_handle_t *h,
+                                                 unsigned max_latency_us);
+
+/** @brief logger_get_batch_stats() for a specific handle. */
+logger_status_t logger_get_batch_stats_h(logger_handle_t *h,
+                                         logger_batch_stats_t *out);
+
+/** @brief logger_set_file_durable() for a specific handle. */
+logger_status_t logger_set_file_durable_h(logger_handle_t *h, int enabled,
+                                          unsigned sync_interval_ms);
+
+/** @brief logger_enable_jsonl_output() for a specific handle. */
+logger_status_t logger_enable_jsonl_output_h(logger_handle_t *h,
+                                             const char *path);
+
+/** @brief logger_disable_jsonl_output() for a specific handle. */
+logger_status_t logger_disable_jsonl_output_h(logger_handle_t *h);
+
+/** @brief logger_enable_journald() for a specific handle. */
+logger_status_t logger_enable_journald_h(logger_handle_t *h,
+                                         const char *socket_path);
+
+/** @brief logger_disable_journald() for a specific handle. */
+logger_status_t logger_disable_journald_h(logger_handle_t *h);
+
+/** @brief logger_enable_tracy() for a specific handle. */
+logger_status_t logger_enable_tracy_h(logger_handle_t *h);
+
+/** @brief logger_disable_tracy() for a specific handle. */
+logger_status_t logger_disable_tracy_h(logger_handle_t *h);
+
+/** @brief logger_set_output_level() for a specific handle. */
+logger_status_t logger_set_output_level_h(logger_handle_t *h,
+                                          logger_output_t out,
+                                          logger_level_t level);
+
+/** @brief logger_load_config() for a specific handle. */
+logger_status_t logger_load_config_h(logger_handle_t *h, const char *path);
+
+/** @brief logger_watch_config() for a specific handle. */
+logger_status_t logger_watch_config_h(logger_handle_t *h, const char *path);
+
+/** @brief logger_unwatch_config() for a specific handle. */
+logger_status_t logger_unwatch_config_h(logger_handle_t *h);
+
+/**
+ * @brief logger_log() for a specific handle.
+ *
+ * Filtering uses the level and started state of @p h only.
+ */
+void logger_log_h(logger_handle_t *h, logger_level_t level, const char *file,
+                  int line, const char *fmt, ...) LOGGER_PRINTF_FMT(5, 6);
+
+/**
+ * @brief va_list variant of logger_log_h(), for wrapping the logger.
+ */
+void logger_vlog_h(logger_handle_t *h, logger_level_t level, const char *file,
+                   int line, const char *fmt, va_list args)
+    LOGGER_PRINTF_FMT(5, 0);
+
+// --- Logger real-time mode --- //
+/**
+ * @brief Enables or disables real-time mode for the calling thread.
+ *
+ * In real-time mode every log call of this thread (LOG_*, logger_log*,
+ * LOG_RT_*) is bounded and wait-free: the message is formatted into a
+ * preallocated per-thread slot and handed to a drain thread, or dropped and
+ * counted in logger_stats_t::dropped when the thread's queue is full. It
+ * never takes a lock, allocates or makes a syscall, so a full stdout pipe
+ * or a slow disk cannot stall the caller.
+ *
+ * Call it from the thread itself, outside its time-critical section:
+ * enabling allocates the queue and may start the drain thread. The queue
+ * is released when the thread exits or calls this with @p enabled = 0.
+ * Queued records are emitted by the drain thread, and at the latest by
+ * logger_stop()/logger_destroy() of their logger.
+ *
+ * @param enabled Non-zero to enable, 0 to disable.
+ * @return LOGGER_OK, LOGGER_OUT_OF_MEMORY, or LOGGER_UNKOWN_ERROR if the
+ *         drain thread could not be started.
+ */
+logger_status_t logger_set_thread_rt(int enabled);
+
+/**
+ * @brief logger_log() that always takes the real-time path.
+ *
+ * On a thread without real-time mode the record is dropped (and counted),
+ * never emitted synchronously.
+ */
+void logger_log_rt(logger_level_t level, const char *file, int line,
+                   const char *fmt, ...) LOGGER_PRINTF_FMT(4, 5);
+
+/** @brief logger_log_rt() for a specific handle. */
+void logger_log_rt_h(logger_handle_t *h, logger_level_t level,
+                     const char *file, int line, const char *fmt, ...)
+    LOGGER_PRINTF_FMT(5, 6);
+
+// --- Logger startup --- //
+/**
+ * @brief Builds outputs on their first record instead of in logger_start().
+ *
+ * With lazy outputs, logger_start() only wires up proxies: files are opened
+ * and Quill's backend thread is started when the first record reaches that
+ * output (or earlier, by the prewarm thread). An output that then fails
+ * to open drops its records; eager outputs (the default) report the
+ * failure from logger_start() / logger_enable_*() instead.
+ *
+ * Applies to outputs built after the call (next logger_start() or output
+ * change).
+ *
+ * @param enabled Non-zero to enable, 0 to disable (default).
+ * @return LOGGER_OK, or LOGGER_NO_EXIST if logger is NULL.
+ */
+logger_status_t logger_set_lazy_outputs(int enabled);
+
+/**
+ * @brief Prepares outputs on a background thread after logger_start().
+ *
+ * The thread builds lazy outputs, faults in the file backend's block
+ * buffers and, on Linux, reserves @p file_prealloc bytes past the end of
+ * the log file (fallocate() with FALLOC_FL_KEEP_SIZE: the file size is
+ * unchanged). logger_start() does not wait for it; logger_stop() does.
+ *
+ * @param enabled      Non-zero to enable, 0 to disable (default).
+ * @param file_prealloc Bytes to reserve for the file output, 0 for none.
+ * @return LOGGER_OK, or LOGGER_NO_EXIST if logger is NULL.
+ */
+logger_status_t logger_set_prewarm(int enabled, size_t file_prealloc);
+
+/** @brief logger_set_lazy_outputs() for a specific handle. */
+logger_status_t logger_set_lazy_outputs_h(logger_handle_t *h, int enabled);
+
+/** @brief logger_set_prewarm() for a specific handle. */
+logger_status_t logger_set_prewarm_h(logger_handle_t *h, int enabled,
+                                     size_t file_prealloc);
+
+// --- Logger dedup --- //
+/**
+ * @brief Collapses consecutive repeated records of the default logger.
+ *
+ * A record identical to the previous one (same level, source location,
+ * formatted message and context fields) is counted instead of written.
+ * The run is reported as "last message repeated N times", at the repeated
+ * record's level, location and context, when a different record arrives,
+ * when logger_stop() is called, when dedup is disabled, and, with a
+ * window, @p window_ms after the run's first repeat (from a background
+ * thread, so a run that ends quietly is reported too). A repeat costs one
+ * hash of the message and a short critical section; memory use is
+ * constant.
+ *
+ * "Consecutive" is per logger, across all threads. Per-output levels apply
+ * to the summary line like to any other record.
+ *
+ * @param enabled   Non-zero to enable, 0 to disable (default).
+ * @param window_ms Summary interval for long runs, 0 = only on change.
+ * @return LOGGER_OK, or LOGGER_NO_EXIST if logger is NULL.
+ */
+logger_status_t logger_set_dedup(int enabled, unsigned window_ms);
+
+/** @brief logger_set_dedup() for a specific handle. */
+logger_status_t logger_set_dedup_h(logger_handle_t *h, int enabled,
+                                   unsigned window_ms);
+
+// --- Logger async mode --- //
+/**
+ * @brief Moves backend I/O of the default logger off the calling threads.
+ *
+ * With async mode on, logger_log() formats the message into a pooled record,
+ * stamps it with CLOCK_MONOTONIC and pushes it onto the calling thread's own
+ * SPSC queue, then returns. A single consumer thread merges all per-thread
+ * queues by timestamp and writes the records to the backends, so producers
+ * never share a queue cache line. Output is globally ordered by capture
+ * time within the merge window (logger_set_async_window()).
+ *
+ * A full queue (LOGGER_ASYNC_SLOTS records) makes the producer yield until
+ * the consumer catches up; nothing is dropped. Threads in real-time mode
+ * keep their own drop-on-full rings.
+ *
+ * Disabling, logger_stop() and logger_destroy() emit everything queued.
+ *
+ * @param enabled Non-zero to enable, 0 to disable.
+ * @return LOGGER_OK, or LOGGER_NO_EXIST if logger is NULL.
+ */
+logger_status_t logger_set_async(int enabled);
+
+/** @brief logger_set_async() for a specific handle. */
+logger_status_t logger_set_async_h(logger_handle_t *h, int enabled);
+
+/**
+ * @brief Sets the consumer's merge window (default 200 us, all loggers).
+ *
+ * A record is held back at most this long waiting for older records from
+ * other threads. 0 emits as soon as possible, trading global order for
+ * latency.
+ *
+ * @return LOGGER_OK.
+ */
+logger_status_t logger_set_async_window(unsigned window_us);
+
+/**
+ * @brief Places and schedules every logger background thread.
+ *
+ * Applies to the threads the library runs for all loggers: the async and
+ * real-time consumer, file writers (which also compress), journald
+ * senders, queue adapters of user backends, the asynchronous flusher, the
+ * config watcher, prewarm threads and, in Quill builds, Quill's backend
+ * thread. Running threads are updated at once and new ones on start, so
+ * logging work can be kept off latency-critical cores. Threads are named
+ * "log-<role>" (e.g. log-file) for ps/top.
+ *
+ * @c wait only changes threads that poll: the async consumer and Quill's
+ * backend (fixed when Quill starts, on the first Quill output). The others
+ * sleep until producers signal them and only take affinity and policy.
+ * Setting @c sched back to INHERIT leaves threads as they are. Linux only;
+ * elsewhere only @c wait is supported.
+ *
+ * @code
+ * logger_thread_options_t o = {.cpus = "0-3", .sched = LOGGER_SCHED_BATCH,
+ *                              .priority = 5};
+ * logger_set_thread_options(&o); // efficiency cores, lower priority
+ * @endcode
+ *
+ * @param opt Options (copied).
+ * @return LOGGER_OK, or LOGGER_UNKOWN_ERROR if @p opt is NULL or invalid,
+ *         or a running thread refused the settings (e.g. a real-time
+ *         policy without CAP_SYS_NICE; valid options are kept).
+ */
+logger_status_t logger_set_thread_options(const logger_thread_options_t *opt);
+
+/**
+ * @brief Reads the options last set with logger_set_thread_options().
+ *
+ * @param out Destination; @c out->cpus stays valid until the next set.
+ * @return LOGGER_OK, or LOGGER_UNKOWN_ERROR if @p out is NULL.
+ */
+logger_status_t logger_get_thread_options(logger_thread_options_t *out);
+
+/**
+ * @brief Routes severe records of the default logger around the async queue.
+ *
+ * In async mode, records at or above @p min_level are formatted and written
+ * by the calling thread, like with async mode off, so they reach the
+ * backends (and, with durable files, the disk) before logger_log() returns
+ * instead of waiting behind a backlog of bulk records. Lower levels keep
+ * using the queue. On by default for LOGGER_LEVEL_ERROR and above.
+ *
+ * An express record can overtake records the same thread queued earlier;
+ * turn on logger_set_sequence() to recover capture order. Real-time
+ * threads always use their rings.
+ *
+ * @param enabled   Non-zero to enable, 0 to queue every level.
+ * @param min_level Lowest level written inline.
+ * @return LOGGER_OK, or LOGGER_NO_EXIST if logger is NULL.
+ */
+logger_status_t logger_set_express_lane(int enabled, logger_level_t min_level);
+
+/** @brief logger_set_express_lane() for a specific handle. */
+logger_status_t logger_set_express_lane_h(logger_handle_t *h, int enabled,
+                                          logger_level_t min_level);
+
+/**
+ * @brief Stamps every record of the default logger with a sequence number.
+ *
+ * Numbers start at 1 and follow capture order across all threads and lanes
+ * (sync, express, async, real-time). The file output prefixes lines with
+ * "#<seq> " and the JSONL output adds a "seq" field, so readers can sort
+ * records back into the order they were logged in. Costs one shared atomic
+ * increment per record. Off by default.
+ *
+ * @param enabled Non-zero to enable, 0 to disable.
+ * @return LOGGER_OK, or LOGGER_NO_EXIST if logger is NULL.
+ */
+logger_status_t logger_set_sequence(int enabled);
+
+/** @brief logger_set_sequence() for a specific handle. */
+logger_status_t logger_set_sequence_h(logger_handle_t *h, int enabled);
+
+// --- Thread context --- //
+/**
+ * @brief Adds a key/value field to the calling thread's context.
+ *
+ * Every record the thread logs afterwards, on any logger, carries the
+ * fields pushed so far until they are popped. A field is rendered once
+ * here, not per record; records reference the context, and queued records
+ * keep it alive after the pop. The text outputs add "key=value ..." after
+ * the location, the JSONL output a "ctx" object and journald one field
+ * per key (upper-cased). At most 16 fields per thread; keys longer than 63
+ * and values longer than 255 bytes are truncated.
+ *
+ * @code
+ * logger_ctx_pushf("job", "%d", job->id);
+ * LOG_INFO("started");          // [INFO] jobs.c:42 | job=17 | started
+ * logger_ctx_pop();
+ * @endcode
+ *
+ * @param key   Field name (non-empty).
+ * @param value Field value (NULL = "").
+ * @return LOGGER_OK, LOGGER_OUT_OF_MEMORY, or LOGGER_UNKOWN_ERROR if
+ *         @p key is NULL/empty or the thread already has 16 fields.
+ */
+logger_status_t logger_ctx_push(const char *key, const char *value);
+
+/** @brief logger_ctx_push() with a printf-style value. */
+logger_status_t logger_ctx_pushf(const char *key, const char *fmt, ...)
+    LOGGER_PRINTF_FMT(2, 3);
+
+/**
+ * @brief Removes the field pushed last by the calling thread.
+ *
+ * @return LOGGER_OK, or LOGGER_UNKOWN_ERROR if there is none.
+ */
+logger_status_t logger_ctx_pop(void);
+
+/**
+ * @brief Sets the name shown for the calling thread.
+ *
+ * The name is cached per thread: by default it is the OS thread name
+ * (pthread_getname_np()), read once. Longer than 31 bytes is truncated.
+ *
+ * @param name New name, or NULL to read the OS name again.
+ * @return LOGGER_OK or LOGGER_OUT_OF_MEMORY.
+ */
+logger_status_t logger_set_thread_name(const char *name);
+
+/**
+ * @brief Shows the logging thread's id and name on the default logger.
+ *
+ * The text outputs add "tid=<id> thread=<name>" before the context fields,
+ * JSONL "tid"/"thread" and journald TID/THREAD_NAME. Both are looked up
+ * once per thread. Off by default.
+ *
+ * @param enabled Non-zero to enable, 0 to disable.
+ * @return LOGGER_OK, or LOGGER_NO_EXIST if logger is NULL.
+ */
+logger_status_t logger_set_thread_info(int enabled);
+
+/** @brief logger_set_thread_info() for a specific handle. */
+logger_status_t logger_set_thread_info_h(logger_handle_t *h, int enabled);
+
+// --- Logger stats --- //
+/**
+ * @brief Read the default logger's counters.
+ *
+ * @param out Destination (must be non-NULL).
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if logger is NULL,
+ *         LOGGER_UNKOWN_ERROR if @p out is NULL.
+ */
+logger_status_t logger_get_stats(logger_stats_t *out);
+
+/** @brief logger_get_stats() for a specific handle. */
+logger_status_t logger_get_stats_h(logger_handle_t *h, logger_stats_t *out);
+
+/**
+ * @brief Read the default logger's journald delivery counters.
+ *
+ * Counters accumulate over the logger's lifetime, across enabling,
+ * disabling and reconfiguring the output.
+ *
+ * @param out Destination (must be non-NULL).
+ * @return LOGGER_OK on success, LOGGER_NO_EXIST if logger is NULL,
+ *         LOGGER_UNKOWN_ERROR if @p out is NULL.
+ */
+logger_status_t logger_get_journald_stats(logger_journald_stats_t *out);
+
+/** @brief logger_get_journald_stats() for a specific handle. */
+logger_status_t logger_get_journald_stats_h(logger_handle_t *h,
+                                            logger_journald_stats_t *out);
 
 // --- Logger utils functions --- //
 /**
@@ -225,29 +1105,69 @@ const char *logger_status_to_string(logger_status_t status);
  * @name Convenience macros
  * @{
  *
- * These macros automatically fill file/line using __FILE__/__LINE__.
+ * These macros automatically fill file/line using LOGGER_FILE/__LINE__.
  *
  * Note:
  * - Consider wrapping in do { ... } while (0) for safer macro behavior
  *   inside if/else blocks.
+ * - C++ code can include logger.hpp instead, which redefines these macros
+ *   to validate the format string at compile time.
  */
 #define LOG_TRACE(fmt, ...)                                                    \
-  logger_log(LOGGER_LEVEL_TRACE, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+  logger_log(LOGGER_LEVEL_TRACE, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
 
 #define LOG_DEBUG(fmt, ...)                                                    \
-  logger_log(LOGGER_LEVEL_DEBUG, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+  logger_log(LOGGER_LEVEL_DEBUG, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
 
 #define LOG_INFO(fmt, ...)                                                     \
-  logger_log(LOGGER_LEVEL_INFO, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+  logger_log(LOGGER_LEVEL_INFO, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
 
 #define LOG_WARN(fmt, ...)                                                     \
-  logger_log(LOGGER_LEVEL_WARN, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+  logger_log(LOGGER_LEVEL_WARN, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
 
 #define LOG_ERROR(fmt, ...)                                                    \
-  logger_log(LOGGER_LEVEL_ERROR, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+  logger_log(LOGGER_LEVEL_ERROR, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
 
 #define LOG_FATAL(fmt, ...)                                                    \
-  logger_log(LOGGER_LEVEL_FATAL, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+  logger_log(LOGGER_LEVEL_FATAL, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
+
+/* Same as above, for a named logger handle. */
+#define LOGH_TRACE(h, fmt, ...)                                                \
+  logger_log_h(h, LOGGER_LEVEL_TRACE, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
+
+#define LOGH_DEBUG(h, fmt, ...)                                                \
+  logger_log_h(h, LOGGER_LEVEL_DEBUG, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
+
+#define LOGH_INFO(h, fmt, ...)                                                 \
+  logger_log_h(h, LOGGER_LEVEL_INFO, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
+
+#define LOGH_WARN(h, fmt, ...)                                                 \
+  logger_log_h(h, LOGGER_LEVEL_WARN, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
+
+#define LOGH_ERROR(h, fmt, ...)                                                \
+  logger_log_h(h, LOGGER_LEVEL_ERROR, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
+
+#define LOGH_FATAL(h, fmt, ...)                                                \
+  logger_log_h(h, LOGGER_LEVEL_FATAL, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
+
+/* Real-time variants: queue or drop, never block (see logger_set_thread_rt). */
+#define LOG_RT_TRACE(fmt, ...)                                                 \
+  logger_log_rt(LOGGER_LEVEL_TRACE, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
+
+#define LOG_RT_DEBUG(fmt, ...)                                                 \
+  logger_log_rt(LOGGER_LEVEL_DEBUG, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
+
+#define LOG_RT_INFO(fmt, ...)                                                  \
+  logger_log_rt(LOGGER_LEVEL_INFO, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
+
+#define LOG_RT_WARN(fmt, ...)                                                  \
+  logger_log_rt(LOGGER_LEVEL_WARN, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
+
+#define LOG_RT_ERROR(fmt, ...)                                                 \
+  logger_log_rt(LOGGER_LEVEL_ERROR, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
+
+#define LOG_RT_FATAL(fmt, ...)                                                 \
+  logger_log_rt(LOGGER_LEVEL_FATAL, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__)
 /** @} */
 
 #ifdef __cplusplus
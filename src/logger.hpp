@@ -0,0 +1,513 @@
+/**
+ * @file logger.hpp
+ * @brief C++17 front end: compile-time format validation for LOG_* macros.
+ *
+ * Including this header instead of logger.h redefines LOG_* / LOGH_* so
+ * that every call site checks, at compile time, the format string against
+ * the static types of its arguments:
+ * - argument count (too few / too many),
+ * - integer vs floating vs string vs pointer conversions,
+ * - integer width vs length modifier (e.g. %d with a long long),
+ * - unsupported conversions (%n, positional %1$d, wide strings).
+ *
+ * A mismatch is a hard error pointing at the offending call, with the reason
+ * shown in the "call to non-constexpr function format_error(...)" note.
+ *
+ * The same parser produces a logger::format_layout, the per-argument
+ * storage classes of a call, so a deferred or binary capture path can copy
+ * arguments without walking the format string at run time:
+ *
+ * @code
+ * constexpr logger::format_layout l = LOGGER_FMT_LAYOUT("%s=%d", name, v);
+ * static_assert(l.count == 2 && l.kinds[1] == logger::arg_kind::int_value);
+ * @endcode
+ *
+ * The format argument of the macros must be a string literal (or another
+ * constant expression). Call logger_log() directly for run-time formats.
+ *
+ * With C++20 coroutines, `co_await logger::flush()` waits for
+ * logger_flush_async() without parking the calling thread:
+ *
+ * @code
+ * task handle(request r) {
+ *   LOG_ERROR("payment %d failed", r.id);
+ *   logger_status_t st = co_await logger::flush();
+ *   co_return reply(r, st);
+ * }
+ * @endcode
+ */
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include "logger.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define LOGGER_HAS_COROUTINES 1
+#endif
+#endif
+
+namespace logger {
+
+/** Storage class of one format argument after default promotions. */
+enum class arg_kind : unsigned char {
+  int_value,         /**< int (also char, short, '*' width/precision) */
+  long_value,        /**< long */
+  long_long_value,   /**< long long, intmax_t */
+  size_value,        /**< size_t, ptrdiff_t */
+  double_value,      /**< double (float promotes) */
+  long_double_value, /**< long double */
+  string,            /**< const char * */
+  pointer            /**< any other pointer */
+};
+
+/** Maximum number of arguments a checked call may take. */
+inline constexpr std::size_t max_format_args = 32;
+
+/** Argument layout of a format string, computed at compile time. */
+struct format_layout {
+  std::size_t count = 0; /**< Arguments consumed, including '*'. */
+  arg_kind kinds[max_format_args] = {};
+  bool fast = true; /**< Fully handled by the in-tree formatter (format.h). */
+};
+
+namespace detail {
+
+/* Not constexpr: reaching it during constant evaluation is the diagnostic. */
+inline void format_error(const char *) {}
+
+enum class type_class : unsigned char {
+  integral,
+  floating,
+  long_double,
+  string,
+  pointer,
+  other
+};
+
+struct type_desc {
+  type_class cls;
+  std::size_t size;
+};
+
+template <class T> constexpr type_desc describe() {
+  using U = std::remove_cv_t<T>;
+  if constexpr (std::is_same_v<U, long double>) {
+    return {type_class::long_double, sizeof(U)};
+  } else if constexpr (std::is_floating_point_v<U>) {
+    return {type_class::floating, sizeof(U)};
+  } else if constexpr (std::is_integral_v<U>) {
+    return {type_class::integral, sizeof(U)};
+  } else if constexpr (std::is_enum_v<U>) {
+    return {type_class::integral, sizeof(std::underlying_type_t<U>)};
+  } else if constexpr (std::is_null_pointer_v<U>) {
+    return {type_class::pointer, sizeof(void *)};
+  } else if constexpr (std::is_pointer_v<U>) {
+    using P = std::remove_cv_t<std::remove_pointer_t<U>>;
+    if constexpr (std::is_same_v<P, char> || std::is_same_v<P, signed char> ||
+                  std::is_same_v<P, unsigned char>)
+      return {type_class::string, sizeof(U)};
+    else
+      return {type_class::pointer, sizeof(U)};
+  } else {
+    return {type_class::other, sizeof(U)};
+  }
+}
+
+enum class length { none, hh, h, l, ll, z, j, t, L };
+
+/* Mirrors the fast subset accepted by logger_vformat() in format.c. */
+constexpr int FAST_MAX_PREC = 40;
+
+struct parser {
+  const char *f;
+  const type_desc *types; /* nargs entries plus one sentinel */
+  std::size_t nargs;
+  format_layout out{};
+
+  constexpr const type_desc &next(arg_kind kind) {
+    if (out.count >= nargs) {
+      format_error("logger: too few arguments for format string");
+      return types[nargs];
+    }
+    if (out.count >= max_format_args) {
+      format_error("logger: too many format arguments (max 32)");
+      return types[nargs];
+    }
+    out.kinds[out.count] = kind;
+    return types[out.count++];
+  }
+
+  constexpr void star() {
+    const type_desc &t = next(arg_kind::int_value);
+    if (t.cls != type_class::integral || t.size > sizeof(int))
+      format_error("logger: '*' width/precision needs an int argument");
+  }
+
+  constexpr void integer(length len) {
+    arg_kind kind = arg_kind::int_value;
+    std::size_t want = sizeof(int);
+    switch (len) {
+    case length::l:
+      kind = arg_kind::long_value;
+      want = sizeof(long);
+      break;
+    case length::ll:
+    case length::j:
+      kind = arg_kind::long_long_value;
+      want = sizeof(long long);
+      break;
+    case length::z:
+    case length::t:
+      kind = arg_kind::size_value;
+      want = sizeof(std::size_t);
+      break;
+    case length::L:
+      format_error("logger: 'L' is not valid on integer conversions");
+      break;
+    default:
+      break;
+    }
+
+    const type_desc &t = next(kind);
+    if (t.cls != type_class::integral) {
+      format_error("logger: integer conversion needs an integer argument");
+    } else if (kind == arg_kind::int_value) {
+      if (t.size > sizeof(int))
+        format_error("logger: argument wider than int; use l, ll or z");
+    } else if (t.size != want) {
+      format_error("logger: argument size does not match length modifier");
+    }
+  }
+
+  constexpr void floating(length len) {
+    if (len == length::L) {
+      if (next(arg_kind::long_double_value).cls != type_class::long_double)
+        format_error("logger: %Lf needs a long double argument");
+      return;
+    }
+    if (len != length::none && len != length::l)
+      format_error("logger: invalid length modifier on floating conversion");
+    if (next(arg_kind::double_value).cls != type_class::floating)
+      format_error("logger: floating conversion needs a float or double");
+  }
+
+  constexpr void run() {
+    while (*f) {
+      if (*f++ != '%')
+        continue;
+      if (*f == '%') {
+        ++f;
+        continue;
+      }
+
+      while (*f == '-' || *f == '+' || *f == ' ' || *f == '#' || *f == '0') {
+        ++f;
+        out.fast = false;
+      }
+
+      if (*f == '*') {
+        ++f;
+        out.fast = false;
+        star();
+      } else if (*f >= '0' && *f <= '9') {
+        out.fast = false;
+        while (*f >= '0' && *f <= '9')
+          ++f;
+        if (*f == '$')
+          format_error("logger: positional arguments are not supported");
+      }
+
+      int prec = -1;
+      if (*f == '.') {
+        ++f;
+        if (*f == '*') {
+          ++f;
+          out.fast = false;
+          star();
+          prec = 0;
+        } else if (*f < '0' || *f > '9') {
+          out.fast = false;
+          prec = 0;
+        } else {
+          prec = 0;
+          while (*f >= '0' && *f <= '9') {
+            if (prec <= FAST_MAX_PREC)
+              prec = prec * 10 + (*f - '0');
+            ++f;
+          }
+        }
+      }
+
+      length len = length::none;
+      switch (*f) {
+      case 'h':
+        ++f;
+        len = length::h;
+        if (*f == 'h') {
+          ++f;
+          len = length::hh;
+        }
+        break;
+      case 'l':
+        ++f;
+        len = length::l;
+        if (*f == 'l') {
+          ++f;
+          len = length::ll;
+        }
+        break;
+      case 'z':
+        ++f;
+        len = length::z;
+        break;
+      case 'j':
+        ++f;
+        len = length::j;
+        break;
+      case 't':
+        ++f;
+        len = length::t;
+        break;
+      case 'L':
+        ++f;
+        len = length::L;
+        break;
+      default:
+        break;
+      }
+
+      const char conv = *f;
+      if (!conv) {
+        format_error("logger: incomplete conversion at end of format string");
+        return;
+      }
+      ++f;
+
+      if (prec > FAST_MAX_PREC || (prec >= 0 && conv != 'f' && conv != 's'))
+        out.fast = false;
+      if (len != length::none &&
+          !((len == length::l || len == length::ll || len == length::z) &&
+            (conv == 'd' || conv == 'i' || conv == 'u' || conv == 'x' ||
+             conv == 'X')))
+        out.fast = false;
+
+      switch (conv) {
+      case 'd':
+      case 'i':
+      case 'u':
+      case 'x':
+      case 'X':
+        integer(len);
+        break;
+      case 'o':
+        out.fast = false;
+        integer(len);
+        break;
+      case 'f':
+        floating(len);
+        break;
+      case 'F':
+      case 'e':
+      case 'E':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':
+        out.fast = false;
+        floating(len);
+        break;
+      case 'c': {
+        if (len != length::none)
+          format_error("logger: wide characters are not supported");
+        const type_desc &t = next(arg_kind::int_value);
+        if (t.cls != type_class::integral || t.size > sizeof(int))
+          format_error("logger: %c needs a character argument");
+        break;
+      }
+      case 's':
+        if (len != length::none)
+          format_error("logger: wide strings are not supported");
+        if (next(arg_kind::string).cls != type_class::string)
+          format_error("logger: %s needs a C string (const char *)");
+        break;
+      case 'p': {
+        if (len != length::none)
+          format_error("logger: invalid length modifier on %p");
+        const type_class c = next(arg_kind::pointer).cls;
+        if (c != type_class::pointer && c != type_class::string)
+          format_error("logger: %p needs a pointer argument");
+        break;
+      }
+      case 'n':
+        format_error("logger: %n is not supported");
+        break;
+      default:
+        format_error("logger: unknown conversion specifier");
+        break;
+      }
+    }
+
+    if (out.count < nargs)
+      format_error("logger: too many arguments for format string");
+  }
+};
+
+template <class... A> struct type_list {};
+
+/* Only used in unevaluated context: arguments are never evaluated twice. */
+template <class... A>
+constexpr type_list<std::decay_t<A>...> types_of(const A &...) {
+  return {};
+}
+
+template <class... A>
+constexpr format_layout layout(const char *fmt, type_list<A...>) {
+  constexpr type_desc types[] = {describe<A>()...,
+                                 type_desc{type_class::other, 0}};
+  parser p{fmt, types, sizeof...(A)};
+  p.run();
+  return p.out;
+}
+
+template <class... A>
+constexpr bool check(const char *fmt, type_list<A...> args) {
+  return layout(fmt, args).count == sizeof...(A);
+}
+
+template <bool Ok> struct checked {
+  static_assert(Ok, "logger: format string does not match its arguments");
+};
+
+} // namespace detail
+
+#ifdef LOGGER_HAS_COROUTINES
+/**
+ * Awaitable of logger::flush(). The coroutine is resumed on the logger's
+ * flusher thread once the flush completes (or inline if it could not be
+ * queued); co_await yields the flush status.
+ */
+class flush_awaitable {
+public:
+  explicit flush_awaitable(logger_handle_t *h) noexcept : h_(h) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> co) noexcept {
+    co_ = co;
+    logger_status_t st = logger_flush_async_h(h_, &flush_awaitable::done, this);
+    if (st == LOGGER_OK)
+      return true; /* `this` may already be resumed and gone */
+    st_ = st;
+    return false;
+  }
+
+  logger_status_t await_resume() const noexcept { return st_; }
+
+private:
+  static void done(logger_status_t st, void *self) {
+    auto *a = static_cast<flush_awaitable *>(self);
+    a->st_ = st;
+    a->co_.resume();
+  }
+
+  logger_handle_t *h_;
+  std::coroutine_handle<> co_;
+  logger_status_t st_ = LOGGER_OK;
+};
+
+/** `co_await logger::flush(h)`: logger_flush_h() without blocking. */
+inline flush_awaitable flush(logger_handle_t *h = logger_default()) noexcept {
+  return flush_awaitable(h);
+}
+#endif
+
+} // namespace logger
+
+/** Compile-time logger::format_layout of @p fmt applied to the arguments. */
+#define LOGGER_FMT_LAYOUT(fmt, ...)                                            \
+  ::logger::detail::layout(                                                    \
+      fmt, decltype(::logger::detail::types_of(__VA_ARGS__)){})
+
+/** Expression that fails to compile if @p fmt does not match the arguments. */
+#define LOGGER_FMT_CHECK(fmt, ...)                                             \
+  static_cast<void>(                                                           \
+      ::logger::detail::checked<(::logger::detail::check(                      \
+          fmt, decltype(::logger::detail::types_of(__VA_ARGS__)){}))>{})
+
+#undef LOG_TRACE
+#undef LOG_DEBUG
+#undef LOG_INFO
+#undef LOG_WARN
+#undef LOG_ERROR
+#undef LOG_FATAL
+#undef LOGH_TRACE
+#undef LOGH_DEBUG
+#undef LOGH_INFO
+#undef LOGH_WARN
+#undef LOGH_ERROR
+#undef LOGH_FATAL
+#undef LOG_RT_TRACE
+#undef LOG_RT_DEBUG
+#undef LOG_RT_INFO
+#undef LOG_RT_WARN
+#undef LOG_RT_ERROR
+#undef LOG_RT_FATAL
+
+#define LOGGER_CHECKED_LOG_(lvl, fmt, ...)                                     \
+  (LOGGER_FMT_CHECK(fmt, ##__VA_ARGS__),                                       \
+   logger_log(lvl, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__))
+
+#define LOGGER_CHECKED_LOGH_(h, lvl, fmt, ...)                                 \
+  (LOGGER_FMT_CHECK(fmt, ##__VA_ARGS__),                                       \
+   logger_log_h(h, lvl, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__))
+
+#define LOGGER_CHECKED_LOG_RT_(lvl, fmt, ...)                                  \
+  (LOGGER_FMT_CHECK(fmt, ##__VA_ARGS__),                                       \
+   logger_log_rt(lvl, LOGGER_FILE, __LINE__, fmt, ##__VA_ARGS__))
+
+#define LOG_TRACE(fmt, ...)                                                    \
+  LOGGER_CHECKED_LOG_(LOGGER_LEVEL_TRACE, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(fmt, ...)                                                    \
+  LOGGER_CHECKED_LOG_(LOGGER_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...)                                                     \
+  LOGGER_CHECKED_LOG_(LOGGER_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...)                                                     \
+  LOGGER_CHECKED_LOG_(LOGGER_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...)                                                    \
+  LOGGER_CHECKED_LOG_(LOGGER_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define LOG_FATAL(fmt, ...)                                                    \
+  LOGGER_CHECKED_LOG_(LOGGER_LEVEL_FATAL, fmt, ##__VA_ARGS__)
+
+#define LOGH_TRACE(h, fmt, ...)                                                \
+  LOGGER_CHECKED_LOGH_(h, LOGGER_LEVEL_TRACE, fmt, ##__VA_ARGS__)
+#define LOGH_DEBUG(h, fmt, ...)                                                \
+  LOGGER_CHECKED_LOGH_(h, LOGGER_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOGH_INFO(h, fmt, ...)                                                 \
+  LOGGER_CHECKED_LOGH_(h, LOGGER_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOGH_WARN(h, fmt, ...)                                                 \
+  LOGGER_CHECKED_LOGH_(h, LOGGER_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOGH_ERROR(h, fmt, ...)                                                \
+  LOGGER_CHECKED_LOGH_(h, LOGGER_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define LOGH_FATAL(h, fmt, ...)                                                \
+  LOGGER_CHECKED_LOGH_(h, LOGGER_LEVEL_FATAL, fmt, ##__VA_ARGS__)
+
+#define LOG_RT_TRACE(fmt, ...)                                                 \
+  LOGGER_CHECKED_LOG_RT_(LOGGER_LEVEL_TRACE, fmt, ##__VA_ARGS__)
+#define LOG_RT_DEBUG(fmt, ...)                                                 \
+  LOGGER_CHECKED_LOG_RT_(LOGGER_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_RT_INFO(fmt, ...)                                                  \
+  LOGGER_CHECKED_LOG_RT_(LOGGER_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_RT_WARN(fmt, ...)                                                  \
+  LOGGER_CHECKED_LOG_RT_(LOGGER_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_RT_ERROR(fmt, ...)                                                 \
+  LOGGER_CHECKED_LOG_RT_(LOGGER_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define LOG_RT_FATAL(fmt, ...)                                                 \
+  LOGGER_CHECKED_LOG_RT_(LOGGER_LEVEL_FATAL, fmt, ##__VA_ARGS__)
+
+#endif
@@ -0,0 +1,134 @@
+/**
+ * @file logger_timer.h
+ * @brief Scoped timers that aggregate latencies into per-thread histograms.
+ *
+ * Instead of one "took X us" line per call, LOG_SCOPE_TIMER() records the
+ * duration of the enclosing scope into an HDR-style (log-linear, ~6%
+ * relative error) histogram owned by the calling thread and keyed by call
+ * site. Once per interval each thread emits one summary record per site
+ * through the default logger:
+ *
+ *   [INFO] motor.c:42 | timer step: count=1000 p50=12.5us p99=40.1us max=93.0us
+ *
+ * Usage:
+ * @code
+ * void step(void) {
+ *   LOG_SCOPE_TIMER("step");
+ *   ...
+ * }
+ * @endcode
+ *
+ * An interval starts at a site's first sample. It is reported by the next
+ * sample after it ends or, if the site has gone quiet, by a background
+ * "log-timer" thread that checks every quarter interval.
+ *
+ * Notes:
+ * - C uses the GCC/Clang cleanup attribute; C++ uses a destructor.
+ * - Recording never allocates after a thread's first sample for a site and
+ *   never waits: the histogram's flag is only contended while the
+ *   background thread takes a summary (well under a microsecond per
+ *   interval), and a sample landing in that moment is dropped. Only the
+ *   summary goes through logger_log().
+ * - Histograms of a thread are flushed when it exits, on demand with
+ *   logger_timer_flush(), and for all threads by logger_timer_flush_all(),
+ *   which logger_stop()/logger_destroy() call before the outputs close.
+ */
+#ifndef LOGGER_TIMER_H
+#define LOGGER_TIMER_H
+
+#include "logger.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of distinct LOG_SCOPE_TIMER() call sites. */
+#define LOGGER_TIMER_MAX_SITES 256
+
+/**
+ * @brief Static per-call-site descriptor created by LOG_SCOPE_TIMER().
+ */
+typedef struct logger_timer_site {
+  const char *name; /**< Timer name. */
+  const char *file; /**< Call site file. */
+  int line;         /**< Call site line. */
+  int id;           /**< Site index + 1, assigned on first use (atomic). */
+} logger_timer_site_t;
+
+/**
+ * @brief Running scope timer (stack object).
+ */
+typedef struct logger_scope_timer {
+  logger_timer_site_t *site;
+  unsigned long long start_ns;
+} logger_scope_timer_t;
+
+/**
+ * @brief Configure summary emission for all scope timers.
+ *
+ * @param interval_ms Summary interval per thread and site (default 1000).
+ *                    0 restores the default.
+ * @param level Level of the summary records (default LOGGER_LEVEL_INFO).
+ * @return LOGGER_OK.
+ */
+logger_status_t logger_timer_configure(unsigned interval_ms,
+                                       logger_level_t level);
+
+/**
+ * @brief Emit and reset all histograms of the calling thread now.
+ */
+void logger_timer_flush(void);
+
+/**
+ * @brief Emit and reset the histograms of every thread now.
+ */
+void logger_timer_flush_all(void);
+
+/**
+ * @brief Records one duration for @p site. Used by LOG_SCOPE_TIMER().
+ */
+void logger_timer_record(logger_timer_site_t *site, unsigned long long ns);
+
+/** @brief CLOCK_MONOTONIC in nanoseconds. */
+unsigned long long logger_timer_now_ns(void);
+
+/** @brief Cleanup handler used by LOG_SCOPE_TIMER() in C. */
+void logger_scope_timer_end(logger_scope_timer_t *t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define LOGGER_TIMER_CAT2_(a, b) a##b
+#define LOGGER_TIMER_CAT_(a, b) LOGGER_TIMER_CAT2_(a, b)
+
+#ifdef __cplusplus
+namespace logger_detail {
+struct scope_timer {
+  logger_scope_timer_t t;
+  explicit scope_timer(logger_timer_site_t *site)
+      : t{site, logger_timer_now_ns()} {}
+  ~scope_timer() { logger_scope_timer_end(&t); }
+  scope_timer(const scope_timer &) = delete;
+  scope_timer &operator=(const scope_timer &) = delete;
+};
+} // namespace logger_detail
+
+#define LOG_SCOPE_TIMER(name)                                                  \
+  static logger_timer_site_t LOGGER_TIMER_CAT_(logger_timer_site_,             \
+                                               __LINE__) = {                   \
+      name, LOGGER_FILE, __LINE__, 0};                                         \
+  logger_detail::scope_timer LOGGER_TIMER_CAT_(logger_timer_, __LINE__)(       \
+      &LOGGER_TIMER_CAT_(logger_timer_site_, __LINE__))
+#else
+#define LOG_SCOPE_TIMER(name)                                                  \
+  static logger_timer_site_t LOGGER_TIMER_CAT_(logger_timer_site_,             \
+                                               __LINE__) = {                   \
+      name, LOGGER_FILE, __LINE__, 0};                                         \
+  logger_scope_timer_t LOGGER_TIMER_CAT_(logger_timer_, __LINE__)              \
+      __attribute__((cleanup(logger_scope_timer_end))) = {                     \
+          &LOGGER_TIMER_CAT_(logger_timer_site_, __LINE__),                    \
+          logger_timer_now_ns()}
+#endif
+
+#endif
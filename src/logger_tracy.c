@@ -0,0 +1,24 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
+#include "logger_tracy.h"
+#include <time.h>
+
+static unsigned long long now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ull +
+         (unsigned long long)ts.tv_nsec;
+}
+
+logger_zone_t logger_zone_begin(const char *name, const char *file, int line) {
+  logger_zone_t z = {name, file, line, now_ns()};
+  return z;
+}
+
+void logger_zone_end(const logger_zone_t *zone) {
+  if (!zone)
+    return;
+  unsigned long long us = (now_ns() - zone->start_ns) / 1000ull;
+  logger_log(LOGGER_LEVEL_DEBUG, zone->file, zone->line, "zone %s: %llu us",
+             zone->name ? zone->name : "?", us);
+}
@@ -0,0 +1,76 @@
+/**
+ * @file logger_tracy.h
+ * @brief Tracy zone macros that also log the zone duration.
+ *
+ * Usage:
+ * @code
+ * LOG_ZONE_BEGIN(z, "parse_frame");
+ * parse(frame);
+ * LOG_ZONE_END(z);   // Tracy zone + DEBUG "zone parse_frame: 42 us"
+ * @endcode
+ *
+ * Notes:
+ * - With TRACY_ENABLE the macros open/close a named Tracy zone
+ *   (TracyCZoneN/TracyCZoneEnd); without it only the duration is logged.
+ * - The duration is logged at LOGGER_LEVEL_DEBUG through the default logger
+ *   with the LOG_ZONE_BEGIN() call site, so it is filtered like any other
+ *   DEBUG record.
+ * - @p name must be a string literal (Tracy stores it in a static source
+ *   location).
+ */
+#ifndef LOGGER_TRACY_H
+#define LOGGER_TRACY_H
+
+#include "logger.h"
+
+#ifdef TRACY_ENABLE
+#include "tracy/TracyC.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Running zone started by LOG_ZONE_BEGIN().
+ */
+typedef struct logger_zone {
+  const char *name;            /**< Zone name. */
+  const char *file;            /**< LOG_ZONE_BEGIN() source file. */
+  int line;                    /**< LOG_ZONE_BEGIN() source line. */
+  unsigned long long start_ns; /**< CLOCK_MONOTONIC start time. */
+} logger_zone_t;
+
+/**
+ * @brief Starts timing a zone. Prefer LOG_ZONE_BEGIN().
+ */
+logger_zone_t logger_zone_begin(const char *name, const char *file, int line);
+
+/**
+ * @brief Logs the zone duration at DEBUG. Prefer LOG_ZONE_END().
+ */
+void logger_zone_end(const logger_zone_t *zone);
+
+#ifdef TRACY_ENABLE
+#define LOGGER_TRACY_ZONE_BEGIN_(var, name) TracyCZoneN(var##_tracy, name, 1)
+#define LOGGER_TRACY_ZONE_END_(var) TracyCZoneEnd(var##_tracy)
+#else
+#define LOGGER_TRACY_ZONE_BEGIN_(var, name) ((void)0)
+#define LOGGER_TRACY_ZONE_END_(var) ((void)0)
+#endif
+
+#define LOG_ZONE_BEGIN(var, name)                                              \
+  LOGGER_TRACY_ZONE_BEGIN_(var, name);                                         \
+  logger_zone_t var = logger_zone_begin(name, LOGGER_FILE, __LINE__)
+
+#define LOG_ZONE_END(var)                                                      \
+  do {                                                                         \
+    logger_zone_end(&var);                                                     \
+    LOGGER_TRACY_ZONE_END_(var);                                               \
+  } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
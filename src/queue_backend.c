@@ -0,0 +1,304 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
+#include "queue_backend.h"
+#include "arena.h"
+#include "context.h"
+#include "srcloc.h"
+#include "threads.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define Q_BATCH 64           /* records per delivery */
+#define Q_BUF (64u * 1024u)  /* message bytes per batch */
+#define Q_FLUSH_MS 5         /* a partial batch is delivered after this */
+#define Q_FILE_MAX 256       /* copied file name bytes (tail of the path) */
+
+typedef struct q_batch {
+  char *buf;
+  size_t len;
+  unsigned n;
+  logger_backend_record_t recs[Q_BATCH];
+} q_batch_t;
+
+typedef struct queue_ctx {
+  logger_backend_t *inner;
+  int batch; /* log_batch() instead of log() */
+
+  /*
+   * Producers fill batches[fill]; batches[fill ^ 1] is being delivered
+   * while sealed is set. Batch counters let flush() wait for its records.
+   */
+  pthread_mutex_t lock;
+  pthread_cond_t filled;  /* deliverer: a batch was sealed */
+  pthread_cond_t drained; /* flush/producers: a batch was delivered */
+  q_batch_t batches[2];
+  unsigned fill;
+  int sealed;
+  unsigned sealed_count, done_count;
+  int flush_req, stop;
+  pthread_t thread;
+} queue_ctx_t;
+
+/* ---- delivery ---- */
+
+static void deliver(queue_ctx_t *c, const q_batch_t *b) {
+  logger_backend_t *in = c->inner;
+  if (c->batch) {
+    in->vtbl->log_batch(in, b->recs, b->n);
+    return;
+  }
+  for (unsigned i = 0; i < b->n; ++i) {
+    const logger_backend_record_t *r = &b->recs[i];
+    logger_tls_record.seq = r->seq;
+    logger_tls_record.ts_ns = r->ts_ns;
+    logger_tls_record.ctx = r->ctx;
+    logger_tls_record.thread = r->thread;
+    in->vtbl->log(in, r->level, r->file, r->line, r->msg);
+  }
+  logger_tls_record.ctx = NULL;
+}
+
+/* Hands the filling batch to the deliverer if it is free. Caller holds lock. */
+static int seal_locked(queue_ctx_t *c) {
+  if (c->sealed)
+    return 0;
+  if (c->batches[c->fill].n) {
+    c->fill ^= 1;
+    c->sealed = 1;
+    c->sealed_count++;
+    pthread_cond_signal(&c->filled);
+  }
+  return 1;
+}
+
+static void deadline(struct timespec *ts, unsigned ms) {
+  clock_gettime(CLOCK_REALTIME, ts);
+  ts->tv_nsec += (long)ms * 1000000L;
+  if (ts->tv_nsec >= 1000000000L) {
+    ts->tv_sec++;
+    ts->tv_nsec -= 1000000000L;
+  }
+}
+
+static void *deliver_main(void *arg) {
+  queue_ctx_t *c = (queue_ctx_t *)arg;
+  logger_thread_started("log-queue");
+
+  pthread_mutex_lock(&c->lock);
+  for (;;) {
+    while (!c->sealed && !c->stop && !c->flush_req) {
+      if (!c->batches[c->fill].n) {
+        pthread_cond_wait(&c->filled, &c->lock); /* idle */
+        continue;
+      }
+      if (!c->batch) {
+        seal_locked(c); /* one record at a time: no reason to wait */
+        continue;
+      }
+      struct timespec ts;
+      deadline(&ts, Q_FLUSH_MS);
+      if (pthread_cond_timedwait(&c->filled, &c->lock, &ts) == ETIMEDOUT)
+        seal_locked(c);
+    }
+    if (!c->sealed && (c->stop || c->flush_req))
+      seal_locked(c);
+
+    if (c->sealed) {
+      q_batch_t *b = &c->batches[c->fill ^ 1];
+      pthread_mutex_unlock(&c->lock);
+      deliver(c, b);
+      for (unsigned i = 0; i < b->n; ++i)
+        logger_ctx_release((logger_ctx_t *)b->recs[i].ctx);
+      pthread_mutex_lock(&c->lock);
+      b->n = 0;
+      b->len = 0;
+      c->sealed = 0;
+      c->done_count++;
+      pthread_cond_broadcast(&c->drained);
+      continue;
+    }
+
+    c->flush_req = 0;
+    pthread_cond_broadcast(&c->drained);
+    if (c->stop)
+      break;
+  }
+  pthread_mutex_unlock(&c->lock);
+  return NULL;
+}
+
+/* ---- vtable methods ---- */
+
+static logger_status_t q_start(logger_backend_t *self) {
+  queue_ctx_t *c = (queue_ctx_t *)self->ctx;
+  return c->inner->vtbl->start(c->inner);
+}
+
+/* Waits until everything queued so far was delivered. */
+static void drain(queue_ctx_t *c) {
+  pthread_mutex_lock(&c->lock);
+  unsigned target = c->sealed_count + (c->batches[c->fill].n != 0);
+  c->flush_req = 1;
+  pthread_cond_signal(&c->filled);
+  while ((int)(c->done_count - target) < 0 && !c->stop)
+    pthread_cond_wait(&c->drained, &c->lock);
+  pthread_mutex_unlock(&c->lock);
+}
+
+static logger_status_t q_flush(logger_backend_t *self) {
+  queue_ctx_t *c = (queue_ctx_t *)self->ctx;
+  drain(c);
+  return c->inner->vtbl->flush ? c->inner->vtbl->flush(c->inner) : LOGGER_OK;
+}
+
+static logger_status_t q_stop(logger_backend_t *self) {
+  queue_ctx_t *c = (queue_ctx_t *)self->ctx;
+  drain(c);
+  return c->inner->vtbl->stop(c->inner);
+}
+
+static void q_log(logger_backend_t *self, logger_level_t level,
+                  const char *file, int line, const char *msg) {
+  queue_ctx_t *c = (queue_ctx_t *)self->ctx;
+  if (!msg)
+    msg = "";
+
+  size_t n = strlen(msg);
+  if (n >= Q_BUF - Q_FILE_MAX)
+    n = Q_BUF - Q_FILE_MAX - 1;
+
+  /* delivered later: a name that is not interned may not outlive the call */
+  const char *name = logger_srcloc_find(file);
+  size_t fn = 0;
+  if (!name && file) {
+    fn = strlen(file);
+    if (fn >= Q_FILE_MAX) {
+      file += fn - (Q_FILE_MAX - 1);
+      fn = Q_FILE_MAX - 1;
+    }
+    ++fn; /* NUL */
+  }
+  logger_record_meta_t meta = *logger_backend_current_record();
+  if (!meta.ts_ns) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    meta.ts_ns = (unsigned long long)ts.tv_sec * 1000000000ull +
+                 (unsigned long long)ts.tv_nsec;
+  }
+
+  pthread_mutex_lock(&c->lock);
+  q_batch_t *b = &c->batches[c->fill];
+  while (b->n == Q_BATCH || b->len + n + 1 + fn > Q_BUF) {
+    if (!seal_locked(c))
+      pthread_cond_wait(&c->drained, &c->lock); /* both full: wait */
+    b = &c->batches[c->fill];
+  }
+  int was_empty = b->n == 0;
+
+  logger_backend_record_t *r = &b->recs[b->n++];
+  r->level = level;
+  r->file = name;
+  r->line = line;
+  r->msg = b->buf + b->len;
+  r->seq = meta.seq;
+  r->ts_ns = meta.ts_ns;
+  r->ctx = logger_ctx_retain((logger_ctx_t *)meta.ctx);
+  r->thread = meta.thread;
+  memcpy(b->buf + b->len, msg, n);
+  b->buf[b->len + n] = '\0';
+  b->len += n + 1;
+  if (fn) {
+    r->file = b->buf + b->len;
+    memcpy(b->buf + b->len, file, fn - 1);
+    b->buf[b->len + fn - 1] = '\0';
+    b->len += fn;
+  }
+
+  if (c->batch && (b->n == Q_BATCH || level >= LOGGER_LEVEL_ERROR)) {
+    if (!seal_locked(c))
+      c->flush_req = 1; /* deliverer busy: seal right after this batch */
+  } else if (was_empty) {
+    pthread_cond_signal(&c->filled);
+  }
+  pthread_mutex_unlock(&c->lock);
+}
+
+static void q_prewarm(logger_backend_t *self) {
+  queue_ctx_t *c = (queue_ctx_t *)self->ctx;
+  if (c->inner->vtbl->prewarm)
+    c->inner->vtbl->prewarm(c->inner);
+}
+
+static void q_destroy(logger_backend_t *self) {
+  queue_ctx_t *c = (queue_ctx_t *)self->ctx;
+  if (c) {
+    pthread_mutex_lock(&c->lock);
+    c->stop = 1;
+    pthread_cond_signal(&c->filled);
+    pthread_mutex_unlock(&c->lock);
+    pthread_join(c->thread, NULL);
+
+    c->inner->vtbl->destroy(c->inner);
+    pthread_cond_destroy(&c->drained);
+    pthread_cond_destroy(&c->filled);
+    pthread_mutex_destroy(&c->lock);
+    free(c->batches[0].buf);
+    free(c->batches[1].buf);
+    logger_arena_free(c, sizeof(*c));
+  }
+  logger_arena_free(self, sizeof(*self));
+}
+
+static const logger_backend_vtbl_t V = {.start = q_start,
+                                        .stop = q_stop,
+                                        .log = q_log,
+                                        .destroy = q_destroy,
+                                        .flush = q_flush,
+                                        .prewarm = q_prewarm};
+
+logger_backend_t *logger_backend_queue_create(logger_backend_t *inner,
+                                              int batch) {
+  if (!inner || (batch && !inner->vtbl->log_batch))
+    return NULL;
+
+  logger_backend_t *b = (logger_backend_t *)logger_arena_alloc(sizeof(*b));
+  if (!b)
+    return NULL;
+
+  queue_ctx_t *c = (queue_ctx_t *)logger_arena_alloc(sizeof(*c));
+  if (!c) {
+    logger_arena_free(b, sizeof(*b));
+    return NULL;
+  }
+
+  c->inner = inner;
+  c->batch = batch != 0;
+  c->batches[0].buf = (char *)malloc(Q_BUF);
+  c->batches[1].buf = (char *)malloc(Q_BUF);
+  if (!c->batches[0].buf || !c->batches[1].buf)
+    goto fail;
+
+  pthread_mutex_init(&c->lock, NULL);
+  pthread_cond_init(&c->filled, NULL);
+  pthread_cond_init(&c->drained, NULL);
+  if (pthread_create(&c->thread, NULL, deliver_main, c) != 0) {
+    pthread_cond_destroy(&c->drained);
+    pthread_cond_destroy(&c->filled);
+    pthread_mutex_destroy(&c->lock);
+    goto fail;
+  }
+
+  b->vtbl = &V;
+  b->ctx = c;
+  return b;
+
+fail:
+  free(c->batches[0].buf);
+  free(c->batches[1].buf);
+  logger_arena_free(c, sizeof(*c));
+  logger_arena_free(b, sizeof(*b));
+  return NULL;
+}
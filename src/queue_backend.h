@@ -0,0 +1,45 @@
+/**
+ * @file queue_backend.h
+ * @brief Adapter that delivers records to a backend from its own thread.
+ *
+ * Used for registered backends that are not thread-safe or that take
+ * records in batches (logger_backend_caps_t):
+ * - log() copies the record into the filling batch and returns; a
+ *   delivery thread hands sealed batches to the inner backend, either
+ *   with one log_batch() call or with one log() call per record. File
+ *   names that are not interned are copied with the message.
+ * - Per-record delivery starts as soon as the thread is free. A partial
+ *   batch is delivered after a few milliseconds, at once for ERROR+
+ *   records, on flush() and on stop().
+ * - Nothing is dropped: a producer that finds both batches full waits for
+ *   the delivery thread.
+ *
+ * Ownership:
+ * - The adapter owns @p inner and destroys it.
+ */
+#ifndef QUEUE_BACKEND_H
+#define QUEUE_BACKEND_H
+
+#include "backend.h"
+
+/**
+ * @brief Record metadata of the calling thread (defined in logger.c).
+ *
+ * Set by the delivery thread before each inner log(), so
+ * logger_backend_current_record() keeps working behind the queue.
+ */
+extern _Thread_local logger_record_meta_t logger_tls_record;
+
+/**
+ * @brief Creates a queueing adapter around @p inner.
+ *
+ * @param inner Backend to deliver to.
+ * @param batch Non-zero to deliver through inner->vtbl->log_batch().
+ *
+ * @return Pointer to a logger_backend_t instance on success, NULL on failure
+ *         (the caller keeps @p inner).
+ */
+logger_backend_t *logger_backend_queue_create(logger_backend_t *inner,
+                                              int batch);
+
+#endif
@@ -1,5 +1,8 @@
 #include "quill_backend.h"
+#include "arena.h"
+#include "threads.h"
 
+#include <chrono>
 #include <cstdlib>
 #include <memory>
 #include <mutex>
@@ -26,7 +29,30 @@ struct quill_ctx {
 static std::once_flag g_quill_once;
 
 static void ensure_quill_started() {
-  std::call_once(g_quill_once, []() { quill::Backend::start(); });
+  std::call_once(g_quill_once, []() {
+    quill::BackendOptions opts;
+    opts.thread_name = "log-quill";
+
+    // Idle strategy is fixed at start; placement follows later changes.
+    unsigned idle_us;
+    switch (logger_thread_wait(&idle_us)) {
+    case LOGGER_WAIT_SPIN:
+      opts.sleep_duration = std::chrono::nanoseconds{0};
+      opts.enable_yield_when_idle = false;
+      break;
+    case LOGGER_WAIT_YIELD:
+      opts.sleep_duration = std::chrono::nanoseconds{0};
+      opts.enable_yield_when_idle = true;
+      break;
+    default:
+      if (idle_us)
+        opts.sleep_duration = std::chrono::microseconds{idle_us};
+      break;
+    }
+
+    quill::Backend::start(opts);
+    logger_thread_adopt(quill::Backend::get_thread_id());
+  });
 }
 
 /* --- vtable methods --- */
@@ -40,33 +66,54 @@ static logger_status_t quill_stop(logger_backend_t *self) {
   return LOGGER_OK;
 }
 
+static logger_status_t quill_flush(logger_backend_t *self) {
+  auto *ctx = static_cast<quill_ctx *>(self->ctx);
+  if (ctx && ctx->logger) {
+    ctx->logger->flush_log(); // blocks until the backend thread wrote it
+  }
+  return LOGGER_OK;
+}
+
 static void quill_log(logger_backend_t *self, logger_level_t level,
                       const char *file, int line, const char *msg) {
   auto *ctx = static_cast<quill_ctx *>(self->ctx);
   if (!ctx || !ctx->logger)
     return;
 
+  // Quill prints the thread id itself; only the pushed fields are added.
+  size_t flen;
+  const char *fields =
+      logger_ctx_text(logger_backend_current_record()->ctx, 0, &flen);
+  const char *sep = flen ? " | " : "";
+
   switch (level) {
   case LOGGER_LEVEL_TRACE:
-    QUILL_LOG_TRACE_L3(ctx->logger, "[QUILL] {}:{} | {}", file, line, msg);
+    QUILL_LOG_TRACE_L3(ctx->logger, "[QUILL] {}:{} | {}{}{}", file, line,
+                       fields, sep, msg);
     break;
   case LOGGER_LEVEL_DEBUG:
-    QUILL_LOG_DEBUG(ctx->logger, "[QUILL] {}:{} | {}", file, line, msg);
+    QUILL_LOG_DEBUG(ctx->logger, "[QUILL] {}:{} | {}{}{}", file, line,
+                    fields, sep, msg);
     break;
   case LOGGER_LEVEL_INFO:
-    QUILL_LOG_INFO(ctx->logger, "[QUILL] {}:{} | {}", file, line, msg);
+    QUILL_LOG_INFO(ctx->logger, "[QUILL] {}:{} | {}{}{}", file, line,
+                   fields, sep, msg);
     break;
   case LOGGER_LEVEL_WARN:
-    QUILL_LOG_WARNING(ctx->logger, "[QUILL] {}:{} | {}", file, line, msg);
+    QUILL_LOG_WARNING(ctx->logger, "[QUILL] {}:{} | {}{}{}", file, line,
+                      fields, sep, msg);
     break;
   case LOGGER_LEVEL_ERROR:
-    QUILL_LOG_ERROR(ctx->logger, "[QUILL] {}:{} | {}", file, line, msg);
+    QUILL_LOG_ERROR(ctx->logger, "[QUILL] {}:{} | {}{}{}", file, line,
+                    fields, sep, msg);
     break;
   case LOGGER_LEVEL_FATAL:
-    QUILL_LOG_CRITICAL(ctx->logger, "[QUILL] {}:{} | {}", file, line, msg);
+    QUILL_LOG_CRITICAL(ctx->logger, "[QUILL] {}:{} | {}{}{}", file, line,
+                       fields, sep, msg);
     break;
   default:
-    QUILL_LOG_INFO(ctx->logger, "[QUILL] {}:{} | {}", file, line, msg);
+    QUILL_LOG_INFO(ctx->logger, "[QUILL] {}:{} | {}{}{}", file, line,
+                   fields, sep, msg);
     break;
   }
 }
@@ -83,15 +130,17 @@ static void quill_destroy(logger_backend_t *self) {
     delete ctx;
   }
 
-  std::free(self);
+  logger_arena_free(self, sizeof(*self));
 }
 
 static const logger_backend_vtbl_t QUILL_VTBL = {.start = quill_start,
                                                  .stop = quill_stop,
                                                  .log = quill_log,
-                                                 .destroy = quill_destroy};
+                                                 .destroy = quill_destroy,
+                                                 .flush = quill_flush};
 
-extern "C" logger_backend_t *logger_backend_quill_create(const char *file_path,
+extern "C" logger_backend_t *logger_backend_quill_create(const char *name,
+                                                         const char *file_path,
                                                          int enable_console) {
   ensure_quill_started();
 
@@ -117,7 +166,8 @@ extern "C" logger_backend_t *logger_backend_quill_create(const char *file_path,
   logger_pfo.format_pattern = "%(time) [%(thread_id)] %(log_level) %(message)";
 
   quill::Logger *logger =
-      quill::Frontend::create_or_get_logger("backend", sinks, logger_pfo);
+      quill::Frontend::create_or_get_logger(name && name[0] ? name : "backend",
+                                            sinks, logger_pfo);
 
   logger->set_log_level(quill::LogLevel::TraceL3);
 
@@ -126,7 +176,8 @@ extern "C" logger_backend_t *logger_backend_quill_create(const char *file_path,
     return nullptr;
 
   auto *b =
-      static_cast<logger_backend_t *>(std::calloc(1, sizeof(logger_backend_t)));
+      static_cast<logger_backend_t *>(
+      logger_arena_alloc(sizeof(logger_backend_t)));
   if (!b) {
     delete ctx;
     return nullptr;
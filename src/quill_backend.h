@@ -5,6 +5,7 @@
  * Build:
  * - Compile this backend only when USE_QUILL is defined.
  *
+ * @param name Quill logger name (one per logger handle).
  * @param file_path If NULL or empty, file sink is disabled.
  * @param enable_console 0/1 to enable console sink.
  *
@@ -28,6 +29,8 @@ extern "C" {
  * This backend uses Quill (C++) to provide asynchronous logging with
  * optional console and file sinks.
  *
+ * @param name Name of the underlying Quill logger. Each logger handle uses
+ *        its own name so independent handles do not share a Quill logger.
  * @param file_path Path to the log file.
  *        If NULL or empty (""), the file sink is not created.
  * @param enable_console Enable console output (stdout).
@@ -38,7 +41,8 @@ extern "C" {
  *
  * @note This backend is only available when compiled with USE_QUILL enabled.
  */
-logger_backend_t *logger_backend_quill_create(const char *file_path,
+logger_backend_t *logger_backend_quill_create(const char *name,
+                                              const char *file_path,
                                               int enable_console);
 
 #ifdef __cplusplus
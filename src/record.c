@@ -0,0 +1,105 @@
+#include "record.h"
+#include "arena.h"
+#include "shard.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+typedef struct logger_record_cache {
+  logger_record_t *local; /* owner thread only */
+  struct logger_record_cache *next_parked;
+
+  /* Pushed by other threads, drained by the owner in one exchange. */
+  _Alignas(LOGGER_CACHE_LINE) _Atomic(logger_record_t *) remote;
+} record_cache_t;
+
+static pthread_mutex_t g_parked_mutex = PTHREAD_MUTEX_INITIALIZER;
+static record_cache_t *g_parked = NULL;
+
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_key;
+static _Thread_local record_cache_t *tls_cache = NULL;
+
+/* Thread exit: park the cache; records in flight still point at it. */
+static void cache_park(void *arg) {
+  record_cache_t *c = (record_cache_t *)arg;
+  pthread_mutex_lock(&g_parked_mutex);
+  c->next_parked = g_parked;
+  g_parked = c;
+  pthread_mutex_unlock(&g_parked_mutex);
+}
+
+static void make_key(void) { pthread_key_create(&g_key, cache_park); }
+
+static record_cache_t *thread_cache(void) {
+  if (tls_cache)
+    return tls_cache;
+  pthread_once(&g_key_once, make_key);
+
+  pthread_mutex_lock(&g_parked_mutex);
+  record_cache_t *c = g_parked;
+  if (c)
+    g_parked = c->next_parked;
+  pthread_mutex_unlock(&g_parked_mutex);
+
+  if (!c) {
+    c = (record_cache_t *)logger_arena_alloc(sizeof(*c));
+    if (!c)
+      return NULL;
+    atomic_init(&c->remote, NULL);
+  }
+  c->next_parked = NULL;
+
+  pthread_setspecific(g_key, c);
+  tls_cache = c;
+  return c;
+}
+
+static int cache_refill(record_cache_t *c) {
+  logger_record_t *slab = (logger_record_t *)logger_arena_alloc(
+      LOGGER_RECORD_SLAB * sizeof(logger_record_t));
+  if (!slab)
+    return 0;
+  for (int i = 0; i < LOGGER_RECORD_SLAB; ++i) {
+    slab[i].owner = c;
+    slab[i].next = c->local;
+    c->local = &slab[i];
+  }
+  return 1;
+}
+
+logger_record_t *logger_record_acquire(void) {
+  record_cache_t *c = thread_cache();
+  if (!c)
+    return NULL;
+
+  if (!c->local) {
+    c->local = atomic_exchange_explicit(&c->remote, NULL, memory_order_acquire);
+    if (!c->local && !cache_refill(c))
+      return NULL;
+  }
+
+  logger_record_t *r = c->local;
+  c->local = r->next;
+  r->next = NULL;
+  return r;
+}
+
+void logger_record_release(logger_record_t *r) {
+  if (!r)
+    return;
+
+  record_cache_t *c = r->owner;
+  if (c == tls_cache) {
+    r->next = c->local;
+    c->local = r;
+    return;
+  }
+
+  /* Push only; the owner takes the whole stack at once, so no ABA. */
+  logger_record_t *head =
+      atomic_load_explicit(&c->remote, memory_order_relaxed);
+  do {
+    r->next = head;
+  } while (!atomic_compare_exchange_weak_explicit(
+      &c->remote, &head, r, memory_order_release, memory_order_relaxed));
+}
@@ -0,0 +1,56 @@
+/**
+ * @file record.h
+ * @brief Internal fixed-size record pool for queued/deferred log messages.
+ *
+ * A record carries one already-formatted message from a producer thread to
+ * whoever emits it later. Records come from per-thread caches:
+ * - acquire pops from the calling thread's local free list, then takes the
+ *   records other threads handed back, and only when both are empty carves
+ *   a new slab (the only path that allocates);
+ * - release from the owning thread pushes onto the local list; from any
+ *   other thread it pushes onto the owner's lock-free return stack.
+ *
+ * The cache of an exiting thread is parked and adopted by the next new
+ * thread, together with any records still in flight, so after warm-up the
+ * pool stops allocating even with short-lived threads.
+ */
+#ifndef LOGGER_RECORD_H
+#define LOGGER_RECORD_H
+
+#include "backend.h"
+#include <stddef.h>
+
+/** Message capacity of a record, matching logger_log()'s stack buffer. */
+#define LOGGER_RECORD_MSG_MAX 2048
+
+/** Records allocated per slab when a thread's cache runs dry. */
+#define LOGGER_RECORD_SLAB 16
+
+struct logger_record_cache;
+
+typedef struct logger_record {
+  struct logger_record *next;         /**< Free-list / queue link. */
+  struct logger_record_cache *owner;  /**< Cache the record returns to. */
+  logger_handle_t *h;                 /**< Logger the record is for. */
+  unsigned long long ts_ns;           /**< CLOCK_MONOTONIC at capture. */
+  unsigned long long seq;             /**< Capture order, 0 if disabled. */
+  struct logger_ctx *ctx;             /**< Referenced thread context. */
+  logger_level_t level;
+  unsigned file_id;                   /**< logger_srcloc_intern() id. */
+  int line;
+  size_t len;                         /**< strlen(msg). */
+  char msg[LOGGER_RECORD_MSG_MAX];
+} logger_record_t;
+
+/**
+ * @brief Takes a record from the calling thread's cache.
+ * @return NULL only if a new slab could not be allocated.
+ */
+logger_record_t *logger_record_acquire(void);
+
+/**
+ * @brief Returns @p r to its owner's cache. Callable from any thread.
+ */
+void logger_record_release(logger_record_t *r);
+
+#endif
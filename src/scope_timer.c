@@ -0,0 +1,346 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
+#include "logger_timer.h"
+#include "threads.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Log-linear buckets: values < 16 ns are exact; above that each power of two
+ * is split into 16 sub-buckets (~6% relative error), up to 2^63 ns.
+ */
+#define SUB_BITS 4
+#define SUB_COUNT (1u << SUB_BITS)
+#define BUCKETS (61u * SUB_COUNT)
+
+#define DEFAULT_INTERVAL_NS 1000000000ull
+
+/* The sweeper looks for expired intervals this often per interval. */
+#define SWEEPS_PER_INTERVAL 4
+#define SWEEP_MIN_NS 1000000ull
+
+typedef struct timer_hist {
+  /* Held by the owner while recording and by the sweeper while taking a
+   * summary. A recording owner never waits for it: see logger_timer_record.
+   */
+  atomic_int busy;
+  unsigned long long window_start; /* first sample of the interval */
+  unsigned long long count;
+  unsigned long long max;
+  uint32_t buckets[BUCKETS];
+} timer_hist_t;
+
+typedef struct timer_thread {
+  /* written by the owner only; read by the sweeper */
+  _Atomic(timer_hist_t *) hists[LOGGER_TIMER_MAX_SITES];
+  struct timer_thread *next;
+} timer_thread_t;
+
+/* Snapshot of one interval, reported once the histogram is released. */
+typedef struct timer_summary {
+  unsigned long long count;
+  double p50, p99, max;
+} timer_summary_t;
+
+static logger_timer_site_t *g_sites[LOGGER_TIMER_MAX_SITES];
+static atomic_int g_site_count = 0;
+static atomic_ullong g_interval_ns = DEFAULT_INTERVAL_NS;
+static atomic_int g_level = LOGGER_LEVEL_INFO;
+
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_key;
+static _Thread_local timer_thread_t *tls_timers = NULL;
+
+/* Live threads' histograms, for the sweeper and logger_timer_flush_all(). */
+static pthread_mutex_t g_threads_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_sweep_cond = PTHREAD_COND_INITIALIZER;
+static timer_thread_t *g_threads = NULL;
+static int g_sweeper_running = 0;
+
+static unsigned bucket_of(unsigned long long v) {
+  if (v < SUB_COUNT)
+    return (unsigned)v;
+  unsigned msb = 63u - (unsigned)__builtin_clzll(v);
+  unsigned shift = msb - SUB_BITS;
+  unsigned sub = (unsigned)(v >> shift) & (SUB_COUNT - 1);
+  unsigned idx = (shift + 1) * SUB_COUNT + sub;
+  return idx < BUCKETS ? idx : BUCKETS - 1;
+}
+
+/* Midpoint of a bucket, in ns. */
+static double bucket_value(unsigned idx) {
+  if (idx < SUB_COUNT)
+    return (double)idx;
+  unsigned shift = idx / SUB_COUNT - 1;
+  unsigned sub = idx % SUB_COUNT;
+  double lower = (double)((unsigned long long)(SUB_COUNT + sub) << shift);
+  return lower + (double)(1ull << shift) / 2.0;
+}
+
+static double percentile(const timer_hist_t *h, double q) {
+  unsigned long long rank = (unsigned long long)(q * (double)h->count);
+  if (rank >= h->count)
+    rank = h->count - 1;
+  unsigned long long seen = 0;
+  for (unsigned i = 0; i < BUCKETS; ++i) {
+    seen += h->buckets[i];
+    if (seen > rank)
+      return bucket_value(i);
+  }
+  return (double)h->max;
+}
+
+static int hist_trylock(timer_hist_t *h) {
+  return !atomic_exchange_explicit(&h->busy, 1, memory_order_acquire);
+}
+
+static void hist_lock(timer_hist_t *h) {
+  for (unsigned spins = 0; !hist_trylock(h); ++spins) {
+    if (spins < 64)
+      logger_cpu_relax();
+    else
+      sched_yield();
+  }
+}
+
+static void hist_unlock(timer_hist_t *h) {
+  atomic_store_explicit(&h->busy, 0, memory_order_release);
+}
+
+/* Summarizes and resets @p h; returns 0 if it holds no samples. Locked. */
+static int take_locked(timer_hist_t *h, timer_summary_t *out) {
+  if (!h->count)
+    return 0;
+  out->count = h->count;
+  out->max = (double)h->max;
+  out->p50 = percentile(h, 0.50);
+  out->p99 = percentile(h, 0.99);
+  if (out->p50 > out->max)
+    out->p50 = out->max;
+  if (out->p99 > out->max)
+    out->p99 = out->max;
+
+  h->count = 0;
+  h->max = 0;
+  for (unsigned i = 0; i < BUCKETS; ++i)
+    h->buckets[i] = 0;
+  return 1;
+}
+
+static void report(const logger_timer_site_t *site, const timer_summary_t *s) {
+  logger_log((logger_level_t)atomic_load(&g_level), site->file, site->line,
+             "timer %s: count=%llu p50=%.1fus p99=%.1fus max=%.1fus",
+             site->name, s->count, s->p50 / 1000.0, s->p99 / 1000.0,
+             s->max / 1000.0);
+}
+
+/*
+ * Reports the histograms of @p t: all of them, or with @p expired_only the
+ * ones whose interval has run out.
+ */
+static void flush_thread(timer_thread_t *t, int expired_only) {
+  int n = atomic_load(&g_site_count);
+  if (n > LOGGER_TIMER_MAX_SITES)
+    n = LOGGER_TIMER_MAX_SITES;
+  unsigned long long now = logger_timer_now_ns();
+  unsigned long long interval = atomic_load(&g_interval_ns);
+
+  for (int i = 0; i < n; ++i) {
+    timer_hist_t *h = atomic_load_explicit(&t->hists[i], memory_order_acquire);
+    if (!h)
+      continue;
+    timer_summary_t s;
+    hist_lock(h);
+    int due = !expired_only || now - h->window_start >= interval;
+    int have = due && take_locked(h, &s);
+    hist_unlock(h);
+    if (have)
+      report(g_sites[i], &s);
+  }
+}
+
+/* Interval summaries of sites that went quiet, emitted in the background. */
+static void *sweeper_main(void *arg) {
+  (void)arg;
+  logger_thread_started("log-timer");
+
+  pthread_mutex_lock(&g_threads_lock);
+  while (g_threads) {
+    unsigned long long wait =
+        atomic_load(&g_interval_ns) / SWEEPS_PER_INTERVAL;
+    if (wait < SWEEP_MIN_NS)
+      wait = SWEEP_MIN_NS;
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += (time_t)(wait / 1000000000ull);
+    ts.tv_nsec += (long)(wait % 1000000000ull);
+    if (ts.tv_nsec >= 1000000000L) {
+      ts.tv_sec += 1;
+      ts.tv_nsec -= 1000000000L;
+    }
+    pthread_cond_timedwait(&g_sweep_cond, &g_threads_lock, &ts);
+
+    for (timer_thread_t *t = g_threads; t; t = t->next)
+      flush_thread(t, 1);
+  }
+  g_sweeper_running = 0;
+  pthread_mutex_unlock(&g_threads_lock);
+  return NULL;
+}
+
+static void thread_exit(void *arg) {
+  timer_thread_t *t = (timer_thread_t *)arg;
+
+  pthread_mutex_lock(&g_threads_lock);
+  for (timer_thread_t **pp = &g_threads; *pp; pp = &(*pp)->next) {
+    if (*pp == t) {
+      *pp = t->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&g_threads_lock);
+
+  if (tls_timers == t)
+    tls_timers = NULL;
+  flush_thread(t, 0);
+  for (int i = 0; i < LOGGER_TIMER_MAX_SITES; ++i)
+    free(atomic_load_explicit(&t->hists[i], memory_order_relaxed));
+  free(t);
+}
+
+static void make_key(void) { pthread_key_create(&g_key, thread_exit); }
+
+static timer_thread_t *thread_state(void) {
+  if (tls_timers)
+    return tls_timers;
+  pthread_once(&g_key_once, make_key);
+  timer_thread_t *t = (timer_thread_t *)calloc(1, sizeof(*t));
+  if (!t)
+    return NULL;
+  pthread_setspecific(g_key, t);
+  tls_timers = t;
+
+  pthread_mutex_lock(&g_threads_lock);
+  t->next = g_threads;
+  g_threads = t;
+  if (!g_sweeper_running) {
+    pthread_t tid;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    /* without it, quiet sites report at their next sample or thread exit */
+    g_sweeper_running = pthread_create(&tid, &attr, sweeper_main, NULL) == 0;
+    pthread_attr_destroy(&attr);
+  }
+  pthread_mutex_unlock(&g_threads_lock);
+  return t;
+}
+
+/* Returns the site index, assigning one on first use; -1 if full. */
+static int site_index(logger_timer_site_t *site) {
+  int id = __atomic_load_n(&site->id, __ATOMIC_ACQUIRE);
+  if (id > 0)
+    return id - 1;
+  if (id < 0)
+    return -1;
+
+  /* Claim the site (0 -> -1 = "registering"), then publish its index. */
+  int expected = 0;
+  if (!__atomic_compare_exchange_n(&site->id, &expected, -1, 0,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    while ((id = __atomic_load_n(&site->id, __ATOMIC_ACQUIRE)) == -1)
+      ;
+    return id > 0 ? id - 1 : -1;
+  }
+
+  int idx = atomic_fetch_add(&g_site_count, 1);
+  if (idx >= LOGGER_TIMER_MAX_SITES) {
+    __atomic_store_n(&site->id, -2, __ATOMIC_RELEASE);
+    return -1;
+  }
+  g_sites[idx] = site;
+  __atomic_store_n(&site->id, idx + 1, __ATOMIC_RELEASE);
+  return idx;
+}
+
+unsigned long long logger_timer_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ull +
+         (unsigned long long)ts.tv_nsec;
+}
+
+void logger_timer_record(logger_timer_site_t *site, unsigned long long ns) {
+  if (!site)
+    return;
+  int idx = site_index(site);
+  if (idx < 0)
+    return;
+  timer_thread_t *t = thread_state();
+  if (!t)
+    return;
+
+  timer_hist_t *h = atomic_load_explicit(&t->hists[idx], memory_order_relaxed);
+  unsigned long long now = logger_timer_now_ns();
+  if (!h) {
+    h = (timer_hist_t *)calloc(1, sizeof(*h));
+    if (!h)
+      return;
+    atomic_store_explicit(&t->hists[idx], h, memory_order_release);
+  }
+
+  /* The sweeper holds it for a few hundred ns per interval; rather than
+   * wait (possibly behind a lower-priority thread), drop this sample. */
+  timer_summary_t s;
+  if (!hist_trylock(h))
+    return;
+  if (!h->count)
+    h->window_start = now;
+  h->buckets[bucket_of(ns)]++;
+  h->count++;
+  if (ns > h->max)
+    h->max = ns;
+  int have = now - h->window_start >= atomic_load(&g_interval_ns) &&
+             take_locked(h, &s);
+  hist_unlock(h);
+
+  if (have)
+    report(site, &s);
+}
+
+void logger_scope_timer_end(logger_scope_timer_t *t) {
+  if (!t)
+    return;
+  logger_timer_record(t->site, logger_timer_now_ns() - t->start_ns);
+}
+
+void logger_timer_flush(void) {
+  if (tls_timers)
+    flush_thread(tls_timers, 0);
+}
+
+void logger_timer_flush_all(void) {
+  pthread_mutex_lock(&g_threads_lock);
+  for (timer_thread_t *t = g_threads; t; t = t->next)
+    flush_thread(t, 0);
+  pthread_mutex_unlock(&g_threads_lock);
+}
+
+logger_status_t logger_timer_configure(unsigned interval_ms,
+                                       logger_level_t level) {
+  unsigned long long ns = interval_ms
+                               ? (unsigned long long)interval_ms * 1000000ull
+                               : DEFAULT_INTERVAL_NS;
+  atomic_store(&g_interval_ns, ns);
+  atomic_store(&g_level, (int)level);
+
+  /* re-arm the sweeper for the new period */
+  pthread_mutex_lock(&g_threads_lock);
+  pthread_cond_signal(&g_sweep_cond);
+  pthread_mutex_unlock(&g_threads_lock);
+  return LOGGER_OK;
+}
@@ -0,0 +1,14 @@
+#include "shard.h"
+#include <stdatomic.h>
+
+_Thread_local unsigned logger_tls_shard = 0;
+
+static atomic_uint g_next_shard = 0;
+
+unsigned logger_shard_assign(void) {
+  unsigned idx = atomic_fetch_add_explicit(&g_next_shard, 1,
+                                           memory_order_relaxed) &
+                 (LOGGER_SHARDS - 1);
+  logger_tls_shard = idx + 1;
+  return idx;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file shard.h
+ * @brief Internal helpers for cache-line-aware, per-thread sharded state.
+ *
+ * Counters that every logging thread updates are split into LOGGER_SHARDS
+ * cache-line-sized shards. Each thread is assigned one shard on first use
+ * (round-robin), so threads update disjoint cache lines and readers that
+ * need a total simply sum the shards.
+ */
+#ifndef LOGGER_SHARD_H
+#define LOGGER_SHARD_H
+
+/** Cache line size assumed for padding/alignment (x86_64, Cortex-A). */
+#define LOGGER_CACHE_LINE 64
+
+/** Number of shards; a power of two. */
+#define LOGGER_SHARDS 16
+
+/** Calling thread's shard index + 1, or 0 if not assigned yet. */
+extern _Thread_local unsigned logger_tls_shard;
+
+/**
+ * @brief Assigns the calling thread a shard and returns its index.
+ */
+unsigned logger_shard_assign(void);
+
+/**
+ * @brief Returns the calling thread's shard index in [0, LOGGER_SHARDS).
+ */
+static inline unsigned logger_shard_index(void) {
+  unsigned s = logger_tls_shard;
+  return s ? s - 1 : logger_shard_assign();
+}
+
+#endif
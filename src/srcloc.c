@@ -0,0 +1,225 @@
+#include "srcloc.h"
+#include "arena.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Pointer -> id cache; several pointers (one per TU) may share an id. A hit
+ * is confirmed against the interned name, since a caller-owned string can
+ * be freed and its address reused for another file: by address when the
+ * caller passes the interned copy itself, by content otherwise.
+ */
+#define PTR_SLOTS 4096 /* power of two */
+#define PTR_PROBES 16
+
+/* Interned names are copied here, so they outlive the caller's string. */
+#define NAME_POOL_SIZE (64 * 1024)
+
+/* (file, line, level) -> prefix; lookups are lock-free. */
+#define PREFIX_SLOTS 8192 /* power of two */
+#define PREFIX_PROBES 8
+#define PREFIX_MAX 256
+
+typedef struct ptr_slot {
+  _Atomic(const char *) key;
+  atomic_uint id; /* set before key is published; may be replaced later */
+} ptr_slot_t;
+
+typedef struct prefix_entry {
+  const char *file;
+  int line;
+  int level;
+  size_t len;
+  char text[];
+} prefix_entry_t;
+
+static ptr_slot_t g_ptrs[PTR_SLOTS];
+static const char *g_names[LOGGER_SRCLOC_MAX_FILES + 1]; /* [0] unused */
+static atomic_uint g_name_count = 0;
+static char g_name_pool[NAME_POOL_SIZE];
+static size_t g_name_pool_used = 0; /* under g_intern_mutex */
+static pthread_mutex_t g_intern_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static _Atomic(prefix_entry_t *) g_prefixes[PREFIX_SLOTS];
+
+static const char *LEVEL_NAMES[] = {"TRACE", "DEBUG", "INFO",
+                                    "WARN",  "ERROR", "FATAL"};
+#define LEVEL_COUNT (sizeof(LEVEL_NAMES) / sizeof(LEVEL_NAMES[0]))
+
+static inline size_t hash_ptr(const void *p) {
+  uint64_t x = (uint64_t)(uintptr_t)p;
+  return (size_t)((x >> 3) * 0x9E3779B97F4A7C15ull >> 40);
+}
+
+static const char *display_name(const char *file) {
+#ifdef LOGGER_STRIP_PATH
+  const char *base = file;
+  for (const char *p = file; *p; ++p) {
+    if (*p == '/' || *p == '\\')
+      base = p + 1;
+  }
+  return base;
+#else
+  return file;
+#endif
+}
+
+/* Interned names live in the pool, and nothing else does. */
+static inline int is_interned(const char *p) {
+  return p >= g_name_pool && p < g_name_pool + sizeof(g_name_pool);
+}
+
+/* Cached id of @p file's address, if it still names @p name. Lock-free. */
+static unsigned lookup(const char *file, const char *name) {
+  size_t h = hash_ptr(file);
+  for (size_t i = 0; i < PTR_PROBES; ++i) {
+    ptr_slot_t *s = &g_ptrs[(h + i) & (PTR_SLOTS - 1)];
+    const char *k = atomic_load_explicit(&s->key, memory_order_acquire);
+    if (!k)
+      break;
+    if (k == file) {
+      unsigned id = atomic_load_explicit(&s->id, memory_order_acquire);
+      const char *interned = g_names[id];
+      return interned == name || strcmp(interned, name) == 0 ? id : 0;
+    }
+  }
+  return 0;
+}
+
+static unsigned intern_slow(const char *file, const char *name) {
+  pthread_mutex_lock(&g_intern_mutex);
+
+  /* This address's slot (stale, or filled by a racing thread) or a free
+   * one to cache it in. */
+  size_t h = hash_ptr(file);
+  ptr_slot_t *slot = NULL;
+  for (size_t i = 0; i < PTR_PROBES; ++i) {
+    ptr_slot_t *s = &g_ptrs[(h + i) & (PTR_SLOTS - 1)];
+    const char *k = atomic_load_explicit(&s->key, memory_order_relaxed);
+    if (!k || k == file) {
+      slot = s;
+      break;
+    }
+  }
+
+  /* Same path from another translation unit: reuse its id. */
+  unsigned n = atomic_load_explicit(&g_name_count, memory_order_relaxed);
+  unsigned id = 0;
+  for (unsigned i = 1; i <= n; ++i) {
+    if (strcmp(g_names[i], name) == 0) {
+      id = i;
+      break;
+    }
+  }
+  size_t len = strlen(name) + 1;
+  if (!id && n < LOGGER_SRCLOC_MAX_FILES &&
+      len <= sizeof(g_name_pool) - g_name_pool_used) {
+    char *copy = g_name_pool + g_name_pool_used;
+    memcpy(copy, name, len);
+    g_name_pool_used += len;
+    id = n + 1;
+    g_names[id] = copy;
+    atomic_store_explicit(&g_name_count, id, memory_order_release);
+  }
+
+  if (id && slot) {
+    atomic_store_explicit(&slot->id, id, memory_order_release);
+    atomic_store_explicit(&slot->key, file, memory_order_release);
+  }
+
+  pthread_mutex_unlock(&g_intern_mutex);
+  return id;
+}
+
+unsigned logger_srcloc_intern(const char *file) {
+  if (!file)
+    return 0;
+  const char *name = display_name(file);
+  unsigned id = lookup(file, name);
+  return id ? id : intern_slow(file, name);
+}
+
+const char *logger_srcloc_find(const char *file) {
+  if (!file)
+    return NULL;
+  if (is_interned(file))
+    return file;
+  unsigned id = lookup(file, display_name(file));
+  return id ? g_names[id] : NULL;
+}
+
+const char *logger_srcloc_name(unsigned id) {
+  if (id == 0 || id > atomic_load_explicit(&g_name_count, memory_order_acquire))
+    return NULL;
+  return g_names[id];
+}
+
+const char *logger_srcloc_canonical(const char *file) {
+  if (!file || is_interned(file))
+    return file;
+  const char *name = logger_srcloc_name(logger_srcloc_intern(file));
+  return name ? name : file;
+}
+
+static prefix_entry_t *prefix_build(logger_level_t level, const char *file,
+                                    int line) {
+  char tmp[PREFIX_MAX];
+  const char *lvl = (unsigned)level < LEVEL_COUNT ? LEVEL_NAMES[level]
+                                                 : "UNKNOWN";
+  int n = snprintf(tmp, sizeof(tmp), "[%s] %s:%d | ", lvl, file ? file : "",
+                   line);
+  if (n < 0 || (size_t)n >= sizeof(tmp))
+    return NULL;
+
+  prefix_entry_t *e =
+      (prefix_entry_t *)logger_arena_alloc(sizeof(*e) + (size_t)n + 1);
+  if (!e)
+    return NULL;
+  e->file = file;
+  e->line = line;
+  e->level = (int)level;
+  e->len = (size_t)n;
+  memcpy(e->text, tmp, (size_t)n + 1);
+  return e;
+}
+
+const char *logger_srcloc_prefix(logger_level_t level, const char *file,
+                                 int line, size_t *len) {
+  /* keyed by address: only names that are never freed or reused */
+  if (!is_interned(file))
+    return NULL;
+
+  size_t h = hash_ptr(file) ^ ((size_t)line * 0x85EBCA6Bu) ^ (size_t)level;
+  prefix_entry_t *mine = NULL;
+
+  for (size_t i = 0; i < PREFIX_PROBES; ++i) {
+    _Atomic(prefix_entry_t *) *slot = &g_prefixes[(h + i) & (PREFIX_SLOTS - 1)];
+    prefix_entry_t *e = atomic_load_explicit(slot, memory_order_acquire);
+
+    if (!e) {
+      if (!mine && !(mine = prefix_build(level, file, line)))
+        return NULL;
+      if (atomic_compare_exchange_strong_explicit(slot, &e, mine,
+                                                  memory_order_acq_rel,
+                                                  memory_order_acquire)) {
+        *len = mine->len;
+        return mine->text;
+      }
+      /* lost the race: e now holds the winner, check it below */
+    }
+
+    if (e->file == file && e->line == line && e->level == (int)level) {
+      if (mine)
+        logger_arena_free(mine, sizeof(*mine) + mine->len + 1);
+      *len = e->len;
+      return e->text;
+    }
+  }
+
+  if (mine)
+    logger_arena_free(mine, sizeof(*mine) + mine->len + 1);
+  return NULL;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file srcloc.h
+ * @brief Internal source-location interning and cached line prefixes.
+ *
+ * File paths are interned to small ids on first use; the name is copied, so
+ * the caller's string may be freed or reused afterwards. logger_log() maps
+ * every incoming file pointer to its canonical interned name, so downstream
+ * code
+ * (records, backends, the prefix cache) can key on the pointer or carry the
+ * 32-bit id instead of the string. When the library is built with
+ * LOGGER_STRIP_PATH the interned name is the basename, which also covers
+ * compilers without __FILE_NAME__ (see LOGGER_FILE in logger.h).
+ *
+ * The "[LEVEL] file:line | " prefix of the text backends is rendered once
+ * per (file, line, level) and cached, so emitting a line is a copy.
+ */
+#ifndef LOGGER_SRCLOC_H
+#define LOGGER_SRCLOC_H
+
+#include "logger.h"
+#include <stddef.h>
+
+/** Maximum number of distinct interned files. */
+#define LOGGER_SRCLOC_MAX_FILES 1024
+
+/**
+ * @brief Returns the id of @p file, interning it on first use.
+ *
+ * The address of @p file is cached, and a cached id is only used while its
+ * name still matches, so @p file need not outlive the call.
+ * @return Id > 0, or 0 if @p file is NULL or the table (or its name pool)
+ *         is full.
+ */
+unsigned logger_srcloc_intern(const char *file);
+
+/**
+ * @brief Canonical name for @p file if it is already interned, else NULL.
+ *
+ * Never takes a lock or allocates, so real-time callers can use it.
+ */
+const char *logger_srcloc_find(const char *file);
+
+/**
+ * @brief Canonical name of an interned file id, or NULL for id 0/unknown.
+ */
+const char *logger_srcloc_name(unsigned id);
+
+/**
+ * @brief Canonical name for @p file (interned, possibly stripped).
+ *
+ * Falls back to @p file itself when it cannot be interned.
+ */
+const char *logger_srcloc_canonical(const char *file);
+
+/**
+ * @brief Cached "[LEVEL] file:line | " prefix for a call site.
+ *
+ * Entries are keyed by the @p file pointer, so only canonical names
+ * (logger_srcloc_canonical()) are cached.
+ *
+ * @param len Receives the prefix length.
+ * @return The NUL-terminated prefix, or NULL if @p file is not canonical or
+ *         the prefix could not be cached; the caller then renders it itself.
+ */
+const char *logger_srcloc_prefix(logger_level_t level, const char *file,
+                                 int line, size_t *len);
+
+#endif
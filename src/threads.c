@@ -0,0 +1,212 @@
+#define _GNU_SOURCE /* sched_setaffinity, pthread_setname_np, syscall */
+
+#include "threads.h"
+#include "arena.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+typedef struct bg_thread {
+  unsigned long tid;
+  struct bg_thread *next;
+} bg_thread_t;
+
+/* Registered threads and scheduling options, under the lock. */
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static bg_thread_t *g_threads = NULL;
+static logger_sched_t g_sched = LOGGER_SCHED_INHERIT;
+static int g_priority = 0;
+static char g_cpu_list[256]; /* as given, for logger_get_thread_options() */
+
+/* Read by polling threads on every idle pass. */
+static atomic_int g_wait = LOGGER_WAIT_SLEEP;
+static atomic_uint g_idle_us = 0;
+#ifdef __linux__
+static cpu_set_t g_cpus;
+static int g_has_cpus = 0;
+#endif
+
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_key;
+
+static unsigned long self_tid(void) {
+#ifdef __linux__
+  return (unsigned long)syscall(SYS_gettid);
+#else
+  return (unsigned long)pthread_self();
+#endif
+}
+
+#ifdef __linux__
+/* "0-3,6" -> set; 0 on a syntax error or an empty set. */
+static int parse_cpus(const char *s, cpu_set_t *out) {
+  CPU_ZERO(out);
+  while (*s) {
+    char *end;
+    unsigned long lo = strtoul(s, &end, 10), hi = lo;
+    if (end == s)
+      return 0;
+    s = end;
+    if (*s == '-') {
+      hi = strtoul(++s, &end, 10);
+      if (end == s || hi < lo)
+        return 0;
+      s = end;
+    }
+    if (hi >= CPU_SETSIZE)
+      return 0;
+    for (unsigned long c = lo; c <= hi; ++c)
+      CPU_SET(c, out);
+    if (*s == ',')
+      ++s;
+    else if (*s)
+      return 0;
+  }
+  return CPU_COUNT(out) > 0;
+}
+
+static int sched_policy(logger_sched_t s) {
+  switch (s) {
+  case LOGGER_SCHED_BATCH:
+    return SCHED_BATCH;
+  case LOGGER_SCHED_IDLE:
+    return SCHED_IDLE;
+  case LOGGER_SCHED_FIFO:
+    return SCHED_FIFO;
+  case LOGGER_SCHED_RR:
+    return SCHED_RR;
+  default:
+    return SCHED_OTHER;
+  }
+}
+#endif
+
+/* Applies the current options to @p tid; g_lock held. 0 on failure. */
+static int apply_locked(unsigned long tid) {
+#ifdef __linux__
+  pid_t t = (pid_t)tid;
+  int ok = 1;
+  if (g_has_cpus)
+    ok = sched_setaffinity(t, sizeof(g_cpus), &g_cpus) == 0;
+  if (g_sched != LOGGER_SCHED_INHERIT) {
+    int policy = sched_policy(g_sched);
+    struct sched_param sp = {0};
+    int rt = policy == SCHED_FIFO || policy == SCHED_RR;
+    if (rt)
+      sp.sched_priority = g_priority;
+    ok = sched_setscheduler(t, policy, &sp) == 0 && ok;
+    /* per-thread nice value for the time-sharing policies */
+    if (!rt && policy != SCHED_IDLE)
+      ok = setpriority(PRIO_PROCESS, (id_t)t, g_priority) == 0 && ok;
+  }
+  return ok;
+#else
+  (void)tid;
+  return g_sched == LOGGER_SCHED_INHERIT;
+#endif
+}
+
+static void unregister(void *arg) {
+  bg_thread_t *self = (bg_thread_t *)arg;
+  pthread_mutex_lock(&g_lock);
+  for (bg_thread_t **pp = &g_threads; *pp; pp = &(*pp)->next) {
+    if (*pp == self) {
+      *pp = self->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&g_lock);
+  logger_arena_free(self, sizeof(*self));
+}
+
+static void make_key(void) { pthread_key_create(&g_key, unregister); }
+
+static void add(unsigned long tid, int owned) {
+  bg_thread_t *t = (bg_thread_t *)logger_arena_alloc(sizeof(*t));
+  pthread_mutex_lock(&g_lock);
+  apply_locked(tid); /* best effort; reported by logger_set_thread_options */
+  if (t) {
+    t->tid = tid;
+    t->next = g_threads;
+    g_threads = t;
+  }
+  pthread_mutex_unlock(&g_lock);
+  if (t && owned) {
+    pthread_once(&g_key_once, make_key);
+    pthread_setspecific(g_key, t);
+  }
+}
+
+void logger_thread_started(const char *name) {
+#if defined(__linux__) && defined(__GLIBC__)
+  pthread_setname_np(pthread_self(), name);
+#else
+  (void)name;
+#endif
+  add(self_tid(), 1);
+}
+
+void logger_thread_adopt(unsigned long tid) {
+  if (tid)
+    add(tid, 0);
+}
+
+logger_wait_t logger_thread_wait(unsigned *idle_us) {
+  *idle_us = atomic_load_explicit(&g_idle_us, memory_order_relaxed);
+  return (logger_wait_t)atomic_load_explicit(&g_wait, memory_order_relaxed);
+}
+
+logger_status_t logger_set_thread_options(const logger_thread_options_t *opt) {
+  if (!opt || (unsigned)opt->wait > LOGGER_WAIT_SPIN ||
+      (unsigned)opt->sched > LOGGER_SCHED_RR)
+    return LOGGER_UNKOWN_ERROR;
+
+#ifdef __linux__
+  cpu_set_t cpus;
+  int has_cpus = opt->cpus && opt->cpus[0];
+  if (has_cpus && !parse_cpus(opt->cpus, &cpus))
+    return LOGGER_UNKOWN_ERROR;
+#else
+  if ((opt->cpus && opt->cpus[0]) || opt->sched != LOGGER_SCHED_INHERIT)
+    return LOGGER_UNKOWN_ERROR;
+#endif
+
+  pthread_mutex_lock(&g_lock);
+#ifdef __linux__
+  g_has_cpus = has_cpus;
+  if (has_cpus)
+    g_cpus = cpus;
+#endif
+  snprintf(g_cpu_list, sizeof(g_cpu_list), "%s", opt->cpus ? opt->cpus : "");
+  g_sched = opt->sched;
+  g_priority = opt->priority;
+  atomic_store_explicit(&g_wait, (int)opt->wait, memory_order_relaxed);
+  atomic_store_explicit(&g_idle_us, opt->idle_us, memory_order_relaxed);
+
+  int ok = 1;
+  for (bg_thread_t *t = g_threads; t; t = t->next)
+    ok = apply_locked(t->tid) && ok;
+  pthread_mutex_unlock(&g_lock);
+
+  return ok ? LOGGER_OK : LOGGER_UNKOWN_ERROR;
+}
+
+logger_status_t logger_get_thread_options(logger_thread_options_t *out) {
+  if (!out)
+    return LOGGER_UNKOWN_ERROR;
+  pthread_mutex_lock(&g_lock);
+  out->cpus = g_cpu_list;
+  out->sched = g_sched;
+  out->priority = g_priority;
+  pthread_mutex_unlock(&g_lock);
+  out->wait = logger_thread_wait(&out->idle_us);
+  return LOGGER_OK;
+}
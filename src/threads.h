@@ -0,0 +1,61 @@
+/**
+ * @file threads.h
+ * @brief Internal registry of the logger's background threads.
+ *
+ * Every thread the logger starts (async consumer, file writer, journald
+ * sender, queue adapters, flusher, config watcher, timer sweeper, dedup
+ * window timer, prewarm) calls logger_thread_started() first. That names
+ * it, applies the options of logger_set_thread_options() and registers it
+ * until it exits, so later changes reach running threads too. Threads
+ * started by a library (Quill's backend) are registered by kernel id with
+ * logger_thread_adopt().
+ *
+ * The wait strategy only changes threads that poll (the async/real-time
+ * consumer, Quill's backend); the others block on condition variables that
+ * producers signal.
+ */
+#ifndef LOGGER_THREADS_H
+#define LOGGER_THREADS_H
+
+#include "logger.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Names the calling thread and applies the thread options.
+ *
+ * @param name Short name ("log-file"); shown by ps/top (15 bytes max).
+ */
+void logger_thread_started(const char *name);
+
+/**
+ * @brief Registers a thread started outside the logger by its kernel id.
+ *
+ * Affinity and scheduling are applied now and on later changes. The thread
+ * must outlive the process's use of the logger.
+ */
+void logger_thread_adopt(unsigned long tid);
+
+/**
+ * @brief Wait strategy of polling threads.
+ *
+ * @param idle_us Receives the SLEEP poll period, 0 for the thread's default.
+ */
+logger_wait_t logger_thread_wait(unsigned *idle_us);
+
+/** One step of a busy-wait loop. */
+static inline void logger_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
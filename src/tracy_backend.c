@@ -1,4 +1,9 @@
 #include "tracy_backend.h"
+#include "arena.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -6,60 +11,185 @@
 #include "tracy/TracyC.h"
 #endif
 
+/* Metrics are plotted once every PLOT_EVERY messages. */
+#define PLOT_EVERY 64u
+
+/* Longest message forwarded to Tracy (prefix included); longer is cut. */
+#define TRACY_MSG_MAX 2300
+
 typedef struct tracy_ctx {
   int enabled;
+  logger_handle_t *owner; /* metrics source, may be NULL */
+  const char *plot_logged;
+  const char *plot_filtered;
+  const char *plot_dropped;
+  atomic_uint since_plot;
 } tracy_ctx_t;
 
+static const char *lvl_to_str(logger_level_t lvl) {
+  switch (lvl) {
+  case LOGGER_LEVEL_TRACE:
+    return "TRACE";
+  case LOGGER_LEVEL_DEBUG:
+    return "DEBUG";
+  case LOGGER_LEVEL_INFO:
+    return "INFO";
+  case LOGGER_LEVEL_WARN:
+    return "WARN";
+  case LOGGER_LEVEL_ERROR:
+    return "ERROR";
+  case LOGGER_LEVEL_FATAL:
+    return "FATAL";
+  default:
+    return "UNKNOWN";
+  }
+}
+
+/* 0xRRGGBB message colors shown in the Tracy UI. */
+static uint32_t lvl_to_color(logger_level_t lvl) {
+  switch (lvl) {
+  case LOGGER_LEVEL_TRACE:
+    return 0x808080;
+  case LOGGER_LEVEL_DEBUG:
+    return 0x4FC3F7;
+  case LOGGER_LEVEL_INFO:
+    return 0xE0E0E0;
+  case LOGGER_LEVEL_WARN:
+    return 0xFFC107;
+  case LOGGER_LEVEL_ERROR:
+    return 0xFF5252;
+  case LOGGER_LEVEL_FATAL:
+    return 0xE040FB;
+  default:
+    return 0xE0E0E0;
+  }
+}
+
+/*
+ * Tracy keeps plot names by pointer for the whole profiling session, so
+ * per-logger names are interned once and never freed.
+ */
+typedef struct plot_name {
+  struct plot_name *next;
+  char name[];
+} plot_name_t;
+
+static pthread_mutex_t g_plot_mutex = PTHREAD_MUTEX_INITIALIZER;
+static plot_name_t *g_plot_names = NULL;
+
+static const char *intern_plot_name(const char *logger, const char *metric) {
+  char buf[160];
+  snprintf(buf, sizeof(buf), "logger.%s.%s", logger ? logger : "default",
+           metric);
+
+  pthread_mutex_lock(&g_plot_mutex);
+  for (plot_name_t *it = g_plot_names; it; it = it->next) {
+    if (strcmp(it->name, buf) == 0) {
+      pthread_mutex_unlock(&g_plot_mutex);
+      return it->name;
+    }
+  }
+  size_t len = strlen(buf) + 1;
+  plot_name_t *p = (plot_name_t *)malloc(sizeof(*p) + len);
+  if (!p) {
+    pthread_mutex_unlock(&g_plot_mutex);
+    return NULL;
+  }
+  memcpy(p->name, buf, len);
+  p->next = g_plot_names;
+  g_plot_names = p;
+  pthread_mutex_unlock(&g_plot_mutex);
+  return p->name;
+}
+
+static void plot_metrics(tracy_ctx_t *ctx) {
+  logger_stats_t st;
+  if (!ctx->owner || logger_get_stats_h(ctx->owner, &st) != LOGGER_OK)
+    return;
+#ifdef TRACY_ENABLE
+  if (ctx->plot_logged)
+    TracyCPlot(ctx->plot_logged, (double)st.logged);
+  if (ctx->plot_filtered)
+    TracyCPlot(ctx->plot_filtered, (double)st.filtered);
+  if (ctx->plot_dropped)
+    TracyCPlot(ctx->plot_dropped, (double)st.dropped);
+#endif
+}
+
 static logger_status_t t_start(logger_backend_t *self) {
   (void)self;
   return LOGGER_OK;
 }
 
 static logger_status_t t_stop(logger_backend_t *self) {
-  (void)self;
+  tracy_ctx_t *ctx = (tracy_ctx_t *)self->ctx;
+  if (ctx && ctx->enabled)
+    plot_metrics(ctx);
   return LOGGER_OK;
 }
 
 static void t_log(logger_backend_t *self, logger_level_t level,
                   const char *file, int line, const char *msg) {
-  (void)level;
-  (void)file;
-  (void)line;
-
   tracy_ctx_t *ctx = (tracy_ctx_t *)self->ctx;
   if (!ctx || !ctx->enabled)
     return;
 
+  /* Stack buffer: Tracy copies the text, nothing is allocated here. */
+  const logger_record_meta_t *meta = logger_backend_current_record();
+  size_t flen;
+  const char *fields = logger_ctx_text(meta->ctx, meta->thread, &flen);
+
+  char buf[TRACY_MSG_MAX];
+  int n = snprintf(buf, sizeof(buf), "[%s] %s:%d | %s%s%s", lvl_to_str(level),
+                   file ? file : "", line, fields, flen ? " | " : "",
+                   msg ? msg : "");
+  if (n < 0)
+    return;
+  size_t len = (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1;
+
 #ifdef TRACY_ENABLE
-  /* Enviar mensaje a Tracy (live) */
-  TracyCMessage(msg, (uint16_t)strlen(msg));
+  TracyCMessageC(buf, len, lvl_to_color(level));
 #else
-  (void)msg;
+  (void)len;
+  (void)lvl_to_color;
 #endif
+
+  if (atomic_fetch_add_explicit(&ctx->since_plot, 1, memory_order_relaxed) %
+          PLOT_EVERY ==
+      0)
+    plot_metrics(ctx);
 }
 
 static void t_destroy(logger_backend_t *self) {
   if (!self)
     return;
-  free(self->ctx);
-  free(self);
+  logger_arena_free(self->ctx, sizeof(tracy_ctx_t));
+  logger_arena_free(self, sizeof(*self));
 }
 
 static const logger_backend_vtbl_t V = {
     .start = t_start, .stop = t_stop, .log = t_log, .destroy = t_destroy};
 
-logger_backend_t *logger_backend_tracy_create(void) {
-  logger_backend_t *b = (logger_backend_t *)calloc(1, sizeof(*b));
+logger_backend_t *logger_backend_tracy_create(logger_handle_t *owner) {
+  logger_backend_t *b = (logger_backend_t *)logger_arena_alloc(sizeof(*b));
   if (!b)
     return NULL;
 
-  tracy_ctx_t *ctx = (tracy_ctx_t *)calloc(1, sizeof(*ctx));
+  tracy_ctx_t *ctx = (tracy_ctx_t *)logger_arena_alloc(sizeof(*ctx));
   if (!ctx) {
-    free(b);
+    logger_arena_free(b, sizeof(*b));
     return NULL;
   }
 
   ctx->enabled = 1;
+  ctx->owner = owner;
+  if (owner) {
+    const char *name = logger_name(owner);
+    ctx->plot_logged = intern_plot_name(name, "logged");
+    ctx->plot_filtered = intern_plot_name(name, "filtered");
+    ctx->plot_dropped = intern_plot_name(name, "dropped");
+  }
+  atomic_init(&ctx->since_plot, 0);
 
   b->vtbl = &V;
   b->ctx = ctx;
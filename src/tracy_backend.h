@@ -8,6 +8,11 @@
  *
  * Behavior:
  * - Messages are visible in Tracy UI (not printed to stdout by this backend).
+ * - Messages carry the source location ("[LEVEL] file:line | msg") and are
+ *   colored per level (TracyCMessageC). They are built in a stack buffer;
+ *   the backend never allocates per message.
+ * - The owning logger's counters are plotted as "logger.<name>.logged",
+ *   ".filtered" and ".dropped" (TracyCPlot) every 64 messages and on stop.
  *
  * Ownership:
  * - Returned backend must be destroyed via vtbl->destroy().
@@ -23,6 +28,8 @@
  * This backend forwards log messages to the Tracy profiler UI.
  * Messages sent through this backend are not printed to stdout or stderr.
  *
+ * @param owner Logger whose counters are plotted (may be NULL: no plots).
+ *
  * @return Pointer to a logger_backend_t instance on success.
  *         Returns NULL if allocation fails or if Tracy support is not
  * available.
@@ -30,6 +37,6 @@
  * @note This backend is only functional when compiled with TRACY_ENABLE
  *       and when the application links TracyClient.cpp.
  */
-logger_backend_t *logger_backend_tracy_create(void);
+logger_backend_t *logger_backend_tracy_create(logger_handle_t *owner);
 
 #endif
@@ -0,0 +1,295 @@
+/*
+ * Arena (arena.h) and record pool (record.h):
+ * - arena blocks are zeroed, cache-line aligned and disjoint for every size
+ *   class and above the largest; a freed block is handed out again, zeroed,
+ *   to the next request of its class and not to another class; threads
+ *   allocating and freeing at once never see each other's bytes;
+ * - records released by their owner are reused first; records released by
+ *   other threads go back to the owner's cache and are reused before a new
+ *   slab; a record producer/consumer pair stays within a few slabs;
+ * - the cache of an exited thread, and records released to it afterwards,
+ *   are adopted by the next new thread instead of new slabs.
+ */
+#define _GNU_SOURCE /* mkdtemp */
+
+#include "arena.h"
+#include "harness.h"
+#include "record.h"
+#include <pthread.h>
+#include <stdint.h>
+
+#define CACHE_LINE 64
+#define BATCH (2 * LOGGER_RECORD_SLAB)
+#define THREADS 4
+#define ROUNDS 2000
+#define LIVE 16
+#define PINGS 20000
+#define RING 64
+
+static int zeroed(const void *p, size_t n) {
+  const unsigned char *b = (const unsigned char *)p;
+  for (size_t i = 0; i < n; ++i)
+    if (b[i])
+      return 0;
+  return 1;
+}
+
+static int aligned(const void *p) { return (uintptr_t)p % CACHE_LINE == 0; }
+
+static void arena_classes(void) {
+  static const size_t sizes[] = {1, 64, 65, 128, 500, 1024, 4096, 10000};
+  enum { N = sizeof(sizes) / sizeof(sizes[0]) };
+  unsigned char *p[N];
+  for (int i = 0; i < N; ++i) {
+    p[i] = (unsigned char *)logger_arena_alloc(sizes[i]);
+    CHECKF(p[i] && aligned(p[i]) && zeroed(p[i], sizes[i]),
+           "%zu bytes: %p", sizes[i], (void *)p[i]);
+    if (p[i])
+      memset(p[i], 0xab, sizes[i]);
+  }
+  int overlaps = 0;
+  for (int i = 0; i < N; ++i)
+    for (int j = 0; j < N; ++j)
+      overlaps += i != j && p[i] && p[j] && p[i] < p[j] + sizes[j] &&
+                  p[j] < p[i] + sizes[i];
+  CHECKF(overlaps == 0, "%d overlapping blocks", overlaps / 2);
+
+  /* 65 bytes is the 128-byte class: reused by 100, not by 64 */
+  unsigned char *again = (unsigned char *)logger_arena_alloc(100);
+  CHECK(again != p[2]);
+  logger_arena_free(p[2], sizes[2]);
+  unsigned char *other = (unsigned char *)logger_arena_alloc(64);
+  CHECK(other != p[2]);
+  unsigned char *reused = (unsigned char *)logger_arena_alloc(100);
+  CHECKF(reused == p[2], "freed 128-byte block not reused");
+  CHECK(reused && zeroed(reused, 128));
+  p[2] = reused;
+
+  for (int i = 0; i < N; ++i)
+    logger_arena_free(p[i], i == 2 ? 100 : sizes[i]);
+  logger_arena_free(again, 100);
+  logger_arena_free(other, 64);
+  logger_arena_free(NULL, 64);
+}
+
+static void *arena_churn(void *arg) {
+  unsigned id = (unsigned)(uintptr_t)arg;
+  unsigned char *live[LIVE] = {0};
+  size_t size[LIVE] = {0};
+  unsigned seed = id * 2654435761u + 1;
+  long bad = 0;
+  for (int r = 0; r < ROUNDS; ++r) {
+    int k = r % LIVE;
+    if (live[k]) {
+      for (size_t i = 0; i < size[k]; ++i)
+        bad += live[k][i] != (unsigned char)id;
+      logger_arena_free(live[k], size[k]);
+    }
+    seed = seed * 1103515245u + 12345u;
+    size[k] = 1 + (seed >> 8) % 4096;
+    live[k] = (unsigned char *)logger_arena_alloc(size[k]);
+    if (!live[k] || !zeroed(live[k], size[k]))
+      ++bad;
+    else
+      memset(live[k], (int)id, size[k]);
+  }
+  for (int k = 0; k < LIVE; ++k)
+    logger_arena_free(live[k], size[k]);
+  return (void *)bad;
+}
+
+static void arena_threads(void) {
+  pthread_t t[THREADS];
+  for (uintptr_t i = 0; i < THREADS; ++i)
+    CHECK(pthread_create(&t[i], NULL, arena_churn, (void *)(i + 1)) == 0);
+  long bad = 0;
+  for (int i = 0; i < THREADS; ++i) {
+    void *r;
+    pthread_join(t[i], &r);
+    bad += (long)r;
+  }
+  CHECKF(bad == 0, "%ld bytes or blocks corrupted", bad);
+}
+
+/* ---- record pool ---- */
+
+typedef struct batch {
+  logger_record_t *r[BATCH];
+  int n;
+} batch_t;
+
+static void acquire_batch(batch_t *b) {
+  for (b->n = 0; b->n < BATCH; ++b->n) {
+    b->r[b->n] = logger_record_acquire();
+    if (!b->r[b->n])
+      break;
+  }
+  CHECK(b->n == BATCH);
+}
+
+static void release_batch(const batch_t *b, int from, int to) {
+  for (int i = from; i < to; ++i)
+    logger_record_release(b->r[i]);
+}
+
+/* Records of @p b found in @p set. */
+static int found(const batch_t *b, const batch_t *set) {
+  int n = 0;
+  for (int i = 0; i < b->n; ++i)
+    for (int j = 0; j < set->n; ++j)
+      if (b->r[i] == set->r[j]) {
+        ++n;
+        break;
+      }
+  return n;
+}
+
+static batch_t g_first, g_handed;
+
+/* Fresh process: takes two slabs, gives all back, exits. */
+static void *first_owner(void *arg) {
+  (void)arg;
+  acquire_batch(&g_first);
+  release_batch(&g_first, 0, g_first.n);
+  return NULL;
+}
+
+/* Adopts the parked cache; keeps 8 records in flight past its exit. */
+static void *second_owner(void *arg) {
+  batch_t *b = (batch_t *)arg;
+  acquire_batch(b);
+  g_handed.n = 8;
+  memcpy(g_handed.r, b->r, sizeof(b->r[0]) * 8);
+  release_batch(b, 8, b->n);
+  return NULL;
+}
+
+static void *third_owner(void *arg) {
+  acquire_batch((batch_t *)arg);
+  release_batch((batch_t *)arg, 0, ((batch_t *)arg)->n);
+  return NULL;
+}
+
+static void parked_caches(void) {
+  pthread_t t;
+  CHECK(pthread_create(&t, NULL, first_owner, NULL) == 0);
+  pthread_join(t, NULL);
+
+  batch_t second, third;
+  CHECK(pthread_create(&t, NULL, second_owner, &second) == 0);
+  pthread_join(t, NULL);
+  CHECKF(found(&second, &g_first) == BATCH,
+         "new thread: %d of %d records from the parked cache",
+         found(&second, &g_first), BATCH);
+
+  /* released after their owner exited: back to the parked cache */
+  release_batch(&g_handed, 0, g_handed.n);
+  CHECK(pthread_create(&t, NULL, third_owner, &third) == 0);
+  pthread_join(t, NULL);
+  CHECKF(found(&third, &g_first) == BATCH,
+         "after in-flight release: %d of %d records reused",
+         found(&third, &g_first), BATCH);
+}
+
+static void *release_all(void *arg) {
+  const batch_t *b = (const batch_t *)arg;
+  release_batch(b, 0, b->n);
+  return NULL;
+}
+
+static void owner_reuse(void) {
+  batch_t a, b;
+  acquire_batch(&a);
+  release_batch(&a, 0, a.n);
+  acquire_batch(&b);
+  CHECKF(found(&b, &a) == BATCH, "local release: %d of %d reused",
+         found(&b, &a), BATCH);
+
+  /* several threads give the owner's records back at once */
+  pthread_t t[THREADS];
+  batch_t part[THREADS];
+  for (int i = 0; i < THREADS; ++i) {
+    part[i].n = BATCH / THREADS;
+    memcpy(part[i].r, b.r + i * part[i].n, sizeof(b.r[0]) * part[i].n);
+    CHECK(pthread_create(&t[i], NULL, release_all, &part[i]) == 0);
+  }
+  for (int i = 0; i < THREADS; ++i)
+    pthread_join(t[i], NULL);
+  acquire_batch(&a);
+  CHECKF(found(&a, &b) == BATCH, "remote release: %d of %d reused",
+         found(&a, &b), BATCH);
+  release_batch(&a, 0, a.n);
+}
+
+/* Producer -> consumer ring; the consumer releases what it takes. */
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cv = PTHREAD_COND_INITIALIZER;
+static logger_record_t *g_ring[RING];
+static int g_head = 0, g_tail = 0, g_done = 0;
+static long g_mismatch = 0;
+
+static void *consumer(void *arg) {
+  (void)arg;
+  for (;;) {
+    pthread_mutex_lock(&g_lock);
+    while (g_head == g_tail && !g_done)
+      pthread_cond_wait(&g_cv, &g_lock);
+    if (g_head == g_tail) {
+      pthread_mutex_unlock(&g_lock);
+      return NULL;
+    }
+    logger_record_t *r = g_ring[g_tail++ % RING];
+    pthread_cond_broadcast(&g_cv);
+    pthread_mutex_unlock(&g_lock);
+    int n;
+    g_mismatch += sscanf(r->msg, "ping %d", &n) != 1 || r->line != n;
+    logger_record_release(r);
+  }
+}
+
+static void ping_pong(void) {
+  enum { SEEN_MAX = 1024 };
+  static logger_record_t *seen[SEEN_MAX];
+  int distinct = 0;
+  pthread_t t;
+  CHECK(pthread_create(&t, NULL, consumer, NULL) == 0);
+  for (int i = 0; i < PINGS; ++i) {
+    logger_record_t *r = logger_record_acquire();
+    CHECK(r != NULL);
+    if (!r)
+      break;
+    int known = 0;
+    for (int k = 0; k < distinct && !known; ++k)
+      known = seen[k] == r;
+    if (!known && distinct < SEEN_MAX)
+      seen[distinct++] = r;
+    r->line = i;
+    r->len = (size_t)snprintf(r->msg, sizeof(r->msg), "ping %d", i);
+    pthread_mutex_lock(&g_lock);
+    while (g_head - g_tail == RING)
+      pthread_cond_wait(&g_cv, &g_lock);
+    g_ring[g_head++ % RING] = r;
+    pthread_cond_signal(&g_cv);
+    pthread_mutex_unlock(&g_lock);
+  }
+  pthread_mutex_lock(&g_lock);
+  g_done = 1;
+  pthread_cond_broadcast(&g_cv);
+  pthread_mutex_unlock(&g_lock);
+  pthread_join(t, NULL);
+  CHECK(g_mismatch == 0);
+  /* the ring, one record on each side, and the slabs they were cut from */
+  int bound = (RING + 2 + 2 * LOGGER_RECORD_SLAB) / LOGGER_RECORD_SLAB *
+              LOGGER_RECORD_SLAB;
+  CHECKF(distinct <= bound, "%d distinct records for %d messages, want <= %d",
+         distinct, PINGS, bound);
+}
+
+int main(void) {
+  parked_caches(); /* first: no thread has parked a cache yet */
+  arena_classes();
+  arena_threads();
+  owner_reuse();
+  ping_pong();
+  return harness_result("arena_test");
+}
@@ -0,0 +1,344 @@
+/*
+ * Registered backends (logger_register_backend()), one per delivery path:
+ * - THREAD_SAFE: log() is called by the logging thread, within the call;
+ * - THREAD_SAFE | RAW_ARGS: log_raw() gets the format and its arguments;
+ * - BATCH: log_batch() gets the records in order, an ERROR record without
+ *   waiting for a flush;
+ * - no flags: the queue adapter calls log() from its own thread, one call
+ *   at a time, in order;
+ * - the queue adapter itself: a file name the caller overwrites (or a long
+ *   one) right after log() is delivered as it was, an interned one as the
+ *   canonical pointer;
+ * - backends registered and unregistered while threads log: every one
+ *   created is destroyed, and none is called after that (ASan/TSan).
+ */
+#define _GNU_SOURCE /* mkdtemp, usleep */
+
+#include "backend.h"
+#include "harness.h"
+#include "queue_backend.h"
+#include "srcloc.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define RECORDS 200
+#define PRODUCERS 4
+
+typedef struct sink {
+  pthread_mutex_t lock;
+  int n;                  /* records delivered */
+  int batches;            /* log_batch() calls */
+  int raw;                /* log_raw() calls */
+  int out_of_order;       /* "n=<i>" not following its predecessor */
+  int on_caller;          /* log() calls on the logging thread */
+  atomic_int overlap;     /* log() entered while another call was running */
+  atomic_int busy;
+  pthread_t caller;       /* the thread that logs */
+  char file[400];         /* of the last record */
+  const char *file_ptr;
+  int line;
+  logger_level_t level;
+  char msg[256];
+  atomic_int created, destroyed;
+} sink_t;
+
+static void sink_init(sink_t *s) {
+  memset(s, 0, sizeof(*s));
+  pthread_mutex_init(&s->lock, NULL);
+  s->caller = pthread_self();
+}
+
+static void sink_record(sink_t *s, logger_level_t lvl, const char *file,
+                        int line, const char *msg) {
+  int i;
+  if (sscanf(msg, "n=%d", &i) == 1 && i != s->n)
+    ++s->out_of_order;
+  ++s->n;
+  s->level = lvl;
+  s->line = line;
+  s->file_ptr = file;
+  snprintf(s->file, sizeof(s->file), "%s", file ? file : "(null)");
+  snprintf(s->msg, sizeof(s->msg), "%s", msg);
+}
+
+static logger_status_t cap_start(logger_backend_t *b) {
+  (void)b;
+  return LOGGER_OK;
+}
+
+static void cap_log(logger_backend_t *b, logger_level_t lvl, const char *file,
+                    int line, const char *msg) {
+  sink_t *s = (sink_t *)b->ctx;
+  if (atomic_fetch_add(&s->busy, 1))
+    atomic_fetch_add(&s->overlap, 1);
+  pthread_mutex_lock(&s->lock);
+  if (pthread_equal(pthread_self(), s->caller))
+    ++s->on_caller;
+  sink_record(s, lvl, file, line, msg);
+  pthread_mutex_unlock(&s->lock);
+  atomic_fetch_sub(&s->busy, 1);
+}
+
+static void cap_log_raw(logger_backend_t *b, logger_level_t lvl,
+                        const char *file, int line, const char *fmt,
+                        va_list args) {
+  sink_t *s = (sink_t *)b->ctx;
+  char msg[256];
+  vsnprintf(msg, sizeof(msg), fmt, args);
+  pthread_mutex_lock(&s->lock);
+  ++s->raw;
+  sink_record(s, lvl, file, line, msg);
+  pthread_mutex_unlock(&s->lock);
+}
+
+static void cap_log_batch(logger_backend_t *b,
+                          const logger_backend_record_t *r, size_t count) {
+  sink_t *s = (sink_t *)b->ctx;
+  pthread_mutex_lock(&s->lock);
+  ++s->batches;
+  for (size_t i = 0; i < count; ++i)
+    sink_record(s, r[i].level, r[i].file, r[i].line, r[i].msg);
+  pthread_mutex_unlock(&s->lock);
+}
+
+static void cap_destroy(logger_backend_t *b) {
+  atomic_fetch_add(&((sink_t *)b->ctx)->destroyed, 1);
+  free(b);
+}
+
+static const logger_backend_vtbl_t CAP_VTBL = {.start = cap_start,
+                                               .stop = cap_start,
+                                               .log = cap_log,
+                                               .destroy = cap_destroy,
+                                               .log_batch = cap_log_batch,
+                                               .log_raw = cap_log_raw};
+
+static logger_backend_t *cap_create(void *arg) {
+  logger_backend_t *b = (logger_backend_t *)calloc(1, sizeof(*b));
+  if (b) {
+    b->vtbl = &CAP_VTBL;
+    b->ctx = arg;
+    atomic_fetch_add(&((sink_t *)arg)->created, 1);
+  }
+  return b;
+}
+
+static void reg(const char *name, unsigned caps, sink_t *s) {
+  logger_backend_desc_t desc = {.name = name,
+                                .caps = caps,
+                                .min_level = LOGGER_LEVEL_TRACE,
+                                .create = cap_create,
+                                .arg = s};
+  CHECKF(logger_register_backend(&desc) == LOGGER_OK, "register %s", name);
+}
+
+static int delivered(sink_t *s) {
+  pthread_mutex_lock(&s->lock);
+  int n = s->n;
+  pthread_mutex_unlock(&s->lock);
+  return n;
+}
+
+static void direct_paths(void) {
+  sink_t plain, raw, batch, queued;
+  sink_init(&plain);
+  sink_init(&raw);
+  sink_init(&batch);
+  sink_init(&queued);
+
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  reg("plain", LOGGER_BACKEND_THREAD_SAFE, &plain);
+  reg("raw", LOGGER_BACKEND_THREAD_SAFE | LOGGER_BACKEND_RAW_ARGS, &raw);
+  CHECK(logger_start(LOGGER_LEVEL_TRACE) == LOGGER_OK);
+  /* registered after start: built right away */
+  reg("batch", LOGGER_BACKEND_BATCH, &batch);
+  reg("queued", 0, &queued);
+  logger_backend_desc_t dup = {.name = "queued", .create = cap_create,
+                               .arg = &queued};
+  CHECK(logger_register_backend(&dup) != LOGGER_OK);
+
+  /* thread-safe: within the call, on this thread */
+  logger_log(LOGGER_LEVEL_WARN, "backend_test.c", 42, "warn %d %s", 7, "x");
+  CHECK(plain.n == 1 && plain.level == LOGGER_LEVEL_WARN &&
+        plain.line == 42 && strcmp(plain.msg, "warn 7 x") == 0 &&
+        strcmp(plain.file, "backend_test.c") == 0);
+  CHECK(plain.on_caller == 1 && plain.raw == 0);
+  CHECK(raw.n == 1 && raw.raw == 1 && strcmp(raw.msg, "warn 7 x") == 0 &&
+        raw.line == 42 && strcmp(raw.file, "backend_test.c") == 0);
+
+  /* batches go out without a flush: after a few ms, at once for ERROR */
+  double t0 = harness_now();
+  while (delivered(&batch) < 1 && harness_now() - t0 < 2.0)
+    usleep(1000);
+  CHECKF(delivered(&batch) == 1, "batch: WARN not delivered in %.0f ms",
+         (harness_now() - t0) * 1e3);
+  logger_log(LOGGER_LEVEL_ERROR, "backend_test.c", 43, "n=%d", 1);
+  t0 = harness_now();
+  while (delivered(&batch) < 2 && harness_now() - t0 < 2.0)
+    usleep(1000);
+  CHECKF(delivered(&batch) == 2, "batch: ERROR not delivered in %.0f ms",
+         (harness_now() - t0) * 1e3);
+
+  for (int i = 2; i < RECORDS; ++i)
+    logger_log(LOGGER_LEVEL_INFO, "backend_test.c", 44, "n=%d", i);
+  CHECK(logger_flush() == LOGGER_OK);
+
+  CHECK(plain.n == RECORDS && plain.out_of_order == 0);
+  CHECK(raw.n == RECORDS && raw.raw == RECORDS);
+  CHECKF(batch.n == RECORDS && batch.out_of_order == 0,
+         "batch: %d records, %d out of order", batch.n, batch.out_of_order);
+  CHECKF(batch.batches > 1 && batch.batches < RECORDS,
+         "batch: %d log_batch() calls", batch.batches);
+  CHECKF(queued.n == RECORDS && queued.out_of_order == 0,
+         "queued: %d records, %d out of order", queued.n, queued.out_of_order);
+  CHECK(queued.on_caller == 0 && atomic_load(&queued.overlap) == 0);
+  CHECK(strcmp(queued.file, "backend_test.c") == 0 &&
+        strcmp(queued.msg, "n=199") == 0);
+
+  /* unregistered: destroyed at once, no longer called */
+  CHECK(logger_unregister_backend("queued") == LOGGER_OK);
+  CHECK(logger_unregister_backend("queued") == LOGGER_NO_EXIST);
+  CHECK(atomic_load(&queued.destroyed) == 1);
+  logger_log(LOGGER_LEVEL_INFO, "backend_test.c", 45, "after");
+  CHECK(plain.n == RECORDS + 1 && queued.n == RECORDS);
+
+  CHECK(logger_destroy() == LOGGER_OK);
+  CHECK(atomic_load(&plain.created) == 1 &&
+        atomic_load(&plain.destroyed) == 1);
+  CHECK(atomic_load(&raw.destroyed) == 1);
+  CHECK(atomic_load(&batch.created) == 1 &&
+        atomic_load(&batch.destroyed) == 1);
+}
+
+/* The adapter copies what it cannot point at. */
+static void queue_file_names(int batch) {
+  sink_t s;
+  sink_init(&s);
+  logger_backend_t *q = logger_backend_queue_create(cap_create(&s), batch);
+  CHECK(q != NULL);
+  if (!q)
+    return;
+  CHECK(q->vtbl->start(q) == LOGGER_OK);
+
+  char name[64];
+  snprintf(name, sizeof(name), "caller_owned.c");
+  q->vtbl->log(q, LOGGER_LEVEL_INFO, name, 1, "owned");
+  memset(name, 'z', sizeof(name) - 1); /* before the deliverer runs */
+  CHECK(q->vtbl->flush(q) == LOGGER_OK);
+  CHECKF(s.n == 1 && strcmp(s.file, "caller_owned.c") == 0,
+         "batch %d: file \"%s\"", batch, s.file);
+
+  /* long: its tail, like the other copies of a path */
+  char path[1000];
+  memset(path, 'd', sizeof(path));
+  memcpy(path + sizeof(path) - 8, "/tail.c", 8);
+  q->vtbl->log(q, LOGGER_LEVEL_INFO, path, 2, "long");
+  memset(path, 'z', sizeof(path) - 1);
+  CHECK(q->vtbl->flush(q) == LOGGER_OK);
+  size_t fl = strlen(s.file);
+  CHECKF(s.n == 2 && fl > 7 && fl < 300 &&
+             strcmp(s.file + fl - 7, "/tail.c") == 0,
+         "batch %d: long file \"%.40s...\" (%zu bytes)", batch, s.file, fl);
+
+  /* interned: passed as is */
+  const char *canon = logger_srcloc_canonical("interned_test.c");
+  q->vtbl->log(q, LOGGER_LEVEL_INFO, canon, 3, "interned");
+  q->vtbl->log(q, LOGGER_LEVEL_INFO, NULL, 4, "no file");
+  CHECK(q->vtbl->flush(q) == LOGGER_OK);
+  CHECK(s.n == 4 && s.file_ptr == NULL && s.line == 4);
+  CHECK(q->vtbl->stop(q) == LOGGER_OK);
+  q->vtbl->destroy(q);
+  CHECK(atomic_load(&s.destroyed) == 1);
+
+  /* the interned pointer, on a fresh adapter */
+  sink_init(&s);
+  q = logger_backend_queue_create(cap_create(&s), batch);
+  CHECK(q && q->vtbl->start(q) == LOGGER_OK);
+  if (!q)
+    return;
+  q->vtbl->log(q, LOGGER_LEVEL_INFO, canon, 3, "interned");
+  CHECK(q->vtbl->flush(q) == LOGGER_OK);
+  CHECK(s.n == 1 && s.file_ptr == canon);
+  q->vtbl->destroy(q);
+}
+
+static atomic_int g_stop = 0;
+static atomic_ulong g_calls = 0;
+
+static void *producer(void *arg) {
+  long id = (long)arg;
+  char file[32];
+  for (unsigned long i = 0; !atomic_load(&g_stop); ++i) {
+    snprintf(file, sizeof(file), "producer%ld.c", id);
+    logger_log(i % 16 ? LOGGER_LEVEL_INFO : LOGGER_LEVEL_ERROR, file,
+               (int)id, "producer %ld: %lu", id, i);
+    atomic_fetch_add(&g_calls, 1);
+  }
+  return NULL;
+}
+
+static void churn_while_logging(void) {
+  static const unsigned CAPS[] = {
+      LOGGER_BACKEND_THREAD_SAFE,
+      LOGGER_BACKEND_THREAD_SAFE | LOGGER_BACKEND_RAW_ARGS,
+      LOGGER_BACKEND_BATCH, 0};
+  static const char *const NAMES[] = {"plain", "raw", "batch", "queued"};
+  sink_t s[4], anchor;
+  for (int k = 0; k < 4; ++k)
+    sink_init(&s[k]);
+  sink_init(&anchor);
+
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  reg("anchor", LOGGER_BACKEND_THREAD_SAFE, &anchor); /* start needs one */
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+
+  pthread_t t[PRODUCERS];
+  for (long i = 0; i < PRODUCERS; ++i)
+    pthread_create(&t[i], NULL, producer, (void *)i);
+
+  int failed = 0;
+  for (int round = 0; round < 200; ++round) {
+    int k = round % 4;
+    logger_backend_desc_t desc = {.name = NAMES[k],
+                                  .caps = CAPS[k],
+                                  .min_level = LOGGER_LEVEL_TRACE,
+                                  .create = cap_create,
+                                  .arg = &s[k]};
+    failed += logger_register_backend(&desc) != LOGGER_OK;
+    usleep(200);
+    if (round % 3 == 0)
+      failed += logger_flush() != LOGGER_OK;
+    failed += logger_unregister_backend(NAMES[k]) != LOGGER_OK;
+  }
+  CHECKF(failed == 0, "%d register/flush/unregister calls failed", failed);
+
+  atomic_store(&g_stop, 1);
+  for (int i = 0; i < PRODUCERS; ++i)
+    pthread_join(t[i], NULL);
+  CHECK(logger_destroy() == LOGGER_OK);
+
+  int total = 0;
+  for (int k = 0; k < 4; ++k) {
+    CHECKF(atomic_load(&s[k].created) == 50 &&
+               atomic_load(&s[k].destroyed) == 50,
+           "%s: %d created, %d destroyed", NAMES[k],
+           atomic_load(&s[k].created), atomic_load(&s[k].destroyed));
+    CHECK(atomic_load(&s[k].overlap) == 0 ||
+          CAPS[k] & LOGGER_BACKEND_THREAD_SAFE);
+    total += s[k].n;
+  }
+  CHECKF(total > 0, "no record reached a registered backend");
+  printf("backend_test: %lu calls, %d records delivered while churning\n",
+         atomic_load(&g_calls), total);
+}
+
+int main(void) {
+  direct_paths();
+  queue_file_names(0);
+  queue_file_names(1);
+  churn_while_logging();
+  return harness_result("backend_test");
+}
@@ -0,0 +1,133 @@
+/*
+ * Producer contention from 1 to 32 threads: the per-thread async queues
+ * against the one queue all threads share when they log synchronously to a
+ * backend that is not thread-safe (the delivery adapter's batch). The
+ * backend is a no-op, so the numbers measure the hand-off, not an output.
+ *
+ * Reports each caller's CPU time per call (flat if producers do not
+ * contend) and end-to-end throughput, up to the last record delivered
+ * (logger_flush()).
+ *
+ * Usage: bench_async [max_threads] [calls_per_thread]
+ */
+#define _GNU_SOURCE /* mkdtemp */
+
+#include "backend.h"
+#include "harness.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+static atomic_ullong g_seen = 0;
+
+static logger_status_t null_start(logger_backend_t *b) {
+  (void)b;
+  return LOGGER_OK;
+}
+
+static void null_log(logger_backend_t *b, logger_level_t lvl, const char *file,
+                     int line, const char *msg) {
+  (void)b;
+  (void)lvl;
+  (void)file;
+  (void)line;
+  harness_sink(msg);
+  atomic_fetch_add_explicit(&g_seen, 1, memory_order_relaxed);
+}
+
+static void null_destroy(logger_backend_t *b) { free(b); }
+
+static const logger_backend_vtbl_t NULL_VTBL = {.start = null_start,
+                                                .stop = null_start,
+                                                .log = null_log,
+                                                .destroy = null_destroy};
+
+static logger_backend_t *null_create(void *arg) {
+  (void)arg;
+  logger_backend_t *b = (logger_backend_t *)calloc(1, sizeof(*b));
+  if (b)
+    b->vtbl = &NULL_VTBL;
+  return b;
+}
+
+static double thread_cpu_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+typedef struct run {
+  long calls;
+  pthread_barrier_t *go;
+  double busy; /* CPU seconds spent logging */
+} run_t;
+
+static void *worker(void *arg) {
+  run_t *r = (run_t *)arg;
+  pthread_barrier_wait(r->go);
+  double t0 = thread_cpu_now();
+  for (long i = 0; i < r->calls; ++i)
+    LOG_INFO("worker iteration %ld: state=%s value=%d", i, "running",
+             (int)(i & 1023));
+  r->busy = thread_cpu_now() - t0;
+  return NULL;
+}
+
+/* Caller CPU ns per call, and calls per second end to end. */
+static void measure(int threads, long calls, double *ns, double *rate) {
+  pthread_t tids[threads];
+  run_t runs[threads];
+  pthread_barrier_t go;
+  pthread_barrier_init(&go, NULL, (unsigned)threads + 1);
+  for (int i = 0; i < threads; ++i) {
+    runs[i] = (run_t){calls, &go, 0};
+    pthread_create(&tids[i], NULL, worker, &runs[i]);
+  }
+
+  pthread_barrier_wait(&go);
+  double t0 = harness_now();
+  double busy = 0;
+  for (int i = 0; i < threads; ++i) {
+    pthread_join(tids[i], NULL);
+    busy += runs[i].busy;
+  }
+  CHECK(logger_flush() == LOGGER_OK);
+  double dt = harness_now() - t0;
+  pthread_barrier_destroy(&go);
+
+  *ns = busy / ((double)threads * (double)calls) * 1e9;
+  *rate = (double)threads * (double)calls / dt;
+}
+
+int main(int argc, char **argv) {
+  int max_threads = argc > 1 ? atoi(argv[1]) : 32;
+  long calls = argc > 2 ? atol(argv[2]) : 50000;
+
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  logger_backend_desc_t desc = {.name = "null",
+                                .min_level = LOGGER_LEVEL_TRACE,
+                                .create = null_create};
+  CHECK(logger_register_backend(&desc) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+
+  printf("%ld calls per thread; caller CPU ns per call, end-to-end Mcalls/s\n",
+         calls);
+  printf("%7s %14s %14s %15s %15s\n", "threads", "shared ns", "async ns",
+         "shared Mcalls/s", "async Mcalls/s");
+  for (int n = 1; n <= max_threads; n *= 2) {
+    double sns, srate, ans, arate;
+    CHECK(logger_set_async(0) == LOGGER_OK);
+    measure(n, calls, &sns, &srate);
+    CHECK(logger_set_async(1) == LOGGER_OK);
+    measure(n, calls, &ans, &arate);
+    printf("%7d %14.1f %14.1f %15.2f %15.2f\n", n, sns, ans, srate / 1e6,
+           arate / 1e6);
+  }
+
+  logger_stats_t st;
+  CHECK(logger_get_stats(&st) == LOGGER_OK);
+  CHECK(st.dropped == 0 && st.logged == atomic_load(&g_seen));
+  CHECK(logger_stop() == LOGGER_OK);
+  CHECK(logger_destroy() == LOGGER_OK);
+  return harness_result("bench_async");
+}
@@ -0,0 +1,153 @@
+/*
+ * Compressed file output: CPU cost per MB of log text against the bytes it
+ * keeps off the flash. Logs the same synthetic device log once per setup
+ * and reports the file size and the process CPU time, which includes the
+ * writer thread that compresses:
+ * - "plain": the default output, one write() per line;
+ * - "blocks": plain text written in 64 KiB blocks (latency target), the
+ *   write pattern of the compressed output without a codec;
+ * - "lz4", "zstd": compressed 64 KiB blocks.
+ * A codec's cost is its CPU time above "blocks".
+ *
+ * The codecs are compiled in on request: make bench CODECS="lz4 zstd"
+ * (after make clean). Codecs missing from the build are reported as such.
+ *
+ * Usage: bench_compress [lines]
+ */
+#define _GNU_SOURCE /* mkdtemp */
+
+#include "harness.h"
+#include "logger.h"
+#include <stdint.h>
+#include <sys/stat.h>
+
+static const char *const STATES[] = {"IDLE", "RUNNING", "STOPPING", "FAULT"};
+static const char *const PEERS[] = {"10.0.0.12", "10.0.0.40", "192.168.1.7"};
+
+static uint64_t g_rng;
+
+static uint64_t rnd(void) {
+  g_rng ^= g_rng >> 12;
+  g_rng ^= g_rng << 25;
+  g_rng ^= g_rng >> 27;
+  return g_rng * 0x2545F4914F6CDD1Dull;
+}
+
+/* A mix of the call sites of a small controller, same sequence per run. */
+static void log_corpus(long lines) {
+  g_rng = 0x9E3779B97F4A7C15ull;
+  for (long i = 0; i < lines; ++i) {
+    uint64_t r = rnd();
+    switch (r % 5) {
+    case 0:
+      LOG_INFO("motor %u: rpm=%u current=%.2fA temp=%.1fC",
+               (unsigned)(r >> 8) % 4, 1400 + (unsigned)(r >> 16) % 200,
+               (double)((r >> 24) % 500) / 100,
+               35.0 + (double)((r >> 32) % 200) / 10);
+      break;
+    case 1:
+      LOG_DEBUG("frame %ld: %u packets, %u bytes, crc=0x%08x", i,
+                (unsigned)(r >> 8) % 64, (unsigned)(r >> 16) % 65536,
+                (unsigned)(r >> 32));
+      break;
+    case 2:
+      LOG_INFO("session %s: state %s -> %s", PEERS[(r >> 8) % 3],
+               STATES[(r >> 16) % 4], STATES[(r >> 24) % 4]);
+      break;
+    case 3:
+      LOG_WARN("queue depth %u above threshold %u (%s)",
+               (unsigned)(r >> 8) % 1000, 800u, "dropping oldest");
+      break;
+    default:
+      LOG_INFO("sensor batch %lu: min=%d max=%d avg=%.3f",
+               (unsigned long)(r >> 40), -(int)((r >> 8) % 50),
+               (int)((r >> 16) % 120), (double)((r >> 24) % 100000) / 1000);
+      break;
+    }
+  }
+}
+
+typedef struct setup {
+  const char *name;
+  logger_compression_t codec;
+  unsigned latency_us; /* 0: per-line writes (plain only) */
+} setup_t;
+
+typedef struct result {
+  int ok;
+  double file_mb; /* bytes on disk */
+  double cpu;     /* process CPU seconds */
+} result_t;
+
+static result_t run(const setup_t *s, long lines) {
+  result_t r = {0};
+  char file[64];
+  snprintf(file, sizeof(file), "bench_compress_%s.log", s->name);
+  const char *path = harness_path(file);
+
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  if (logger_set_file_compression(s->codec, 0) != LOGGER_OK) {
+    CHECK(logger_destroy() == LOGGER_OK);
+    return r;
+  }
+  if (s->latency_us)
+    CHECK(logger_set_file_latency_target(s->latency_us) == LOGGER_OK);
+  CHECK(logger_enable_file_output(path) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_DEBUG) == LOGGER_OK);
+
+  double c0 = harness_cpu_now();
+  log_corpus(lines);
+  CHECK(logger_flush() == LOGGER_OK);
+  r.cpu = harness_cpu_now() - c0;
+  CHECK(logger_stop() == LOGGER_OK);
+  CHECK(logger_destroy() == LOGGER_OK);
+
+  struct stat st;
+  CHECK(stat(path, &st) == 0);
+  r.file_mb = (double)st.st_size / 1e6;
+  r.ok = 1;
+  remove(path);
+  return r;
+}
+
+int main(int argc, char **argv) {
+  long lines = argc > 1 ? atol(argv[1]) : 500000;
+  static const setup_t SETUPS[] = {
+      {"plain", LOGGER_COMPRESSION_NONE, 0},
+      {"blocks", LOGGER_COMPRESSION_NONE, 1000000},
+      {"lz4", LOGGER_COMPRESSION_LZ4, 0},
+      {"zstd", LOGGER_COMPRESSION_ZSTD, 0}};
+
+  printf("%ld lines; ms of CPU per MB of log text (incl. writer thread)\n",
+         lines);
+  printf("%-7s %8s %7s %10s %12s %14s\n", "setup", "file MB", "ratio",
+         "CPU ms/MB", "codec ms/MB", "MB saved/CPU s");
+  double raw_mb = 0, block_ms = 0;
+  for (size_t i = 0; i < sizeof(SETUPS) / sizeof(SETUPS[0]); ++i) {
+    const setup_t *s = &SETUPS[i];
+    result_t r = run(s, lines);
+    if (!r.ok) {
+      printf("%-7s not compiled in\n", s->name);
+      continue;
+    }
+    if (i == 0)
+      raw_mb = r.file_mb; /* same corpus for every setup */
+    double ms = r.cpu * 1e3 / raw_mb;
+    printf("%-7s %8.1f %6.1fx %10.1f", s->name, r.file_mb, raw_mb / r.file_mb,
+           ms);
+    if (s->codec == LOGGER_COMPRESSION_NONE) {
+      if (s->latency_us)
+        block_ms = ms;
+      printf(" %12s %14s\n", "-", "-");
+    } else {
+      double codec_ms = ms - block_ms;
+      printf(" %12.1f", codec_ms);
+      if (codec_ms > 0)
+        printf(" %14.0f\n", (1.0 - r.file_mb / raw_mb) / (codec_ms / 1e3));
+      else
+        printf(" %14s\n", "-");
+    }
+  }
+  return harness_result("bench_compress");
+}
@@ -0,0 +1,73 @@
+/*
+ * logger_vformat() against vsnprintf() on format strings typical of log call
+ * sites, in ns per call.
+ */
+#define _GNU_SOURCE /* mkdtemp */
+
+#include "format.h"
+#include "harness.h"
+#include <stdarg.h>
+
+typedef int (*vfmt_fn)(char *, size_t, const char *, va_list);
+
+static int call(vfmt_fn fn, char *buf, size_t size, const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = fn(buf, size, fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+/* One format per case; the arguments are fixed below. */
+enum { C_TEXT, C_INTS, C_MIXED, C_FLOAT, C_HEXPTR, C_WIDTH, C_COUNT };
+
+static const char *const NAMES[C_COUNT] = {
+    "text", "ints", "mixed", "float", "hex/ptr", "width (fallback)"};
+
+static int run_case(vfmt_fn fn, char *buf, size_t size, int c, long i) {
+  switch (c) {
+  case C_TEXT:
+    return call(fn, buf, size, "Logger started, waiting for connections");
+  case C_INTS:
+    return call(fn, buf, size, "frame %d: %u packets, %ld bytes", (int)i,
+                (unsigned)(i * 3), (long)i * 1500);
+  case C_MIXED:
+    return call(fn, buf, size, "user=%s id=%lu state=%s retries=%d",
+                "operator", (unsigned long)i, "CONNECTED", (int)(i & 7));
+  case C_FLOAT:
+    return call(fn, buf, size, "temp=%.1fC duty=%.2f rpm=%f", 41.5 + (i & 3),
+                0.62, 1498.25);
+  case C_HEXPTR:
+    return call(fn, buf, size, "reg 0x%x = 0x%X at %p", (unsigned)i,
+                0xBEEFu, (void *)0x7f0012345678);
+  default:
+    return call(fn, buf, size, "[%8s] %5d|%-6.2f", "motor", (int)i, 3.5);
+  }
+}
+
+int main(int argc, char **argv) {
+  long iters = argc > 1 ? atol(argv[1]) : 1000000;
+  char a[512], b[512];
+
+  printf("%-18s %12s %12s %8s\n", "format", "vsnprintf ns", "vformat ns",
+         "speedup");
+  for (int c = 0; c < C_COUNT; ++c) {
+    int na = run_case(vsnprintf, a, sizeof(a), c, 7);
+    int nb = run_case(logger_vformat, b, sizeof(b), c, 7);
+    CHECKF(na == nb && strcmp(a, b) == 0, "%s: \"%s\" != \"%s\"", NAMES[c], a,
+           b);
+
+    double t[2];
+    vfmt_fn fns[2] = {vsnprintf, logger_vformat};
+    for (int k = 0; k < 2; ++k) {
+      double t0 = harness_now();
+      for (long i = 0; i < iters; ++i) {
+        run_case(fns[k], a, sizeof(a), c, i);
+        harness_sink(a);
+      }
+      t[k] = (harness_now() - t0) / (double)iters * 1e9;
+    }
+    printf("%-18s %12.1f %12.1f %7.2fx\n", NAMES[c], t[0], t[1], t[0] / t[1]);
+  }
+  return harness_result("bench_format");
+}
@@ -0,0 +1,123 @@
+/*
+ * JSON string escaping: logger_jsonl_escape() (SSE2/NEON) against the naive
+ * byte loop it replaced, on messages shaped like real log lines. Outputs are
+ * compared first, so the benchmark also guards the vector path.
+ */
+#define _GNU_SOURCE /* mkdtemp */
+
+#include "harness.h"
+#include "jsonl_backend.h"
+
+static size_t naive_escape(char *dst, const char *src, size_t len) {
+  static const char hex[] = "0123456789abcdef";
+  char *out = dst;
+  for (size_t i = 0; i < len; ++i) {
+    unsigned char ch = (unsigned char)src[i];
+    switch (ch) {
+    case '"':
+      *out++ = '\\';
+      *out++ = '"';
+      break;
+    case '\\':
+      *out++ = '\\';
+      *out++ = '\\';
+      break;
+    case '\n':
+      *out++ = '\\';
+      *out++ = 'n';
+      break;
+    case '\r':
+      *out++ = '\\';
+      *out++ = 'r';
+      break;
+    case '\t':
+      *out++ = '\\';
+      *out++ = 't';
+      break;
+    case '\b':
+      *out++ = '\\';
+      *out++ = 'b';
+      break;
+    case '\f':
+      *out++ = '\\';
+      *out++ = 'f';
+      break;
+    default:
+      if (ch < 0x20) {
+        memcpy(out, "\\u00", 4);
+        out[4] = hex[ch >> 4];
+        out[5] = hex[ch & 0xF];
+        out += 6;
+      } else {
+        *out++ = (char)ch;
+      }
+    }
+  }
+  return (size_t)(out - dst);
+}
+
+typedef struct sample {
+  const char *name;
+  const char *msg;
+} sample_t;
+
+static const sample_t SAMPLES[] = {
+    {"short", "Logger started"},
+    {"typical", "motor 3: setpoint=1520 rpm actual=1498 rpm duty=0.62 "
+                "temp=41.5C state=RUNNING"},
+    {"path", "open(/var/lib/app/cache/segment-000123.bin) failed: "
+             "No such file or directory (errno=2)"},
+    {"quoted", "config key \"net.retry\" = \"3\" overrides \"2\" from "
+               "\"/etc/app.conf\""},
+    {"json", "{\"id\":17,\"tags\":[\"a\",\"b\"],\"path\":\"C:\\\\tmp\"}"},
+    {"multiline", "stack:\n  #0 f() at a.c:10\n  #1 g() at b.c:22\n"
+                  "  #2 main() at main.c:5\n"},
+    {"utf8", "température élevée: 85 °C — réduction de la puissance "
+             "à 50 % (limite 80 °C)"},
+};
+
+#define NSAMPLES (sizeof(SAMPLES) / sizeof(SAMPLES[0]))
+
+static double bench(size_t (*fn)(char *, const char *, size_t), char *out,
+                    const char *msg, size_t len, long iters) {
+  double t0 = harness_now();
+  for (long i = 0; i < iters; ++i) {
+    fn(out, msg, len);
+    harness_sink(out);
+  }
+  return (harness_now() - t0) / (double)iters * 1e9;
+}
+
+int main(int argc, char **argv) {
+  long iters = argc > 1 ? atol(argv[1]) : 2000000;
+  static char a[8192], b[8192];
+
+  /* long line: the typical sample repeated to ~1 KiB */
+  static char longmsg[1100];
+  size_t tlen = strlen(SAMPLES[1].msg);
+  size_t n = 0;
+  while (n + tlen + 1 < sizeof(longmsg)) {
+    memcpy(longmsg + n, SAMPLES[1].msg, tlen);
+    n += tlen;
+    longmsg[n++] = ' ';
+  }
+  longmsg[n] = '\0';
+
+  printf("%-10s %6s %12s %12s %8s\n", "message", "bytes", "naive ns",
+         "simd ns", "speedup");
+  for (size_t i = 0; i <= NSAMPLES; ++i) {
+    const char *name = i < NSAMPLES ? SAMPLES[i].name : "long";
+    const char *msg = i < NSAMPLES ? SAMPLES[i].msg : longmsg;
+    size_t len = strlen(msg);
+
+    size_t la = naive_escape(a, msg, len);
+    size_t lb = logger_jsonl_escape(b, msg, len);
+    CHECKF(la == lb && memcmp(a, b, la) == 0, "%s: outputs differ", name);
+
+    long it = len > 256 ? iters / 8 : iters;
+    double tn = bench(naive_escape, a, msg, len, it);
+    double ts = bench(logger_jsonl_escape, b, msg, len, it);
+    printf("%-10s %6zu %12.1f %12.1f %7.2fx\n", name, len, tn, ts, tn / ts);
+  }
+  return harness_result("bench_jsonl_escape");
+}
@@ -0,0 +1,118 @@
+/*
+ * Throughput of logger_log() from 1 to N threads, for calls filtered by the
+ * level check and for calls delivered to a no-op user backend (so the
+ * numbers measure the logger, not an output). With the hot state on its
+ * own cache line and sharded counters, total throughput should grow
+ * linearly up to the number of CPUs.
+ *
+ * Usage: bench_scaling [max_threads] [calls_per_thread]
+ */
+#define _GNU_SOURCE /* mkdtemp, sysconf */
+
+#include "backend.h"
+#include "harness.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+static atomic_ullong g_seen = 0;
+
+static logger_status_t null_start(logger_backend_t *b) {
+  (void)b;
+  return LOGGER_OK;
+}
+
+static void null_log(logger_backend_t *b, logger_level_t lvl, const char *file,
+                     int line, const char *msg) {
+  (void)b;
+  (void)lvl;
+  (void)file;
+  (void)line;
+  harness_sink(msg);
+  atomic_fetch_add_explicit(&g_seen, 1, memory_order_relaxed);
+}
+
+static void null_destroy(logger_backend_t *b) { free(b); }
+
+static const logger_backend_vtbl_t NULL_VTBL = {.start = null_start,
+                                                .stop = null_start,
+                                                .log = null_log,
+                                                .destroy = null_destroy};
+
+static logger_backend_t *null_create(void *arg) {
+  (void)arg;
+  logger_backend_t *b = (logger_backend_t *)calloc(1, sizeof(*b));
+  if (b)
+    b->vtbl = &NULL_VTBL;
+  return b;
+}
+
+typedef struct run {
+  long calls;
+  logger_level_t level;
+  pthread_barrier_t *go;
+} run_t;
+
+static void *worker(void *arg) {
+  run_t *r = (run_t *)arg;
+  pthread_barrier_wait(r->go);
+  for (long i = 0; i < r->calls; ++i)
+    logger_log(r->level, __FILE__, __LINE__, "iteration %ld of %s", i, "run");
+  return NULL;
+}
+
+/* Calls per second, all threads together. */
+static double measure(int threads, long calls, logger_level_t level) {
+  pthread_t tids[threads];
+  pthread_barrier_t go;
+  run_t r = {calls, level, &go};
+  pthread_barrier_init(&go, NULL, (unsigned)threads + 1);
+  for (int i = 0; i < threads; ++i)
+    pthread_create(&tids[i], NULL, worker, &r);
+
+  pthread_barrier_wait(&go);
+  double t0 = harness_now();
+  for (int i = 0; i < threads; ++i)
+    pthread_join(tids[i], NULL);
+  double dt = harness_now() - t0;
+  pthread_barrier_destroy(&go);
+  return (double)threads * (double)calls / dt;
+}
+
+int main(int argc, char **argv) {
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  int max_threads = argc > 1 ? atoi(argv[1]) : (int)(ncpu < 2 ? 4 : 2 * ncpu);
+  long calls = argc > 2 ? atol(argv[2]) : 1000000;
+
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  logger_backend_desc_t desc = {.name = "null",
+                                .caps = LOGGER_BACKEND_THREAD_SAFE,
+                                .min_level = LOGGER_LEVEL_TRACE,
+                                .create = null_create};
+  CHECK(logger_register_backend(&desc) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+
+  printf("%ld CPU(s) online, %ld calls per thread\n", ncpu, calls);
+  printf("%7s %16s %10s %16s %10s\n", "threads", "filtered Mops/s", "scaling",
+         "delivered Mops/s", "scaling");
+
+  double base_f = 0, base_d = 0;
+  for (int n = 1; n <= max_threads; n *= 2) {
+    double f = measure(n, calls, LOGGER_LEVEL_DEBUG);
+    double d = measure(n, calls / 4, LOGGER_LEVEL_INFO);
+    if (n == 1) {
+      base_f = f;
+      base_d = d;
+    }
+    printf("%7d %16.2f %9.2fx %16.2f %9.2fx\n", n, f / 1e6, f / base_f,
+           d / 1e6, d / base_d);
+  }
+
+  logger_stats_t st;
+  CHECK(logger_get_stats(&st) == LOGGER_OK);
+  CHECK(st.logged == atomic_load(&g_seen));
+  CHECK(logger_stop() == LOGGER_OK);
+  CHECK(logger_destroy() == LOGGER_OK);
+  return harness_result("bench_scaling");
+}
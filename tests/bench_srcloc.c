@@ -0,0 +1,65 @@
+/*
+ * Per-call cost of the source-location cache (srcloc.h) on a cached hit, in
+ * ns per call: logger_srcloc_intern() given a call site's own path (the
+ * cached id is confirmed by comparing the names) and given the interned
+ * name, as the async path does (confirmed by address); logger_srcloc_find()
+ * and logger_srcloc_canonical() on the call site's path; and the cached
+ * prefix of the interned name.
+ */
+#define _GNU_SOURCE /* mkdtemp */
+
+#include "harness.h"
+#include "srcloc.h"
+
+/* A path as long as __FILE__ of a nested source tree. */
+static const char PATH[] =
+    "/home/build/src/firmware/drivers/motor/controller/pid_loop.c";
+
+enum { C_INTERN, C_INTERN_NAME, C_FIND, C_CANONICAL, C_PREFIX, C_COUNT };
+
+static const char *const NAMES[C_COUNT] = {
+    "intern path", "intern name", "find path", "canonical path",
+    "prefix name"};
+
+int main(int argc, char **argv) {
+  long iters = argc > 1 ? atol(argv[1]) : 10000000;
+
+  unsigned id = logger_srcloc_intern(PATH);
+  const char *name = logger_srcloc_name(id);
+  CHECK(id != 0 && name != NULL && name != PATH);
+  if (!name)
+    return harness_result("bench_srcloc");
+  CHECK(logger_srcloc_intern(name) == id);
+  CHECK(logger_srcloc_find(PATH) == name);
+  CHECK(logger_srcloc_canonical(PATH) == name);
+  size_t len = 0;
+  CHECK(logger_srcloc_prefix(LOGGER_LEVEL_INFO, name, 42, &len) != NULL);
+
+  printf("%-18s %12s\n", "call", "ns");
+  for (int c = 0; c < C_COUNT; ++c) {
+    unsigned bad = 0;
+    double t0 = harness_now();
+    for (long i = 0; i < iters; ++i) {
+      switch (c) {
+      case C_INTERN:
+        bad += logger_srcloc_intern(PATH) != id;
+        break;
+      case C_INTERN_NAME:
+        bad += logger_srcloc_intern(name) != id;
+        break;
+      case C_FIND:
+        harness_sink(logger_srcloc_find(PATH));
+        break;
+      case C_CANONICAL:
+        harness_sink(logger_srcloc_canonical(PATH));
+        break;
+      default:
+        harness_sink(logger_srcloc_prefix(LOGGER_LEVEL_INFO, name, 42, &len));
+      }
+    }
+    double ns = (harness_now() - t0) / (double)iters * 1e9;
+    CHECKF(bad == 0, "%s: %u wrong ids", NAMES[c], bad);
+    printf("%-18s %12.1f\n", NAMES[c], ns);
+  }
+  return harness_result("bench_srcloc");
+}
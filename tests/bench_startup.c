@@ -0,0 +1,118 @@
+/*
+ * Startup cost: time from logger_init() to the first logged line, with
+ * outputs built eagerly (default), lazily, and lazily with the prewarm
+ * thread. Every sample runs in a fresh child process, so one-time costs
+ * (thread creation, first allocations, page faults) are counted.
+ *
+ * Per mode, medians of:
+ * - start:     logger_init() .. logger_start() returned;
+ * - first log: .. the first LOG_INFO() returned (what the program waits);
+ * - on disk:   .. logger_flush() returned with that line written.
+ *
+ * The outputs are a block-mode file (latency target) and a JSONL file.
+ *
+ * Usage: bench_startup [runs]
+ */
+#define _GNU_SOURCE /* mkdtemp */
+
+#include "harness.h"
+#include "logger.h"
+#include <sys/wait.h>
+#include <unistd.h>
+
+enum { M_EAGER, M_LAZY, M_PREWARM, M_COUNT };
+
+static const char *const NAMES[M_COUNT] = {"eager", "lazy", "lazy+prewarm"};
+
+typedef struct sample {
+  double start, first, disk; /* seconds since logger_init() */
+} sample_t;
+
+static void child(int mode, int fd) {
+  char path[512], jpath[512];
+  snprintf(path, sizeof(path), "startup_%d_%d.log", mode, (int)getpid());
+  snprintf(jpath, sizeof(jpath), "startup_%d_%d.jsonl", mode, (int)getpid());
+  snprintf(path, sizeof(path), "%s", harness_path(path));
+  snprintf(jpath, sizeof(jpath), "%s", harness_path(jpath));
+
+  sample_t s;
+  double t0 = harness_now();
+  logger_init();
+  logger_disable_console();
+  logger_set_lazy_outputs(mode != M_EAGER);
+  logger_set_prewarm(mode == M_PREWARM, 1 << 20);
+  logger_set_file_latency_target(2000);
+  logger_enable_file_output(path);
+  logger_enable_jsonl_output(jpath);
+  logger_start(LOGGER_LEVEL_INFO);
+  s.start = harness_now() - t0;
+  LOG_INFO("service up, pid %d", (int)getpid());
+  s.first = harness_now() - t0;
+  logger_flush();
+  s.disk = harness_now() - t0;
+
+  logger_stop();
+  logger_destroy();
+  size_t len = 0;
+  char *text = harness_slurp(path, &len);
+  if (!text || !strstr(text, "service up"))
+    s.disk = -1;
+  free(text);
+  remove(path);
+  remove(jpath);
+  _exit(write(fd, &s, sizeof(s)) == (ssize_t)sizeof(s) ? 0 : 1);
+}
+
+static int cmp(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+static double median(double *v, int n) {
+  qsort(v, (size_t)n, sizeof(*v), cmp);
+  return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+int main(int argc, char **argv) {
+  int runs = argc > 1 ? atoi(argv[1]) : 50;
+  double *start = calloc((size_t)runs, sizeof(double));
+  double *first = calloc((size_t)runs, sizeof(double));
+  double *disk = calloc((size_t)runs, sizeof(double));
+  harness_path("");
+
+  printf("%d runs per mode, medians in us since logger_init()\n", runs);
+  printf("%-13s %10s %10s %10s\n", "mode", "start", "first log", "on disk");
+  for (int m = 0; m < M_COUNT; ++m) {
+    int n = 0;
+    for (int r = 0; r < runs; ++r) {
+      int fds[2];
+      CHECK(pipe(fds) == 0);
+      fflush(stdout);
+      pid_t pid = fork();
+      if (pid == 0)
+        child(m, fds[1]);
+      close(fds[1]);
+      sample_t s;
+      int ok = read(fds[0], &s, sizeof(s)) == (ssize_t)sizeof(s);
+      close(fds[0]);
+      int status;
+      waitpid(pid, &status, 0);
+      CHECKF(ok && s.disk >= 0, "%s: run %d lost its first line", NAMES[m],
+             r);
+      if (ok && s.disk >= 0) {
+        start[n] = s.start;
+        first[n] = s.first;
+        disk[n] = s.disk;
+        ++n;
+      }
+    }
+    if (n)
+      printf("%-13s %10.0f %10.0f %10.0f\n", NAMES[m],
+             median(start, n) * 1e6, median(first, n) * 1e6,
+             median(disk, n) * 1e6);
+  }
+  free(start);
+  free(first);
+  free(disk);
+  return harness_result("bench_startup");
+}
@@ -0,0 +1,245 @@
+/*
+ * Compressed file output (logger_set_file_compression()), per codec, plain
+ * and durable, with the block index on:
+ * - every indexed block decodes with the codec's own library to exactly
+ *   the index's raw size and line count; the blocks tile the log, and
+ *   their text is every record in order;
+ * - compressed logs are smaller than the text they hold;
+ * - logq reads every record back from the same file.
+ * Codecs not compiled in (CODECS="lz4 zstd" compiles them) are refused by
+ * logger_set_file_compression() and skipped; LOGGER_COMPRESSION_NONE always
+ * runs. Runs the logq built next to this test.
+ */
+#define _GNU_SOURCE /* mkdtemp */
+
+#include "file_backend.h"
+#include "file_index.h"
+#include "harness.h"
+#include "logger.h"
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef LOGGER_USE_LZ4
+#include <lz4frame.h>
+#endif
+#ifdef LOGGER_USE_ZSTD
+#include <zstd.h>
+#endif
+
+#define LINES 20000
+#define PER_FLUSH 5000
+#define MAX_ENTRIES 256
+
+static const char *const NAMES[] = {"none", "lz4", "zstd"};
+static char g_logq[512];
+
+static void write_log(const char *path, logger_compression_t codec,
+                      int durable) {
+  remove(path);
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  CHECK(logger_set_file_index(1) == LOGGER_OK);
+  CHECK(logger_set_file_compression(codec, 0) == LOGGER_OK);
+  if (durable)
+    CHECK(logger_set_file_durable(1, 0) == LOGGER_OK);
+  CHECK(logger_enable_file_output(path) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_TRACE) == LOGGER_OK);
+  for (int i = 0; i < LINES; ++i) {
+    LOG_INFO("compress_test %d state=%s peer=10.0.0.%d", i,
+             i % 7 ? "RUNNING" : "IDLE", i % 50);
+    if (i % PER_FLUSH == PER_FLUSH - 1)
+      CHECK(logger_flush() == LOGGER_OK);
+  }
+  CHECK(logger_destroy() == LOGGER_OK);
+}
+
+/* Decodes one block payload into @p out (capacity @p raw); bytes written. */
+static size_t decode(logger_compression_t codec, const char *src, size_t n,
+                     char *out, size_t raw) {
+  switch (codec) {
+  case LOGGER_COMPRESSION_NONE:
+    if (n > raw)
+      return (size_t)-1;
+    memcpy(out, src, n);
+    return n;
+#ifdef LOGGER_USE_LZ4
+  case LOGGER_COMPRESSION_LZ4: {
+    LZ4F_dctx *d;
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&d, LZ4F_VERSION)))
+      return (size_t)-1;
+    size_t in = 0, got = 0, r = 1;
+    while (r != 0 && in < n) {
+      size_t dsz = raw - got, ssz = n - in;
+      r = LZ4F_decompress(d, out + got, &dsz, src + in, &ssz, NULL);
+      if (LZ4F_isError(r) || (!dsz && !ssz))
+        break;
+      in += ssz;
+      got += dsz;
+    }
+    LZ4F_freeDecompressionContext(d);
+    return LZ4F_isError(r) || r != 0 || in != n ? (size_t)-1 : got;
+  }
+#endif
+#ifdef LOGGER_USE_ZSTD
+  case LOGGER_COMPRESSION_ZSTD: {
+    size_t r = ZSTD_decompress(out, raw, src, n);
+    return ZSTD_isError(r) ? (size_t)-1 : r;
+  }
+#endif
+  default:
+    return (size_t)-1;
+  }
+}
+
+static int read_index(const char *path, logger_index_entry_t *e, int max) {
+  char ipath[600];
+  snprintf(ipath, sizeof(ipath), "%s.idx", path);
+  size_t len = 0;
+  unsigned char *p = (unsigned char *)harness_slurp(ipath, &len);
+  int n = -1;
+  if (p && len >= LOGGER_INDEX_HDR &&
+      (len - LOGGER_INDEX_HDR) % LOGGER_INDEX_ENTRY == 0) {
+    n = (int)((len - LOGGER_INDEX_HDR) / LOGGER_INDEX_ENTRY);
+    for (int i = 0; i < n && i < max; ++i)
+      logger_index_decode(p + LOGGER_INDEX_HDR + i * LOGGER_INDEX_ENTRY,
+                          &e[i]);
+  }
+  free(p);
+  return n;
+}
+
+/* Records "compress_test <k> " in order in @p text; returns the count. */
+static int records_in_order(const char *text, size_t len, int *misplaced) {
+  int k = 0;
+  for (const char *p = text; p < text + len;) {
+    const char *nl = memchr(p, '\n', (size_t)(text + len - p));
+    if (!nl)
+      break;
+    char want[32];
+    int wn = snprintf(want, sizeof(want), "compress_test %d ", k);
+    if (!memmem(p, (size_t)(nl - p), want, (size_t)wn))
+      ++*misplaced;
+    ++k;
+    p = nl + 1;
+  }
+  return k;
+}
+
+static void verify(const char *path, logger_compression_t codec,
+                   int durable) {
+  const char *name = NAMES[codec];
+  static logger_index_entry_t e[MAX_ENTRIES];
+  int n = read_index(path, e, MAX_ENTRIES);
+  CHECKF(n >= LINES / PER_FLUSH && n <= MAX_ENTRIES,
+         "%s/%d: %d index entries", name, durable, n);
+  if (n < 1 || n > MAX_ENTRIES)
+    return;
+
+  size_t len = 0;
+  char *log = harness_slurp(path, &len);
+  size_t raw_total = 0;
+  for (int i = 0; i < n; ++i)
+    raw_total += e[i].raw;
+  char *text = (char *)malloc(raw_total + 1);
+  CHECK(log && text);
+  if (!log || !text) {
+    free(log);
+    free(text);
+    return;
+  }
+
+  size_t hdr = durable ? 16 : 0, at = 0, got = 0;
+  int bad = 0, lines = 0;
+  for (int i = 0; i < n; ++i) {
+    bad += e[i].offset != at || e[i].codec != (unsigned)codec ||
+           e[i].flags != (durable ? LOGGER_INDEX_FRAMED : 0u) ||
+           e[i].stored < hdr || e[i].offset + e[i].stored > len;
+    if (e[i].offset + e[i].stored > len || e[i].stored < hdr)
+      break;
+    size_t r = decode(codec, log + e[i].offset + hdr, e[i].stored - hdr,
+                      text + got, raw_total - got);
+    int nl = 0;
+    for (size_t k = 0; r != (size_t)-1 && k < r; ++k)
+      nl += text[got + k] == '\n';
+    if (r != e[i].raw || (unsigned)nl != e[i].lines) {
+      CHECKF(0, "%s/%d: block %d decodes to %zd bytes, %d lines; index %u "
+                "bytes, %u lines",
+             name, durable, i, (ssize_t)r, nl, e[i].raw, e[i].lines);
+      break;
+    }
+    got += r;
+    lines += nl;
+    at += e[i].stored;
+  }
+  CHECKF(bad == 0 && at == len, "%s/%d: %d bad entries, blocks end at %zu "
+                                "of %zu",
+         name, durable, bad, at, len);
+
+  int misplaced = 0;
+  int records = records_in_order(text, got, &misplaced);
+  CHECKF(records == LINES && lines == LINES && misplaced == 0,
+         "%s/%d: %d records, %d out of order", name, durable, records,
+         misplaced);
+  if (codec != LOGGER_COMPRESSION_NONE)
+    CHECKF(len < raw_total / 2, "%s/%d: %zu bytes for %zu of text", name,
+           durable, len, raw_total);
+  printf("compress_test: %s%s: %zu bytes of text in %zu (%d blocks)\n", name,
+         durable ? " durable" : "", raw_total, len, n);
+  free(text);
+  free(log);
+}
+
+static void logq_reads(const char *path, const char *name) {
+  char cmd[2048];
+  snprintf(cmd, sizeof(cmd), "%s -l trace %s", g_logq, path);
+  FILE *p = popen(cmd, "r");
+  CHECK(p != NULL);
+  if (!p)
+    return;
+  static char line[4096];
+  int k = 0, misplaced = 0;
+  while (fgets(line, sizeof(line), p)) {
+    const char *r = strstr(line, "compress_test ");
+    int n;
+    misplaced += !r || sscanf(r, "compress_test %d ", &n) != 1 || n != k;
+    ++k;
+  }
+  int rc = pclose(p);
+  CHECKF(rc == 0 && k == LINES && misplaced == 0,
+         "%s: logq exit %d, %d records, %d out of order", name, rc, k,
+         misplaced);
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  const char *slash = strrchr(argv[0], '/');
+  snprintf(g_logq, sizeof(g_logq), "%.*slogq",
+           slash ? (int)(slash - argv[0] + 1) : 0, argv[0]);
+  CHECKF(access(g_logq, X_OK) == 0, "%s not built", g_logq);
+
+  char path[256];
+  CHECK(snprintf(path, sizeof(path), "%s", harness_path("compress.log")) <
+        (int)sizeof(path));
+
+  for (int c = LOGGER_COMPRESSION_NONE; c <= LOGGER_COMPRESSION_ZSTD; ++c) {
+    logger_compression_t codec = (logger_compression_t)c;
+    if (!logger_file_compression_supported(codec)) {
+      CHECK(logger_init() == LOGGER_OK);
+      CHECK(logger_set_file_compression(codec, 0) == LOGGER_UNKOWN_ERROR);
+      CHECK(logger_destroy() == LOGGER_OK);
+      printf("compress_test: %s not compiled in, skipped\n", NAMES[c]);
+      continue;
+    }
+    for (int durable = 0; durable < 2; ++durable) {
+      write_log(path, codec, durable);
+      verify(path, codec, durable);
+      logq_reads(path, NAMES[c]);
+    }
+  }
+
+  remove(path);
+  char ipath[300];
+  snprintf(ipath, sizeof(ipath), "%s.idx", path);
+  remove(ipath);
+  return harness_result("compress_test");
+}
@@ -0,0 +1,285 @@
+/*
+ * Thread context (logger_ctx_push()/logger_ctx_pop()) and thread info
+ * (logger_set_thread_info(), logger_set_thread_name()):
+ * - pushed fields render as "key=value ..." in push order, the nodes chain
+ *   from the newest down to the thread node (logger_ctx_parent()), and
+ *   pops restore the previous text; empty keys, a 17th field and popping
+ *   an empty stack are refused; long keys are truncated;
+ * - with thread info on, records carry the kernel id and the OS name of
+ *   the logging thread, "tid=<id> thread=<name>" before the fields; a name
+ *   set with logger_set_thread_name() replaces it and keeps the fields;
+ *   with thread info off the text leaves them out;
+ * - async: records queued by threads that popped their fields and exited
+ *   before the records were written still carry the fields of the call;
+ * - the file output writes the fields between the location and the
+ *   message.
+ */
+#define _GNU_SOURCE /* mkdtemp, pthread_setname_np, syscall */
+
+#include "backend.h"
+#include "harness.h"
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define THREADS 4
+#define PER_THREAD 100
+#define MAX_RECORDS (THREADS * PER_THREAD + 16)
+
+typedef struct rec {
+  char msg[64];
+  char text[512];  /* logger_ctx_text() with the record's thread flag */
+  char bare[512];  /* logger_ctx_text() without the thread fields */
+  char chain[512]; /* "key=value," per node from the top, "." at the end */
+  char name[32];
+  unsigned long tid;
+  int fields;      /* nodes with a key */
+  int has_ctx;
+} rec_t;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static rec_t g_recs[MAX_RECORDS];
+static int g_count = 0;
+
+static logger_status_t cap_start(logger_backend_t *b) {
+  (void)b;
+  return LOGGER_OK;
+}
+
+static void cap_log(logger_backend_t *b, logger_level_t lvl, const char *file,
+                    int line, const char *msg) {
+  (void)b;
+  (void)lvl;
+  (void)file;
+  (void)line;
+  const logger_record_meta_t *meta = logger_backend_current_record();
+  rec_t r;
+  size_t len;
+  const char *text = logger_ctx_text(meta->ctx, meta->thread, &len);
+  snprintf(r.text, sizeof(r.text), "%.*s", (int)len, text);
+  text = logger_ctx_text(meta->ctx, 0, &len);
+  snprintf(r.bare, sizeof(r.bare), "%.*s", (int)len, text);
+  snprintf(r.msg, sizeof(r.msg), "%s", msg);
+  snprintf(r.name, sizeof(r.name), "%s", logger_ctx_thread_name(meta->ctx));
+  r.tid = logger_ctx_thread_id(meta->ctx);
+  r.has_ctx = meta->ctx != NULL;
+  r.fields = 0;
+  size_t at = 0;
+  r.chain[0] = '\0';
+  for (const logger_ctx_t *c = meta->ctx; c && at < sizeof(r.chain);
+       c = logger_ctx_parent(c)) {
+    const char *key = logger_ctx_key(c);
+    r.fields += key != NULL;
+    int n = key ? snprintf(r.chain + at, sizeof(r.chain) - at, "%s=%s,", key,
+                           logger_ctx_value(c))
+                : snprintf(r.chain + at, sizeof(r.chain) - at, ".");
+    at += n < 0 ? 0 : (size_t)n;
+  }
+  pthread_mutex_lock(&g_lock);
+  if (g_count < MAX_RECORDS)
+    g_recs[g_count++] = r;
+  pthread_mutex_unlock(&g_lock);
+}
+
+static void cap_destroy(logger_backend_t *b) { free(b); }
+
+static const logger_backend_vtbl_t CAP_VTBL = {.start = cap_start,
+                                               .stop = cap_start,
+                                               .log = cap_log,
+                                               .destroy = cap_destroy};
+
+static logger_backend_t *cap_create(void *arg) {
+  (void)arg;
+  logger_backend_t *b = (logger_backend_t *)calloc(1, sizeof(*b));
+  if (b)
+    b->vtbl = &CAP_VTBL;
+  return b;
+}
+
+static unsigned long gettid_(void) {
+  return (unsigned long)syscall(SYS_gettid);
+}
+
+/* Logs @p msg synchronously; returns the captured record. */
+static rec_t logged(const char *msg) {
+  pthread_mutex_lock(&g_lock);
+  g_count = 0;
+  pthread_mutex_unlock(&g_lock);
+  LOG_INFO("%s", msg);
+  rec_t r = {.msg = ""};
+  pthread_mutex_lock(&g_lock);
+  CHECKF(g_count == 1, "%s: %d records", msg, g_count);
+  if (g_count == 1)
+    r = g_recs[0];
+  pthread_mutex_unlock(&g_lock);
+  return r;
+}
+
+static void fields(void) {
+  rec_t r = logged("no context");
+  CHECK(!r.has_ctx && r.text[0] == '\0' && r.fields == 0);
+
+  CHECK(logger_ctx_push("job", "17") == LOGGER_OK);
+  CHECK(logger_ctx_pushf("step", "%s-%d", "load", 2) == LOGGER_OK);
+  r = logged("two fields");
+  CHECKF(strcmp(r.text, "job=17 step=load-2") == 0, "text \"%s\"", r.text);
+  CHECK(r.fields == 2);
+  CHECKF(strcmp(r.chain, "step=load-2,job=17,.") == 0, "chain \"%s\"",
+         r.chain);
+
+  CHECK(logger_ctx_push("k", NULL) == LOGGER_OK);
+  r = logged("null value");
+  CHECKF(strcmp(r.text, "job=17 step=load-2 k=") == 0, "text \"%s\"",
+         r.text);
+  CHECK(logger_ctx_pop() == LOGGER_OK);
+
+  CHECK(logger_ctx_pop() == LOGGER_OK);
+  r = logged("one field");
+  CHECKF(strcmp(r.text, "job=17") == 0, "text \"%s\"", r.text);
+  CHECK(logger_ctx_pop() == LOGGER_OK);
+  r = logged("popped");
+  CHECKF(r.text[0] == '\0' && r.fields == 0, "text \"%s\"", r.text);
+  CHECK(logger_ctx_pop() == LOGGER_UNKOWN_ERROR);
+
+  CHECK(logger_ctx_push("", "x") == LOGGER_UNKOWN_ERROR);
+  CHECK(logger_ctx_push(NULL, "x") == LOGGER_UNKOWN_ERROR);
+
+  /* at most 16 fields */
+  int pushed = 0;
+  for (int i = 0; i < 17; ++i)
+    pushed += logger_ctx_pushf("f", "%d", i) == LOGGER_OK;
+  CHECKF(pushed == 16, "%d fields pushed", pushed);
+  r = logged("full");
+  CHECK(r.fields == 16);
+  while (logger_ctx_pop() == LOGGER_OK)
+    --pushed;
+  CHECK(pushed == 0);
+
+  /* keys are truncated to 63 bytes */
+  char key[100];
+  memset(key, 'k', sizeof(key) - 1);
+  key[sizeof(key) - 1] = '\0';
+  CHECK(logger_ctx_push(key, "v") == LOGGER_OK);
+  r = logged("long key");
+  CHECKF(strlen(r.text) == 63 + 2 && r.text[63] == '=',
+         "%zu bytes of text", strlen(r.text));
+  CHECK(logger_ctx_pop() == LOGGER_OK);
+}
+
+static void *named_thread(void *arg) {
+  (void)arg;
+  pthread_setname_np(pthread_self(), "ctx-worker");
+  char want[128];
+  unsigned long tid = gettid_();
+
+  rec_t r = logged("os name");
+  snprintf(want, sizeof(want), "tid=%lu thread=ctx-worker", tid);
+  CHECKF(strcmp(r.text, want) == 0, "text \"%s\", want \"%s\"", r.text,
+         want);
+  CHECK(r.tid == tid && strcmp(r.name, "ctx-worker") == 0);
+  CHECK(r.bare[0] == '\0');
+
+  CHECK(logger_ctx_push("req", "7") == LOGGER_OK);
+  CHECK(logger_set_thread_name("renamed") == LOGGER_OK);
+  r = logged("renamed");
+  snprintf(want, sizeof(want), "tid=%lu thread=renamed req=7", tid);
+  CHECKF(strcmp(r.text, want) == 0, "text \"%s\", want \"%s\"", r.text,
+         want);
+  CHECK(strcmp(r.bare, "req=7") == 0 && r.fields == 1);
+
+  CHECK(logger_set_thread_name(NULL) == LOGGER_OK);
+  r = logged("os name again");
+  CHECK(strcmp(r.name, "ctx-worker") == 0 && strcmp(r.bare, "req=7") == 0);
+
+  CHECK(logger_set_thread_info(0) == LOGGER_OK);
+  r = logged("thread info off");
+  CHECKF(strcmp(r.text, "req=7") == 0, "text \"%s\"", r.text);
+  CHECK(logger_ctx_pop() == LOGGER_OK);
+  return NULL;
+}
+
+static void thread_info(void) {
+  CHECK(logger_set_thread_info(1) == LOGGER_OK);
+  pthread_t t;
+  CHECK(pthread_create(&t, NULL, named_thread, NULL) == 0);
+  pthread_join(t, NULL);
+}
+
+static void *queued_writer(void *arg) {
+  int id = (int)(long)arg;
+  for (int i = 0; i < PER_THREAD; ++i) {
+    logger_ctx_pushf("writer", "%d", id);
+    logger_ctx_pushf("n", "%d", i);
+    LOG_INFO("writer %d: %d", id, i);
+    logger_ctx_pop();
+    logger_ctx_pop();
+  }
+  return NULL; /* the thread's context goes with it */
+}
+
+static void queued(void) {
+  pthread_mutex_lock(&g_lock);
+  g_count = 0;
+  pthread_mutex_unlock(&g_lock);
+  CHECK(logger_set_async(1) == LOGGER_OK);
+  pthread_t t[THREADS];
+  for (long i = 0; i < THREADS; ++i)
+    CHECK(pthread_create(&t[i], NULL, queued_writer, (void *)i) == 0);
+  for (int i = 0; i < THREADS; ++i)
+    pthread_join(t[i], NULL);
+  CHECK(logger_flush() == LOGGER_OK);
+  CHECK(logger_set_async(0) == LOGGER_OK);
+
+  pthread_mutex_lock(&g_lock);
+  CHECKF(g_count == THREADS * PER_THREAD, "%d records", g_count);
+  int bad = 0;
+  for (int i = 0; i < g_count; ++i) {
+    int id, n;
+    char want[64];
+    if (sscanf(g_recs[i].msg, "writer %d: %d", &id, &n) != 2) {
+      ++bad;
+      continue;
+    }
+    snprintf(want, sizeof(want), "writer=%d n=%d", id, n);
+    bad += strcmp(g_recs[i].text, want) != 0;
+  }
+  CHECKF(bad == 0, "%d queued records with other fields", bad);
+  pthread_mutex_unlock(&g_lock);
+}
+
+static void file_line(const char *path) {
+  CHECK(logger_enable_file_output(path) == LOGGER_OK);
+  CHECK(logger_ctx_push("job", "17") == LOGGER_OK);
+  LOG_INFO("in the file");
+  CHECK(logger_ctx_pop() == LOGGER_OK);
+  CHECK(logger_flush() == LOGGER_OK);
+  size_t len = 0;
+  char *text = harness_slurp(path, &len);
+  CHECKF(text && strstr(text, " | job=17 | in the file\n"), "file: %s",
+         text ? text : "(none)");
+  free(text);
+}
+
+int main(void) {
+  char path[256];
+  CHECK(snprintf(path, sizeof(path), "%s", harness_path("context.log")) <
+        (int)sizeof(path));
+
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  logger_backend_desc_t desc = {.name = "capture",
+                                .caps = LOGGER_BACKEND_THREAD_SAFE,
+                                .min_level = LOGGER_LEVEL_TRACE,
+                                .create = cap_create};
+  CHECK(logger_register_backend(&desc) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+
+  fields();
+  thread_info();
+  queued();
+  file_line(path);
+
+  CHECK(logger_destroy() == LOGGER_OK);
+  remove(path);
+  return harness_result("context_test");
+}
@@ -0,0 +1,8 @@
+// The public headers stay valid C++17 (`make c11`): C++ applications and
+// quill_backend.cpp include them while src/*.c are compiled as C11.
+#include "backend.h"
+#include "logger.h"
+#include "logger.hpp"
+#include "logger_timer.h"
+#include "logger_tracy.h"
+#include "quill_backend.h"
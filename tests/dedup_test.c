@@ -0,0 +1,206 @@
+/*
+ * Dedup stage:
+ * - a run followed by silence is summarised once its window has passed;
+ * - records that differ only in their context fields are not collapsed,
+ *   and a summary carries the context of the record it repeats;
+ * - a repeat is counted while the output is still busy with the record it
+ *   repeats (the stage does not hold its lock across the output);
+ * - threads alternating between two messages: every record is either
+ *   forwarded or counted in the summary that follows it, and a summary
+ *   always follows a record of the same call site.
+ */
+#define _GNU_SOURCE /* mkdtemp, usleep */
+
+#include "backend.h"
+#include "harness.h"
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define THREADS 4
+#define ROUNDS 2000
+#define LINE_A 1001
+#define LINE_B 1002
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static int g_last_line = 0;        /* line of the last forwarded record */
+static unsigned long g_total[2];   /* per call site: records + repeats */
+static int g_summaries = 0;
+static int g_misplaced = 0;        /* summary after another site's record */
+static unsigned long g_last_repeats = 0;
+static char g_last_ctx[128];       /* context of the last record */
+static char g_summary_ctx[128];    /* context of the last summary */
+static pthread_cond_t g_cv = PTHREAD_COND_INITIALIZER;
+static int g_hold = 0;             /* "slow" blocks in the output */
+static int g_entered = 0;          /* ... and has reached it */
+static int g_held_out = 0;         /* ... and gave up waiting */
+
+/* Keeps the output busy until released (at most 2 s). */
+static void hold(void) {
+  pthread_mutex_lock(&g_lock);
+  g_entered = 1;
+  pthread_cond_broadcast(&g_cv);
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec += 2;
+  while (g_hold && !g_held_out)
+    if (pthread_cond_timedwait(&g_cv, &g_lock, &ts) == ETIMEDOUT)
+      g_held_out = 1;
+  pthread_mutex_unlock(&g_lock);
+}
+
+static logger_status_t cap_start(logger_backend_t *b) {
+  (void)b;
+  return LOGGER_OK;
+}
+
+static void cap_log(logger_backend_t *b, logger_level_t lvl, const char *file,
+                    int line, const char *msg) {
+  (void)b;
+  (void)lvl;
+  (void)file;
+  const logger_record_meta_t *meta = logger_backend_current_record();
+  size_t len;
+  const char *ctx = logger_ctx_text(meta->ctx, 0, &len);
+  if (strcmp(msg, "slow") == 0)
+    hold();
+
+  pthread_mutex_lock(&g_lock);
+  unsigned long n = 1;
+  if (sscanf(msg, "last message repeated %lu", &n) == 1) {
+    ++g_summaries;
+    g_last_repeats = n;
+    if (line != g_last_line)
+      ++g_misplaced;
+    snprintf(g_summary_ctx, sizeof(g_summary_ctx), "%s", ctx);
+  }
+  if (line == LINE_A || line == LINE_B)
+    g_total[line == LINE_B] += n;
+  g_last_line = line;
+  snprintf(g_last_ctx, sizeof(g_last_ctx), "%s", ctx);
+  pthread_mutex_unlock(&g_lock);
+}
+
+static void cap_destroy(logger_backend_t *b) { free(b); }
+
+static const logger_backend_vtbl_t CAP_VTBL = {.start = cap_start,
+                                               .stop = cap_start,
+                                               .log = cap_log,
+                                               .destroy = cap_destroy};
+
+static logger_backend_t *cap_create(void *arg) {
+  (void)arg;
+  logger_backend_t *b = (logger_backend_t *)calloc(1, sizeof(*b));
+  if (b)
+    b->vtbl = &CAP_VTBL;
+  return b;
+}
+
+static int summaries(void) {
+  pthread_mutex_lock(&g_lock);
+  int n = g_summaries;
+  pthread_mutex_unlock(&g_lock);
+  return n;
+}
+
+/* One call site for the records that should repeat. */
+static void say(const char *msg) { LOG_INFO("%s", msg); }
+
+static void *say_slow(void *arg) {
+  (void)arg;
+  say("slow");
+  return NULL;
+}
+
+static void *alternate(void *arg) {
+  (void)arg;
+  for (int i = 0; i < ROUNDS; ++i) {
+    logger_log(LOGGER_LEVEL_INFO, __FILE__, LINE_A, "site a");
+    logger_log(LOGGER_LEVEL_INFO, __FILE__, LINE_B, "site b");
+  }
+  return NULL;
+}
+
+int main(void) {
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  logger_backend_desc_t desc = {.name = "capture",
+                                .caps = LOGGER_BACKEND_THREAD_SAFE,
+                                .min_level = LOGGER_LEVEL_TRACE,
+                                .create = cap_create};
+  CHECK(logger_register_backend(&desc) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+  CHECK(logger_set_dedup(1, 50) == LOGGER_OK);
+
+  /* quiet after the run: the timer reports it */
+  for (int i = 0; i < 5; ++i)
+    say("link down");
+  CHECK(summaries() == 0);
+  for (int i = 0; i < 100 && summaries() == 0; ++i)
+    usleep(10 * 1000);
+  CHECKF(summaries() == 1 && g_last_repeats == 4, "%d summaries, %lu repeats",
+         summaries(), g_last_repeats);
+
+  /* context is part of the record */
+  CHECK(logger_ctx_push("job", "1") == LOGGER_OK);
+  say("step");
+  say("step");
+  CHECK(logger_ctx_pop() == LOGGER_OK);
+  CHECK(logger_ctx_push("job", "2") == LOGGER_OK);
+  say("step"); /* differs: forwarded, and ends the job=1 run */
+  CHECK(logger_ctx_pop() == LOGGER_OK);
+  CHECKF(summaries() == 2 && g_last_repeats == 1, "%d summaries",
+         summaries());
+  CHECKF(strstr(g_summary_ctx, "job=1") != NULL, "summary context \"%s\"",
+         g_summary_ctx);
+  CHECKF(strstr(g_last_ctx, "job=2") != NULL, "context \"%s\"", g_last_ctx);
+  CHECK(logger_set_dedup(1, 0) == LOGGER_OK);
+  CHECK(logger_ctx_push("job", "3") == LOGGER_OK);
+  say("again");
+  say("again");
+  CHECK(logger_ctx_pop() == LOGGER_OK);
+  say("other");
+  /* the summary was forwarded with job=3, before "other" */
+  CHECK(summaries() == 3);
+  CHECKF(strstr(g_summary_ctx, "job=3") != NULL, "summary context \"%s\"",
+         g_summary_ctx);
+  CHECKF(strstr(g_last_ctx, "job=") == NULL, "context \"%s\"", g_last_ctx);
+
+  /* slow output: the repeat is counted without waiting for it */
+  pthread_t slow;
+  g_hold = 1;
+  CHECK(pthread_create(&slow, NULL, say_slow, NULL) == 0);
+  pthread_mutex_lock(&g_lock);
+  while (!g_entered)
+    pthread_cond_wait(&g_cv, &g_lock);
+  pthread_mutex_unlock(&g_lock);
+  say("slow");
+  pthread_mutex_lock(&g_lock);
+  g_hold = 0;
+  pthread_cond_broadcast(&g_cv);
+  pthread_mutex_unlock(&g_lock);
+  pthread_join(slow, NULL);
+  CHECKF(!g_held_out, "a repeat waited for the output");
+  say("other");
+  CHECKF(summaries() == 4 && g_last_repeats == 1, "%d summaries",
+         summaries());
+
+  /* concurrent runs */
+  pthread_mutex_lock(&g_lock);
+  g_total[0] = g_total[1] = 0;
+  g_misplaced = 0;
+  pthread_mutex_unlock(&g_lock);
+  pthread_t t[THREADS];
+  for (int i = 0; i < THREADS; ++i)
+    pthread_create(&t[i], NULL, alternate, NULL);
+  for (int i = 0; i < THREADS; ++i)
+    pthread_join(t[i], NULL);
+  CHECK(logger_stop() == LOGGER_OK);
+  CHECKF(g_total[0] == THREADS * ROUNDS && g_total[1] == THREADS * ROUNDS,
+         "site a %lu, site b %lu of %d", g_total[0], g_total[1],
+         THREADS * ROUNDS);
+  CHECKF(g_misplaced == 0, "%d misplaced summaries", g_misplaced);
+
+  CHECK(logger_destroy() == LOGGER_OK);
+  return harness_result("dedup_test");
+}
@@ -0,0 +1,219 @@
+/*
+ * Durable file frames:
+ * - CRC-32C known answers, and the instruction path against the table path
+ *   over every length and alignment of a random buffer;
+ * - one frame per ERROR record; a clean reopen keeps the file as is;
+ * - a torn last frame, a flipped payload byte, a flipped length and a torn
+ *   header are each cut back to the end of the last good frame on reopen,
+ *   the last good record survives and new records follow it;
+ * - a plain-text file is refused and left untouched.
+ * Frames are checked here with a bitwise CRC, not the library's.
+ */
+#define _GNU_SOURCE /* mkdtemp */
+
+#include "crc32c.h"
+#include "file_backend.h"
+#include "harness.h"
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define HDR 16
+#define RECORDS 6
+
+static uint32_t crc_bitwise(uint32_t crc, const unsigned char *p, size_t n) {
+  crc = ~crc;
+  while (n--) {
+    crc ^= *p++;
+    for (int k = 0; k < 8; ++k)
+      crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1u)));
+  }
+  return ~crc;
+}
+
+static uint32_t le32(const unsigned char *p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+         (uint32_t)p[3] << 24;
+}
+
+/* Walks the frames; returns their count and the end of the last good one. */
+static int frames(const char *path, long *ends, long *end) {
+  size_t len = 0;
+  unsigned char *p = (unsigned char *)harness_slurp(path, &len);
+  int n = 0;
+  size_t off = 0;
+  while (p && off + HDR <= len && memcmp(p + off, "LGB1", 4) == 0) {
+    uint32_t plen = le32(p + off + 8);
+    if (plen > len - off - HDR)
+      break;
+    uint32_t crc = crc_bitwise(crc_bitwise(0, p + off + 4, 8),
+                               p + off + HDR, plen);
+    if (crc != le32(p + off + 12))
+      break;
+    off += HDR + plen;
+    if (n < RECORDS * 2)
+      ends[n] = (long)off;
+    ++n;
+  }
+  *end = (long)off;
+  free(p);
+  return n;
+}
+
+static long file_size(const char *path) {
+  struct stat st;
+  return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+static logger_backend_t *open_durable(const char *path) {
+  logger_file_options_t opt = {.durable = 1};
+  logger_backend_t *b = logger_backend_file_create_ex(path, &opt);
+  if (b)
+    CHECK(b->vtbl->start(b) == LOGGER_OK);
+  return b;
+}
+
+/* ERROR records: one committed frame each. */
+static void write_records(const char *path, int from, int to) {
+  logger_backend_t *b = open_durable(path);
+  CHECK(b != NULL);
+  if (!b)
+    return;
+  char msg[64];
+  for (int i = from; i < to; ++i) {
+    snprintf(msg, sizeof(msg), "record %d", i);
+    b->vtbl->log(b, LOGGER_LEVEL_ERROR, "durable_test.c", 1, msg);
+  }
+  CHECK(b->vtbl->flush(b) == LOGGER_OK);
+  b->vtbl->destroy(b);
+}
+
+static int contains(const char *path, const char *what) {
+  size_t len = 0;
+  char *text = harness_slurp(path, &len);
+  int found = text && memmem(text, len, what, strlen(what)) != NULL;
+  free(text);
+  return found;
+}
+
+static void crc_vectors(void) {
+  CHECK(logger_crc32c(0, "123456789", 9) == 0xE3069283u);
+  CHECK(logger_crc32c_sw(0, "123456789", 9) == 0xE3069283u);
+  CHECK(logger_crc32c(0, "", 0) == 0);
+  static const unsigned char zeros[32];
+  CHECK(logger_crc32c(0, zeros, sizeof(zeros)) == 0x8A9136AAu);
+
+  unsigned char buf[300 + 8];
+  uint32_t x = 0x12345678u;
+  for (size_t i = 0; i < sizeof(buf); ++i) {
+    x = x * 1103515245u + 12345u;
+    buf[i] = (unsigned char)(x >> 16);
+  }
+  int bad = 0;
+  for (size_t align = 0; align < 8; ++align)
+    for (size_t n = 0; n <= 300; ++n) {
+      uint32_t want = crc_bitwise(0, buf + align, n);
+      uint32_t split = logger_crc32c(logger_crc32c(0, buf + align, n / 3),
+                                     buf + align + n / 3, n - n / 3);
+      bad += logger_crc32c(0, buf + align, n) != want ||
+             logger_crc32c_sw(0, buf + align, n) != want || split != want;
+    }
+  CHECKF(bad == 0, "%d CRC-32C mismatches", bad);
+}
+
+typedef enum { TORN_FRAME, FLIP_PAYLOAD, FLIP_LENGTH, TORN_HEADER } damage_t;
+
+static const char *const DAMAGE[] = {"torn frame", "flipped payload byte",
+                                     "flipped length", "torn header"};
+
+static void damage_and_reopen(const char *path, damage_t how) {
+  remove(path);
+  write_records(path, 0, RECORDS);
+  long ends[RECORDS * 2], end;
+  int n = frames(path, ends, &end);
+  CHECKF(n == RECORDS && end == file_size(path), "%s: %d frames, end %ld",
+         DAMAGE[how], n, end);
+  if (n != RECORDS)
+    return;
+  long good = how == TORN_HEADER ? ends[n - 1] : ends[n - 2];
+
+  FILE *f = fopen(path, "r+b");
+  CHECK(f != NULL);
+  if (!f)
+    return;
+  switch (how) {
+  case TORN_FRAME:
+    CHECK(ftruncate(fileno(f), ends[n - 1] - 3) == 0);
+    break;
+  case FLIP_PAYLOAD:
+  case FLIP_LENGTH: {
+    long at = how == FLIP_PAYLOAD ? ends[n - 1] - 2 : ends[n - 2] + 8;
+    fseek(f, at, SEEK_SET);
+    int c = fgetc(f);
+    fseek(f, at, SEEK_SET);
+    fputc(c ^ 0x01, f);
+    break;
+  }
+  case TORN_HEADER:
+    fseek(f, 0, SEEK_END);
+    fwrite("LGB1\x00\x00", 1, 6, f);
+    break;
+  }
+  fclose(f);
+
+  /* reopen: cut back, nothing written yet */
+  logger_backend_t *b = open_durable(path);
+  CHECKF(b != NULL, "%s: reopen refused", DAMAGE[how]);
+  if (b)
+    b->vtbl->destroy(b);
+  CHECKF(file_size(path) == good, "%s: size %ld, last good frame ends at %ld",
+         DAMAGE[how], file_size(path), good);
+  char last[32];
+  snprintf(last, sizeof(last), "record %d", how == TORN_HEADER ? n - 1 : n - 2);
+  CHECKF(contains(path, last), "%s: \"%s\" lost", DAMAGE[how], last);
+
+  /* appending continues from the good frame */
+  write_records(path, 100, 102);
+  n = frames(path, ends, &end);
+  int want = how == TORN_HEADER ? RECORDS + 2 : RECORDS + 1;
+  CHECKF(n == want && end == file_size(path) && contains(path, "record 101"),
+         "%s: %d frames after appending, end %ld of %ld", DAMAGE[how], n, end,
+         file_size(path));
+}
+
+int main(void) {
+  crc_vectors();
+
+  char path[256];
+  CHECK(snprintf(path, sizeof(path), "%s", harness_path("durable.log")) <
+        (int)sizeof(path));
+
+  /* clean reopen keeps every frame */
+  write_records(path, 0, RECORDS);
+  long ends[RECORDS * 2], end;
+  long size = file_size(path);
+  CHECK(frames(path, ends, &end) == RECORDS && end == size);
+  logger_backend_t *b = open_durable(path);
+  CHECK(b != NULL);
+  if (b)
+    b->vtbl->destroy(b);
+  CHECK(file_size(path) == size);
+
+  for (int how = TORN_FRAME; how <= TORN_HEADER; ++how)
+    damage_and_reopen(path, (damage_t)how);
+
+  /* not ours */
+  static const char text[] = "[INFO] main.c:1 | plain text log\n";
+  FILE *f = fopen(path, "wb");
+  CHECK(f && fwrite(text, 1, sizeof(text) - 1, f) == sizeof(text) - 1);
+  if (f)
+    fclose(f);
+  b = open_durable(path);
+  CHECK(b == NULL);
+  if (b)
+    b->vtbl->destroy(b);
+  CHECK(file_size(path) == (long)sizeof(text) - 1 && contains(path, text));
+
+  remove(path);
+  return harness_result("durable_test");
+}
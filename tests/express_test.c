@@ -0,0 +1,200 @@
+/*
+ * Express lane and sequence numbers (logger_set_express_lane(),
+ * logger_set_sequence()), in async mode:
+ * - an ERROR record behind a backlog of queued INFO records reaches the
+ *   outputs before logger_log() returns, on the calling thread; with the
+ *   lane off it is queued like the rest;
+ * - every record carries a sequence number, queued ones a capture
+ *   timestamp too; the numbers of one thread follow its capture order
+ *   whichever lane wrote the record, and those of several threads are
+ *   distinct and contiguous;
+ * - the file output prefixes lines with "#<seq> ".
+ */
+#define _GNU_SOURCE /* mkdtemp */
+
+#include "backend.h"
+#include "harness.h"
+#include <pthread.h>
+
+#define BACKLOG 200
+#define THREADS 4
+#define PER_THREAD 500
+#define MAX_RECORDS (BACKLOG + 1 + THREADS * PER_THREAD + 16)
+
+typedef struct rec {
+  unsigned long long seq, ts_ns;
+  int queued; /* INFO: went through the async queue */
+  int thread; /* writer id from the message, -1 for the main thread */
+  int n;      /* position in its writer's capture order */
+} rec_t;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static rec_t g_recs[MAX_RECORDS];
+static int g_count = 0;
+static pthread_t g_main;
+static int g_express_inline = -1; /* "express": delivered on the caller */
+
+static logger_status_t cap_start(logger_backend_t *b) {
+  (void)b;
+  return LOGGER_OK;
+}
+
+static void cap_log(logger_backend_t *b, logger_level_t lvl, const char *file,
+                    int line, const char *msg) {
+  (void)b;
+  (void)file;
+  (void)line;
+  const logger_record_meta_t *meta = logger_backend_current_record();
+  rec_t r = {.seq = meta->seq,
+             .ts_ns = meta->ts_ns,
+             .queued = lvl < LOGGER_LEVEL_ERROR,
+             .thread = -1,
+             .n = -1};
+  if (strcmp(msg, "express") == 0) {
+    r.n = BACKLOG;
+  } else if (sscanf(msg, "backlog %d", &r.n) != 1 &&
+             sscanf(msg, "writer %d: %d", &r.thread, &r.n) != 2) {
+    return;
+  }
+  pthread_mutex_lock(&g_lock);
+  if (strcmp(msg, "express") == 0)
+    g_express_inline = pthread_equal(pthread_self(), g_main);
+  if (g_count < MAX_RECORDS)
+    g_recs[g_count++] = r;
+  pthread_mutex_unlock(&g_lock);
+}
+
+static void cap_destroy(logger_backend_t *b) { free(b); }
+
+static const logger_backend_vtbl_t CAP_VTBL = {.start = cap_start,
+                                               .stop = cap_start,
+                                               .log = cap_log,
+                                               .destroy = cap_destroy};
+
+static logger_backend_t *cap_create(void *arg) {
+  (void)arg;
+  logger_backend_t *b = (logger_backend_t *)calloc(1, sizeof(*b));
+  if (b)
+    b->vtbl = &CAP_VTBL;
+  return b;
+}
+
+static void reset(void) {
+  pthread_mutex_lock(&g_lock);
+  g_count = 0;
+  g_express_inline = -1;
+  pthread_mutex_unlock(&g_lock);
+}
+
+static int cmp_seq(const void *a, const void *b) {
+  const rec_t *x = (const rec_t *)a, *y = (const rec_t *)b;
+  return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
+/* Sorted by seq: distinct, contiguous, and in capture order per writer. */
+static void check_order(int want, int writers) {
+  pthread_mutex_lock(&g_lock);
+  CHECKF(g_count == want, "%d records of %d", g_count, want);
+  qsort(g_recs, (size_t)g_count, sizeof(rec_t), cmp_seq);
+  int gaps = 0, zero_ts = 0, misordered = 0;
+  int next[THREADS + 1] = {0};
+  for (int i = 0; i < g_count; ++i) {
+    const rec_t *r = &g_recs[i];
+    gaps += i > 0 && r->seq != g_recs[i - 1].seq + 1;
+    zero_ts += r->queued && r->ts_ns == 0;
+    int w = r->thread + 1;
+    if (w < 0 || w > writers || r->n != next[w])
+      ++misordered;
+    else
+      ++next[w];
+  }
+  CHECKF(g_count == 0 || g_recs[0].seq > 0, "sequence numbers off");
+  CHECKF(gaps == 0 && misordered == 0 && zero_ts == 0,
+         "%d gaps, %d out of capture order, %d queued without a timestamp",
+         gaps, misordered, zero_ts);
+  pthread_mutex_unlock(&g_lock);
+}
+
+static void backlog_then_error(int express) {
+  reset();
+  CHECK(logger_set_express_lane(express, LOGGER_LEVEL_ERROR) == LOGGER_OK);
+  for (int i = 0; i < BACKLOG; ++i)
+    LOG_INFO("backlog %d", i);
+  LOG_ERROR("express");
+  pthread_mutex_lock(&g_lock);
+  int inline_ = g_express_inline;
+  pthread_mutex_unlock(&g_lock);
+  if (express)
+    CHECKF(inline_ == 1, "express: %s",
+           inline_ < 0 ? "not delivered in the call" : "delivered elsewhere");
+  else
+    CHECKF(inline_ != 1, "lane off: written by the caller");
+  CHECK(logger_flush() == LOGGER_OK);
+  check_order(BACKLOG + 1, 0);
+}
+
+static void *writer(void *arg) {
+  int id = (int)(long)arg;
+  for (int i = 0; i < PER_THREAD; ++i) {
+    if (i % 50 == 49)
+      LOG_ERROR("writer %d: %d", id, i); /* express */
+    else
+      LOG_INFO("writer %d: %d", id, i);
+  }
+  return NULL;
+}
+
+static void file_prefix(const char *path) {
+  size_t len = 0;
+  char *text = harness_slurp(path, &len);
+  int lines = 0, bad = 0;
+  unsigned long long seq;
+  for (char *p = text; p && p < text + len;) {
+    char *nl = memchr(p, '\n', (size_t)(text + len - p));
+    if (!nl)
+      break;
+    ++lines;
+    bad += sscanf(p, "#%llu ", &seq) != 1 || seq == 0;
+    p = nl + 1;
+  }
+  CHECKF(lines > 0 && bad == 0, "%d of %d file lines without \"#<seq> \"",
+         bad, lines);
+  free(text);
+}
+
+int main(void) {
+  char path[256];
+  CHECK(snprintf(path, sizeof(path), "%s", harness_path("express.log")) <
+        (int)sizeof(path));
+  g_main = pthread_self();
+
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  logger_backend_desc_t desc = {.name = "capture",
+                                .caps = LOGGER_BACKEND_THREAD_SAFE,
+                                .min_level = LOGGER_LEVEL_TRACE,
+                                .create = cap_create};
+  CHECK(logger_register_backend(&desc) == LOGGER_OK);
+  CHECK(logger_enable_file_output(path) == LOGGER_OK);
+  CHECK(logger_set_async(1) == LOGGER_OK);
+  CHECK(logger_set_sequence(1) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+
+  backlog_then_error(1);
+  backlog_then_error(0);
+
+  reset();
+  CHECK(logger_set_express_lane(1, LOGGER_LEVEL_ERROR) == LOGGER_OK);
+  pthread_t t[THREADS];
+  for (long i = 0; i < THREADS; ++i)
+    pthread_create(&t[i], NULL, writer, (void *)i);
+  for (int i = 0; i < THREADS; ++i)
+    pthread_join(t[i], NULL);
+  CHECK(logger_flush() == LOGGER_OK);
+  check_order(THREADS * PER_THREAD, THREADS);
+
+  file_prefix(path);
+  CHECK(logger_destroy() == LOGGER_OK);
+  remove(path);
+  return harness_result("express_test");
+}
@@ -0,0 +1,252 @@
+/*
+ * Asynchronous flush (logger_flush_async()):
+ * - requests issued between batches of records complete in request order,
+ *   each exactly once, and each callback finds every record logged before
+ *   its request in the file output and in a queued registered backend;
+ * - destroying a handle while one of its flushes runs and two more wait:
+ *   the waiting ones complete with LOGGER_NO_EXIST before destroy returns,
+ *   the running one completes normally, another logger's request is not
+ *   affected, and no callback runs twice (the flusher never gets to flush
+ *   the destroyed handle for them).
+ */
+#define _GNU_SOURCE /* mkdtemp, usleep */
+
+#include "backend.h"
+#include "harness.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define REQUESTS 20
+#define PER_REQUEST 10
+
+typedef struct req {
+  int id;
+  int done;        /* callbacks run */
+  logger_status_t st;
+  int lines;       /* in the file output, at callback time */
+  int delivered;   /* reached the queued backend, at callback time */
+} req_t;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cv = PTHREAD_COND_INITIALIZER;
+static int g_order[REQUESTS + 8];
+static int g_completed = 0;
+static char g_path[256];
+static atomic_int g_delivered = 0;
+
+/* gate backend: its flush() blocks until opened (at most 2 s) */
+static int g_in_flush = 0, g_open = 0, g_gate_timeout = 0;
+
+static int file_lines(void) {
+  size_t len = 0;
+  char *text = harness_slurp(g_path, &len);
+  int n = 0;
+  for (size_t i = 0; text && i < len; ++i)
+    n += text[i] == '\n';
+  free(text);
+  return n;
+}
+
+static void on_flushed(logger_status_t st, void *user) {
+  req_t *r = (req_t *)user;
+  int lines = r->id < REQUESTS ? file_lines() : 0;
+  pthread_mutex_lock(&g_lock);
+  r->st = st;
+  r->lines = lines;
+  r->delivered = atomic_load(&g_delivered);
+  r->done++;
+  if (g_completed < (int)(sizeof(g_order) / sizeof(g_order[0])))
+    g_order[g_completed] = r->id;
+  g_completed++;
+  pthread_cond_broadcast(&g_cv);
+  pthread_mutex_unlock(&g_lock);
+}
+
+/* Waits until @p n callbacks ran; returns 0 after 5 s. */
+static int wait_completed(int n) {
+  double t0 = harness_now();
+  pthread_mutex_lock(&g_lock);
+  while (g_completed < n && harness_now() - t0 < 5.0) {
+    pthread_mutex_unlock(&g_lock);
+    usleep(1000);
+    pthread_mutex_lock(&g_lock);
+  }
+  int ok = g_completed >= n;
+  pthread_mutex_unlock(&g_lock);
+  return ok;
+}
+
+static logger_status_t cap_start(logger_backend_t *b) {
+  (void)b;
+  return LOGGER_OK;
+}
+
+static void cap_log(logger_backend_t *b, logger_level_t lvl, const char *file,
+                    int line, const char *msg) {
+  (void)b;
+  (void)lvl;
+  (void)file;
+  (void)line;
+  (void)msg;
+  usleep(50); /* a slow output, so flushes have something to wait for */
+  atomic_fetch_add(&g_delivered, 1);
+}
+
+static logger_status_t gate_flush(logger_backend_t *b) {
+  (void)b;
+  pthread_mutex_lock(&g_lock);
+  g_in_flush = 1;
+  pthread_cond_broadcast(&g_cv);
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec += 2;
+  while (!g_open && !g_gate_timeout)
+    if (pthread_cond_timedwait(&g_cv, &g_lock, &ts) == ETIMEDOUT)
+      g_gate_timeout = 1;
+  pthread_mutex_unlock(&g_lock);
+  return LOGGER_OK;
+}
+
+static void cap_destroy(logger_backend_t *b) { free(b); }
+
+static const logger_backend_vtbl_t CAP_VTBL = {.start = cap_start,
+                                               .stop = cap_start,
+                                               .log = cap_log,
+                                               .destroy = cap_destroy};
+
+static const logger_backend_vtbl_t GATE_VTBL = {.start = cap_start,
+                                                .stop = cap_start,
+                                                .log = cap_log,
+                                                .destroy = cap_destroy,
+                                                .flush = gate_flush};
+
+static logger_backend_t *cap_create(void *arg) {
+  logger_backend_t *b = (logger_backend_t *)calloc(1, sizeof(*b));
+  if (b)
+    b->vtbl = (const logger_backend_vtbl_t *)arg;
+  return b;
+}
+
+static void in_order(void) {
+  static req_t req[REQUESTS];
+  logger_backend_desc_t desc = {.name = "queued",
+                                .min_level = LOGGER_LEVEL_TRACE,
+                                .create = cap_create,
+                                .arg = (void *)&CAP_VTBL};
+  CHECK(logger_register_backend(&desc) == LOGGER_OK);
+  CHECK(logger_set_async(1) == LOGGER_OK);
+  CHECK(logger_enable_file_output(g_path) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+
+  for (int i = 0; i < REQUESTS; ++i) {
+    for (int k = 0; k < PER_REQUEST; ++k)
+      LOG_INFO("flush_test %d.%d", i, k);
+    req[i].id = i;
+    CHECK(logger_flush_async(on_flushed, &req[i]) == LOGGER_OK);
+  }
+  CHECKF(wait_completed(REQUESTS), "%d of %d callbacks", g_completed,
+         REQUESTS);
+  usleep(20 * 1000); /* no callback runs twice */
+
+  pthread_mutex_lock(&g_lock);
+  CHECKF(g_completed == REQUESTS, "%d callbacks", g_completed);
+  for (int i = 0; i < REQUESTS && i < g_completed; ++i) {
+    int want = (i + 1) * PER_REQUEST;
+    CHECKF(g_order[i] == i, "completion %d is request %d", i, g_order[i]);
+    CHECKF(req[i].done == 1 && req[i].st == LOGGER_OK, "request %d: %d calls",
+           i, req[i].done);
+    CHECKF(req[i].lines >= want && req[i].delivered >= want,
+           "request %d: %d lines in the file, %d delivered, want %d", i,
+           req[i].lines, req[i].delivered, want);
+  }
+  pthread_mutex_unlock(&g_lock);
+
+  CHECK(logger_set_async(0) == LOGGER_OK);
+  CHECK(logger_unregister_backend("queued") == LOGGER_OK);
+}
+
+static void *open_gate(void *arg) {
+  (void)arg;
+  usleep(50 * 1000);
+  pthread_mutex_lock(&g_lock);
+  g_open = 1;
+  pthread_cond_broadcast(&g_cv);
+  pthread_mutex_unlock(&g_lock);
+  return NULL;
+}
+
+static void destroy_pending(void) {
+  /* ids >= REQUESTS: no file check in the callback */
+  req_t running = {.id = 100}, waiting[2] = {{.id = 101}, {.id = 102}},
+        other = {.id = 103};
+  pthread_mutex_lock(&g_lock);
+  g_completed = 0;
+  pthread_mutex_unlock(&g_lock);
+
+  logger_handle_t *h = logger_create("flush_test");
+  CHECK(h != NULL);
+  if (!h)
+    return;
+  CHECK(logger_disable_console_h(h) == LOGGER_OK);
+  logger_backend_desc_t desc = {.name = "gate",
+                                .caps = LOGGER_BACKEND_THREAD_SAFE,
+                                .min_level = LOGGER_LEVEL_TRACE,
+                                .create = cap_create,
+                                .arg = (void *)&GATE_VTBL};
+  CHECK(logger_register_backend_h(h, &desc) == LOGGER_OK);
+  CHECK(logger_start_h(h, LOGGER_LEVEL_INFO) == LOGGER_OK);
+  LOGH_INFO(h, "flush_test gated");
+
+  CHECK(logger_flush_async_h(h, on_flushed, &running) == LOGGER_OK);
+  pthread_mutex_lock(&g_lock);
+  while (!g_in_flush)
+    pthread_cond_wait(&g_cv, &g_lock);
+  pthread_mutex_unlock(&g_lock);
+
+  CHECK(logger_flush_async_h(h, on_flushed, &waiting[0]) == LOGGER_OK);
+  CHECK(logger_flush_async_h(h, on_flushed, &waiting[1]) == LOGGER_OK);
+  CHECK(logger_flush_async(on_flushed, &other) == LOGGER_OK);
+
+  pthread_t opener;
+  CHECK(pthread_create(&opener, NULL, open_gate, NULL) == 0);
+  CHECK(logger_destroy_h(h) == LOGGER_OK);
+
+  pthread_mutex_lock(&g_lock);
+  for (int i = 0; i < 2; ++i)
+    CHECKF(waiting[i].done == 1 && waiting[i].st == LOGGER_NO_EXIST,
+           "waiting request %d: %d calls, status %d", i, waiting[i].done,
+           (int)waiting[i].st);
+  pthread_mutex_unlock(&g_lock);
+  pthread_join(opener, NULL);
+
+  CHECK(wait_completed(4));
+  usleep(20 * 1000);
+  pthread_mutex_lock(&g_lock);
+  CHECKF(g_completed == 4, "%d callbacks", g_completed);
+  CHECK(running.done == 1 && running.st == LOGGER_OK);
+  CHECK(other.done == 1 && other.st == LOGGER_OK);
+  CHECK(!g_gate_timeout);
+  /* the dropped requests in request order */
+  int at[2] = {-1, -1};
+  for (int i = 0; i < g_completed && i < 4; ++i)
+    if (g_order[i] == 101 || g_order[i] == 102)
+      at[g_order[i] - 101] = i;
+  CHECKF(at[0] >= 0 && at[0] < at[1], "dropped at %d and %d", at[0], at[1]);
+  pthread_mutex_unlock(&g_lock);
+}
+
+int main(void) {
+  CHECK(snprintf(g_path, sizeof(g_path), "%s", harness_path("flush.log")) <
+        (int)sizeof(g_path));
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+
+  in_order();
+  destroy_pending();
+
+  CHECK(logger_destroy() == LOGGER_OK);
+  remove(g_path);
+  return harness_result("flush_test");
+}
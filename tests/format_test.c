@@ -0,0 +1,226 @@
+/*
+ * Differential test of logger_vformat() against the C library's vsnprintf():
+ * every case is formatted by both at several buffer sizes (0, tiny, cut
+ * mid-conversion, exact, large) and must agree byte for byte, including the
+ * return value and the bytes past the NUL, which must stay untouched.
+ *
+ * The fixed corpus covers the fast subset and each way out of it (flags,
+ * width/precision, '*', length modifiers, other conversions); a seeded
+ * random corpus then sweeps values through the fast paths.
+ */
+#define _GNU_SOURCE /* mkdtemp */
+
+#include "format.h"
+#include "harness.h"
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BUF 512
+#define GUARD 0x5A
+
+static unsigned long g_cases = 0;
+
+static void check(int line, const char *fmt, ...) {
+  static const size_t sizes[] = {0, 1, 2, 3, 5, 8, 13, 21, 34, BUF};
+  char want[BUF + 16], got[BUF + 16];
+  va_list ap;
+  va_start(ap, fmt);
+
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+    size_t size = sizes[i];
+    va_list a, b;
+    memset(want, GUARD, sizeof(want));
+    memset(got, GUARD, sizeof(got));
+    va_copy(a, ap);
+    va_copy(b, ap);
+    int nw = vsnprintf(size ? want : NULL, size, fmt, a);
+    int ng = logger_vformat(size ? got : NULL, size, fmt, b);
+    va_end(a);
+    va_end(b);
+
+    ++g_cases;
+    if (nw != ng || memcmp(want, got, sizeof(want)) != 0) {
+      CHECKF(0, "line %d: \"%s\" size %zu: libc %d \"%.*s\", ours %d \"%.*s\"",
+             line, fmt, size, nw, size ? (int)strnlen(want, size) : 0, want,
+             ng, size ? (int)strnlen(got, size) : 0, got);
+      break;
+    }
+  }
+  va_end(ap);
+}
+
+#define T(...) check(__LINE__, __VA_ARGS__)
+
+static void fixed_corpus(void) {
+  static char big[400];
+  memset(big, 'x', sizeof(big) - 1);
+
+  /* literals and %% */
+  T("");
+  T("plain text");
+  T("%%");
+  T("100%% done, %d%%", 7);
+  T("%%d %%s");
+
+  /* integers */
+  T("%d %d %d %d", 0, 1, -1, 42);
+  T("%d %d", INT_MIN, INT_MAX);
+  T("%i %i", -7, 123456789);
+  T("%u %u", 0u, UINT_MAX);
+  T("%x %X %x", 0xdeadbeefu, 0xdeadbeefu, 0u);
+  T("%ld %ld", LONG_MIN, LONG_MAX);
+  T("%lu %lx %lX", ULONG_MAX, ULONG_MAX, 0x1234abcdUL);
+  T("%lld %lld", LLONG_MIN, LLONG_MAX);
+  T("%llu %llx", ULLONG_MAX, 0x0123456789abcdefULL);
+  T("%zu %zx %zd", (size_t)SIZE_MAX, (size_t)0xabc, (ptrdiff_t)-5);
+  T("%li %lli", -99L, -99LL);
+
+  /* characters, strings, pointers */
+  T("%c%c%c", 'a', ' ', '~');
+  T("[%c]", 0xE9);
+  T("%s", "hello");
+  T("%s|%s|%s", "", "a", "multi word string");
+  T("%s", big);
+  T("%.3s|%.0s|%.10s", "abcdef", "abc", "short");
+  T("%s", (char *)NULL);
+  T("%.3s|%.6s|%.8s", (char *)NULL, (char *)NULL, (char *)NULL);
+  T("%p %p", (void *)0x1234, (void *)&g_cases);
+  T("%p", (void *)NULL);
+
+  /* doubles on the fast path and around it */
+  T("%f %f %f", 0.0, 1.0, -1.0);
+  T("%f", -0.0);
+  T("%.0f %.0f %.0f %.0f", 0.5, 1.5, 2.5, -0.5);
+  T("%.1f %.2f %.3f", 0.05, 0.125, 2.0005);
+  T("%.2f %.2f", 1.005, 2.675);
+  T("%.9f %.10f %.15f %.20f", 1.0 / 3, 1.0 / 3, 1.0 / 3, 0.1);
+  T("%.40f", 1e-30);
+  T("%.41f", 1.0);
+  T("%f %f", 1e12, 1099511627775.75);
+  T("%f %.3f", 1e300, -1e300);
+  T("%f %f %f", INFINITY, -INFINITY, NAN);
+  T("%.2f %.2f", DBL_MIN, DBL_TRUE_MIN);
+  T("%f %f", DBL_MAX, -DBL_MAX);
+  T("%.6f", 123456.7890125);
+
+  /* flags and widths: fallback, must still match */
+  T("[%5d] [%-5d] [%05d] [%+d] [% d]", 42, 42, 42, 42, 42);
+  T("[%#x] [%#X] [%#o] [%o]", 255u, 255u, 8u, 8u);
+  T("[%10s] [%-10s] [%10.3s]", "abc", "abc", "abcdef");
+  T("[%8.3f] [%-8.3f] [%+.2f] [%08.2f]", 3.14159, 3.14159, 2.5, -2.5);
+  T("[%*d] [%-*d] [%.*f] [%*.*s]", 6, 1, 6, 2, 3, 2.0, 5, 2, "xyz");
+  T("[%.*s]", -1, "negative precision");
+  T("[%.5d] [%.0d] [%.3x]", 42, 0, 10u);
+  T("[%5c] [%-3c]", 'z', 'y');
+  T("[%20p]", (void *)0xbeef);
+
+  /* length modifiers outside the subset */
+  T("%hhd %hhu %hd %hu", 300, 300, 70000, 70000);
+  T("%jd %ju", (intmax_t)-1, (uintmax_t)UINTMAX_MAX);
+  T("%td", (ptrdiff_t)-123);
+  T("%Lf %.3Lf", 1.5L, -2.25L);
+  T("%lf %lc", 1.25, (int)'w');
+
+  /* conversions outside the subset */
+  T("%e %E %g %G", 12345.678, 12345.678, 0.0001234, 1e20);
+  T("%a %A", 1.0, -0.5);
+  T("%o %#o", 0777u, 0u);
+
+  /* fast subset mixed with one fallback conversion later on */
+  T("%d %s %f then %5d", 1, "two", 3.0, 4);
+  T("%s=%d %s=%lu %s=%.3f", "a", -1, "b", 2UL, "c", 0.125);
+}
+
+/* xorshift64*, seeded for reproducible runs */
+static uint64_t g_rng = 0x9E3779B97F4A7C15ull;
+
+static uint64_t rnd(void) {
+  g_rng ^= g_rng >> 12;
+  g_rng ^= g_rng << 25;
+  g_rng ^= g_rng >> 27;
+  return g_rng * 0x2545F4914F6CDD1Dull;
+}
+
+static double rnd_double(void) {
+  switch (rnd() % 6) {
+  case 0: /* small with a short fraction, often near ties */
+    return (double)(int64_t)(rnd() % 20001 - 10000) / 8.0;
+  case 1: /* decimal-looking values */
+    return (double)(int64_t)(rnd() % 2000001 - 1000000) / 1000.0;
+  case 2: /* any magnitude */
+    return ldexp((double)(rnd() >> 11) / 9007199254740992.0,
+                 (int)(rnd() % 200) - 100) *
+           (rnd() & 1 ? -1.0 : 1.0);
+  case 3: /* around the fast path bound */
+    return 1099511627776.0 * ((double)(rnd() % 2000) / 1000.0);
+  case 4: { /* raw bit patterns: subnormals, huge, inf, nan */
+    uint64_t bits = rnd();
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+  }
+  default:
+    return (double)(rnd() % 100) + 0.5;
+  }
+}
+
+static void random_corpus(unsigned long n) {
+  char str[64];
+  for (unsigned long i = 0; i < n; ++i) {
+    uint64_t v = rnd() >> (rnd() % 64);
+    int prec = (int)(rnd() % 14);
+    char fmt[32];
+
+    switch (rnd() % 9) {
+    case 0:
+      check(__LINE__, "%d|%i", (int)v, -(int)v);
+      break;
+    case 1:
+      check(__LINE__, "%u %x %X", (unsigned)v, (unsigned)v, (unsigned)v);
+      break;
+    case 2:
+      check(__LINE__, "%ld %lu %lx", (long)v, (unsigned long)v,
+            (unsigned long)v);
+      break;
+    case 3:
+      check(__LINE__, "%lld %llu %zu %zd", (long long)v,
+            (unsigned long long)v, (size_t)v, (ptrdiff_t)v);
+      break;
+    case 4:
+      check(__LINE__, "%f", rnd_double());
+      break;
+    case 5:
+      snprintf(fmt, sizeof(fmt), "v=%%.%df", prec);
+      check(__LINE__, fmt, rnd_double());
+      break;
+    case 6: {
+      size_t len = rnd() % (sizeof(str) - 1);
+      for (size_t k = 0; k < len; ++k)
+        str[k] = (char)(' ' + rnd() % 95);
+      str[len] = '\0';
+      snprintf(fmt, sizeof(fmt), "<%%s> <%%.%ds>", prec);
+      check(__LINE__, fmt, str, str);
+      break;
+    }
+    case 7:
+      check(__LINE__, "%p %c", (void *)(uintptr_t)v, (int)(' ' + v % 95));
+      break;
+    default:
+      check(__LINE__, "%s=%d, %s=%.2f (%u%%)", "n", (int)v, "x",
+            rnd_double(), (unsigned)(v % 101));
+      break;
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+  fixed_corpus();
+  random_corpus(n);
+  printf("format_test: %lu comparisons\n", g_cases);
+  return harness_result("format_test");
+}
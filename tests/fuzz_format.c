@@ -0,0 +1,287 @@
+/*
+ * Fuzz target for the formatting path: the input chooses a buffer size and
+ * a format string, which logger_vformat() must render exactly like
+ * vsnprintf() (return value and buffer contents, in a buffer of exactly
+ * that size so ASan sees any overrun). The same format then goes through
+ * logger_log() to a capture backend and must arrive as vsnprintf() renders
+ * it into the logger's message buffer.
+ *
+ * Input: two bytes of buffer size (high bit of the first: 0..255, else
+ * 0..4199), then the format string. The format is made safe before use:
+ * every conversion is rewritten to match the type of the argument it takes
+ * from a fixed argument pack, widths and precisions are capped at 3 digits,
+ * %n and unknown conversions are escaped, and conversions past the end of
+ * the pack are escaped.
+ *
+ * Built two ways:
+ * - make fuzz: libFuzzer (clang, -fsanitize=fuzzer,address,undefined);
+ * - make check: a standalone driver that runs the files given on the
+ *   command line, or a seeded random corpus.
+ *
+ * Usage: fuzz_format [input files]
+ */
+#define _GNU_SOURCE /* mkdtemp */
+
+#include "backend.h"
+#include "format.h"
+#include "harness.h"
+#include <limits.h>
+#include <stdarg.h>
+#include <stdint.h>
+
+#define MSG_MAX 2048 /* the logger's message buffer */
+
+enum { K_INT, K_LONG, K_LLONG, K_SIZE, K_DBL, K_STR, K_PTR };
+
+static char g_long[3000]; /* longer than a log message */
+
+/* Argument pack, and the type and '*' use of each of its slots. */
+#define PACK                                                                   \
+  -42, "ab\tc", LLONG_MIN, 3.14159, 7, LONG_MAX, (size_t)SIZE_MAX,             \
+      (void *)0x1234, 123, g_long, 1e300, INT_MIN, -2.5e-7, (char *)NULL
+static const int KINDS[] = {K_INT, K_STR,  K_LLONG, K_DBL, K_INT,
+                            K_LONG, K_SIZE, K_PTR,  K_INT, K_STR,
+                            K_DBL, K_INT,  K_DBL,  K_STR};
+static const int STAR_OK[] = {1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0};
+#define SLOTS ((int)(sizeof(KINDS) / sizeof(KINDS[0])))
+
+static char g_msg[MSG_MAX + 64];
+static int g_got = 0;
+
+static logger_status_t cap_start(logger_backend_t *b) {
+  (void)b;
+  return LOGGER_OK;
+}
+
+static void cap_log(logger_backend_t *b, logger_level_t lvl, const char *file,
+                    int line, const char *msg) {
+  (void)b;
+  (void)lvl;
+  (void)file;
+  (void)line;
+  snprintf(g_msg, sizeof(g_msg), "%s", msg);
+  g_got = 1;
+}
+
+static void cap_destroy(logger_backend_t *b) { free(b); }
+
+static const logger_backend_vtbl_t CAP_VTBL = {.start = cap_start,
+                                               .stop = cap_start,
+                                               .log = cap_log,
+                                               .destroy = cap_destroy};
+
+static logger_backend_t *cap_create(void *arg) {
+  (void)arg;
+  logger_backend_t *b = (logger_backend_t *)calloc(1, sizeof(*b));
+  if (b)
+    b->vtbl = &CAP_VTBL;
+  return b;
+}
+
+static void setup(void) {
+  memset(g_long, 'y', sizeof(g_long) - 1);
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  logger_backend_desc_t desc = {.name = "capture",
+                                .caps = LOGGER_BACKEND_THREAD_SAFE,
+                                .min_level = LOGGER_LEVEL_TRACE,
+                                .create = cap_create};
+  CHECK(logger_register_backend(&desc) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+}
+
+static int is_int_conv(char c) { return c && strchr("diouxX", c) != NULL; }
+
+/* Conversion (with length) for @p c taking an argument of @p kind. */
+static int put_conv(char *out, int kind, char c) {
+  static const char *const LEN[] = {"", "l", "ll", "z"};
+  switch (kind) {
+  case K_INT:
+    if (c == 'c' || is_int_conv(c))
+      return sprintf(out, "%c", c);
+    return sprintf(out, "d");
+  case K_LONG:
+  case K_LLONG:
+  case K_SIZE:
+    return sprintf(out, "%s%c", LEN[kind], is_int_conv(c) ? c : 'u');
+  case K_DBL:
+    return sprintf(out, "%c", c && strchr("fFeEgGaA", c) ? c : 'f');
+  case K_STR:
+    return sprintf(out, "s");
+  default:
+    return sprintf(out, "p");
+  }
+}
+
+/* Copies a run of up to 3 digits, skipping any further ones. */
+static size_t digits(const uint8_t *p, size_t n, size_t i, char **o) {
+  for (int k = 0; i < n && p[i] >= '0' && p[i] <= '9'; ++i, ++k)
+    if (k < 3)
+      *(*o)++ = (char)p[i];
+  return i;
+}
+
+/* Safe format from fuzz bytes; @p out holds 2 * n + 1 bytes. */
+static void sanitize(const uint8_t *p, size_t n, char *out) {
+  char *o = out;
+  int slot = 0;
+  size_t i = 0;
+  while (i < n && p[i]) {
+    if (p[i] != '%') {
+      *o++ = (char)p[i++];
+      continue;
+    }
+    /* spec text without '%', and the slots its '*'s take */
+    char spec[32], *s = spec;
+    int used = slot;
+    ++i;
+    while (i < n && p[i] && strchr("-+ #0", p[i]) && s - spec < 5)
+      *s++ = (char)p[i++];
+    for (int part = 0; part < 2; ++part) { /* width, then precision */
+      if (part == 1) {
+        if (i >= n || p[i] != '.')
+          break;
+        *s++ = (char)p[i++];
+      }
+      if (i < n && p[i] == '*') {
+        ++i;
+        if (used < SLOTS && STAR_OK[used]) {
+          *s++ = '*';
+          ++used;
+        }
+      } else {
+        i = digits(p, n, i, &s);
+      }
+    }
+    while (i < n && p[i] && strchr("hlzjtLq", p[i]))
+      ++i; /* length: chosen by the argument's type below */
+    char c = i < n ? (char)p[i++] : '\0';
+    *s = '\0';
+
+    if (c == '%') {
+      o += sprintf(o, "%%%%");
+    } else if (!c || used >= SLOTS ||
+               !strchr("diouxXcspfFeEgGaA", c)) { /* literal text */
+      o += sprintf(o, "%%%%%s", spec);
+      if (c)
+        *o++ = c;
+    } else {
+      o += sprintf(o, "%%%s", spec);
+      o += put_conv(o, KINDS[used], c);
+      slot = used + 1;
+    }
+  }
+  *o = '\0';
+}
+
+static void render(char *want, int *nw, char *got, int *ng, size_t size,
+                   const char *fmt, ...) {
+  va_list ap, a, b;
+  va_start(ap, fmt);
+  va_copy(a, ap);
+  va_copy(b, ap);
+  *nw = vsnprintf(want, size, fmt, a);
+  *ng = logger_vformat(got, size, fmt, b);
+  va_end(a);
+  va_end(b);
+  va_end(ap);
+}
+
+static void libc_format(char *buf, size_t size, const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(buf, size, fmt, ap);
+  va_end(ap);
+}
+
+static void one_input(const uint8_t *data, size_t n) {
+  if (n < 2)
+    return;
+  size_t size = data[0] & 0x80 ? data[1]
+                               : (((size_t)data[0] << 8) | data[1]) % 4200;
+  data += 2;
+  n -= 2;
+  char *fmt = (char *)malloc(2 * n + 1);
+  sanitize(data, n, fmt);
+
+  /* exactly @p size bytes each, so an overrun is an ASan report */
+  char *want = size ? (char *)malloc(size) : NULL;
+  char *got = size ? (char *)malloc(size) : NULL;
+  if (size) {
+    memset(want, 0x5A, size);
+    memset(got, 0x5A, size);
+  }
+  int nw, ng;
+  render(want, &nw, got, &ng, size, fmt, PACK);
+  CHECKF(nw == ng && (!size || memcmp(want, got, size) == 0),
+         "\"%s\" size %zu: libc %d \"%.*s\", ours %d \"%.*s\"", fmt, size, nw,
+         size ? (int)strnlen(want, size) : 0, want ? want : "", ng,
+         size ? (int)strnlen(got, size) : 0, got ? got : "");
+
+  /* through the logging path (delivered in the call: thread-safe output) */
+  static char line[MSG_MAX];
+  libc_format(line, sizeof(line), fmt, PACK);
+  g_got = 0;
+  logger_log(LOGGER_LEVEL_INFO, __FILE__, __LINE__, fmt, PACK);
+  CHECKF(g_got && strcmp(g_msg, line) == 0,
+         "\"%s\": logged \"%.80s\", want \"%.80s\"", fmt,
+         g_got ? g_msg : "(nothing)", line);
+
+  free(want);
+  free(got);
+  free(fmt);
+}
+
+#ifdef LOGGER_LIBFUZZER
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t n) {
+  static int ready = 0;
+  if (!ready) {
+    setup();
+    ready = 1;
+  }
+  one_input(data, n);
+  if (harness_failures)
+    abort();
+  return 0;
+}
+#else
+/* xorshift64*, seeded for reproducible runs */
+static uint64_t g_rng = 0x9E3779B97F4A7C15ull;
+
+static uint64_t rnd(void) {
+  g_rng ^= g_rng >> 12;
+  g_rng ^= g_rng << 25;
+  g_rng ^= g_rng >> 27;
+  return g_rng * 0x2545F4914F6CDD1Dull;
+}
+
+int main(int argc, char **argv) {
+  static const char ALPHABET[] = "%%%%%%dsfxXuicpgeEaAn.*-+ #0123456789hlzjLq"
+                                 "%%abc\t";
+  setup();
+  if (argc > 1) {
+    for (int i = 1; i < argc; ++i) {
+      size_t len = 0;
+      char *in = harness_slurp(argv[i], &len);
+      CHECKF(in != NULL, "cannot read %s", argv[i]);
+      if (in)
+        one_input((const uint8_t *)in, len);
+      free(in);
+    }
+  } else {
+    uint8_t in[96];
+    unsigned long runs = 100000;
+    for (unsigned long r = 0; r < runs && harness_failures < 10; ++r) {
+      size_t n = 2 + rnd() % (sizeof(in) - 2);
+      in[0] = (uint8_t)rnd();
+      in[1] = (uint8_t)rnd();
+      for (size_t i = 2; i < n; ++i)
+        in[i] = (uint8_t)ALPHABET[rnd() % (sizeof(ALPHABET) - 1)];
+      one_input(in, n);
+    }
+    printf("fuzz_format: %lu random inputs\n", runs);
+  }
+  CHECK(logger_destroy() == LOGGER_OK);
+  return harness_result("fuzz_format");
+}
+#endif
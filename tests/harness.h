@@ -0,0 +1,113 @@
+/**
+ * @file harness.h
+ * @brief Minimal helpers shared by the tests and benchmarks in tests/.
+ *
+ * Header-only on purpose: each program is a single .c file linked against
+ * the library built by tests/Makefile.
+ */
+#ifndef LOGGER_TEST_HARNESS_H
+#define LOGGER_TEST_HARNESS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int harness_failures = 0;
+
+/** Records a failure and keeps going, so one run reports every mismatch. */
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      ++harness_failures;                                                      \
+    }                                                                          \
+  } while (0)
+
+/** Like CHECK(), with a printf-style explanation. */
+#define CHECKF(cond, ...)                                                      \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "%s:%d: ", __FILE__, __LINE__);                          \
+      fprintf(stderr, __VA_ARGS__);                                            \
+      fputc('\n', stderr);                                                     \
+      ++harness_failures;                                                      \
+    }                                                                          \
+  } while (0)
+
+/** Exit status for main(): prints a summary line. */
+static inline int harness_result(const char *name) {
+  if (harness_failures) {
+    fprintf(stderr, "%s: %d failure(s)\n", name, harness_failures);
+    return 1;
+  }
+  printf("%s: ok\n", name);
+  return 0;
+}
+
+static inline double harness_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static inline double harness_cpu_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/** Keeps the compiler from dropping a computation whose result is unused. */
+static inline void harness_sink(const void *p) {
+  __asm__ __volatile__("" : : "r"(p) : "memory");
+}
+
+/**
+ * Path of a scratch file "<dir>/<name>" in a per-run directory under
+ * $TMPDIR (or /tmp), created on first use. Returns a static buffer.
+ */
+static inline const char *harness_path(const char *name) {
+  static char dir[256];
+  static char path[512];
+  if (!dir[0]) {
+    const char *tmp = getenv("TMPDIR");
+    snprintf(dir, sizeof(dir), "%s/logger-test-XXXXXX", tmp ? tmp : "/tmp");
+    if (!mkdtemp(dir)) {
+      perror("mkdtemp");
+      exit(2);
+    }
+  }
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  return path;
+}
+
+/** Reads a whole file into a malloc()ed, NUL-terminated buffer. */
+static inline char *harness_slurp(const char *path, size_t *len) {
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return NULL;
+  size_t cap = 4096, n = 0;
+  char *buf = (char *)malloc(cap);
+  size_t got;
+  while (buf && (got = fread(buf + n, 1, cap - n - 1, f)) > 0) {
+    n += got;
+    if (cap - n - 1 == 0) {
+      char *bigger = (char *)realloc(buf, cap * 2);
+      if (!bigger) {
+        free(buf);
+        buf = NULL;
+        break;
+      }
+      buf = bigger;
+      cap *= 2;
+    }
+  }
+  fclose(f);
+  if (buf)
+    buf[n] = '\0';
+  if (len)
+    *len = n;
+  return buf;
+}
+
+#endif
@@ -0,0 +1,220 @@
+/*
+ * Block index ("<log>.idx") and tools/logq:
+ * - three blocks, one per phase (INFO, INFO/WARN, DEBUG/TRACE records, a
+ *   flush after each; no ERROR, which commits a block of its own): the
+ *   entries tile the log from offset 0 to its size, with the line counts,
+ *   levels and wall-clock ranges of their phase; in durable mode each
+ *   entry is the frame, header included;
+ * - logq's level and time filters return exactly the matching records and
+ *   skip the other blocks without reading them (-v statistics);
+ * - a log cut short of its index: logq scans the stale part in full, and
+ *   reopening the output trims the entries past the end of the log.
+ * Runs the logq built next to this test.
+ */
+#define _GNU_SOURCE /* mkdtemp, usleep */
+
+#include "file_index.h"
+#include "harness.h"
+#include "logger.h"
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PHASES 3
+#define LINES 20
+
+static const logger_level_t LEVELS[PHASES][2] = {
+    {LOGGER_LEVEL_INFO, LOGGER_LEVEL_INFO},
+    {LOGGER_LEVEL_INFO, LOGGER_LEVEL_WARN},
+    {LOGGER_LEVEL_DEBUG, LOGGER_LEVEL_TRACE}};
+
+static char g_logq[512];
+
+static uint64_t wall_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static long file_size(const char *path) {
+  struct stat st;
+  return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+/* Reads the entries of "<path>.idx"; returns their count, -1 if foreign. */
+static int read_index(const char *path, logger_index_entry_t *e, int max) {
+  char ipath[600];
+  snprintf(ipath, sizeof(ipath), "%s.idx", path);
+  size_t len = 0;
+  unsigned char *p = (unsigned char *)harness_slurp(ipath, &len);
+  unsigned char hdr[LOGGER_INDEX_HDR];
+  logger_index_header(hdr);
+  int n = -1;
+  if (p && len >= LOGGER_INDEX_HDR && memcmp(p, hdr, sizeof(hdr)) == 0 &&
+      (len - LOGGER_INDEX_HDR) % LOGGER_INDEX_ENTRY == 0) {
+    n = (int)((len - LOGGER_INDEX_HDR) / LOGGER_INDEX_ENTRY);
+    for (int i = 0; i < n && i < max; ++i)
+      logger_index_decode(p + LOGGER_INDEX_HDR + i * LOGGER_INDEX_ENTRY,
+                          &e[i]);
+  }
+  free(p);
+  return n;
+}
+
+static void open_output(const char *path, int durable) {
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  CHECK(logger_set_file_index(1) == LOGGER_OK);
+  if (durable)
+    CHECK(logger_set_file_durable(1, 0) == LOGGER_OK);
+  CHECK(logger_enable_file_output(path) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_TRACE) == LOGGER_OK);
+}
+
+/* One block per phase; @p t gets the wall-clock bounds of each. */
+static void write_phases(const char *path, int durable, uint64_t t[][2]) {
+  open_output(path, durable);
+  for (int ph = 0; ph < PHASES; ++ph) {
+    t[ph][0] = wall_ns();
+    for (int i = 0; i < LINES; ++i)
+      logger_log(LEVELS[ph][i % 2], "motor.c", 10 + ph,
+                 "phase %d record %d", ph, i);
+    t[ph][1] = wall_ns();
+    CHECK(logger_flush() == LOGGER_OK);
+    usleep(20 * 1000); /* phases apart in time */
+  }
+  CHECK(logger_stop() == LOGGER_OK);
+  CHECK(logger_destroy() == LOGGER_OK);
+}
+
+static void check_entries(const char *path, int durable, uint64_t t[][2]) {
+  logger_index_entry_t e[8];
+  int n = read_index(path, e, 8);
+  CHECKF(n == PHASES, "durable %d: %d entries", durable, n);
+  if (n != PHASES)
+    return;
+  uint64_t at = 0;
+  for (int i = 0; i < n; ++i) {
+    unsigned levels = 1u << LEVELS[i][0] | 1u << LEVELS[i][1];
+    CHECKF(e[i].offset == at, "entry %d at %llu, block at %llu", i,
+           (unsigned long long)e[i].offset, (unsigned long long)at);
+    CHECK(e[i].lines == LINES && e[i].levels == levels);
+    CHECK(e[i].first_ns >= t[i][0] && e[i].first_ns <= e[i].last_ns &&
+          e[i].last_ns <= t[i][1]);
+    CHECK(e[i].codec == 0);
+    CHECK(e[i].flags == (durable ? LOGGER_INDEX_FRAMED : 0));
+    CHECK(e[i].stored == e[i].raw + (durable ? 16u : 0u));
+    at += e[i].stored;
+  }
+  CHECKF((long)at == file_size(path), "entries end at %llu, log is %ld",
+         (unsigned long long)at, file_size(path));
+
+  /* the block holds its phase's lines */
+  size_t len = 0;
+  char *log = harness_slurp(path, &len);
+  if (log && (long)len == file_size(path)) {
+    char *blk = log + e[1].offset + (durable ? 16 : 0);
+    CHECK(memmem(blk, e[1].raw, "phase 1 record 0", 16) &&
+          memmem(blk, e[1].raw, "phase 1 record 19", 17) &&
+          !memmem(blk, e[1].raw, "phase 0", 7) &&
+          !memmem(blk, e[1].raw, "phase 2", 7));
+  }
+  free(log);
+}
+
+/* Runs logq; returns its output, *stats gets its -v line. */
+static char *logq(const char *args, const char *path, char *stats,
+                  size_t cap) {
+  char cmd[2048];
+  const char *err = harness_path("logq.err");
+  snprintf(cmd, sizeof(cmd), "%s -v %s %s 2>%s", g_logq, args, path, err);
+  FILE *p = popen(cmd, "r");
+  CHECK(p != NULL);
+  static char out[65536];
+  size_t n = p ? fread(out, 1, sizeof(out) - 1, p) : 0;
+  out[n] = '\0';
+  int rc = p ? pclose(p) : -1;
+  CHECKF(rc == 0, "%s: exit status %d", cmd, rc);
+  size_t elen = 0;
+  char *e = harness_slurp(err, &elen);
+  snprintf(stats, cap, "%s", e ? e : "");
+  free(e);
+  return out;
+}
+
+static int count(const char *s, const char *what) {
+  int n = 0;
+  for (const char *p = s; (p = strstr(p, what)) != NULL; p += strlen(what))
+    ++n;
+  return n;
+}
+
+static void query(const char *path, uint64_t t[][2]) {
+  char stats[512], args[128];
+
+  /* level: only the block with WARN records is read */
+  char *out = logq("-l warn", path, stats, sizeof(stats));
+  CHECKF(count(out, "[WARN]") == LINES / 2 && count(out, "\n") == LINES / 2,
+         "-l warn: %d lines", count(out, "\n"));
+  CHECKF(strstr(stats, "3 blocks, 2 skipped"), "-l warn: %s", stats);
+
+  /* time range of phase 1 */
+  snprintf(args, sizeof(args), "-s %.6f -e %.6f", (double)t[1][0] / 1e9,
+           (double)t[1][1] / 1e9);
+  out = logq(args, path, stats, sizeof(stats));
+  CHECKF(count(out, "phase 1 record") == LINES && count(out, "\n") == LINES,
+         "%s: %d lines", args, count(out, "\n"));
+  CHECKF(strstr(stats, "3 blocks, 2 skipped"), "%s: %s", args, stats);
+
+  /* both: no INFO+ block in the range of phase 2 */
+  snprintf(args, sizeof(args), "-l info -s %.6f", (double)t[2][0] / 1e9);
+  out = logq(args, path, stats, sizeof(stats));
+  CHECKF(count(out, "\n") == 0 && strstr(stats, "3 blocks, 3 skipped"),
+         "%s: %d lines, %s", args, count(out, "\n"), stats);
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  const char *slash = strrchr(argv[0], '/');
+  snprintf(g_logq, sizeof(g_logq), "%.*slogq",
+           slash ? (int)(slash - argv[0] + 1) : 0, argv[0]);
+  CHECKF(access(g_logq, X_OK) == 0, "%s not built", g_logq);
+
+  char path[256], dpath[256];
+  CHECK(snprintf(path, sizeof(path), "%s", harness_path("index.log")) <
+        (int)sizeof(path));
+  CHECK(snprintf(dpath, sizeof(dpath), "%s", harness_path("durable.log")) <
+        (int)sizeof(dpath));
+  uint64_t t[PHASES][2];
+
+  write_phases(dpath, 1, t);
+  check_entries(dpath, 1, t);
+  query(dpath, t);
+
+  write_phases(path, 0, t);
+  check_entries(path, 0, t);
+  query(path, t);
+
+  /* the log loses half of its last block; the index still lists it */
+  logger_index_entry_t e[8];
+  CHECK(read_index(path, e, 8) == PHASES);
+  long cut = (long)(e[2].offset + e[2].stored / 2);
+  CHECK(truncate(path, cut) == 0);
+  char stats[512];
+  char *out = logq("-l trace", path, stats, sizeof(stats));
+  CHECKF(count(out, "phase 0 record") == LINES &&
+             count(out, "phase 1 record") == LINES &&
+             count(out, "phase 2 record") > 0 &&
+             count(out, "phase 2 record") < LINES,
+         "stale index: %d lines", count(out, "\n"));
+  CHECKF(strstr(stats, "2 blocks"), "stale index: %s", stats);
+
+  /* reopening trims the index to the entries inside the log */
+  open_output(path, 0);
+  CHECK(logger_destroy() == LOGGER_OK);
+  int n = read_index(path, e, 8);
+  CHECKF(n == PHASES - 1, "%d entries after reopen", n);
+  CHECK(n < 1 || (long)(e[n - 1].offset + e[n - 1].stored) <= cut);
+
+  return harness_result("index_test");
+}
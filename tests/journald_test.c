@@ -0,0 +1,237 @@
+/*
+ * Journald output against a stand-in journal: an AF_UNIX datagram socket
+ * bound by the test, read back and decoded with the native protocol rules.
+ * - one datagram per record with PRIORITY, SYSLOG_IDENTIFIER, CODE_FILE,
+ *   CODE_LINE, LOGGER_SEQ, TID/THREAD_NAME and the context fields;
+ * - context keys that name a reserved field ("priority", "message") come
+ *   out with a CTX_ prefix and leave the record's own fields alone;
+ * - a multi-line MESSAGE in the length-prefixed binary form;
+ * - a journal that stops reading (full socket queue) and one that is gone
+ *   cost drops, counted, and never block the caller.
+ */
+#define _GNU_SOURCE /* mkdtemp */
+
+#include "harness.h"
+#include "logger.h"
+#include <errno.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define MAX_FIELDS 32
+
+typedef struct field {
+  char name[64];
+  char value[256];
+  size_t len;
+  int binary;
+} field_t;
+
+/* Decodes one datagram; returns the number of fields, -1 if malformed. */
+static int decode(const char *p, size_t n, field_t *out) {
+  int nf = 0;
+  const char *end = p + n;
+  while (p < end && nf < MAX_FIELDS) {
+    field_t *f = &out[nf++];
+    const char *sep = p;
+    while (sep < end && *sep != '=' && *sep != '\n')
+      ++sep;
+    if (sep == end || (size_t)(sep - p) >= sizeof(f->name))
+      return -1;
+    memcpy(f->name, p, (size_t)(sep - p));
+    f->name[sep - p] = '\0';
+
+    const char *v = sep + 1;
+    if (*sep == '=') {
+      const char *nl = memchr(v, '\n', (size_t)(end - v));
+      if (!nl)
+        return -1;
+      f->len = (size_t)(nl - v);
+      f->binary = 0;
+      p = nl + 1;
+    } else { /* NAME\n, LE64 length, data, \n */
+      if (end - v < 8)
+        return -1;
+      uint64_t len = 0;
+      for (int i = 0; i < 8; ++i)
+        len |= (uint64_t)(unsigned char)v[i] << (8 * i);
+      v += 8;
+      if ((uint64_t)(end - v) < len + 1 || v[len] != '\n')
+        return -1;
+      f->len = (size_t)len;
+      f->binary = 1;
+      p = v + len + 1;
+    }
+    if (f->len >= sizeof(f->value))
+      return -1;
+    memcpy(f->value, v, f->len);
+    f->value[f->len] = '\0';
+  }
+  return p == end ? nf : -1;
+}
+
+static const field_t *get(const field_t *f, int n, const char *name) {
+  for (int i = 0; i < n; ++i)
+    if (strcmp(f[i].name, name) == 0)
+      return &f[i];
+  return NULL;
+}
+
+#define EXPECT(f, n, name, want)                                              \
+  do {                                                                         \
+    const field_t *x_ = get(f, n, name);                                       \
+    CHECKF(x_ && strcmp(x_->value, want) == 0, "%s: \"%s\", want \"%s\"",      \
+           name, x_ ? x_->value : "(missing)", want);                          \
+  } while (0)
+
+static int count(const field_t *f, int n, const char *name) {
+  int k = 0;
+  for (int i = 0; i < n; ++i)
+    k += strcmp(f[i].name, name) == 0;
+  return k;
+}
+
+static int listen_at(const char *path) {
+  int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+  struct sockaddr_un a = {.sun_family = AF_UNIX};
+  CHECKF(snprintf(a.sun_path, sizeof(a.sun_path), "%s", path) <
+             (int)sizeof(a.sun_path),
+         "socket path too long: %s", path);
+  CHECK(fd >= 0 && bind(fd, (struct sockaddr *)&a, sizeof(a)) == 0);
+  return fd;
+}
+
+/* Reads one pending datagram, or returns -1 if there is none. */
+static ssize_t receive(int fd, char *buf, size_t cap) {
+  return recv(fd, buf, cap, MSG_DONTWAIT);
+}
+
+static void stats(unsigned long long *sent, unsigned long long *dropped) {
+  logger_journald_stats_t st;
+  CHECK(logger_get_journald_stats(&st) == LOGGER_OK);
+  *sent = st.sent;
+  *dropped = st.dropped;
+}
+
+int main(void) {
+  static char buf[65536];
+  field_t f[MAX_FIELDS];
+  char path[256];
+  CHECK(snprintf(path, sizeof(path), "%s", harness_path("journal.sock")) <
+        (int)sizeof(path));
+  int fd = listen_at(path);
+
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  CHECK(logger_set_sequence(1) == LOGGER_OK);
+  CHECK(logger_set_thread_info(1) == LOGGER_OK);
+  CHECK(logger_set_thread_name("main") == LOGGER_OK);
+  CHECK(logger_enable_journald(path) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+
+  int line = __LINE__ + 1;
+  LOG_INFO("hello %d", 1);
+  CHECK(logger_ctx_push("req-id", "42") == LOGGER_OK);
+  CHECK(logger_ctx_push("9x", "nine") == LOGGER_OK);
+  LOG_WARN("two\nlines");
+  CHECK(logger_ctx_pop() == LOGGER_OK);
+  CHECK(logger_ctx_pop() == LOGGER_OK);
+  CHECK(logger_ctx_push("priority", "low") == LOGGER_OK);
+  CHECK(logger_ctx_push("message", "shadow") == LOGGER_OK);
+  CHECK(logger_ctx_push("code_file", "other.c") == LOGGER_OK);
+  CHECK(logger_ctx_push("Tid", "7") == LOGGER_OK);
+  LOG_WARN("reserved keys");
+  for (int i = 0; i < 4; ++i)
+    CHECK(logger_ctx_pop() == LOGGER_OK);
+  CHECK(logger_flush() == LOGGER_OK);
+
+  /* plain record */
+  ssize_t n = receive(fd, buf, sizeof(buf));
+  int nf = n > 0 ? decode(buf, (size_t)n, f) : -1;
+  CHECKF(nf > 0, "first datagram: %zd bytes, %d fields", n, nf);
+  if (nf > 0) {
+    char num[16];
+    snprintf(num, sizeof(num), "%d", line);
+    EXPECT(f, nf, "PRIORITY", "6");
+    EXPECT(f, nf, "SYSLOG_IDENTIFIER", "journald_test");
+    EXPECT(f, nf, "CODE_LINE", num);
+    EXPECT(f, nf, "MESSAGE", "hello 1");
+    EXPECT(f, nf, "THREAD_NAME", "main");
+    const field_t *file = get(f, nf, "CODE_FILE");
+    CHECK(file && strstr(file->value, "journald_test.c"));
+    CHECK(get(f, nf, "LOGGER_SEQ") && get(f, nf, "TID"));
+    CHECK(!get(f, nf, "REQ_ID"));
+  }
+
+  /* multi-line message and context fields */
+  n = receive(fd, buf, sizeof(buf));
+  nf = n > 0 ? decode(buf, (size_t)n, f) : -1;
+  CHECKF(nf > 0, "second datagram: %zd bytes, %d fields", n, nf);
+  if (nf > 0) {
+    EXPECT(f, nf, "PRIORITY", "4");
+    EXPECT(f, nf, "REQ_ID", "42");
+    EXPECT(f, nf, "CTX_9X", "nine");
+    const field_t *msg = get(f, nf, "MESSAGE");
+    CHECK(msg && msg->binary && msg->len == 9 &&
+          memcmp(msg->value, "two\nlines", 9) == 0);
+  }
+
+  /* context keys naming reserved fields */
+  n = receive(fd, buf, sizeof(buf));
+  nf = n > 0 ? decode(buf, (size_t)n, f) : -1;
+  CHECKF(nf > 0, "third datagram: %zd bytes, %d fields", n, nf);
+  if (nf > 0) {
+    static const char *const OWN[] = {"PRIORITY", "MESSAGE", "CODE_FILE",
+                                      "TID"};
+    for (int i = 0; i < 4; ++i)
+      CHECKF(count(f, nf, OWN[i]) == 1, "%s appears %d times", OWN[i],
+             count(f, nf, OWN[i]));
+    EXPECT(f, nf, "PRIORITY", "4");
+    EXPECT(f, nf, "MESSAGE", "reserved keys");
+    const field_t *file = get(f, nf, "CODE_FILE");
+    CHECK(file && strstr(file->value, "journald_test.c"));
+    EXPECT(f, nf, "CTX_PRIORITY", "low");
+    EXPECT(f, nf, "CTX_MESSAGE", "shadow");
+    EXPECT(f, nf, "CTX_CODE_FILE", "other.c");
+    EXPECT(f, nf, "CTX_TID", "7");
+  }
+  CHECK(receive(fd, buf, sizeof(buf)) < 0);
+
+  unsigned long long sent, dropped;
+  stats(&sent, &dropped);
+  CHECKF(sent == 3 && dropped == 0, "sent %llu, dropped %llu", sent, dropped);
+
+  /* the journal stops reading: its queue fills, the rest is dropped */
+  int burst = 2000;
+  double t0 = harness_now();
+  for (int i = 0; i < burst; ++i)
+    LOG_INFO("burst %d", i);
+  double dt = harness_now() - t0;
+  CHECK(logger_flush() == LOGGER_OK);
+  int queued = 0;
+  while (receive(fd, buf, sizeof(buf)) > 0)
+    ++queued;
+  unsigned long long sent2, dropped2;
+  stats(&sent2, &dropped2);
+  CHECKF(sent2 - sent == (unsigned long long)queued && dropped2 > dropped &&
+             sent2 + dropped2 == sent + dropped + (unsigned long long)burst,
+         "burst of %d: %llu sent, %d received, %llu dropped", burst,
+         sent2 - sent, queued, dropped2 - dropped);
+  CHECKF(dt < 1.0, "burst took %.3f s", dt);
+
+  /* the journal is gone */
+  close(fd);
+  unlink(path);
+  LOG_ERROR("nobody listens");
+  CHECK(logger_flush() == LOGGER_OK);
+  unsigned long long sent3, dropped3;
+  stats(&sent3, &dropped3);
+  CHECK(sent3 == sent2 && dropped3 == dropped2 + 1);
+
+  printf("journald_test: burst of %d, %d accepted, %llu dropped\n", burst,
+         queued, dropped2 - dropped);
+  CHECK(logger_stop() == LOGGER_OK);
+  CHECK(logger_destroy() == LOGGER_OK);
+  return harness_result("journald_test");
+}
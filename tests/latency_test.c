@@ -0,0 +1,100 @@
+/*
+ * File output latency target (logger_set_file_latency_target()) and its
+ * statistics (logger_get_batch_stats()):
+ * - a lone record is written within the target (block latency; seen in
+ *   the file within the target plus polling slack), where the plain
+ *   interval would hold it for a second; each one is its own write;
+ * - after a burst and a flush, batches/records/bytes agree with what was
+ *   logged and what the file holds, nothing is queued, the percentiles are
+ *   ordered and bounded by the maximum, and target_us reports the setting
+ *   (0 once it is cleared).
+ */
+#define _GNU_SOURCE /* mkdtemp, usleep */
+
+#include "harness.h"
+#include "logger.h"
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TARGET_US 40000u
+#define SLACK_US 2000u /* polling the file size, and seeing it change */
+#define LONE 8
+#define BURST 5000
+
+static long file_size(const char *path) {
+  struct stat st;
+  return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+static void stats(logger_batch_stats_t *st) {
+  CHECK(logger_get_batch_stats(st) == LOGGER_OK);
+}
+
+int main(void) {
+  char path[256];
+  CHECK(snprintf(path, sizeof(path), "%s", harness_path("latency.log")) <
+        (int)sizeof(path));
+
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  CHECK(logger_enable_file_output(path) == LOGGER_OK);
+  CHECK(logger_set_file_latency_target(TARGET_US) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+
+  /* lone records, well apart */
+  double worst = 0;
+  for (int i = 0; i < LONE; ++i) {
+    long before = file_size(path);
+    double t0 = harness_now();
+    LOG_INFO("latency_test lone %d", i);
+    while (file_size(path) == before && harness_now() - t0 < 2.0)
+      usleep(200);
+    double dt = harness_now() - t0;
+    CHECKF(file_size(path) > before, "lone record %d never written", i);
+    if (dt > worst)
+      worst = dt;
+    usleep(3 * TARGET_US);
+  }
+  CHECKF(worst * 1e6 <= TARGET_US + SLACK_US,
+         "lone record written after %.1f ms, target %.1f ms", worst * 1e3,
+         TARGET_US / 1e3);
+
+  logger_batch_stats_t st;
+  stats(&st);
+  CHECKF(st.batches == LONE && st.records == LONE,
+         "lone records: %llu batches, %llu records", st.batches, st.records);
+  CHECK(st.bytes == (unsigned long long)file_size(path));
+  CHECK(st.target_us == TARGET_US && st.queued == 0);
+  CHECKF(st.latency_max_us <= TARGET_US,
+         "block latency up to %u us, target %u us", st.latency_max_us,
+         TARGET_US);
+
+  /* a burst shares writes */
+  for (int i = 0; i < BURST; ++i)
+    LOG_INFO("latency_test burst %d", i);
+  CHECK(logger_flush() == LOGGER_OK);
+  stats(&st);
+  CHECKF(st.records == LONE + BURST, "%llu records of %d", st.records,
+         LONE + BURST);
+  CHECKF(st.batches > LONE && st.batches < st.records,
+         "%llu batches for %llu records", st.batches, st.records);
+  CHECK(st.bytes == (unsigned long long)file_size(path));
+  CHECK(st.queued == 0);
+  CHECK(st.batch_records >= 1 && st.batch_bytes >= st.batch_records);
+  CHECKF(st.latency_p50_us <= st.latency_p99_us &&
+             st.latency_p99_us <= st.latency_max_us,
+         "p50 %u, p99 %u, max %u us", st.latency_p50_us, st.latency_p99_us,
+         st.latency_max_us);
+  printf("latency_test: lone record in %.2f ms; %llu records in %llu "
+         "writes, p50 %u us, p99 %u us, max %u us\n",
+         worst * 1e3, st.records, st.batches, st.latency_p50_us,
+         st.latency_p99_us, st.latency_max_us);
+
+  CHECK(logger_set_file_latency_target(0) == LOGGER_OK);
+  stats(&st);
+  CHECK(st.target_us == 0);
+
+  CHECK(logger_destroy() == LOGGER_OK);
+  remove(path);
+  return harness_result("latency_test");
+}
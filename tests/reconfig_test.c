@@ -0,0 +1,238 @@
+/*
+ * Live reconfiguration (composite outputs, logger_load_config(),
+ * logger_watch_config()), synchronous and async:
+ * - while two threads keep logging, the file output moves to another
+ *   path, a failed move keeps the current file, and a JSON Lines output
+ *   comes and goes: every record lands exactly once in the two files,
+ *   complete, and the records after the failed move in the second one;
+ * - per-output levels: a WARN file level drops INFO from the file but not
+ *   from the JSON Lines output; an unknown output is refused;
+ * - a config file sets levels and outputs and ignores unknown keys and
+ *   comments; a missing file or path is refused; once watched, replacing
+ *   the file changes the running logger; a second watch is refused.
+ */
+#define _GNU_SOURCE /* mkdtemp, usleep */
+
+#include "harness.h"
+#include "logger.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define WRITERS 2
+#define MAX_RECORDS 65536
+
+static atomic_int g_stop;
+static int g_logged[WRITERS];
+static char g_file[2][256], g_jsonl[256], g_cfg[256];
+
+static void *writer(void *arg) {
+  int id = (int)(long)arg, n = 0;
+  while (!atomic_load(&g_stop) && n < MAX_RECORDS) {
+    LOG_INFO("w%d %d", id, n++);
+    usleep(20);
+  }
+  g_logged[id] = n;
+  return NULL;
+}
+
+static void phase(void) { usleep(20 * 1000); }
+
+/* Records of each writer in @p text; incomplete lines count as @p bad. */
+static void tally(const char *text, unsigned char seen[][MAX_RECORDS],
+                  int *dups, int *bad) {
+  for (const char *p = text; p && *p;) {
+    const char *nl = strchr(p, '\n');
+    const char *w = strstr(p, "| w");
+    int id, n;
+    if (!nl || !w || w > nl || sscanf(w, "| w%d %d", &id, &n) != 2 ||
+        id < 0 || id >= WRITERS || n < 0 || n >= MAX_RECORDS)
+      ++*bad;
+    else if (seen[id][n]++)
+      ++*dups;
+    p = nl ? nl + 1 : NULL;
+  }
+}
+
+static int contains(const char *path, const char *what) {
+  size_t len = 0;
+  char *text = harness_slurp(path, &len);
+  int found = text && strstr(text, what) != NULL;
+  free(text);
+  return found;
+}
+
+static void moving_outputs(int async) {
+  static unsigned char seen[WRITERS][MAX_RECORDS];
+  memset(seen, 0, sizeof(seen));
+  remove(g_file[0]);
+  remove(g_file[1]);
+  remove(g_jsonl);
+
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  CHECK(logger_set_async(async) == LOGGER_OK);
+  CHECK(logger_enable_file_output(g_file[0]) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+
+  atomic_store(&g_stop, 0);
+  pthread_t t[WRITERS];
+  for (long i = 0; i < WRITERS; ++i)
+    CHECK(pthread_create(&t[i], NULL, writer, (void *)i) == 0);
+  phase();
+  CHECK(logger_enable_file_output(g_file[1]) == LOGGER_OK);
+  phase();
+  CHECK(logger_enable_file_output("/nonexistent-dir/reconfig.log") ==
+        LOGGER_UNABLE_TO_OPEN_FILE);
+  phase();
+  CHECK(logger_enable_jsonl_output(g_jsonl) == LOGGER_OK);
+  phase();
+  CHECK(logger_disable_jsonl_output() == LOGGER_OK);
+  phase();
+  atomic_store(&g_stop, 1);
+  for (int i = 0; i < WRITERS; ++i)
+    pthread_join(t[i], NULL);
+  CHECK(logger_flush() == LOGGER_OK);
+
+  int dups = 0, bad = 0, lines[2];
+  for (int f = 0; f < 2; ++f) {
+    size_t len = 0;
+    char *text = harness_slurp(g_file[f], &len);
+    int before = bad;
+    tally(text, seen, &dups, &bad);
+    lines[f] = 0;
+    for (size_t i = 0; text && i < len; ++i)
+      lines[f] += text[i] == '\n';
+    CHECKF(text && lines[f] > 0, "async %d: nothing in file %d", async, f);
+    CHECKF(bad == before, "async %d: %d bad lines in file %d", async,
+           bad - before, f);
+    free(text);
+  }
+  int lost = 0;
+  for (int id = 0; id < WRITERS; ++id)
+    for (int n = 0; n < g_logged[id]; ++n)
+      lost += !seen[id][n];
+  CHECKF(lost == 0 && dups == 0,
+         "async %d: %d records lost, %d written twice (%d + %d lines)", async,
+         lost, dups, lines[0], lines[1]);
+
+  /* the last records, logged after the failed move, are in the new file */
+  for (int id = 0; id < WRITERS; ++id) {
+    char last[32];
+    snprintf(last, sizeof(last), "| w%d %d\n", id, g_logged[id] - 1);
+    CHECKF(contains(g_file[1], last), "async %d: writer %d ends elsewhere",
+           async, id);
+  }
+
+  size_t len = 0;
+  char *json = harness_slurp(g_jsonl, &len);
+  int jlines = 0, jbad = 0;
+  for (char *p = json; p && *p;) {
+    char *nl = strchr(p, '\n');
+    ++jlines;
+    jbad += !nl || p[0] != '{' || nl[-1] != '}' || !strstr(p, "\"msg\":\"w");
+    p = nl ? nl + 1 : NULL;
+  }
+  CHECKF(jlines > 0 && jbad == 0, "async %d: %d of %d bad JSON lines", async,
+         jbad, jlines);
+  free(json);
+
+  CHECK(logger_destroy() == LOGGER_OK);
+}
+
+static void output_levels(void) {
+  remove(g_jsonl);
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  CHECK(logger_enable_file_output(g_file[0]) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+  CHECK(logger_enable_jsonl_output(g_jsonl) == LOGGER_OK);
+  CHECK(logger_set_output_level(LOGGER_OUTPUT_FILE, LOGGER_LEVEL_WARN) ==
+        LOGGER_OK);
+  CHECK(logger_set_output_level((logger_output_t)99, LOGGER_LEVEL_WARN) ==
+        LOGGER_UNKOWN_ERROR);
+  LOG_INFO("levels info");
+  LOG_WARN("levels warn");
+  CHECK(logger_flush() == LOGGER_OK);
+  CHECK(!contains(g_file[0], "levels info") &&
+        contains(g_file[0], "levels warn"));
+  CHECK(contains(g_jsonl, "levels info") && contains(g_jsonl, "levels warn"));
+  CHECK(logger_destroy() == LOGGER_OK);
+}
+
+static void write_config(const char *text) {
+  char tmp[300];
+  snprintf(tmp, sizeof(tmp), "%s.tmp", g_cfg);
+  FILE *f = fopen(tmp, "w");
+  CHECK(f != NULL);
+  if (!f)
+    return;
+  fputs(text, f);
+  fclose(f);
+  CHECK(rename(tmp, g_cfg) == 0); /* replaced, like an editor does */
+}
+
+static void config_file(void) {
+  char text[1024];
+  remove(g_file[1]);
+  remove(g_jsonl);
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  CHECK(logger_enable_jsonl_output(g_jsonl) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+
+  snprintf(text, sizeof(text),
+           "# reconfig_test\n"
+           "level = debug\n"
+           "file = %s\n"
+           "level.file = error   # errors only\n"
+           "jsonl = off\n"
+           "no.such.key = 1\n"
+           "console = maybe\n",
+           g_file[1]);
+  write_config(text);
+  CHECK(logger_load_config(g_cfg) == LOGGER_OK);
+  LOG_DEBUG("cfg debug");
+  LOG_ERROR("cfg error");
+  CHECK(logger_flush() == LOGGER_OK);
+  CHECK(contains(g_file[1], "cfg error") && !contains(g_file[1], "cfg debug"));
+  CHECK(!contains(g_jsonl, "cfg"));
+
+  CHECK(logger_load_config("/nonexistent-dir/logger.conf") ==
+        LOGGER_UNABLE_TO_OPEN_FILE);
+  CHECK(logger_load_config("") == LOGGER_INVALID_PATH);
+  CHECK(logger_load_config(NULL) == LOGGER_INVALID_PATH);
+
+  CHECK(logger_watch_config(g_cfg) == LOGGER_OK);
+  CHECK(logger_watch_config(g_cfg) == LOGGER_UNKOWN_ERROR);
+  snprintf(text, sizeof(text), "file = %s\nlevel.file = debug\n", g_file[1]);
+  write_config(text);
+  int seen = 0;
+  double t0 = harness_now();
+  for (int k = 0; !seen && harness_now() - t0 < 2.0; ++k) {
+    LOG_DEBUG("watch debug %d", k);
+    CHECK(logger_flush() == LOGGER_OK);
+    seen = contains(g_file[1], "watch debug");
+    usleep(10 * 1000);
+  }
+  CHECKF(seen, "watched config not applied after %.1f s", harness_now() - t0);
+  CHECK(logger_unwatch_config() == LOGGER_OK);
+  CHECK(logger_unwatch_config() == LOGGER_OK);
+  CHECK(logger_destroy() == LOGGER_OK);
+}
+
+int main(void) {
+  const char *names[] = {"a.log", "b.log", "c.jsonl", "logger.conf"};
+  char *paths[] = {g_file[0], g_file[1], g_jsonl, g_cfg};
+  for (int i = 0; i < 4; ++i)
+    CHECK(snprintf(paths[i], 256, "%s", harness_path(names[i])) < 256);
+
+  moving_outputs(0);
+  moving_outputs(1);
+  output_levels();
+  config_file();
+
+  for (int i = 0; i < 4; ++i)
+    remove(paths[i]);
+  return harness_result("reconfig_test");
+}
@@ -0,0 +1,233 @@
+/*
+ * Real-time mode.
+ *
+ * Syscall count: a child process warms up a real-time thread, then installs
+ * a seccomp filter on that thread that traps every syscall but exit and
+ * rt_sigreturn, and counts the traps while it logs (LOG_*, LOG_RT_*, until
+ * the ring is full and records are dropped). The count must be zero. The
+ * drain thread was started before the filter and is not affected.
+ *
+ * Thread exit: a destructor of a thread-local key that runs after the
+ * logger released the thread's ring still logs; its ordinary call must be
+ * emitted synchronously and its LOG_RT_* call dropped, without touching the
+ * released ring (ASan).
+ */
+#define _GNU_SOURCE /* mkdtemp, syscall */
+
+#include "backend.h"
+#include "harness.h"
+#include <linux/audit.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+#define TEST_AUDIT_ARCH AUDIT_ARCH_X86_64
+#elif defined(__aarch64__)
+#define TEST_AUDIT_ARCH AUDIT_ARCH_AARCH64
+#endif
+
+#define RT_CALLS 4096
+
+static atomic_int g_delivered = 0;
+static atomic_int g_after_close = 0;
+
+static logger_status_t cap_start(logger_backend_t *b) {
+  (void)b;
+  return LOGGER_OK;
+}
+
+static void cap_log(logger_backend_t *b, logger_level_t lvl, const char *file,
+                    int line, const char *msg) {
+  (void)b;
+  (void)lvl;
+  (void)file;
+  (void)line;
+  atomic_fetch_add(&g_delivered, 1);
+  if (strstr(msg, "after close"))
+    atomic_fetch_add(&g_after_close, 1);
+}
+
+static void cap_destroy(logger_backend_t *b) { free(b); }
+
+static const logger_backend_vtbl_t CAP_VTBL = {.start = cap_start,
+                                               .stop = cap_start,
+                                               .log = cap_log,
+                                               .destroy = cap_destroy};
+
+static logger_backend_t *cap_create(void *arg) {
+  (void)arg;
+  logger_backend_t *b = (logger_backend_t *)calloc(1, sizeof(*b));
+  if (b)
+    b->vtbl = &CAP_VTBL;
+  return b;
+}
+
+static void start_logger(void) {
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  logger_backend_desc_t desc = {.name = "capture",
+                                .caps = LOGGER_BACKEND_THREAD_SAFE,
+                                .min_level = LOGGER_LEVEL_TRACE,
+                                .create = cap_create};
+  CHECK(logger_register_backend(&desc) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+}
+
+/* ---- syscall count ---- */
+
+typedef struct shared {
+  atomic_int traps;
+  atomic_int first_nr; /* first trapped syscall, -1 if none */
+  int calls;
+} shared_t;
+
+static shared_t *g_shared;
+
+static void on_sigsys(int sig, siginfo_t *si, void *uc) {
+  (void)sig;
+  (void)uc;
+  int none = -1;
+  atomic_compare_exchange_strong(&g_shared->first_nr, &none, si->si_syscall);
+  atomic_fetch_add(&g_shared->traps, 1);
+}
+
+#ifdef TEST_AUDIT_ARCH
+static int trap_syscalls(void) {
+  struct sock_filter code[] = {
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, arch)),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, TEST_AUDIT_ARCH, 1, 0),
+      BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_KILL_PROCESS),
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr)),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SYS_exit_group, 3, 0),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SYS_exit, 2, 0),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SYS_rt_sigreturn, 1, 0),
+      BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_TRAP),
+      BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+  };
+  struct sock_fprog prog = {(unsigned short)(sizeof(code) / sizeof(code[0])),
+                            code};
+  if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) != 0)
+    return -1;
+  /* no SECCOMP_FILTER_FLAG_TSYNC: this thread only */
+  return (int)syscall(SYS_seccomp, SECCOMP_SET_MODE_FILTER, 0, &prog);
+}
+#endif
+
+static void child(void) {
+  start_logger();
+  CHECK(logger_set_thread_rt(1) == LOGGER_OK);
+
+  /* first calls of the thread set up its context and touch the ring */
+  for (int i = 0; i < 8; ++i)
+    LOG_RT_INFO("warm-up %d", i);
+  for (int i = 0; i < 1000 && atomic_load(&g_delivered) < 8; ++i)
+    usleep(1000);
+  CHECK(atomic_load(&g_delivered) == 8);
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_sigaction = on_sigsys;
+  sa.sa_flags = SA_SIGINFO;
+  sigaction(SIGSYS, &sa, NULL);
+#ifdef TEST_AUDIT_ARCH
+  if (harness_failures || trap_syscalls() != 0)
+    syscall(SYS_exit_group, 2);
+#endif
+
+  for (int i = 0; i < RT_CALLS / 2; ++i) {
+    LOG_RT_INFO("sample %d: %u us, %s", i, (unsigned)i * 3u, "ok");
+    LOG_INFO("ordinary call %d of %d", i, RT_CALLS / 2);
+  }
+  g_shared->calls = RT_CALLS;
+  syscall(SYS_exit_group, 0);
+}
+
+static void syscall_count(void) {
+#ifndef TEST_AUDIT_ARCH
+  printf("rt_test: syscall count skipped (no seccomp arch for this target)\n");
+  return;
+#endif
+  g_shared = (shared_t *)mmap(NULL, sizeof(shared_t), PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  CHECK(g_shared != MAP_FAILED);
+  if (g_shared == MAP_FAILED)
+    return;
+  atomic_init(&g_shared->traps, 0);
+  atomic_init(&g_shared->first_nr, -1);
+
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0)
+    child();
+
+  int status = 0;
+  CHECK(waitpid(pid, &status, 0) == pid);
+  CHECKF(WIFEXITED(status) && WEXITSTATUS(status) == 0,
+         "child status 0x%x (exit 2: seccomp unavailable or warm-up failed)",
+         status);
+  int traps = atomic_load(&g_shared->traps);
+  CHECKF(g_shared->calls == RT_CALLS && traps == 0,
+         "%d syscalls in %d calls, first nr %d", traps, g_shared->calls,
+         atomic_load(&g_shared->first_nr));
+  printf("rt_test: %d syscalls in %d real-time log calls\n", traps,
+         g_shared->calls);
+  munmap(g_shared, sizeof(shared_t));
+}
+
+/* ---- thread exit ---- */
+
+static pthread_key_t g_late_key;
+
+static void late_log(void *arg) {
+  (void)arg;
+  usleep(50 * 1000); /* the drain thread frees the released ring meanwhile */
+  LOG_INFO("synchronous after close");
+  LOG_RT_INFO("dropped after close");
+}
+
+static void *rt_thread(void *arg) {
+  (void)arg;
+  CHECK(logger_set_thread_rt(1) == LOGGER_OK);
+  pthread_setspecific(g_late_key, (void *)1);
+  LOG_RT_INFO("before exit");
+  return NULL;
+}
+
+static void thread_exit(void) {
+  /* created after the logger's keys, so its destructor runs after theirs */
+  CHECK(logger_set_thread_rt(1) == LOGGER_OK);
+  CHECK(logger_set_thread_rt(0) == LOGGER_OK);
+  CHECK(pthread_key_create(&g_late_key, late_log) == 0);
+
+  logger_stats_t before, after;
+  CHECK(logger_get_stats(&before) == LOGGER_OK);
+  pthread_t t;
+  pthread_create(&t, NULL, rt_thread, NULL);
+  pthread_join(t, NULL);
+  CHECK(logger_flush() == LOGGER_OK);
+  CHECK(logger_get_stats(&after) == LOGGER_OK);
+
+  CHECKF(atomic_load(&g_after_close) == 1, "%d records after close",
+         atomic_load(&g_after_close));
+  CHECK(after.dropped == before.dropped + 1);
+  pthread_key_delete(g_late_key);
+}
+
+int main(void) {
+  syscall_count();
+
+  start_logger();
+  thread_exit();
+  CHECK(logger_stop() == LOGGER_OK);
+  CHECK(logger_destroy() == LOGGER_OK);
+  return harness_result("rt_test");
+}
@@ -0,0 +1,115 @@
+/*
+ * Scope timer summaries reach the outputs without further samples: a site
+ * that goes quiet is reported by the background sweeper once its interval
+ * ends, and logger_stop() reports intervals still open.
+ */
+#define _GNU_SOURCE /* mkdtemp, usleep */
+
+#include "backend.h"
+#include "harness.h"
+#include "logger_timer.h"
+#include <pthread.h>
+#include <unistd.h>
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static int g_summaries = 0;
+static unsigned long long g_counted = 0;
+
+static logger_status_t cap_start(logger_backend_t *b) {
+  (void)b;
+  return LOGGER_OK;
+}
+
+static void cap_log(logger_backend_t *b, logger_level_t lvl, const char *file,
+                    int line, const char *msg) {
+  (void)b;
+  (void)lvl;
+  (void)file;
+  (void)line;
+  unsigned long long n;
+  const char *p = strstr(msg, "count=");
+  if (strncmp(msg, "timer ", 6) != 0 || !p || sscanf(p, "count=%llu", &n) != 1)
+    return;
+  pthread_mutex_lock(&g_lock);
+  ++g_summaries;
+  g_counted += n;
+  pthread_mutex_unlock(&g_lock);
+}
+
+static void cap_destroy(logger_backend_t *b) { free(b); }
+
+static const logger_backend_vtbl_t CAP_VTBL = {.start = cap_start,
+                                               .stop = cap_start,
+                                               .log = cap_log,
+                                               .destroy = cap_destroy};
+
+static logger_backend_t *cap_create(void *arg) {
+  (void)arg;
+  logger_backend_t *b = (logger_backend_t *)calloc(1, sizeof(*b));
+  if (b)
+    b->vtbl = &CAP_VTBL;
+  return b;
+}
+
+static void summaries(int *n, unsigned long long *counted) {
+  pthread_mutex_lock(&g_lock);
+  *n = g_summaries;
+  *counted = g_counted;
+  pthread_mutex_unlock(&g_lock);
+}
+
+static void timed_work(int samples) {
+  for (int i = 0; i < samples; ++i) {
+    LOG_SCOPE_TIMER("work");
+    harness_sink(&i);
+  }
+}
+
+static void *other_thread(void *arg) {
+  (void)arg;
+  timed_work(5);
+  usleep(400 * 1000); /* stays alive, and quiet, past the stop below */
+  return NULL;
+}
+
+int main(void) {
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  logger_backend_desc_t desc = {.name = "capture",
+                                .caps = LOGGER_BACKEND_THREAD_SAFE,
+                                .min_level = LOGGER_LEVEL_TRACE,
+                                .create = cap_create};
+  CHECK(logger_register_backend(&desc) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+  CHECK(logger_timer_configure(50, LOGGER_LEVEL_INFO) == LOGGER_OK);
+
+  /* quiet site: reported by the sweeper, with no sample after the burst */
+  timed_work(10);
+  int n;
+  unsigned long long counted;
+  summaries(&n, &counted);
+  CHECK(n == 0);
+  for (int i = 0; i < 100 && n == 0; ++i) {
+    usleep(10 * 1000);
+    summaries(&n, &counted);
+  }
+  CHECKF(n == 1 && counted == 10, "sweeper: %d summaries, %llu samples", n,
+         counted);
+
+  /* open intervals, on this and another live thread, are reported by stop */
+  CHECK(logger_timer_configure(60 * 1000, LOGGER_LEVEL_INFO) == LOGGER_OK);
+  timed_work(3);
+  pthread_t t;
+  pthread_create(&t, NULL, other_thread, NULL);
+  usleep(100 * 1000);
+  summaries(&n, &counted);
+  CHECK(n == 1);
+  CHECK(logger_stop() == LOGGER_OK);
+  summaries(&n, &counted);
+  CHECKF(n == 3 && counted == 18, "stop: %d summaries, %llu samples", n,
+         counted);
+
+  pthread_join(t, NULL);
+  CHECK(logger_destroy() == LOGGER_OK);
+  return harness_result("scope_timer_test");
+}
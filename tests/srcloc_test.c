@@ -0,0 +1,110 @@
+/*
+ * logger_log() accepts file names the caller owns: a heap or stack string
+ * may be freed, or its storage reused for another name, right after the
+ * call. Each record must still carry the name it was logged with (and ASan
+ * must see no access to the old storage), on the synchronous and on the
+ * real-time path.
+ */
+#define _GNU_SOURCE /* mkdtemp */
+
+#include "backend.h"
+#include "harness.h"
+
+#define MAX_SEEN 64
+
+static char g_seen[MAX_SEEN][160];
+static int g_count = 0;
+
+static logger_status_t cap_start(logger_backend_t *b) {
+  (void)b;
+  return LOGGER_OK;
+}
+
+/* Single-threaded backend: the logger serialises calls. */
+static void cap_log(logger_backend_t *b, logger_level_t lvl, const char *file,
+                    int line, const char *msg) {
+  (void)b;
+  (void)lvl;
+  (void)line;
+  (void)msg;
+  if (g_count < MAX_SEEN)
+    snprintf(g_seen[g_count++], sizeof(g_seen[0]), "%s", file);
+}
+
+static void cap_destroy(logger_backend_t *b) { free(b); }
+
+static const logger_backend_vtbl_t CAP_VTBL = {.start = cap_start,
+                                               .stop = cap_start,
+                                               .log = cap_log,
+                                               .destroy = cap_destroy};
+
+static logger_backend_t *cap_create(void *arg) {
+  (void)arg;
+  logger_backend_t *b = (logger_backend_t *)calloc(1, sizeof(*b));
+  if (b)
+    b->vtbl = &CAP_VTBL;
+  return b;
+}
+
+static void log_from(const char *file, int line) {
+  logger_log(LOGGER_LEVEL_INFO, file, line, "from %s", "here");
+}
+
+int main(void) {
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  logger_backend_desc_t desc = {.name = "capture",
+                                .min_level = LOGGER_LEVEL_TRACE,
+                                .create = cap_create};
+  CHECK(logger_register_backend(&desc) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+
+  /* one address, three names */
+  char buf[64];
+  const char *names[] = {"alpha.c", "beta.c", "alpha.c"};
+  for (int i = 0; i < 3; ++i) {
+    snprintf(buf, sizeof(buf), "%s", names[i]);
+    log_from(buf, i);
+  }
+
+  /* heap names, freed after each call; the allocator reuses the block */
+  for (int i = 0; i < 4; ++i) {
+    char *p = (char *)malloc(32);
+    snprintf(p, 32, "heap_%d.c", i);
+    log_from(p, i);
+    free(p);
+  }
+
+  /* real-time path: one name not interned yet, one longer than a slot */
+  CHECK(logger_set_thread_rt(1) == LOGGER_OK);
+  char *fresh = strdup("rt_fresh.c");
+  char *deep = (char *)malloc(300);
+  memset(deep, 'd', 299);
+  strcpy(deep + 299 - 7, "/deep.c");
+  log_from(fresh, 1);
+  log_from(deep, 2);
+  free(fresh);
+  free(deep);
+  CHECK(logger_set_thread_rt(0) == LOGGER_OK);
+  CHECK(logger_stop() == LOGGER_OK);
+
+  const char *want[] = {"alpha.c",  "beta.c",   "alpha.c",    "heap_0.c",
+                        "heap_1.c", "heap_2.c", "heap_3.c",   "rt_fresh.c",
+                        NULL /* tail of the long path */};
+  int n = (int)(sizeof(want) / sizeof(want[0]));
+  CHECKF(g_count == n, "%d records, want %d", g_count, n);
+  for (int i = 0; i < n && i < g_count; ++i) {
+    if (want[i]) {
+      CHECKF(strcmp(g_seen[i], want[i]) == 0, "record %d: \"%s\" != \"%s\"",
+             i, g_seen[i], want[i]);
+    } else {
+      size_t len = strlen(g_seen[i]);
+      CHECKF(len > 7 && len < 128 &&
+                 strcmp(g_seen[i] + len - 7, "/deep.c") == 0,
+             "record %d: \"%s\"", i, g_seen[i]);
+    }
+  }
+
+  CHECK(logger_destroy() == LOGGER_OK);
+  return harness_result("srcloc_test");
+}
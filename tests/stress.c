@@ -0,0 +1,182 @@
+/*
+ * Lifecycle stress: the default logger is stopped, restarted, reconfigured,
+ * destroyed and re-created in a loop while other threads keep logging:
+ * - steady threads: plain synchronous calls, with and without context;
+ * - short-lived threads, created all the time, that log through an async
+ *   queue or a real-time ring and exit in the middle of it, with a scope
+ *   timer and pushed context still open and one more record logged from a
+ *   thread-exit destructor after the logger released their queue.
+ * Logging while no logger exists (between destroy and init) is a no-op; a
+ * second logger_init() before destroy is refused and keeps the logger.
+ *
+ * Pass/fail is the sanitizers' (make check, make tsan) plus: every line
+ * written to the file output is complete and is one of ours.
+ *
+ * Usage: stress [cycles]
+ */
+#define _GNU_SOURCE /* mkdtemp, usleep */
+
+#include "harness.h"
+#include "logger.h"
+#include "logger_timer.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define STEADY 3
+#define CHURN 2
+
+static atomic_int g_stop = 0;
+static atomic_ulong g_calls = 0;
+static atomic_ulong g_threads = 0;
+static pthread_key_t g_late_key;
+
+static void *steady(void *arg) {
+  int id = (int)(long)arg;
+  for (unsigned long i = 0; !atomic_load(&g_stop); ++i) {
+    if (i % 8 == 0) {
+      logger_ctx_push("w", "steady");
+      LOG_INFO("stress steady %d: %lu", id, i);
+      logger_ctx_pop();
+    } else {
+      LOG_WARN("stress steady %d: %lu %s", id, i, "value");
+    }
+    atomic_fetch_add(&g_calls, 1);
+  }
+  return NULL;
+}
+
+/* Runs after the logger's own destructors released this thread's queue. */
+static void late_log(void *arg) {
+  (void)arg;
+  LOG_INFO("stress late");
+  atomic_fetch_add(&g_calls, 1);
+}
+
+static void *short_lived(void *arg) {
+  long n = (long)arg;
+  pthread_setspecific(g_late_key, (void *)1);
+  if (n % 2)
+    logger_set_thread_rt(1);
+  logger_ctx_push("w", "churn");
+  LOG_SCOPE_TIMER("stress churn");
+  for (long i = 0; i < 16 + n % 48; ++i) {
+    LOG_INFO("stress churn %ld: %ld", n, i);
+    atomic_fetch_add(&g_calls, 1);
+  }
+  return NULL; /* ring, queue, context and timer still open */
+}
+
+static void *churn(void *arg) {
+  (void)arg;
+  for (long n = 0; !atomic_load(&g_stop); ++n) {
+    pthread_t t;
+    if (pthread_create(&t, NULL, short_lived, (void *)n) == 0) {
+      pthread_join(t, NULL);
+      atomic_fetch_add(&g_threads, 1);
+    }
+  }
+  return NULL;
+}
+
+/* Every line is newline-terminated and carries one of our messages. */
+static int check_file(const char *path, int *lines) {
+  size_t len = 0;
+  char *text = harness_slurp(path, &len);
+  int bad = 0;
+  *lines = 0;
+  if (!text)
+    return 0;
+  for (char *p = text; p < text + len;) {
+    char *nl = memchr(p, '\n', (size_t)(text + len - p));
+    if (!nl) {
+      ++bad;
+      break;
+    }
+    *nl = '\0';
+    if (!strstr(p, "stress ")) {
+      if (!bad)
+        fprintf(stderr, "unexpected line: \"%s\"\n", p);
+      ++bad;
+    }
+    ++*lines;
+    p = nl + 1;
+  }
+  free(text);
+  return bad;
+}
+
+static void cycle(int c, const char *path, const char *jpath) {
+  CHECK(logger_init() == LOGGER_OK);
+  logger_handle_t *h = logger_default();
+  CHECK(logger_init() == LOGGER_ALREADY_INITIALIZED);
+  CHECK(logger_default() == h && logger_get("default") == h);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  CHECK(logger_set_async(c % 2) == LOGGER_OK);
+  CHECK(logger_enable_file_output(path) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+  usleep(2000);
+
+  CHECK(logger_stop() == LOGGER_OK);
+  usleep(500);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+  CHECK(logger_enable_jsonl_output(jpath) == LOGGER_OK);
+  CHECK(logger_set_async(!(c % 2)) == LOGGER_OK);
+  usleep(2000);
+
+  CHECK(logger_set_level(LOGGER_LEVEL_WARN) == LOGGER_OK);
+  CHECK(logger_disable_jsonl_output() == LOGGER_OK);
+  CHECK(logger_flush() == LOGGER_OK);
+  usleep(1000);
+  CHECK(logger_set_level(LOGGER_LEVEL_INFO) == LOGGER_OK);
+  if (c % 3 == 0) /* destroy while started */
+    CHECK(logger_stop() == LOGGER_OK);
+  CHECK(logger_destroy() == LOGGER_OK);
+  CHECK(logger_get("default") == NULL);
+  usleep(500); /* no logger: calls are no-ops */
+}
+
+int main(int argc, char **argv) {
+  int cycles = argc > 1 ? atoi(argv[1]) : 100;
+  char path[256], jpath[256];
+  snprintf(path, sizeof(path), "%s", harness_path("stress.log"));
+  snprintf(jpath, sizeof(jpath), "%s", harness_path("stress.jsonl"));
+
+  /* the logger's per-thread keys first, so ours is released after them */
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  CHECK(logger_set_async(1) == LOGGER_OK);
+  CHECK(logger_set_thread_rt(1) == LOGGER_OK);
+  CHECK(logger_set_thread_rt(0) == LOGGER_OK);
+  LOG_INFO("stress keys");
+  CHECK(logger_destroy() == LOGGER_OK);
+  CHECK(pthread_key_create(&g_late_key, late_log) == 0);
+
+  pthread_t t[STEADY + CHURN];
+  for (int i = 0; i < STEADY; ++i)
+    pthread_create(&t[i], NULL, steady, (void *)(long)i);
+  for (int i = STEADY; i < STEADY + CHURN; ++i)
+    pthread_create(&t[i], NULL, churn, NULL);
+
+  int lines = 0, bad = 0;
+  for (int c = 0; c < cycles; ++c) {
+    remove(path);
+    cycle(c, path, jpath);
+    int n = 0;
+    bad += check_file(path, &n);
+    lines += n;
+  }
+
+  atomic_store(&g_stop, 1);
+  for (int i = 0; i < STEADY + CHURN; ++i)
+    pthread_join(t[i], NULL);
+
+  CHECKF(bad == 0, "%d malformed or foreign lines", bad);
+  CHECKF(lines > 0, "no line reached the file output");
+  printf("stress: %d cycles, %lu calls, %lu short-lived threads, %d lines\n",
+         cycles, atomic_load(&g_calls), atomic_load(&g_threads), lines);
+  remove(path);
+  remove(jpath);
+  pthread_key_delete(g_late_key);
+  return harness_result("stress");
+}
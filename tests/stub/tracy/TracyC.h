@@ -0,0 +1,57 @@
+/*
+ * Stand-in for Tracy's TracyC.h, for `make c11` only: the declarations
+ * and macros the library uses, with the same shapes as Tracy's, so the
+ * TRACY_ENABLE sources compile without a Tracy checkout. Never linked.
+ */
+#ifndef LOGGER_TEST_STUB_TRACYC_H
+#define LOGGER_TEST_STUB_TRACYC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ___tracy_source_location_data {
+  const char *name;
+  const char *function;
+  const char *file;
+  uint32_t line;
+  uint32_t color;
+};
+
+struct ___tracy_c_zone_context {
+  uint32_t id;
+  int active;
+};
+
+typedef struct ___tracy_c_zone_context TracyCZoneCtx;
+
+TracyCZoneCtx
+___tracy_emit_zone_begin(const struct ___tracy_source_location_data *srcloc,
+                         int active);
+void ___tracy_emit_zone_end(TracyCZoneCtx ctx);
+void ___tracy_emit_plot(const char *name, double val);
+void ___tracy_emit_messageC(const char *txt, size_t size, uint32_t color,
+                            int callstack);
+
+#define TracyCZoneN(ctx, name, active)                                         \
+  static const struct ___tracy_source_location_data                            \
+      TracyConcat(__tracy_source_location, __LINE__) = {                       \
+          name, __func__, __FILE__, (uint32_t)__LINE__, 0};                    \
+  TracyCZoneCtx ctx = ___tracy_emit_zone_begin(                                \
+      &TracyConcat(__tracy_source_location, __LINE__), active)
+#define TracyCZoneEnd(ctx) ___tracy_emit_zone_end(ctx)
+#define TracyCPlot(name, val) ___tracy_emit_plot(name, val)
+#define TracyCMessageC(txt, size, color)                                       \
+  ___tracy_emit_messageC(txt, size, color, 0)
+
+#define TracyConcat(x, y) TracyConcatIndirect(x, y)
+#define TracyConcatIndirect(x, y) x##y
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
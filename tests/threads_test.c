@@ -0,0 +1,212 @@
+/*
+ * Background thread options (logger_set_thread_options()):
+ * - defaults read back as inherit/sleep; NULL, an unknown policy or wait
+ *   strategy and malformed CPU lists are refused and leave the options
+ *   as they were; valid ones read back as set;
+ * - threads started after a set ("log-async", "log-file") and threads
+ *   already running when it changes get the CPU list, the policy and the
+ *   nice value (raised only, so no privilege is needed);
+ * - the async consumer follows the wait strategy: it burns its core while
+ *   idle with SPIN and not with SLEEP, and records still get through with
+ *   each strategy.
+ * Linux only: threads are found by name under /proc/self/task.
+ */
+#define _GNU_SOURCE /* mkdtemp, usleep, sched_getaffinity */
+
+#include "harness.h"
+#include "logger.h"
+#include <dirent.h>
+#include <errno.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#define MAX_TIDS 16
+
+/* Kernel ids of this process's threads named @p name. */
+static int find_threads(const char *name, pid_t *tids, int max) {
+  DIR *d = opendir("/proc/self/task");
+  int n = 0;
+  struct dirent *e;
+  while (d && (e = readdir(d)) != NULL && n < max) {
+    char path[300], comm[32] = "";
+    if (e->d_name[0] == '.')
+      continue;
+    snprintf(path, sizeof(path), "/proc/self/task/%s/comm", e->d_name);
+    FILE *f = fopen(path, "r");
+    if (!f)
+      continue;
+    if (fgets(comm, sizeof(comm), f))
+      comm[strcspn(comm, "\n")] = '\0';
+    fclose(f);
+    if (strcmp(comm, name) == 0)
+      tids[n++] = (pid_t)atoi(e->d_name);
+  }
+  if (d)
+    closedir(d);
+  return n;
+}
+
+/* utime + stime of thread @p tid, in seconds; -1 if unknown. */
+static double cpu_time(pid_t tid) {
+  char path[64], buf[1024];
+  snprintf(path, sizeof(path), "/proc/self/task/%d/stat", (int)tid);
+  FILE *f = fopen(path, "r");
+  size_t n = f ? fread(buf, 1, sizeof(buf) - 1, f) : 0;
+  if (f)
+    fclose(f);
+  buf[n] = '\0';
+  char *p = strrchr(buf, ')'); /* the name may hold spaces */
+  unsigned long ut, st;
+  if (!p || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                   &ut, &st) != 2)
+    return -1;
+  return (double)(ut + st) / (double)sysconf(_SC_CLK_TCK);
+}
+
+/* Every thread named @p name has @p cpu only, @p policy and @p nice. */
+static void check_applied(const char *name, int cpu, int policy, int nice) {
+  pid_t tids[MAX_TIDS];
+  int n = find_threads(name, tids, MAX_TIDS);
+  CHECKF(n > 0, "no %s thread", name);
+  for (int i = 0; i < n; ++i) {
+    cpu_set_t set;
+    CHECK(sched_getaffinity(tids[i], sizeof(set), &set) == 0);
+    CHECKF(CPU_COUNT(&set) == 1 && CPU_ISSET(cpu, &set),
+           "%s: %d CPUs in its affinity", name, CPU_COUNT(&set));
+    CHECKF(sched_getscheduler(tids[i]) == policy, "%s: policy %d, want %d",
+           name, sched_getscheduler(tids[i]), policy);
+    errno = 0;
+    int got = getpriority(PRIO_PROCESS, (id_t)tids[i]);
+    CHECKF(got == nice && errno == 0, "%s: nice %d, want %d", name, got,
+           nice);
+  }
+}
+
+static void options(void) {
+  logger_thread_options_t o;
+  CHECK(logger_get_thread_options(&o) == LOGGER_OK);
+  CHECK(o.cpus && o.cpus[0] == '\0' && o.sched == LOGGER_SCHED_INHERIT &&
+        o.wait == LOGGER_WAIT_SLEEP && o.idle_us == 0);
+  CHECK(logger_get_thread_options(NULL) == LOGGER_UNKOWN_ERROR);
+
+  CHECK(logger_set_thread_options(NULL) == LOGGER_UNKOWN_ERROR);
+  const char *bad_cpus[] = {"x", "3-1", "1-", "0;1", "99999"};
+  for (size_t i = 0; i < sizeof(bad_cpus) / sizeof(bad_cpus[0]); ++i) {
+    logger_thread_options_t b = {.cpus = bad_cpus[i]};
+    CHECKF(logger_set_thread_options(&b) == LOGGER_UNKOWN_ERROR,
+           "cpus \"%s\" accepted", bad_cpus[i]);
+  }
+  logger_thread_options_t b = {.sched = (logger_sched_t)99};
+  CHECK(logger_set_thread_options(&b) == LOGGER_UNKOWN_ERROR);
+  b = (logger_thread_options_t){.wait = (logger_wait_t)7};
+  CHECK(logger_set_thread_options(&b) == LOGGER_UNKOWN_ERROR);
+
+  CHECK(logger_get_thread_options(&o) == LOGGER_OK);
+  CHECK(o.cpus[0] == '\0' && o.sched == LOGGER_SCHED_INHERIT &&
+        o.wait == LOGGER_WAIT_SLEEP);
+
+  logger_thread_options_t set = {.cpus = "0-2,5",
+                                 .sched = LOGGER_SCHED_IDLE,
+                                 .priority = 3,
+                                 .wait = LOGGER_WAIT_YIELD,
+                                 .idle_us = 250};
+  CHECK(logger_set_thread_options(&set) == LOGGER_OK);
+  CHECK(logger_get_thread_options(&o) == LOGGER_OK);
+  CHECK(strcmp(o.cpus, "0-2,5") == 0 && o.sched == LOGGER_SCHED_IDLE &&
+        o.priority == 3 && o.wait == LOGGER_WAIT_YIELD && o.idle_us == 250);
+}
+
+static void applied(const char *path, int cpu) {
+  char cpus[16];
+  snprintf(cpus, sizeof(cpus), "%d", cpu);
+  logger_thread_options_t o = {.cpus = cpus,
+                               .sched = LOGGER_SCHED_BATCH,
+                               .priority = 5};
+  CHECK(logger_set_thread_options(&o) == LOGGER_OK);
+
+  /* started after the set */
+  CHECK(logger_init() == LOGGER_OK);
+  CHECK(logger_disable_console() == LOGGER_OK);
+  CHECK(logger_set_file_latency_target(1000) == LOGGER_OK); /* a writer */
+  CHECK(logger_enable_file_output(path) == LOGGER_OK);
+  CHECK(logger_set_async(1) == LOGGER_OK);
+  CHECK(logger_start(LOGGER_LEVEL_INFO) == LOGGER_OK);
+  LOG_INFO("threads_test started");
+  CHECK(logger_flush() == LOGGER_OK);
+  check_applied("log-async", cpu, SCHED_BATCH, 5);
+  check_applied("log-file", cpu, SCHED_BATCH, 5);
+
+  /* running when the options change */
+  o.sched = LOGGER_SCHED_OTHER;
+  o.priority = 10;
+  CHECK(logger_set_thread_options(&o) == LOGGER_OK);
+  check_applied("log-async", cpu, SCHED_OTHER, 10);
+  check_applied("log-file", cpu, SCHED_OTHER, 10);
+
+  /* INHERIT leaves them as they are */
+  o.sched = LOGGER_SCHED_INHERIT;
+  o.priority = 0;
+  CHECK(logger_set_thread_options(&o) == LOGGER_OK);
+  check_applied("log-async", cpu, SCHED_OTHER, 10);
+}
+
+/* CPU share of the idle async consumer over @p sec seconds. */
+static double idle_share(logger_wait_t wait, double sec) {
+  logger_thread_options_t o;
+  CHECK(logger_get_thread_options(&o) == LOGGER_OK);
+  o.wait = wait;
+  o.idle_us = 1000;
+  CHECK(logger_set_thread_options(&o) == LOGGER_OK);
+  LOG_INFO("threads_test wait %d", (int)wait);
+  CHECK(logger_flush() == LOGGER_OK);
+
+  pid_t tid;
+  if (find_threads("log-async", &tid, 1) != 1) {
+    CHECKF(0, "no log-async thread");
+    return -1;
+  }
+  double c0 = cpu_time(tid), t0 = harness_now();
+  usleep((useconds_t)(sec * 1e6));
+  double c1 = cpu_time(tid), t1 = harness_now();
+  CHECK(c0 >= 0 && c1 >= 0);
+  return (c1 - c0) / (t1 - t0);
+}
+
+static void wait_strategy(const char *path) {
+  double spin = idle_share(LOGGER_WAIT_SPIN, 0.3);
+  double yield = idle_share(LOGGER_WAIT_YIELD, 0.1);
+  double sleep = idle_share(LOGGER_WAIT_SLEEP, 0.3);
+  printf("threads_test: idle consumer CPU: spin %.0f%%, yield %.0f%%, "
+         "sleep %.0f%%\n",
+         spin * 100, yield * 100, sleep * 100);
+  CHECKF(spin >= 0.5, "spinning consumer used %.0f%% of a CPU", spin * 100);
+  CHECKF(sleep <= 0.1, "sleeping consumer used %.0f%% of a CPU",
+         sleep * 100);
+
+  size_t len = 0;
+  char *text = harness_slurp(path, &len);
+  CHECK(text && strstr(text, "threads_test wait 2") &&
+        strstr(text, "threads_test wait 1") &&
+        strstr(text, "threads_test wait 0"));
+  free(text);
+}
+
+int main(void) {
+  char path[256];
+  CHECK(snprintf(path, sizeof(path), "%s", harness_path("threads.log")) <
+        (int)sizeof(path));
+  cpu_set_t mine;
+  CHECK(sched_getaffinity(0, sizeof(mine), &mine) == 0);
+  int cpu = 0;
+  while (cpu < CPU_SETSIZE - 1 && !CPU_ISSET(cpu, &mine))
+    ++cpu;
+
+  options();
+  applied(path, cpu);
+  wait_strategy(path);
+
+  CHECK(logger_destroy() == LOGGER_OK);
+  remove(path);
+  return harness_result("threads_test");
+}
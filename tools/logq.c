@@ -0,0 +1,495 @@
+/**
+ * @file logq.c
+ * @brief Queries a file output through its "<log>.idx" block index.
+ *
+ *   logq [-l level] [-f file.c] [-s time] [-e time] [-g text] [-iv] LOG
+ *
+ * Prints the records of LOG at or above the level, from the source file,
+ * between the two times and containing the text. The log and its index are
+ * mapped with mmap(); blocks whose index entry rules them out (time range,
+ * levels present) are never read, the others are decoded (LZ4/zstd builds)
+ * and scanned line by line. Parts of the log the index does not cover (a
+ * lagging index, data written before indexing was turned on, no index at
+ * all) are scanned in full. Times resolve to whole blocks.
+ *
+ * Times are Unix seconds ("1767225600.5") or local "YYYY-MM-DDTHH:MM:SS"
+ * (a trailing 'Z' means UTC).
+ *
+ * Build: cc -O2 -Isrc tools/logq.c src/crc32c.c -o logq -lpthread
+ * (add -DLOGGER_USE_LZ4 -llz4 / -DLOGGER_USE_ZSTD -lzstd for compressed
+ * logs).
+ */
+#define _GNU_SOURCE /* memmem, timegm */
+
+#include "crc32c.h"
+#include "file_index.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef LOGGER_USE_LZ4
+#include <lz4frame.h>
+#endif
+#ifdef LOGGER_USE_ZSTD
+#include <zstd.h>
+#endif
+
+/* Must match file_backend.c / logger_compression_t. */
+#define FRAME_HDR 16u
+#define CODEC_NONE 0
+#define CODEC_LZ4 1
+#define CODEC_ZSTD 2
+
+static const char *LEVELS[] = {"TRACE", "DEBUG", "INFO",
+                               "WARN",  "ERROR", "FATAL"};
+#define LEVEL_COUNT 6
+
+typedef struct query {
+  unsigned levels;  /* bit per wanted level */
+  const char *file; /* source file suffix, or NULL */
+  size_t file_len;
+  const char *text; /* message substring, or NULL */
+  uint64_t from_ns, to_ns;
+} query_t;
+
+typedef struct scan_stats {
+  unsigned long long blocks, skipped, decoded, bad;
+  unsigned long long unindexed_bytes, matches;
+} scan_stats_t;
+
+static query_t g_q;
+static scan_stats_t g_st;
+static int g_last_match; /* continuation lines follow their record */
+
+static char *g_buf; /* decode scratch */
+
+/* ---- matching ---- */
+
+static int level_of(const char *p, size_t n) {
+  for (int i = 0; i < LEVEL_COUNT; ++i) {
+    if (strlen(LEVELS[i]) == n && memcmp(p, LEVELS[i], n) == 0)
+      return i;
+  }
+  return -1;
+}
+
+/*
+ * "[#seq ][LEVEL] file:line | msg". Returns 1/0 for a record, -1 for a line
+ * that is not one (continuation of a multi-line message).
+ */
+static int match_record(const char *p, size_t n) {
+  const char *end = p + n;
+  if (p < end && *p == '#') {
+    while (p < end && *p != ' ')
+      ++p;
+    ++p;
+  }
+  if (p >= end || *p != '[')
+    return -1;
+  const char *rb = (const char *)memchr(p, ']', (size_t)(end - p));
+  if (!rb)
+    return -1;
+  int lvl = level_of(p + 1, (size_t)(rb - p - 1));
+  if (lvl < 0)
+    return -1;
+  const char *loc = rb + 2;
+  const char *bar =
+      loc < end ? (const char *)memmem(loc, (size_t)(end - loc), " | ", 3)
+                : NULL;
+  if (!bar)
+    return -1;
+
+  if (!(g_q.levels & (1u << lvl)))
+    return 0;
+  if (g_q.file) {
+    const char *colon = bar;
+    while (colon > loc && *colon != ':')
+      --colon;
+    size_t flen = (size_t)(colon - loc);
+    if (flen < g_q.file_len ||
+        memcmp(colon - g_q.file_len, g_q.file, g_q.file_len) != 0 ||
+        (flen > g_q.file_len && colon[-(long)g_q.file_len - 1] != '/'))
+      return 0;
+  }
+  if (g_q.text) {
+    const char *msg = bar + 3;
+    if (!memmem(msg, (size_t)(end - msg), g_q.text, strlen(g_q.text)))
+      return 0;
+  }
+  return 1;
+}
+
+static void scan_text(const char *p, size_t n) {
+  const char *end = p + n;
+  while (p < end) {
+    const char *nl = (const char *)memchr(p, '\n', (size_t)(end - p));
+    size_t len = nl ? (size_t)(nl - p) : (size_t)(end - p);
+    int m = match_record(p, len);
+    if (m >= 0)
+      g_last_match = m;
+    if (m > 0 || (m < 0 && g_last_match)) {
+      fwrite(p, 1, len, stdout);
+      putchar('\n');
+      g_st.matches += m > 0;
+    }
+    p += len + 1;
+  }
+}
+
+/* ---- decoding ---- */
+
+#if defined(LOGGER_USE_LZ4) || defined(LOGGER_USE_ZSTD)
+static size_t g_cap;
+
+static int reserve(size_t need) {
+  if (need <= g_cap)
+    return 1;
+  size_t cap = g_cap ? g_cap : 64 * 1024;
+  while (cap < need)
+    cap *= 2;
+  char *nb = (char *)realloc(g_buf, cap);
+  if (!nb)
+    return 0;
+  g_buf = nb;
+  g_cap = cap;
+  return 1;
+}
+#endif
+
+/*
+ * Decodes the compressed frame of @p codec at the start of src[0, n) into
+ * g_buf. Returns the decoded length and sets *used to the frame size, or
+ * returns (size_t)-1 if the frame is corrupt or the codec is not compiled
+ * in.
+ */
+static size_t decode(int codec, const char *src, size_t n, size_t *used) {
+  switch (codec) {
+#ifdef LOGGER_USE_LZ4
+  case CODEC_LZ4: {
+    LZ4F_dctx *d;
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&d, LZ4F_VERSION)))
+      return (size_t)-1;
+    size_t in = 0, out = 0, r = 1;
+    while (r) {
+      if (!reserve(out + 64 * 1024))
+        break;
+      size_t dsz = g_cap - out, ssz = n - in;
+      r = LZ4F_decompress(d, g_buf + out, &dsz, src + in, &ssz, NULL);
+      if (LZ4F_isError(r) || (!dsz && !ssz))
+        break;
+      in += ssz;
+      out += dsz;
+    }
+    LZ4F_freeDecompressionContext(d);
+    if (r)
+      return (size_t)-1;
+    *used = in;
+    return out;
+  }
+#endif
+#ifdef LOGGER_USE_ZSTD
+  case CODEC_ZSTD: {
+    size_t fsz = ZSTD_findFrameCompressedSize(src, n);
+    unsigned long long raw = ZSTD_getFrameContentSize(src, n);
+    if (ZSTD_isError(fsz) || raw == ZSTD_CONTENTSIZE_UNKNOWN ||
+        raw == ZSTD_CONTENTSIZE_ERROR || !reserve((size_t)raw))
+      return (size_t)-1;
+    size_t r = ZSTD_decompress(g_buf, (size_t)raw, src, fsz);
+    if (ZSTD_isError(r))
+      return (size_t)-1;
+    *used = fsz;
+    return r;
+  }
+#endif
+  default:
+    (void)src;
+    (void)n;
+    (void)used;
+    return (size_t)-1;
+  }
+}
+
+/* Scans one payload of @p codec; text is scanned in place. */
+static int scan_payload(int codec, const char *p, size_t n, size_t *used) {
+  if (codec == CODEC_NONE) {
+    scan_text(p, n);
+    *used = n;
+    return 1;
+  }
+  size_t len = decode(codec, p, n, used);
+  if (len == (size_t)-1)
+    return 0;
+  g_st.decoded++;
+  scan_text(g_buf, len);
+  return 1;
+}
+
+/* Checks a durable frame at p[0, n); returns its payload size or -1. */
+static long frame_at(const unsigned char *p, size_t n) {
+  if (n < FRAME_HDR || memcmp(p, "LGB1", 4) != 0)
+    return -1;
+  uint32_t len = (uint32_t)logger_index_get(p + 8, 4);
+  if (len > n - FRAME_HDR ||
+      logger_crc32c(logger_crc32c(0, p + 4, 8), p + FRAME_HDR, len) !=
+          (uint32_t)logger_index_get(p + 12, 4))
+    return -1;
+  return (long)len;
+}
+
+static int codec_magic(const unsigned char *p, size_t n) {
+  static const unsigned char lz4[4] = {0x04, 0x22, 0x4D, 0x18};
+  static const unsigned char zstd[4] = {0x28, 0xB5, 0x2F, 0xFD};
+  if (n >= 4 && memcmp(p, lz4, 4) == 0)
+    return CODEC_LZ4;
+  if (n >= 4 && memcmp(p, zstd, 4) == 0)
+    return CODEC_ZSTD;
+  return CODEC_NONE;
+}
+
+/* Scans a range the index does not describe, frame by frame if framed. */
+static void scan_unindexed(const unsigned char *p, size_t n) {
+  g_st.unindexed_bytes += n;
+  while (n) {
+    size_t used;
+    long len = frame_at(p, n);
+    if (len >= 0) {
+      if (!scan_payload(p[4], (const char *)p + FRAME_HDR, (size_t)len,
+                        &used))
+        g_st.bad++;
+      p += FRAME_HDR + (size_t)len;
+      n -= FRAME_HDR + (size_t)len;
+      continue;
+    }
+    int codec = codec_magic(p, n);
+    if (codec == CODEC_NONE && memcmp(p, "LGB1", n < 4 ? n : 4) != 0) {
+      scan_text((const char *)p, n);
+      return;
+    }
+    if (codec == CODEC_NONE ||
+        !scan_payload(codec, (const char *)p, n, &used)) {
+      g_st.bad++; /* torn frame, or codec not compiled in */
+      return;
+    }
+    p += used;
+    n -= used;
+  }
+}
+
+static void scan_block(const unsigned char *log,
+                       const logger_index_entry_t *e) {
+  g_st.blocks++;
+  if (!(e->levels & g_q.levels) || e->last_ns < g_q.from_ns ||
+      e->first_ns > g_q.to_ns) {
+    g_st.skipped++;
+    return;
+  }
+  const unsigned char *p = log + e->offset;
+  size_t n = e->stored, used;
+  if (e->flags & LOGGER_INDEX_FRAMED) {
+    long len = frame_at(p, n);
+    if (len < 0) {
+      g_st.bad++;
+      return;
+    }
+    p += FRAME_HDR;
+    n = (size_t)len;
+  }
+  if (!scan_payload(e->codec, (const char *)p, n, &used))
+    g_st.bad++;
+}
+
+/* ---- driver ---- */
+
+static const void *map_file(const char *path, size_t *size) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  const void *p = NULL;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED)
+      p = NULL;
+    else
+      *size = (size_t)st.st_size;
+  }
+  close(fd);
+  return p;
+}
+
+static int parse_time(const char *s, uint64_t *out) {
+  struct tm tm;
+  memset(&tm, 0, sizeof(tm));
+  const char *rest = strptime(s, "%Y-%m-%dT%H:%M:%S", &tm);
+  if (rest && (!*rest || (rest[0] == 'Z' && !rest[1]))) {
+    tm.tm_isdst = -1;
+    time_t t = *rest == 'Z' ? timegm(&tm) : mktime(&tm);
+    if (t < 0)
+      return 0;
+    *out = (uint64_t)t * 1000000000u;
+    return 1;
+  }
+  char *end;
+  double sec = strtod(s, &end);
+  if (end == s || *end || sec < 0)
+    return 0;
+  *out = (uint64_t)(sec * 1e9);
+  return 1;
+}
+
+static void print_time(uint64_t ns) {
+  time_t t = (time_t)(ns / 1000000000u);
+  struct tm tm;
+  char buf[32];
+  strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", gmtime_r(&t, &tm));
+  printf("%s.%03uZ", buf, (unsigned)(ns / 1000000u % 1000u));
+}
+
+static void dump_index(const unsigned char *idx, size_t n) {
+  for (size_t off = LOGGER_INDEX_HDR; off + LOGGER_INDEX_ENTRY <= n;
+       off += LOGGER_INDEX_ENTRY) {
+    logger_index_entry_t e;
+    logger_index_decode(idx + off, &e);
+    printf("%12llu %8u %6u ", (unsigned long long)e.offset, e.stored,
+           e.lines);
+    print_time(e.first_ns);
+    putchar(' ');
+    print_time(e.last_ns);
+    printf(" ");
+    for (int i = 0; i < LEVEL_COUNT; ++i)
+      putchar(e.levels & (1u << i) ? LEVELS[i][0] : '-');
+    putchar('\n');
+  }
+}
+
+static void usage(void) {
+  fprintf(stderr,
+          "usage: logq [-l level] [-f file] [-s time] [-e time] [-g text] "
+          "[-i] [-v] LOG\n"
+          "  -l  minimum level (trace|debug|info|warn|error|fatal)\n"
+          "  -f  source file, e.g. motor.c\n"
+          "  -s  from time, -e until time (Unix seconds or "
+          "YYYY-MM-DDTHH:MM:SS[Z])\n"
+          "  -g  message contains text\n"
+          "  -i  print the index instead of records\n"
+          "  -v  print scan statistics to stderr\n");
+}
+
+int main(int argc, char **argv) {
+  int dump = 0, verbose = 0, opt;
+  g_q.levels = (1u << LEVEL_COUNT) - 1;
+  g_q.to_ns = UINT64_MAX;
+
+  while ((opt = getopt(argc, argv, "l:f:s:e:g:iv")) != -1) {
+    switch (opt) {
+    case 'l': {
+      int lvl = -1;
+      for (int i = 0; i < LEVEL_COUNT; ++i)
+        if (strcasecmp(optarg, LEVELS[i]) == 0)
+          lvl = i;
+      if (lvl < 0) {
+        usage();
+        return 2;
+      }
+      g_q.levels = ((1u << LEVEL_COUNT) - 1) & ~((1u << lvl) - 1);
+      break;
+    }
+    case 'f':
+      g_q.file = optarg;
+      g_q.file_len = strlen(optarg);
+      break;
+    case 's':
+    case 'e':
+      if (!parse_time(optarg, opt == 's' ? &g_q.from_ns : &g_q.to_ns)) {
+        usage();
+        return 2;
+      }
+      break;
+    case 'g':
+      g_q.text = optarg;
+      break;
+    case 'i':
+      dump = 1;
+      break;
+    case 'v':
+      verbose = 1;
+      break;
+    default:
+      usage();
+      return 2;
+    }
+  }
+  if (optind != argc - 1) {
+    usage();
+    return 2;
+  }
+
+  const char *path = argv[optind];
+  size_t log_size = 0, idx_size = 0;
+  const unsigned char *log = (const unsigned char *)map_file(path, &log_size);
+  if (!log && access(path, R_OK) != 0) {
+    perror(path);
+    return 1;
+  }
+
+  size_t plen = strlen(path);
+  char *ipath = (char *)malloc(plen + sizeof(".idx"));
+  if (!ipath)
+    return 1;
+  memcpy(ipath, path, plen);
+  memcpy(ipath + plen, ".idx", sizeof(".idx"));
+  const unsigned char *idx = (const unsigned char *)map_file(ipath, &idx_size);
+  unsigned char hdr[LOGGER_INDEX_HDR];
+  logger_index_header(hdr);
+  if (idx && (idx_size < LOGGER_INDEX_HDR || memcmp(idx, hdr, sizeof(hdr)))) {
+    fprintf(stderr, "logq: %s: not an index, ignored\n", ipath);
+    idx_size = 0;
+  } else if (!idx && verbose) {
+    fprintf(stderr, "logq: no index, scanning %s\n", path);
+  }
+  free(ipath);
+
+  static char out[1 << 16];
+  setvbuf(stdout, out, _IOFBF, sizeof(out));
+
+  if (dump) {
+    if (idx_size)
+      dump_index(idx, idx_size);
+    return 0;
+  }
+
+  /* Indexed blocks in order; the gaps around them are scanned in full. */
+  uint64_t pos = 0, gap_lo = 0;
+  for (size_t off = LOGGER_INDEX_HDR; idx_size &&
+                                      off + LOGGER_INDEX_ENTRY <= idx_size;
+       off += LOGGER_INDEX_ENTRY) {
+    logger_index_entry_t e;
+    logger_index_decode(idx + off, &e);
+    if (e.offset < pos || e.offset + e.stored > log_size)
+      break; /* stale index (log replaced or truncated): scan the rest */
+    if (e.offset > pos && gap_lo <= g_q.to_ns && e.first_ns >= g_q.from_ns)
+      scan_unindexed(log + pos, (size_t)(e.offset - pos));
+    scan_block(log, &e);
+    pos = e.offset + e.stored;
+    gap_lo = e.last_ns;
+  }
+  if (pos < log_size && gap_lo <= g_q.to_ns)
+    scan_unindexed(log + pos, (size_t)(log_size - pos));
+
+  fflush(stdout);
+  if (verbose)
+    fprintf(stderr,
+            "logq: %llu blocks, %llu skipped by the index, %llu decoded, "
+            "%llu unindexed bytes, %llu bad, %llu matches\n",
+            g_st.blocks, g_st.skipped, g_st.decoded, g_st.unindexed_bytes,
+            g_st.bad, g_st.matches);
+  return g_st.bad ? 1 : 0;
+}